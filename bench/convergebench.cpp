@@ -0,0 +1,108 @@
+// 抖动序列的收敛基准：静止画面下逐帧累积（或按 TAA 的指数权重混合），报告与参考图的 RMSE 随帧数的变化，
+// 以及降到白噪声单帧 RMSE 的四分之一（白噪声理论上要 16 帧）所需的帧数，比较原先的 sin 哈希白噪声与蓝噪声 + R2 序列
+// 用法：blackhole-convergebench [width height [frames [background [blend]]]]
+//   blend 为 0 时按帧平均累积；否则每帧以该权重与历史混合（与 BlendWithPreviousFrame 相同）
+// 参考图是蓝噪声在测量窗口之后 4 * frames 帧的平均；盘的动画时间固定，帧间只有抖动不同
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../core/cputracer.h"
+
+namespace {
+
+void renderFrame(CpuTracer& tracer, TraceParams params, JitterSequence jitter, int frame, float* rgba) {
+    params.jitter = jitter;
+    params.iFrame = 2 + frame;
+    tracer.render(params, rgba);
+}
+
+double rmse(const std::vector<float>& image, const std::vector<float>& reference) {
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < image.size(); i += 4) {
+        for (size_t c = 0; c < 3; ++c) {
+            const double error = double(image[i + c]) - double(reference[i + c]);
+            sum += error * error;
+            ++count;
+        }
+    }
+    return std::sqrt(sum / double(count));
+}
+
+// 每帧累积后的 RMSE，下标为已累积的帧数减一
+std::vector<double> convergence(CpuTracer& tracer, const TraceParams& params, JitterSequence jitter, int frames,
+                                float blend, const std::vector<float>& reference) {
+    std::vector<float> frame(reference.size());
+    std::vector<float> history(reference.size(), 0.0f);
+    std::vector<double> errors;
+    for (int i = 0; i < frames; ++i) {
+        renderFrame(tracer, params, jitter, i, frame.data());
+        const float weight = (i == 0 || blend <= 0.0f) ? 1.0f / float(i + 1) : blend;
+        for (size_t j = 0; j < history.size(); ++j) {
+            history[j] += weight * (frame[j] - history[j]);
+        }
+        errors.push_back(rmse(history, reference));
+    }
+    return errors;
+}
+
+int framesToConverge(const std::vector<double>& errors, double threshold) {
+    for (size_t i = 0; i < errors.size(); ++i) {
+        if (errors[i] < threshold) {
+            return int(i) + 1;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    TraceParams params;
+    params.width = argc > 2 ? std::atoi(argv[1]) : 160;
+    params.height = argc > 2 ? std::atoi(argv[2]) : 90;
+    const int frames = argc > 3 ? std::atoi(argv[3]) : 64;
+    params.backgroundType = argc > 4 ? std::atoi(argv[4]) : 0;
+    const float blend = argc > 5 ? float(std::atof(argv[5])) : 0.0f;
+    params.iTime = 3.0f;
+    params.iMouse = glsl::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    if (params.width <= 0 || params.height <= 0 || frames <= 0 || blend < 0.0f || blend > 1.0f) {
+        std::fprintf(stderr, "usage: %s [width height [frames [background [blend]]]]\n", argv[0]);
+        return 1;
+    }
+    CpuTracer tracer;
+    const size_t values = size_t(params.width) * params.height * 4;
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<float> reference(values, 0.0f);
+    std::vector<float> frame(values);
+    const int referenceFrames = 4 * frames;
+    for (int i = 0; i < referenceFrames; ++i) {
+        renderFrame(tracer, params, JitterSequence::BlueNoise, frames + i, frame.data());
+        for (size_t j = 0; j < values; ++j) {
+            reference[j] += frame[j] / float(referenceFrames);
+        }
+    }
+    const std::vector<double> white = convergence(tracer, params, JitterSequence::WhiteNoise, frames, blend, reference);
+    const std::vector<double> blue = convergence(tracer, params, JitterSequence::BlueNoise, frames, blend, reference);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%dx%d, background %d, %s, reference %d frames, %.1f s\n", params.width, params.height,
+                params.backgroundType, blend > 0.0f ? "exponential blend" : "running mean", referenceFrames, seconds);
+    if (blend > 0.0f) {
+        std::printf("blend weight %.3f\n", blend);
+    }
+    std::printf("%8s %14s %14s %8s\n", "frames", "white rmse", "blue rmse", "ratio");
+    for (int n = 1; n <= frames; n *= 2) {
+        std::printf("%8d %14.6f %14.6f %8.2f\n", n, white[size_t(n - 1)], blue[size_t(n - 1)],
+                    white[size_t(n - 1)] / blue[size_t(n - 1)]);
+    }
+    const double threshold = 0.25 * white[0];
+    const int whiteFrames = framesToConverge(white, threshold);
+    const int blueFrames = framesToConverge(blue, threshold);
+    std::printf("frames to rmse < %.6f: white %s%d, blue %s%d\n", threshold, whiteFrames < 0 ? ">" : "",
+                whiteFrames < 0 ? frames : whiteFrames, blueFrames < 0 ? ">" : "", blueFrames < 0 ? frames : blueFrames);
+    return 0;
+}
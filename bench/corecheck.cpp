@@ -0,0 +1,211 @@
+// blackhole-core 的自检（ctest 运行）：只用不依赖Qt和OpenGL的部分，检查各处注释里写明的等价关系
+//   DeflectionTable：表的取样与解析的 Schwarzschild 偏折一致，弱场极限、临界碰撞参数正确
+//   Arena：64字节对齐、互不重叠，溢出后 reset 合并为一整块
+//   WorkStealingPool：每个任务恰好执行一次
+//   CpuTracer：mortonOrder 是块的排列；多线程、各指令集的结果与单线程标量逐位一致
+// 用法：blackhole-corecheck，有检查失败时返回1
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../core/arena.h"
+#include "../core/cputracer.h"
+#include "../core/deflectiontable.h"
+#include "../core/workstealingpool.h"
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+// Rs = 1 时静止观察者在 r0 处以夹角 psi 发出的光线的碰撞参数
+double impactParameter(double r0, double psi) {
+    return r0 * std::sin(psi) / std::sqrt(1.0 - 1.0 / r0);
+}
+
+void checkDeflection() {
+    // 径向向外的光线不偏折，近心点就是出发点
+    const DeflectionSample outward = schwarzschildDeflection(10.0, 0.0, DeflectionTable::kDiskRadius);
+    check(!outward.captured && std::fabs(outward.sweep) < 1e-9 && std::fabs(outward.periapsis - 10.0) < 1e-9,
+          "radial outward ray");
+    check(schwarzschildDeflection(10.0, kPi, DeflectionTable::kDiskRadius).captured, "radial inward ray");
+
+    // 向内的光线在碰撞参数小于 3*sqrt(3)/2 时被吞噬
+    const double critical = 1.5 * std::sqrt(3.0);
+    for (double r0 : {2.0, 5.0, 40.0}) {
+        for (int i = 1; i < 64; ++i) {
+            const double psi = 0.5 * kPi + 0.5 * kPi * i / 64.0;
+            const double b = impactParameter(r0, psi);
+            if (std::fabs(b - critical) < 1e-3) {
+                continue;
+            }
+            const DeflectionSample sample = schwarzschildDeflection(r0, psi, DeflectionTable::kDiskRadius);
+            check(sample.captured == (b < critical), "capture at the critical impact parameter");
+            if (!sample.captured) {
+                // 近心点满足 p / sqrt(1 - 1/p) = b
+                check(std::fabs(sample.periapsis / std::sqrt(1.0 - 1.0 / sample.periapsis) - b) < 1e-6 * b,
+                      "periapsis matches the impact parameter");
+            }
+        }
+    }
+
+    // 弱场：从近心点到无穷远扫过 pi/2 + 1/b（Rs = 1 时总偏折角 2/b）
+    const double r0 = 2000.0;
+    const DeflectionSample tangent = schwarzschildDeflection(r0, 0.5 * kPi, DeflectionTable::kDiskRadius);
+    check(std::fabs(tangent.sweep - (0.5 * kPi + 1.0 / impactParameter(r0, 0.5 * kPi))) < 1e-6,
+          "weak-field deflection");
+
+    // 表的每个纹素就是该格点的解析解
+    const DeflectionTable table;
+    check(std::fabs(DeflectionTable::rowRadius(0) - DeflectionTable::kMinRadius) < 1e-4f &&
+              std::fabs(DeflectionTable::rowRadius(DeflectionTable::kRadiusCount - 1) - DeflectionTable::kMaxRadius) <
+                  1e-2f,
+          "table radius range");
+    for (int row = 0; row < table.height(); row += 17) {
+        for (int column = 0; column < table.width(); column += 97) {
+            const DeflectionSample sample = schwarzschildDeflection(
+                DeflectionTable::rowRadius(row), kPi * column / (table.width() - 1), DeflectionTable::kDiskRadius);
+            const float* texel = table.data() + (size_t(row) * table.width() + column) * 4;
+            const float inverse = sample.captured ? DeflectionTable::kCapturedMark : float(1.0 / sample.periapsis);
+            check(texel[0] == float(sample.sweep) && texel[1] == inverse && texel[2] == float(sample.enterDisk) &&
+                      texel[3] == float(sample.exitDisk),
+                  "table texel equals the analytic sample");
+        }
+    }
+}
+
+void checkArena() {
+    Arena arena(1024);
+    char* first = arena.allocate<char>(100);
+    char* second = arena.allocate<char>(10);
+    check(reinterpret_cast<uintptr_t>(first) % 64 == 0 && reinterpret_cast<uintptr_t>(second) % 64 == 0,
+          "arena allocations are 64-byte aligned");
+    check(second >= first + 100, "arena allocations do not overlap");
+    std::memset(first, 1, 100);
+    std::memset(second, 2, 10);
+    check(first[99] == 1, "arena allocations keep their contents");
+
+    // 溢出：单独成块，reset 后容量扩到总需求，同样的请求全部落在一整块里
+    arena.reset();
+    float* a = arena.allocate<float>(200);
+    float* b = arena.allocate<float>(200);
+    check(reinterpret_cast<char*>(b) < reinterpret_cast<char*>(a) ||
+              reinterpret_cast<char*>(b) >= reinterpret_cast<char*>(a + 200),
+          "spilled allocation is separate");
+    arena.reset();
+    a = arena.allocate<float>(200);
+    b = arena.allocate<float>(200);
+    check(reinterpret_cast<char*>(b) == reinterpret_cast<char*>(a) + 832, "reset merges spilled blocks");
+
+    Arena moved(std::move(arena));
+    moved.reset();
+    check(moved.allocate<float>(200) == a, "moved arena keeps its block");
+    check(arena.allocate<char>(8) != nullptr, "moved-from arena is still usable");
+}
+
+void checkPool() {
+    WorkStealingPool pool(4);
+    check(pool.threadCount() == 4, "pool thread count");
+    for (int round = 0; round < 20; ++round) {
+        const int count = 1 + round * 37;
+        std::vector<int> order(static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i) {
+            order[size_t(i)] = count - 1 - i;
+        }
+        std::vector<std::atomic<int>> runs(static_cast<size_t>(count));
+        std::atomic<bool> badWorker{false};
+        pool.run(order, [&](int index, int worker) {
+            // 任务耗时差异很大，促使空闲线程窃取
+            volatile double sink = 0.0;
+            for (int i = 0; i < (index % 7 == 0 ? 20000 : 10); ++i) {
+                sink = sink + std::sqrt(double(i));
+            }
+            runs[size_t(index)].fetch_add(1);
+            if (worker < 0 || worker >= 4) {
+                badWorker = true;
+            }
+        });
+        bool once = true;
+        for (const std::atomic<int>& run : runs) {
+            once = once && run.load() == 1;
+        }
+        check(once, "every pool task runs exactly once");
+        check(!badWorker, "pool worker index in range");
+    }
+    pool.run({}, [](int, int) {});
+}
+
+void checkMorton() {
+    check(CpuTracer::mortonOrder(2, 2) == std::vector<int>({0, 1, 2, 3}), "2x2 Morton order");
+    const std::vector<int> order = CpuTracer::mortonOrder(4, 4);
+    check(std::vector<int>(order.begin(), order.begin() + 4) == std::vector<int>({0, 1, 4, 5}),
+          "4x4 Morton order starts with the first quad");
+    const int sizes[][2] = {{1, 1}, {3, 5}, {8, 8}, {17, 4}, {1, 9}};
+    for (const auto& size : sizes) {
+        const std::vector<int> tiles = CpuTracer::mortonOrder(size[0], size[1]);
+        std::vector<int> seen(size_t(size[0]) * size[1], 0);
+        bool permutation = tiles.size() == seen.size();
+        for (int tile : tiles) {
+            permutation = permutation && tile >= 0 && size_t(tile) < seen.size() && seen[size_t(tile)]++ == 0;
+        }
+        check(permutation, "Morton order is a permutation of the tiles");
+    }
+}
+
+void checkTracer() {
+    TraceParams params;
+    params.width = 96;
+    params.height = 54;
+    params.iTime = 3.0f;
+    params.iFrame = 2;
+    params.iMouse = glsl::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    const size_t values = size_t(params.width) * params.height * 4;
+
+    CpuTracer reference(1);
+    reference.setSimdIsa(SimdIsa::Scalar);
+    reference.setTileSize(16);
+    std::vector<float> expected(values);
+    reference.render(params, expected.data());
+
+    const SimdIsa isas[] = {SimdIsa::Scalar, SimdIsa::Sse2, SimdIsa::Avx2, SimdIsa::Avx512};
+    for (SimdIsa isa : isas) {
+        if (!simdIsaSupported(isa)) {
+            continue;
+        }
+        CpuTracer tracer(4);
+        tracer.setSimdIsa(isa);
+        tracer.setTileSize(16);
+        std::vector<float> image(values);
+        tracer.render(params, image.data());
+        if (std::memcmp(image.data(), expected.data(), values * sizeof(float)) != 0) {
+            std::fprintf(stderr, "FAIL: %s on 4 threads differs from scalar on 1 thread\n", simdIsaName(isa));
+            ++failures;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    checkDeflection();
+    checkArena();
+    checkPool();
+    checkMorton();
+    checkTracer();
+    if (failures > 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("core checks passed\n");
+    return 0;
+}
@@ -0,0 +1,301 @@
+// circle.frag 移植函数的微基准：逐个函数报告 ns/op、吞吐量，以及与 double 实例相比的误差
+// 用法：blackhole-mathbench [--filter 名称片段] [--min-time 秒] [--count 每轮输入数] [--csv]
+// 想比较候选的更快写法时，在 cases 里加一项同名带后缀的条目即可
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "../core/emissiontables.h"
+#include "../core/shadermath.h"
+
+using glsl::tvec2;
+using glsl::tvec3;
+
+namespace {
+
+// 一个基准项：run 对第 i 个输入做一次运算并把结果写进 out（float精度），
+// reference 对同一输入用 double 计算；width 为每次运算输出的分量数
+struct BenchCase {
+    const char* name;
+    int width;
+    std::function<void(int i, float* out)> run;
+    std::function<void(int i, double* out)> reference;
+};
+
+struct BenchResult {
+    double nanoseconds = 0.0;
+    double maxError = 0.0;
+    double meanError = 0.0;
+    double maxRelativeError = 0.0;
+};
+
+volatile float sink;
+
+BenchResult measure(const BenchCase& bench, int count, double minSeconds) {
+    BenchResult result;
+    std::vector<float> out(size_t(bench.width));
+    std::vector<double> ref(size_t(bench.width));
+
+    // 精度：逐个输入与double参考比较
+    double errorSum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        bench.run(i, out.data());
+        bench.reference(i, ref.data());
+        for (int c = 0; c < bench.width; ++c) {
+            const double error = std::fabs(double(out[size_t(c)]) - ref[size_t(c)]);
+            result.maxError = std::max(result.maxError, error);
+            errorSum += error;
+            if (std::fabs(ref[size_t(c)]) > 1e-30) {
+                result.maxRelativeError = std::max(result.maxRelativeError, error / std::fabs(ref[size_t(c)]));
+            }
+        }
+    }
+    result.meanError = errorSum / (double(count) * bench.width);
+
+    // 耗时：整轮重复到超过 minSeconds，取平均
+    long long operations = 0;
+    float accumulator = 0.0f;
+    const auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        for (int i = 0; i < count; ++i) {
+            bench.run(i, out.data());
+            accumulator += out[0];
+        }
+        operations += count;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    sink = accumulator;
+    result.nanoseconds = elapsed * 1.0e9 / double(operations);
+    return result;
+}
+
+tvec3<double> toDouble(const tvec3<float>& v) {
+    return tvec3<double>(v.x, v.y, v.z);
+}
+
+tvec2<double> toDouble(const tvec2<float>& v) {
+    return tvec2<double>(v.x, v.y);
+}
+
+void store(const tvec3<float>& v, float* out) {
+    out[0] = v.x;
+    out[1] = v.y;
+    out[2] = v.z;
+}
+
+void store(const tvec3<double>& v, double* out) {
+    out[0] = v.x;
+    out[1] = v.y;
+    out[2] = v.z;
+}
+
+// 与着色器的 EmissionTableRow 相同：x 夹到 [0, 1]，行内线性插值
+void emissionRow(const EmissionTables& tables, int row, float x, float* texel) {
+    const float position = std::min(std::max(x, 0.0f), 1.0f) * float(tables.width() - 1);
+    const int left = std::min(int(position), tables.width() - 2);
+    const float t = position - float(left);
+    const float* data = tables.data() + (size_t(row) * size_t(tables.width()) + size_t(left)) * 4;
+    for (int c = 0; c < 4; ++c) {
+        texel[c] = data[c] + t * (data[c + 4] - data[c]);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    double minSeconds = 0.2;
+    int count = 4096;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minSeconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter name] [--min-time seconds] [--count inputs] [--csv]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // 输入取着色器中实际出现的量级：默认质量下 Rs 约 4.7e-6 光年，盘外半径 12 Rs
+    const float rs = 2.0f * 1.49e7f * circle::kGravityConstant / circle::kSpeedOfLight / circle::kSpeedOfLight *
+                     circle::kSolarMass / circle::kLightYear;
+    const float outerRadius = 12.0f * rs;
+    const tvec3<float> blackHolePos(0.0f, 0.0f, -5.0f * rs);
+    const tvec3<float> worldUp(0.0f, 1.0f, 0.0f);
+    const tvec3<float> diskNormal = glsl::normalize(tvec3<float>(0.2f, 1.0f, 0.0f));
+    const DiskParameters disk = diskParameters(1.49e7f, 0.0f);
+    const EmissionTables emission(disk);
+    const float innerRatio = disk.interRadius / disk.rs;
+
+    std::mt19937 random(20240601);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> symmetric(-1.0f, 1.0f);
+    const size_t inputs = size_t(count);
+    std::vector<tvec3<float>> noisePositions(inputs);
+    std::vector<tvec3<float>> diskPositions(inputs);
+    std::vector<float> kelvins(inputs);
+    std::vector<float> shapeInputs(inputs);
+    std::vector<float> diskRadii(inputs);   // 内外缘之间，以Rs为单位
+    std::vector<tvec2<float>> thetaA(inputs);
+    std::vector<tvec2<float>> thetaB(inputs);
+    std::vector<tvec3<float>> rayPositions(inputs);
+    std::vector<tvec3<float>> rayDirections(inputs);
+    for (int i = 0; i < count; ++i) {
+        noisePositions[size_t(i)] = tvec3<float>(20.0f * symmetric(random), 12.0f * unit(random), 10.0f * symmetric(random));
+        diskPositions[size_t(i)] = tvec3<float>(10.0f * symmetric(random), 3.0f + 9.0f * unit(random), symmetric(random));
+        kelvins[size_t(i)] = 300.0f + 99700.0f * unit(random) * unit(random);
+        shapeInputs[size_t(i)] = 0.5f + 0.5f * unit(random);
+        diskRadii[size_t(i)] = innerRatio + (12.0f - innerRatio) * unit(random);
+        thetaA[size_t(i)] = tvec2<float>(symmetric(random), symmetric(random));
+        thetaB[size_t(i)] = tvec2<float>(symmetric(random), symmetric(random));
+        // 黑洞附近 1 ~ 30 Rs 处的光线
+        const tvec3<float> offset = glsl::normalize(tvec3<float>(symmetric(random), symmetric(random), symmetric(random)));
+        rayPositions[size_t(i)] = blackHolePos + offset * ((1.0f + 29.0f * unit(random)) * rs);
+        rayDirections[size_t(i)] = glsl::normalize(tvec3<float>(symmetric(random), symmetric(random), symmetric(random)));
+    }
+
+    // 每帧算一次的黑洞系三轴（BlackHoleKernel 的做法），与着色器逐次构造的写法对比
+    const tvec3<float> spaceY = glsl::normalize(diskNormal);
+    const tvec3<float> spaceZ = glsl::normalize(glsl::cross(worldUp, spaceY));
+    const tvec3<float> spaceX = glsl::normalize(glsl::cross(spaceY, spaceZ));
+
+    // 噪声的格点值取自 NoiseVolume 的整数哈希，float与double实例的格点值相同，误差列只反映插值精度
+    const std::vector<BenchCase> cases = {
+        {"PerlinNoise", 1,
+         [&](int i, float* out) { out[0] = circle::perlinNoise(noisePositions[size_t(i)]); },
+         [&](int i, double* out) { out[0] = circle::perlinNoise(toDouble(noisePositions[size_t(i)])); }},
+        {"GenerateAccretionDiskNoise(1,3)", 1,
+         [&](int i, float* out) { out[0] = circle::accretionDiskNoise(diskPositions[size_t(i)], 1, 3, 80.0f); },
+         [&](int i, double* out) { out[0] = circle::accretionDiskNoise(toDouble(diskPositions[size_t(i)]), 1, 3, 80.0); }},
+        {"GenerateAccretionDiskNoise(0,6)", 1,
+         [&](int i, float* out) { out[0] = circle::accretionDiskNoise(diskPositions[size_t(i)], 0, 6, 80.0f); },
+         [&](int i, double* out) { out[0] = circle::accretionDiskNoise(toDouble(diskPositions[size_t(i)]), 0, 6, 80.0); }},
+        {"KelvinToRgb", 3,
+         [&](int i, float* out) { store(circle::kelvinToRgb(kelvins[size_t(i)]), out); },
+         [&](int i, double* out) { store(circle::kelvinToRgb(double(kelvins[size_t(i)])), out); }},
+        // 查表的误差相对 double 公式，包含取样间隔带来的插值误差
+        {"KelvinToRgb/table", 3,
+         [&](int i, float* out) {
+             const float inverse = 1.0f / kelvins[size_t(i)];
+             float texel[4];
+             emissionRow(emission, 0, (inverse - 1.0f / EmissionTables::kMaxKelvin) /
+                                      (1.0f / EmissionTables::kMinKelvin - 1.0f / EmissionTables::kMaxKelvin), texel);
+             out[0] = texel[0];
+             out[1] = texel[1];
+             out[2] = texel[2];
+         },
+         [&](int i, double* out) { store(circle::kelvinToRgb(double(kelvins[size_t(i)])), out); }},
+        {"Vec2ToTheta", 1,
+         [&](int i, float* out) { out[0] = circle::vec2ToTheta(thetaA[size_t(i)], thetaB[size_t(i)]); },
+         [&](int i, double* out) { out[0] = circle::vec2ToTheta(toDouble(thetaA[size_t(i)]), toDouble(thetaB[size_t(i)])); }},
+        {"Shape", 1,
+         [&](int i, float* out) { out[0] = circle::shape(shapeInputs[size_t(i)], 4.0f, 0.9f); },
+         [&](int i, double* out) { out[0] = circle::shape(double(shapeInputs[size_t(i)]), 4.0, 0.9); }},
+        // 盘剖面：Shape(EffectiveRadius)、盘温度、降温因子，输入为内外缘之间的半径
+        {"DiskProfile", 3,
+         [&](int i, float* out) {
+             const float r = diskRadii[size_t(i)];
+             out[0] = circle::shape(circle::diskEffectiveRadius(r, 1.0f, innerRatio, 12.0f), 4.0f, 0.9f);
+             out[1] = std::pow(disk.diskA * std::pow(std::max(1.0f / r, 0.10f), 3.0f) *
+                               std::max(1.0f - std::sqrt(innerRatio / r), 0.000001f), 0.25f);
+             out[2] = std::exp((r - innerRatio) / (0.6f * (12.0f - innerRatio)));
+         },
+         [&](int i, double* out) {
+             const double r = diskRadii[size_t(i)];
+             out[0] = circle::shape(circle::diskEffectiveRadius(r, 1.0, double(innerRatio), 12.0), 4.0, 0.9);
+             out[1] = std::pow(double(disk.diskA) * std::pow(std::max(1.0 / r, 0.10), 3.0) *
+                               std::max(1.0 - std::sqrt(double(innerRatio) / r), 0.000001), 0.25);
+             out[2] = std::exp((r - double(innerRatio)) / (0.6 * (12.0 - double(innerRatio))));
+         }},
+        {"DiskProfile/table", 3,
+         [&](int i, float* out) {
+             float profile[4];
+             float motion[4];
+             const float x = (diskRadii[size_t(i)] - innerRatio) / (12.0f - innerRatio);
+             emissionRow(emission, 1, x, profile);
+             emissionRow(emission, 2, x, motion);
+             out[0] = profile[0];
+             out[1] = std::sqrt(std::sqrt(profile[2]));
+             out[2] = motion[0];
+         },
+         [&](int i, double* out) {
+             const double r = diskRadii[size_t(i)];
+             out[0] = circle::shape(circle::diskEffectiveRadius(r, 1.0, double(innerRatio), 12.0), 4.0, 0.9);
+             out[1] = std::pow(double(disk.diskA) * std::pow(std::max(1.0 / r, 0.10), 3.0) *
+                               std::max(1.0 - std::sqrt(double(innerRatio) / r), 0.000001), 0.25);
+             out[2] = std::exp((r - double(innerRatio)) / (0.6 * (12.0 - double(innerRatio))));
+         }},
+        {"WorldToBlackHoleSpace", 3,
+         [&](int i, float* out) {
+             store(circle::worldToBlackHoleSpace(rayPositions[size_t(i)], blackHolePos, diskNormal, worldUp), out);
+         },
+         [&](int i, double* out) {
+             store(circle::worldToBlackHoleSpace(toDouble(rayPositions[size_t(i)]), toDouble(blackHolePos),
+                                                 toDouble(diskNormal), toDouble(worldUp)), out);
+         }},
+        {"WorldToBlackHoleSpace/frame-axes", 3,
+         [&](int i, float* out) {
+             const tvec3<float> p = rayPositions[size_t(i)] - blackHolePos;
+             store(tvec3<float>(glsl::dot(spaceX, p), glsl::dot(spaceY, p), glsl::dot(spaceZ, p)), out);
+         },
+         [&](int i, double* out) {
+             store(circle::worldToBlackHoleSpace(toDouble(rayPositions[size_t(i)]), toDouble(blackHolePos),
+                                                 toDouble(diskNormal), toDouble(worldUp)), out);
+         }},
+        // 一整步：到黑洞的距离、单位方向和 geodesicStep，输出新位置（以Rs为单位）和新方向
+        {"GeodesicStep", 6,
+         [&](int i, float* out) {
+             tvec3<float> pos = rayPositions[size_t(i)];
+             tvec3<float> dir = rayDirections[size_t(i)];
+             const tvec3<float> toHole = pos - blackHolePos;
+             const float distance = glsl::length(toHole);
+             circle::geodesicStep(&pos, &dir, toHole / distance, distance, 1.0f, rs, outerRadius);
+             store((pos - blackHolePos) / rs, out);
+             store(dir, out + 3);
+         },
+         [&](int i, double* out) {
+             tvec3<double> pos = toDouble(rayPositions[size_t(i)]);
+             tvec3<double> dir = toDouble(rayDirections[size_t(i)]);
+             const tvec3<double> hole = toDouble(blackHolePos);
+             const tvec3<double> toHole = pos - hole;
+             const double distance = glsl::length(toHole);
+             circle::geodesicStep(&pos, &dir, toHole / distance, distance, 1.0, double(rs), double(outerRadius));
+             store((pos - hole) / double(rs), out);
+             store(dir, out + 3);
+         }},
+    };
+
+    if (csv) {
+        std::printf("name,ns_per_op,mops_per_s,max_abs_error,mean_abs_error,max_rel_error\n");
+    } else {
+        std::printf("%-34s %10s %10s %12s %12s %12s\n", "function", "ns/op", "Mops/s", "max abs err", "mean abs err",
+                    "max rel err");
+    }
+    for (const BenchCase& bench : cases) {
+        if (!filter.empty() && std::string(bench.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        const BenchResult result = measure(bench, count, minSeconds);
+        if (csv) {
+            std::printf("%s,%.3f,%.3f,%.6g,%.6g,%.6g\n", bench.name, result.nanoseconds, 1.0e3 / result.nanoseconds,
+                        result.maxError, result.meanError, result.maxRelativeError);
+        } else {
+            std::printf("%-34s %10.2f %10.2f %12.4g %12.4g %12.4g\n", bench.name, result.nanoseconds,
+                        1.0e3 / result.nanoseconds, result.maxError, result.meanError, result.maxRelativeError);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// 包内核基准：单线程逐行渲染同一帧，报告每核 rays·steps/s，并与标量结果逐位比较
+// 用法：blackhole-bench [width height [repeats [background]]]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "../core/packetkernel.h"
+
+namespace {
+
+struct BenchResult {
+    double seconds = 0.0;
+    uint64_t steps = 0;
+};
+
+BenchResult renderFrame(SimdIsa isa, const BlackHoleKernel& kernel, int width, int height, int repeats,
+                        float* rgba, int* steps) {
+    BenchResult result;
+    const auto start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+        for (int y = 0; y < height; ++y) {
+            shadeRow(isa, kernel, 0, y, width, rgba + size_t(y) * width * 4, steps + size_t(y) * width);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (int i = 0; i < width * height; ++i) {
+        result.steps += uint64_t(steps[i]);
+    }
+    result.steps *= uint64_t(repeats);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    TraceParams params;
+    params.width = argc > 2 ? std::atoi(argv[1]) : 480;
+    params.height = argc > 2 ? std::atoi(argv[2]) : 270;
+    const int repeats = argc > 3 ? std::atoi(argv[3]) : 1;
+    params.backgroundType = argc > 4 ? std::atoi(argv[4]) : 1;
+    params.iTime = 3.0f;
+    params.iFrame = 1;
+    params.iMouse = glsl::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    if (params.width <= 0 || params.height <= 0 || repeats <= 0) {
+        std::fprintf(stderr, "usage: %s [width height [repeats [background]]]\n", argv[0]);
+        return 1;
+    }
+    const BlackHoleKernel kernel(params);
+    const size_t pixels = size_t(params.width) * params.height;
+
+    std::vector<float> reference(pixels * 4);
+    std::vector<int> referenceSteps(pixels);
+    const BenchResult scalar = renderFrame(SimdIsa::Scalar, kernel, params.width, params.height, repeats,
+                                           reference.data(), referenceSteps.data());
+    const double scalarRate = double(scalar.steps) / scalar.seconds;
+    std::printf("%dx%d, %d repeats, %.1f steps per ray\n", params.width, params.height, repeats,
+                double(scalar.steps) / double(pixels) / repeats);
+    std::printf("%-8s %5s %10s %16s %8s %10s\n", "isa", "width", "ms", "rays*steps/s", "speedup", "mismatch");
+    std::printf("%-8s %5d %10.1f %16.4g %8.2f %10d\n", simdIsaName(SimdIsa::Scalar), 1, scalar.seconds * 1.0e3,
+                scalarRate, 1.0, 0);
+
+    bool exact = true;
+    std::vector<float> rgba(pixels * 4);
+    std::vector<int> steps(pixels);
+    for (SimdIsa isa : {SimdIsa::Sse2, SimdIsa::Avx2, SimdIsa::Avx512}) {
+        if (!simdIsaSupported(isa)) {
+            std::printf("%-8s %5d %10s\n", simdIsaName(isa), simdWidth(isa), "unsupported");
+            continue;
+        }
+        const BenchResult result = renderFrame(isa, kernel, params.width, params.height, repeats,
+                                               rgba.data(), steps.data());
+        // 按位比较：包内核与标量路径的运算顺序相同，不应有任何差异
+        int mismatch = 0;
+        for (size_t i = 0; i < pixels; ++i) {
+            if (steps[i] != referenceSteps[i] ||
+                std::memcmp(&rgba[i * 4], &reference[i * 4], sizeof(float) * 4) != 0) {
+                ++mismatch;
+            }
+        }
+        exact = exact && mismatch == 0;
+        const double rate = double(result.steps) / result.seconds;
+        std::printf("%-8s %5d %10.1f %16.4g %8.2f %10d\n", simdIsaName(isa), simdWidth(isa), result.seconds * 1.0e3,
+                    rate, rate / scalarRate, mismatch);
+    }
+    return exact ? 0 : 1;
+}
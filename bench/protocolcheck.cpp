@@ -0,0 +1,174 @@
+// 离线渲染工具文件和消息格式的自检（ctest 运行），不需要OpenGL上下文
+//   LensingMapFile::open：拒绝错误的 magic、版本、平面布局和被截断的文件
+//   RenderConnection：分段到达和合并到达的消息按帧拆出；长度为0或超过 kMaxMessage 时关闭连接并丢弃之后的数据
+// 用法：blackhole-protocolcheck，有检查失败时返回1
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPair>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <cstdio>
+#include <functional>
+#include "../render/lensingmap.h"
+#include "../render/renderprotocol.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+// 用 patch 修改一份合法文件的头部（或截断文件）后再打开
+bool openPatched(const QString& path, const std::function<void(LensingMapHeader&)>& patch, qint64 size = -1) {
+    LensingMapFile map;
+    if (!map.create(path, 16, 8, BlackHoleFrameState())) {
+        return true;   // 无法生成文件时让调用方的检查失败
+    }
+    map.close();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return true;
+    }
+    LensingMapHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    patch(header);
+    file.seek(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (size >= 0) {
+        file.resize(size);
+    }
+    file.close();
+    return map.open(path);
+}
+
+void checkLensingMap(const QString& dir) {
+    const QString path = QDir(dir).filePath("map.bhlmap");
+    const auto keep = [](LensingMapHeader&) {};
+    check(openPatched(path, keep), "valid lensing map opens");
+    check(!openPatched(path, [](LensingMapHeader& h) { h.magic[0] = 'X'; }), "lensing map magic");
+    check(!openPatched(path, [](LensingMapHeader& h) { h.version = kLensingMapVersion + 1; }), "lensing map version");
+    check(!openPatched(path, [](LensingMapHeader& h) { h.headerBytes = 0; }), "lensing map header size");
+    check(!openPatched(path, [](LensingMapHeader& h) { h.width = 0; }), "lensing map zero width");
+    check(!openPatched(path, [](LensingMapHeader& h) { h.planeCount = 1; }), "lensing map plane count");
+    check(!openPatched(path, [](LensingMapHeader& h) { h.planeOffset = 0; }), "lensing map plane offset");
+    check(!openPatched(path, [](LensingMapHeader& h) { h.planeStride = 16; }), "lensing map plane stride");
+    check(!openPatched(path, [](LensingMapHeader& h) { h.height = 4096; }), "lensing map larger than the file");
+    check(!openPatched(path, keep, qint64(sizeof(LensingMapHeader)) + 64), "truncated lensing map");
+    check(!openPatched(path, keep, 16), "lensing map shorter than its header");
+
+    LensingMapFile missing;
+    check(!missing.open(QDir(dir).filePath("missing.bhlmap")) && !missing.errorString().isEmpty(),
+          "missing lensing map reports an error");
+}
+
+// 一条连接：client 写入原始字节，connection 在服务端按帧解析
+struct ConnectionPair {
+    QLocalSocket client;
+    RenderConnection* connection = nullptr;
+    QList<QPair<quint8, QByteArray>> messages;
+    bool closed = false;
+
+    bool open(QLocalServer& server) {
+        client.connectToServer(server.fullServerName());
+        if (!client.waitForConnected(2000) || !server.waitForNewConnection(2000)) {
+            return false;
+        }
+        connection = new RenderConnection(server.nextPendingConnection());
+        QObject::connect(connection, &RenderConnection::messageReceived, [this](quint8 type, const QByteArray& payload) {
+            messages.append(qMakePair(type, payload));
+        });
+        QObject::connect(connection, &RenderConnection::closed, [this]() { closed = true; });
+        return true;
+    }
+    ~ConnectionPair() { delete connection; }
+
+    void write(const QByteArray& bytes) {
+        client.write(bytes);
+        client.flush();
+        client.waitForBytesWritten(2000);
+    }
+
+    // 处理事件直到 done 成立或超时
+    bool pump(const std::function<bool()>& done, int timeoutMs = 2000) {
+        QElapsedTimer timer;
+        timer.start();
+        while (!done() && timer.elapsed() < timeoutMs) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 20);
+        }
+        return done();
+    }
+};
+
+QByteArray frame(quint32 length, quint8 type, const QByteArray& payload) {
+    QByteArray bytes(4, '\0');
+    qToBigEndian<quint32>(length, reinterpret_cast<uchar*>(bytes.data()));
+    bytes.append(char(type));
+    bytes.append(payload);
+    return bytes;
+}
+
+void checkConnection() {
+    QLocalServer server;
+    const QString name = QString("blackhole-protocolcheck-%1").arg(QCoreApplication::applicationPid());
+    QLocalServer::removeServer(name);
+    if (!server.listen(name)) {
+        check(false, "local server listens");
+        return;
+    }
+
+    {
+        ConnectionPair pair;
+        check(pair.open(server), "connection opens");
+        // 一条消息分三段到达，随后两条消息合并到达
+        const QByteArray first = frame(6, RenderProtocol::Work, "hello");
+        pair.write(first.left(3));
+        check(!pair.pump([&] { return !pair.messages.isEmpty(); }, 100), "incomplete message is held back");
+        pair.write(first.mid(3, 4));
+        pair.write(first.mid(7));
+        pair.write(frame(1, RenderProtocol::Shutdown, QByteArray()) + frame(3, RenderProtocol::WorkDone, "ab"));
+        check(pair.pump([&] { return pair.messages.size() == 3; }), "split and merged messages arrive");
+        check(pair.messages.size() == 3 && pair.messages[0].first == RenderProtocol::Work &&
+                  pair.messages[0].second == "hello" && pair.messages[1].first == RenderProtocol::Shutdown &&
+                  pair.messages[1].second.isEmpty() && pair.messages[2].second == "ab",
+              "message types and payloads");
+        check(!pair.closed, "valid messages keep the connection open");
+    }
+
+    const quint32 invalidLengths[] = {0, RenderProtocol::kMaxMessage + 1};
+    for (quint32 length : invalidLengths) {
+        ConnectionPair pair;
+        check(pair.open(server), "connection opens");
+        // 非法长度之后即使跟着合法消息也不再解析
+        pair.write(frame(length, RenderProtocol::Work, "x") + frame(1, RenderProtocol::Shutdown, QByteArray()));
+        check(pair.pump([&] { return pair.closed; }), "invalid length closes the connection");
+        check(pair.messages.isEmpty(), "nothing is parsed after an invalid length");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "Cannot create a temporary directory\n");
+        return 1;
+    }
+    checkLensingMap(dir.path());
+    checkConnection();
+    if (failures > 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("protocol checks passed\n");
+    return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// 线程私有的线性分配器：每块开始时 reset，块内的临时缓冲只移动指针，不走全局堆
+// 容量不足时追加新块，reset 后合并为一整块，稳定后不再分配
+class Arena {
+public:
+    explicit Arena(size_t initialBytes = 1 << 20) : capacity(initialBytes) {}
+    ~Arena() { freeBlocks(); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&& other) noexcept
+        : blocks(std::move(other.blocks)), capacity(other.capacity), used(other.used), spilled(other.spilled) {
+        other.blocks.clear();
+        other.used = 0;
+        other.spilled = 0;
+    }
+
+    template <typename T>
+    T* allocate(size_t count) {
+        const size_t bytes = (count * sizeof(T) + kAlignment - 1) / kAlignment * kAlignment;
+        if (blocks.empty()) {
+            blocks.push_back(allocateBlock(capacity));
+        }
+        if (used + bytes > capacity) {
+            // 溢出的请求单独成块，下次 reset 时把容量扩到总需求
+            spilled += bytes;
+            blocks.push_back(allocateBlock(bytes));
+            return static_cast<T*>(blocks.back());
+        }
+        void* ptr = static_cast<char*>(blocks.front()) + used;
+        used += bytes;
+        return static_cast<T*>(ptr);
+    }
+
+    void reset() {
+        if (spilled > 0) {
+            const size_t total = capacity + spilled;
+            freeBlocks();
+            capacity = total;
+            spilled = 0;
+        }
+        used = 0;
+    }
+
+private:
+    static constexpr size_t kAlignment = 64;   // 缓存行对齐，避免相邻线程伪共享
+
+    static void* allocateBlock(size_t bytes) {
+        void* ptr = std::aligned_alloc(kAlignment, (bytes + kAlignment - 1) / kAlignment * kAlignment);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void freeBlocks() {
+        for (void* block : blocks) {
+            std::free(block);
+        }
+        blocks.clear();
+    }
+
+    std::vector<void*> blocks;   // blocks[0] 为主块，其后为溢出块
+    size_t capacity;
+    size_t used = 0;
+    size_t spilled = 0;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,309 @@
+#include "blackholekernel.h"
+#include <cmath>
+#include "bluenoise.h"
+#include "shadermath.h"
+
+using namespace glsl;
+using namespace circle;
+
+namespace {
+
+// 按着色器原先的 GetCamera / GetCameraRot 构造相机系三轴
+void cameraFrame(const TraceParams& p, vec3* campos, vec3* x, vec3* y, vec3* z) {
+    float theta = 4.0f * kPi * p.iMouse.x / float(p.width);
+    float phi = 0.999f * kPi * p.iMouse.y / float(p.height) + 0.0005f;
+    if (p.iFrame < 2) {
+        theta = 4.0f * kPi * 0.45f;
+        phi = 0.999f * kPi * 0.55f + 0.0005f;
+    }
+    const float r = p.cameraRadius;
+    const vec3 reposcam(r * std::sin(phi) * std::cos(theta), -r * std::cos(phi), -r * std::sin(phi) * std::sin(theta));
+    *campos = reposcam;
+    *x = normalize(cross(vec3(0.0f, 1.0f, 0.0f), reposcam));
+    *y = normalize(cross(reposcam, *x));
+    *z = normalize(reposcam);
+}
+
+inline vec3 rotateInto(const vec3& v, const vec3& x, const vec3& y, const vec3& z) {
+    return vec3(dot(x, v), dot(y, v), dot(z, v));
+}
+
+} // namespace
+
+DiskParameters diskParameters(float blackHoleMass, float spin) {
+    const float mass = blackHoleMass;
+    const float a0 = spin;
+    DiskParameters disk;
+    disk.rs = 2.0f * mass * kGravityConstant / kSpeedOfLight / kSpeedOfLight * kSolarMass;
+    const float z1 = 1.0f + std::pow(1.0f - a0 * a0, 0.333333333333333f) *
+                     (std::pow(1.0f + a0, 0.333333333333333f) + std::pow(1.0f - a0, 0.333333333333333f));
+    const float rmsRatio = (3.0f + std::sqrt(3.0f * a0 * a0 + z1 * z1) -
+                            std::sqrt((3.0f - z1) * (3.0f + z1 + 2.0f * std::sqrt(3.0f * a0 * a0 + z1 * z1)))) / 2.0f;
+    const float accEff = std::sqrt(1.0f - 1.0f / max(rmsRatio, 1.5f));
+    const float mu = 1.0f;
+    const float dmdtEdd = 6.327f * mu / kSpeedOfLight / kSpeedOfLight * mass * kSolarMass / accEff;
+    const float dmdt = 2e-6f * dmdtEdd;
+    disk.diskA = 3.0f * kGravityConstant * kSolarMass / disk.rs / disk.rs / disk.rs * mass * dmdt / (8.0f * kPi * kSigma);
+    disk.quadraticedPeakTemperature = disk.diskA * 0.05665278f;
+
+    disk.rs = disk.rs / kLightYear;
+    disk.interRadius = 0.7f * rmsRatio * disk.rs;
+    disk.outerRadius = 12.0f * disk.rs;
+    return disk;
+}
+
+BlackHoleKernel::BlackHoleKernel(const TraceParams& p)
+    : params(p), resolution(float(p.width), float(p.height)) {
+    const DiskParameters disk = diskParameters(p.blackHoleMass, 0.0f);
+    k.rs = disk.rs;
+    k.interRadius = disk.interRadius;
+    k.outerRadius = disk.outerRadius;
+    k.diskA = disk.diskA;
+    k.quadraticedPeakTemperature = disk.quadraticedPeakTemperature;
+
+    vec3 campos, camX, camY, camZ;
+    cameraFrame(p, &campos, &camX, &camY, &camZ);
+    k.cameraX = camX;
+    k.cameraY = camY;
+    k.cameraZ = camZ;
+    const vec3 worldUp = rotateInto(vec3(0.0f, 1.0f, 0.0f), camX, camY, camZ);
+    k.blackHolePos = rotateInto(vec3(0.0f, 0.0f, 5.0f * k.rs) - campos, camX, camY, camZ);
+    vec3 diskNormal = rotateInto(normalize(p.diskNormal), camX, camY, camZ);
+
+    // 到黑洞系的旋转只依赖每帧常量
+    if (diskNormal == worldUp) {
+        diskNormal += 0.0001f * vec3(1.0f, 0.0f, 0.0f);
+    }
+    k.diskY = normalize(diskNormal);
+    k.diskZ = normalize(cross(worldUp, k.diskY));
+    k.diskX = normalize(cross(k.diskY, k.diskZ));
+    // 相机位于相机系原点，在黑洞系中到黑洞的距离即 |blackHolePos|
+    k.cameraRedshift = std::sqrt(max(1.0f - k.rs / length(k.blackHolePos), 0.000001f));
+    k.slabStepFraction = kSlabStepFraction;
+}
+
+vec4 BlackHoleKernel::diskColor(const vec4& baseColor, float stepLength, const vec3& rayPos, const vec3& rayDir) const {
+    const vec3 posOnDisk = rotateInto(rayPos - k.blackHolePos, k.diskX, k.diskY, k.diskZ);
+    const vec3 dirOnDisk = rotateInto(rayDir, k.diskX, k.diskY, k.diskZ);
+    const float iTime = params.iTime;
+
+    const float posR = length(posOnDisk.zx());
+    const float posY = posOnDisk.y;
+
+    vec4 color(0.0f);
+    if (std::fabs(posY) < 0.5f * k.rs && posR < k.outerRadius && posR > k.interRadius) {
+        float effectiveRadius = 1.0f - ((posR - k.interRadius) / (k.outerRadius - k.interRadius) * 0.5f);
+        if ((k.outerRadius - k.interRadius) > 9.0f * k.rs) {
+            if (posR < 5.0f * k.rs + k.interRadius) {
+                effectiveRadius = 1.0f - ((posR - k.interRadius) / (9.0f * k.rs) * 0.5f);
+            } else {
+                effectiveRadius = 1.0f - (0.5f / 0.9f * 0.5f + ((posR - k.interRadius) / (k.outerRadius - k.interRadius) -
+                                  5.0f * k.rs / (k.outerRadius - k.interRadius)) / (1.0f - 5.0f * k.rs / (k.outerRadius - k.interRadius)) * 0.5f);
+            }
+        }
+
+        const float dustProfile = 1.0f - 5.0f * std::pow(2.0f * (1.0f - effectiveRadius), 2.0f);
+        if ((std::fabs(posY) < 0.5f * k.rs * shape(effectiveRadius, 4.0f, 0.9f)) || (posY < 0.5f * k.rs * dustProfile)) {
+            const float angularVelocity = keplerianAngularVelocity(posR, k.rs);
+            const float halfPiTimeInside = kPi / keplerianAngularVelocity(3.0f * k.rs, k.rs);
+
+            const float spiralTheta = 12.0f * 2.0f / std::sqrt(3.0f) * std::atan(std::sqrt(0.6666666f * (posR / k.rs) - 1.0f));
+            const float innerTheta = kPi / halfPiTimeInside * iTime * k.timeRate;
+            const float posThetaForInnerCloud = vec2ToTheta(posOnDisk.zx(),
+                vec2(std::cos(0.666666f * innerTheta), std::sin(0.666666f * innerTheta)));
+            const float posTheta = vec2ToTheta(posOnDisk.zx(), vec2(std::cos(-spiralTheta), std::sin(-spiralTheta)));
+
+            // 盘温度
+            float diskTemperature = std::pow(k.diskA * std::pow(max(k.rs / posR, 0.10f), 3.0f) *
+                                             max(1.0f - std::sqrt(k.interRadius / posR), 0.000001f), 0.25f);
+            // 云相对速度、多普勒因子和总红移
+            const vec3 cloudVelocity = kLightYear / kSpeedOfLight * angularVelocity * cross(vec3(0.0f, 1.0f, 0.0f), posOnDisk);
+            const float relativeVelocity = dot(-dirOnDisk, cloudVelocity);
+            const float dopler = std::sqrt((1.0f + relativeVelocity) / (1.0f - relativeVelocity));
+            float redShift = dopler * std::sqrt(max(1.0f - k.rs / posR, 0.000001f)) / k.cameraRedshift;
+
+            const float rotPosR = posR / k.rs + 0.3f * std::sqrt(3.0f) * kSpeedOfLight / kLightYear / 3.0f / std::sqrt(3.0f) /
+                                  k.rs * k.timeRate * iTime;
+
+            vec4 color0(0.0f);
+            float density = shape(effectiveRadius, 4.0f, 0.9f);
+            if (std::fabs(posY) < 0.5f * k.rs * density) {
+                const float thick = 0.5f * k.rs * density *
+                    (0.4f + 0.6f * softSaturate(accretionDiskNoise(vec3(1.5f * posTheta, rotPosR, 1.0f), 1, 3, 80.0f)));
+                const float verticalMixFactor = max(0.0f, 1.0f - std::fabs(posY) / thick);
+                density *= 0.7f * verticalMixFactor * density;
+                color0 = vec4(accretionDiskNoise(vec3(1.0f * rotPosR, 1.0f * posY / k.rs, 0.5f * posTheta), 3, 6, 80.0f));
+                color0.setXyz(color0.xyz() * (density * 1.4f * (0.2f + 0.8f * verticalMixFactor + (0.8f - 0.8f * verticalMixFactor) *
+                              accretionDiskNoise(vec3(rotPosR, 1.5f * posTheta, posY / k.rs), 1, 3, 80.0f))));
+                color0.w *= density;
+            }
+            if (std::fabs(posY) < 0.5f * k.rs * dustProfile) {
+                const float dustColor = max(1.0f - std::pow(posY / (0.5f * k.rs * max(dustProfile, 0.0001f)), 2.0f), 0.0f) *
+                    accretionDiskNoise(vec3(1.5f * fract((1.5f * posThetaForInnerCloud + kPi / halfPiTimeInside * iTime * k.timeRate) /
+                                                         2.0f / kPi) * 2.0f * kPi,
+                                            posR / k.rs, posY / k.rs), 0, 6, 80.0f);
+                color0 += 0.02f * vec4(vec3(dustColor), 0.2f * dustColor) * std::sqrt(1.0001f - dirOnDisk.y * dirOnDisk.y) *
+                          min(1.0f, dopler * dopler);
+            }
+
+            color = color0;
+            color *= 1.0f + 20.0f * std::exp(-10.0f * (posR - k.interRadius) / (k.outerRadius - k.interRadius));  // 内侧增加密度
+
+            const float brightWithoutRedshift = 4.5f * diskTemperature * diskTemperature * diskTemperature * diskTemperature /
+                                                k.quadraticedPeakTemperature;
+            if (diskTemperature > 1000.0f) {
+                diskTemperature = max(1000.0f, diskTemperature * redShift * dopler * dopler);
+            }
+            diskTemperature = min(100000.0f, diskTemperature);
+
+            vec3 rgb = color.xyz();
+            rgb *= brightWithoutRedshift * min(1.0f, 1.8f * (k.outerRadius - posR) / (k.outerRadius - k.interRadius));
+            rgb *= kelvinToRgb(diskTemperature / std::exp((posR - k.interRadius) / (0.6f * (k.outerRadius - k.interRadius))));
+            rgb *= min(k.shiftMax, redShift) * min(k.shiftMax, dopler);
+
+            redShift = min(redShift, k.shiftMax);
+            rgb *= std::pow(1.0f - (1.0f - min(1.0f, redShift)) * (posR - k.interRadius) / (k.outerRadius - k.interRadius), 9.0f);
+            rgb *= min(1.0f, 1.0f + 0.5f * ((posR - k.interRadius) / k.interRadius + k.interRadius / (posR - k.interRadius)) -
+                             max(1.0f, redShift));
+            color.setXyz(rgb);
+
+            color *= stepLength / k.rs;
+        }
+    }
+
+    return baseColor + color * (1.0f - baseColor.w);
+}
+
+// CPU端没有纹理单元：棋盘按 createChessTexture 逐texel生成，纹理背景（3）的采样器未绑定，按 (0, 0, 0, 1) 处理
+namespace {
+
+vec4 chessTexel(int x, int y) {
+    const int tile = 64 / 8;
+    x &= 63;
+    y &= 63;
+    if ((x / tile + y / tile) % 2 == 0) {
+        return vec4(220.0f / 255.0f, 220.0f / 255.0f, 220.0f / 255.0f, 1.0f);
+    }
+    return vec4(80.0f / 255.0f, 80.0f / 255.0f, 100.0f / 255.0f, 1.0f);
+}
+
+// GL_LINEAR + GL_REPEAT 采样
+vec4 chessSample(const vec2& uv) {
+    const float u = uv.x * 64.0f - 0.5f;
+    const float v = uv.y * 64.0f - 0.5f;
+    const int x0 = int(std::floor(u));
+    const int y0 = int(std::floor(v));
+    const float fx = u - float(x0);
+    const float fy = v - float(y0);
+    const vec4 a = chessTexel(x0, y0) * (1.0f - fx) + chessTexel(x0 + 1, y0) * fx;
+    const vec4 b = chessTexel(x0, y0 + 1) * (1.0f - fx) + chessTexel(x0 + 1, y0 + 1) * fx;
+    return a * (1.0f - fy) + b * fy;
+}
+
+} // namespace
+
+vec4 BlackHoleKernel::background(const vec4& color, const vec3& rayDir) const {
+    const vec2 uv(0.5f - 0.5f * rayDir.x / rayDir.z, 0.5f - 0.5f * rayDir.y / rayDir.z * resolution.x / resolution.y);
+    const vec2 wrapped(fract(uv.x), fract(uv.y));
+    const float transmit = 1.0f - color.w;
+    switch (params.backgroundType) {
+    case 0:
+        return color + 0.5f * chessTexel(int(wrapped.x * 64.0f), int(wrapped.y * 64.0f)) * transmit;
+    case 1:
+        return color + vec4(0.0f, 0.0f, 0.0f, 1.0f) * transmit;
+    case 3:
+        return color + 0.5f * vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    default:
+        // 着色器把 (1 - a) 乘在了纹理坐标上，照原样移植
+        return color + 0.5f * chessSample(wrapped * transmit);
+    }
+}
+
+void BlackHoleKernel::primaryRay(int x, int y, vec3* rayDir, float* firstStep) const {
+    const vec2 fragUv = vec2(float(x) + 0.5f, float(y) + 0.5f) / resolution;
+    vec3 noise;
+    if (params.jitter == JitterSequence::BlueNoise) {
+        noise = BlueNoiseTile::instance().sample(x, y, params.iFrame);
+    } else {
+        const float seed = float(params.iFrame) * 0.618034f;
+        noise.x = randomStep(fragUv, fract(seed + 0.5f));
+        noise.y = randomStep(fragUv, fract(seed));
+        noise.z = noise.y;
+    }
+    const vec2 jitter(noise.x, noise.y);
+    const vec2 uv = fragUv + 0.5f * jitter / resolution;
+    const vec3 dir = normalize(vec3(params.fov * (2.0f * uv.x - 1.0f),
+                                    params.fov * (2.0f * uv.y - 1.0f) * resolution.y / resolution.x, -1.0f));
+
+    const vec3 posToBlackHole = -k.blackHolePos;
+    const float distanceToBlackHole = length(posToBlackHole);
+    const vec3 normalizedPosToBlackHole = posToBlackHole / distanceToBlackHole;
+    *rayDir = normalize(dir - normalizedPosToBlackHole * dot(normalizedPosToBlackHole, dir) *
+        (-std::sqrt(max(1.0f - k.rs * cubicInterpolate(max(min(1.0f - (0.01f * distanceToBlackHole / k.rs - 1.0f) / 4.0f, 1.0f), 0.0f)) /
+                                   distanceToBlackHole, 0.00000000000000001f)) + 1.0f));
+    *firstStep = noise.z;
+}
+
+vec4 BlackHoleKernel::shade(int x, int y, int* steps) const {
+    vec4 fragColor(0.0f);
+    vec3 rayDir;
+    float firstStep = 0.0f;
+    primaryRay(x, y, &rayDir, &firstStep);
+    vec3 rayPos(0.0f);
+
+    vec3 posToBlackHole = rayPos - k.blackHolePos;
+    float distanceToBlackHole = length(posToBlackHole);
+    vec3 normalizedPosToBlackHole;
+
+    float stepLength = 0.0f;
+    float lastR = distanceToBlackHole;
+    bool marching = true;
+    int count = 0;
+    while (marching) {
+        posToBlackHole = rayPos - k.blackHolePos;
+        distanceToBlackHole = length(posToBlackHole);
+        normalizedPosToBlackHole = posToBlackHole / distanceToBlackHole;
+
+        if (distanceToBlackHole > (2.5f * k.outerRadius) && distanceToBlackHole > lastR && count > 50) {
+            // 远离黑洞
+            marching = false;
+            fragColor = background(fragColor, rayDir);
+        }
+        if (distanceToBlackHole < 0.1f * k.rs) {
+            marching = false;
+        }
+        // 包围体外不调用diskColor；留 0.01Rs 余量，边界上的判断仍由diskColor自己做
+        const float slabGap = diskSlabGap(posToBlackHole, distanceToBlackHole, k.diskY, k.rs, k.interRadius, k.outerRadius);
+        if (marching && slabGap < 0.01f * k.rs) {
+            fragColor = diskColor(fragColor, stepLength, rayPos, rayDir);
+        }
+        if (fragColor.w > 0.99f) {
+            marching = false;
+        }
+
+        lastR = distanceToBlackHole;
+        const float rayStep = geodesicStep(&rayPos, &rayDir, normalizedPosToBlackHole, distanceToBlackHole,
+                                           count == 0 ? firstStep : 1.0f, k.rs, k.outerRadius,   // 光起步步长抖动
+                                           count == 0 ? 0.0f : slabGap);
+        stepLength = rayStep;
+        count++;
+    }
+    if (steps) {
+        *steps = count;
+    }
+    return encodeForBloom(fragColor);
+}
+
+vec4 BlackHoleKernel::encodeForBloom(vec4 fragColor) {
+    // 为了套bloom先逆处理一遍
+    const float colorRFactor = 3.0f * fragColor.x / (fragColor.y + fragColor.y + fragColor.z);
+    const float colorBFactor = 3.0f * fragColor.z / (fragColor.y + fragColor.y + fragColor.z);
+    const float colorGFactor = 3.0f * fragColor.y / (fragColor.y + fragColor.y + fragColor.z);
+
+    const float bloomMax = 12.0f;
+    fragColor.x = min(-4.0f * std::log(1.0f - std::pow(fragColor.x, 2.2f)), bloomMax * colorRFactor);
+    fragColor.y = min(-4.0f * std::log(1.0f - std::pow(fragColor.y, 2.2f)), bloomMax * colorGFactor);
+    fragColor.z = min(-4.0f * std::log(1.0f - std::pow(fragColor.z, 2.2f)), bloomMax * colorBFactor);
+    fragColor.w = min(-4.0f * std::log(1.0f - std::pow(fragColor.w, 2.2f)), 4.0f);
+    return fragColor;
+}
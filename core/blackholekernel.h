@@ -0,0 +1,86 @@
+#ifndef BLACKHOLEKERNEL_H
+#define BLACKHOLEKERNEL_H
+
+#include "glslmath.h"
+
+// 像素和首步步长抖动的来源：BlueNoise 与着色器相同；WhiteNoise 是原先的逐像素 sin 哈希（种子由 iTime 换成 iFrame，
+// 冻结盘的动画时也逐帧变化，首步与纵向抖动共用一个随机数），只供 blackhole-convergebench 对比收敛速度
+enum class JitterSequence {
+    BlueNoise,
+    WhiteNoise
+};
+
+// circle.frag 的输入（与 BlackHoleFrameState 对应，不依赖Qt）
+struct TraceParams {
+    int width = 1920;             // iResolution，整幅图像
+    int height = 1080;
+    float iTime = 0.0f;
+    int iFrame = 0;
+    glsl::vec4 iMouse;
+    float blackHoleMass = 1.49e7f;
+    glsl::vec3 diskNormal{0.2f, 1.0f, 0.0f};
+    float cameraRadius = 0.000057f;
+    float fov = 0.5f;
+    int backgroundType = 1;
+    JitterSequence jitter = JitterSequence::BlueNoise;
+};
+
+// SetupFrame 中与相机无关的盘参数（长度单位为光年），spin 为无量纲自旋（着色器没有 Kerr 表时按0）
+struct DiskParameters {
+    float rs = 0.0f;
+    float interRadius = 0.0f;
+    float outerRadius = 0.0f;
+    float diskA = 0.0f;
+    float quadraticedPeakTemperature = 0.0f;
+};
+
+DiskParameters diskParameters(float blackHoleMass, float spin);
+
+// 每帧常量（相机系，长度单位为光年）
+struct KernelConstants {
+    float rs = 0.0f;
+    float interRadius = 0.0f;
+    float outerRadius = 0.0f;
+    float diskA = 0.0f;
+    float quadraticedPeakTemperature = 0.0f;
+    float shiftMax = 1.25f;
+    float timeRate = 30.0f;
+    glsl::vec3 blackHolePos;
+    // 相机系三轴在世界系中的方向，即世界系到相机系旋转的三行
+    glsl::vec3 cameraX;
+    glsl::vec3 cameraY;
+    glsl::vec3 cameraZ;
+    // 黑洞系（y轴为盘法向）的三个轴，即相机系到黑洞系旋转的三行
+    glsl::vec3 diskX;
+    glsl::vec3 diskY;
+    glsl::vec3 diskZ;
+    float cameraRedshift = 1.0f;      // sqrt(max(1 - Rs / |CameraPos|, 1e-6))
+    float slabStepFraction = 0.0f;    // circle::kSlabStepFraction，供包内核使用
+};
+
+// circle.frag 测地线ray marching和DiskColor的C++移植，逐像素结果与着色器写入fbo的值一致
+// 只对应不混合历史帧的情况（iFrame < 2 或 iMouse.z > 0），每帧常量在构造时算好
+class BlackHoleKernel {
+public:
+    explicit BlackHoleKernel(const TraceParams& params);
+
+    // 像素 (x, y)（OpenGL坐标，y向上）的颜色，未截断到[0, 1]；steps 返回测地线步数
+    glsl::vec4 shade(int x, int y, int* steps) const;
+
+    // 以下供SIMD包内核逐通道调用
+    const KernelConstants& constants() const { return k; }
+    // 像素的初始光线方向（含抖动和近黑洞处的初始偏折）和首步步长抖动
+    void primaryRay(int x, int y, glsl::vec3* rayDir, float* firstStep) const;
+    glsl::vec4 diskColor(const glsl::vec4& baseColor, float stepLength, const glsl::vec3& rayPos,
+                         const glsl::vec3& rayDir) const;
+    glsl::vec4 background(const glsl::vec4& color, const glsl::vec3& rayDir) const;
+    // 着色器末尾为bloom做的逆处理
+    static glsl::vec4 encodeForBloom(glsl::vec4 color);
+
+private:
+    TraceParams params;
+    glsl::vec2 resolution;
+    KernelConstants k;
+};
+
+#endif // BLACKHOLEKERNEL_H
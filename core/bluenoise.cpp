@@ -0,0 +1,117 @@
+#include "bluenoise.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+namespace {
+
+const int kSize = BlueNoiseTile::kSize;
+const int kCount = kSize * kSize;
+
+// Ulichney 的 void-and-cluster：能量是周期高斯核（sigma = 1.5）对已放置点的叠加，
+// 最紧的簇是能量最大的点，最大的空洞是能量最小的空位
+class VoidAndCluster {
+public:
+    explicit VoidAndCluster(std::uint32_t seed) : pattern(kCount, 0), energy(kCount, 0.0), kernel(kCount) {
+        for (int y = 0; y < kSize; ++y) {
+            for (int x = 0; x < kSize; ++x) {
+                const int dx = std::min(x, kSize - x);
+                const int dy = std::min(y, kSize - y);
+                kernel[std::size_t(y * kSize + x)] = std::exp(-double(dx * dx + dy * dy) / (2.0 * 1.5 * 1.5));
+            }
+        }
+        // 初始图样：约十分之一的像素随机置位，再反复把最紧的簇移到最大的空洞直到稳定
+        std::mt19937 random(seed);
+        for (int placed = 0; placed < kCount / 10;) {
+            const int index = int(random() % std::uint32_t(kCount));
+            if (!pattern[std::size_t(index)]) {
+                set(index, true);
+                ++placed;
+            }
+        }
+        for (int iteration = 0; iteration < kCount; ++iteration) {
+            const int cluster = tightestCluster();
+            set(cluster, false);
+            const int gap = largestVoid();
+            set(gap, true);
+            if (gap == cluster) {
+                break;
+            }
+        }
+    }
+
+    void rank(std::uint16_t* out, int stride) {
+        const std::vector<char> initialPattern = pattern;
+        const std::vector<double> initialEnergy = energy;
+        int ones = 0;
+        for (char bit : pattern) {
+            ones += bit;
+        }
+        // 初始点按从紧到松依次取走，排名递减；空位按从大到小依次填上，排名递增
+        for (int remaining = ones; remaining > 0; --remaining) {
+            const int cluster = tightestCluster();
+            set(cluster, false);
+            out[std::size_t(cluster) * stride] = std::uint16_t(remaining - 1);
+        }
+        pattern = initialPattern;
+        energy = initialEnergy;
+        for (int filled = ones; filled < kCount; ++filled) {
+            const int gap = largestVoid();
+            set(gap, true);
+            out[std::size_t(gap) * stride] = std::uint16_t(filled);
+        }
+    }
+
+private:
+    void set(int index, bool bit) {
+        pattern[std::size_t(index)] = bit;
+        const double sign = bit ? 1.0 : -1.0;
+        const int px = index % kSize;
+        const int py = index / kSize;
+        for (int y = 0; y < kSize; ++y) {
+            const double* row = &kernel[std::size_t(((y - py) & (kSize - 1)) * kSize)];
+            double* target = &energy[std::size_t(y * kSize)];
+            for (int x = 0; x < kSize; ++x) {
+                target[x] += sign * row[(x - px) & (kSize - 1)];
+            }
+        }
+    }
+
+    int tightestCluster() const {
+        int best = -1;
+        for (int i = 0; i < kCount; ++i) {
+            if (pattern[std::size_t(i)] && (best < 0 || energy[std::size_t(i)] > energy[std::size_t(best)])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    int largestVoid() const {
+        int best = -1;
+        for (int i = 0; i < kCount; ++i) {
+            if (!pattern[std::size_t(i)] && (best < 0 || energy[std::size_t(i)] < energy[std::size_t(best)])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    std::vector<char> pattern;
+    std::vector<double> energy;
+    std::vector<double> kernel;
+};
+
+} // namespace
+
+const BlueNoiseTile& BlueNoiseTile::instance() {
+    static const BlueNoiseTile tile;
+    return tile;
+}
+
+BlueNoiseTile::BlueNoiseTile() : ranks(std::size_t(kCount) * kChannels) {
+    for (int c = 0; c < kChannels; ++c) {
+        VoidAndCluster(0x5bd1e995u + std::uint32_t(c)).rank(ranks.data() + c, kChannels);
+    }
+}
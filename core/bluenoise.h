@@ -0,0 +1,44 @@
+#ifndef BLUENOISE_H
+#define BLUENOISE_H
+
+#include <cstdint>
+#include <vector>
+#include "glslmath.h"
+
+// 像素抖动和首步步长抖动用的蓝噪声：kSize x kSize 的平铺，三个通道是各自独立生成的 void-and-cluster 阈值图
+// （x 抖动、y 抖动、首步步长），每个通道都是 0 .. kSize^2-1 的一个排列。
+// 每帧整体平移：x/y 按 R2 序列、首步按黄金分割序列，用 32 位定点相加，GPU 与 CPU 的结果逐位相同
+class BlueNoiseTile {
+public:
+    static const int kSize = 64;
+    static const int kChannels = 3;
+
+    // 进程内只生成一次（约十分之几秒）
+    static const BlueNoiseTile& instance();
+
+    int size() const { return kSize; }
+    // x 最快，每个像素三个通道，可直接作为 GL_RGB16UI 纹理上传
+    const std::uint16_t* data() const { return ranks.data(); }
+
+    std::uint16_t rank(int x, int y, int channel) const {
+        return ranks[(std::size_t((y & (kSize - 1)) * kSize + (x & (kSize - 1)))) * kChannels + channel];
+    }
+
+    // 与 blackhole.glsl 的 JitterNoise 相同：像素 (x, y) 第 frame 帧的三个 [0, 1) 随机数
+    glsl::vec3 sample(int x, int y, int frame) const {
+        static const std::uint32_t step[kChannels] = {3242174889u, 2447445413u, 2654435769u};
+        float value[kChannels];
+        for (int c = 0; c < kChannels; ++c) {
+            const std::uint32_t fixed = (std::uint32_t(rank(x, y, c)) << 20) + (1u << 19) + std::uint32_t(frame) * step[c];
+            value[c] = float(fixed >> 8) * (1.0f / 16777216.0f);
+        }
+        return glsl::vec3(value[0], value[1], value[2]);
+    }
+
+private:
+    BlueNoiseTile();
+
+    std::vector<std::uint16_t> ranks;
+};
+
+#endif // BLUENOISE_H
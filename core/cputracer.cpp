@@ -0,0 +1,93 @@
+#include "cputracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// 把坐标的低16位交错成Morton码
+uint32_t spreadBits(uint32_t v) {
+    v &= 0xffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+inline float storeChannel(float v) {
+    // RGBA8 fbo 写入时截断，NaN 写为0
+    return v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f;
+}
+
+} // namespace
+
+CpuTracer::CpuTracer(int threads) : pool(threads) {
+    arenas.reserve(size_t(pool.threadCount()));
+    for (int i = 0; i < pool.threadCount(); ++i) {
+        arenas.emplace_back();
+    }
+}
+
+std::vector<int> CpuTracer::mortonOrder(int tilesX, int tilesY) {
+    std::vector<std::pair<uint32_t, int>> keyed;
+    keyed.reserve(size_t(tilesX) * tilesY);
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            keyed.emplace_back(spreadBits(uint32_t(tx)) | (spreadBits(uint32_t(ty)) << 1), ty * tilesX + tx);
+        }
+    }
+    std::sort(keyed.begin(), keyed.end());
+    std::vector<int> order;
+    order.reserve(keyed.size());
+    for (const auto& entry : keyed) {
+        order.push_back(entry.second);
+    }
+    return order;
+}
+
+void CpuTracer::render(const TraceParams& params, float* rgba) {
+    const BlackHoleKernel kernel(params);
+    const int width = params.width;
+    const int height = params.height;
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+
+    stats.assign(size_t(tilesX) * tilesY, TileStats());
+    pool.run(mortonOrder(tilesX, tilesY), [&](int tile, int worker) {
+        const auto start = std::chrono::steady_clock::now();
+        TileStats& tileStat = stats[size_t(tile)];
+        tileStat.x = (tile % tilesX) * tileSize;
+        tileStat.y = (tile / tilesX) * tileSize;
+        tileStat.width = std::min(tileSize, width - tileStat.x);
+        tileStat.height = std::min(tileSize, height - tileStat.y);
+        tileStat.worker = worker;
+
+        // 块内先写线程私有缓冲，整块完成后按行拷出，避免与相邻块的线程写同一缓存行
+        Arena& arena = arenas[size_t(worker)];
+        arena.reset();
+        float* local = arena.allocate<float>(size_t(tileStat.width) * tileStat.height * 4);
+        int* rowSteps = arena.allocate<int>(size_t(tileStat.width));
+        uint64_t steps = 0;
+        int maxSteps = 0;
+        for (int y = 0; y < tileStat.height; ++y) {
+            float* row = local + size_t(y) * tileStat.width * 4;
+            shadeRow(isa, kernel, tileStat.x, tileStat.y + y, tileStat.width, row, rowSteps);
+            for (int x = 0; x < tileStat.width; ++x) {
+                for (int c = 0; c < 4; ++c) {
+                    row[x * 4 + c] = storeChannel(row[x * 4 + c]);
+                }
+                steps += uint64_t(rowSteps[x]);
+                maxSteps = std::max(maxSteps, rowSteps[x]);
+            }
+        }
+        for (int y = 0; y < tileStat.height; ++y) {
+            std::memcpy(rgba + (size_t(tileStat.y + y) * width + tileStat.x) * 4,
+                        local + size_t(y) * tileStat.width * 4, sizeof(float) * 4 * size_t(tileStat.width));
+        }
+
+        tileStat.steps = steps;
+        tileStat.maxSteps = maxSteps;
+        tileStat.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    });
+}
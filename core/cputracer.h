@@ -0,0 +1,54 @@
+#ifndef CPUTRACER_H
+#define CPUTRACER_H
+
+#include <cstdint>
+#include <vector>
+#include "arena.h"
+#include "blackholekernel.h"
+#include "packetkernel.h"
+#include "workstealingpool.h"
+
+// 一块的渲染统计
+struct TileStats {
+    int x = 0;                // 块左下角（OpenGL坐标）
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    uint64_t steps = 0;       // 块内所有像素的测地线步数之和
+    int maxSteps = 0;         // 块内单像素最大步数
+    double milliseconds = 0.0;
+    int worker = -1;
+};
+
+// 无GPU节点上的参考渲染：circle.frag 的CPU移植按块在工作窃取线程池上运行
+// 块按Morton序分发，每个线程用自己的arena做块内临时缓冲；块内逐行交给SIMD包内核
+class CpuTracer {
+public:
+    explicit CpuTracer(int threads = 0);
+
+    void setTileSize(int size) { tileSize = size > 0 ? size : 32; }
+    // 块内每行用的包内核指令集，默认取CPU支持的最宽者；不支持的指令集退回标量
+    void setSimdIsa(SimdIsa value) { isa = simdIsaSupported(value) ? value : SimdIsa::Scalar; }
+    SimdIsa simdIsa() const { return isa; }
+    int threadCount() const { return pool.threadCount(); }
+
+    // 渲染整幅图像到 rgba（width * height * 4 个float，自下而上行序）
+    // 结果截断到[0, 1]、NaN记为0，与circle通道写入RGBA8 fbo的值一致
+    void render(const TraceParams& params, float* rgba);
+
+    // 上一次 render 的逐块统计，按块在图像中的行优先顺序排列
+    const std::vector<TileStats>& tileStats() const { return stats; }
+    uint64_t stealCount() const { return pool.stealCount(); }
+
+    // tilesX * tilesY 个块按Morton（Z序）曲线排列的行优先索引
+    static std::vector<int> mortonOrder(int tilesX, int tilesY);
+
+private:
+    WorkStealingPool pool;
+    std::vector<Arena> arenas;   // 每个工作线程一个
+    std::vector<TileStats> stats;
+    int tileSize = 32;
+    SimdIsa isa = detectSimdIsa();
+};
+
+#endif // CPUTRACER_H
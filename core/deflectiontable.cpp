@@ -0,0 +1,164 @@
+#include "deflectiontable.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace {
+
+using Complex = std::complex<double>;
+
+const double kPi = 3.14159265358979323846;
+
+// Carlson 对称形式的第一类椭圆积分 R_F(x, y, z)，复数参数（共轭对）同样适用
+double carlsonRF(Complex x, Complex y, Complex z) {
+    const double tolerance = 1e-3;   // 截断误差约 tolerance^6
+    Complex mean;
+    for (int i = 0; i < 64; ++i) {
+        const Complex sx = std::sqrt(x);
+        const Complex sy = std::sqrt(y);
+        const Complex sz = std::sqrt(z);
+        const Complex lambda = sx * (sy + sz) + sy * sz;
+        x = 0.25 * (x + lambda);
+        y = 0.25 * (y + lambda);
+        z = 0.25 * (z + lambda);
+        mean = (x + y + z) / 3.0;
+        if (std::max({std::abs(mean - x), std::abs(mean - y), std::abs(mean - z)}) < tolerance * std::abs(mean)) {
+            break;
+        }
+    }
+    const Complex dx = (mean - x) / mean;
+    const Complex dy = (mean - y) / mean;
+    const Complex dz = -(dx + dy);
+    const Complex e2 = dx * dy - dz * dz;
+    const Complex e3 = dx * dy * dz;
+    return std::real((1.0 + (e2 / 24.0 - 0.1 - 3.0 * e3 / 44.0) * e2 + e3 / 14.0) / std::sqrt(mean));
+}
+
+// 轨道方程 (du/dphi)^2 = P(u) = u^3 - u^2 + 1/b^2（u = 1/r，Rs = 1）
+// 写成三个一次因子 (a_i + b_i u) 之积，在 [y, x] 上积分 du / sqrt(P)
+// （DLMF 19.29.4 取 a_4 = 1, b_4 = 0）
+struct CubicFactors {
+    Complex a[3];
+    double b[3];
+
+    double integrate(double y, double x) const {
+        if (x <= y) {
+            return 0.0;
+        }
+        Complex fx[3];
+        Complex fy[3];
+        for (int i = 0; i < 3; ++i) {
+            fx[i] = std::sqrt(a[i] + b[i] * x);
+            fy[i] = std::sqrt(a[i] + b[i] * y);
+        }
+        const double d = x - y;
+        const Complex u12 = (fx[0] * fx[1] * fy[2] + fy[0] * fy[1] * fx[2]) / d;
+        const Complex u13 = (fx[0] * fx[2] * fy[1] + fy[0] * fy[2] * fx[1]) / d;
+        const Complex u23 = (fx[1] * fx[2] * fy[0] + fy[1] * fy[2] * fx[0]) / d;
+        return 2.0 * carlsonRF(u12 * u12, u13 * u13, u23 * u23);
+    }
+};
+
+} // namespace
+
+DeflectionSample schwarzschildDeflection(double r0, double psi, double diskRadius) {
+    DeflectionSample sample;
+    const double u0 = 1.0 / r0;
+    const double ud = 1.0 / diskRadius;
+    const double sinPsi = std::sin(psi);
+    const bool inward = psi > 0.5 * kPi;
+    // 静止观察者测得的角度换成冲量参数
+    const double b = r0 * sinPsi / std::sqrt(1.0 - u0);
+    if (b < 1e-9) {
+        // 径向光线，方位角不变
+        sample.captured = inward;
+        sample.periapsis = inward ? 0.0 : r0;
+        return sample;
+    }
+    const double c = 1.0 / (b * b);
+
+    // 负实根 u1：P(0) = c > 0，P(-cbrt(c)) < 0，二分
+    double lo = -std::max(1.0, std::cbrt(c));
+    double hi = 0.0;
+    for (int i = 0; i < 200 && hi - lo > 1e-15 * std::max(1.0, -lo); ++i) {
+        const double mid = 0.5 * (lo + hi);
+        if (mid * mid * mid - mid * mid + c > 0.0) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    const double u1 = 0.5 * (lo + hi);
+    // 其余两根是 u^2 + (u1 - 1) u - c / u1 = 0 的根
+    const double p = u1 - 1.0;
+    const double q = -c / u1;
+    const double discriminant = p * p - 4.0 * q;
+
+    CubicFactors factors;
+    factors.a[0] = -u1;
+    factors.b[0] = 1.0;
+    double turning = 0.0;   // 近心点的 u，没有转折点时为0
+    if (discriminant > 0.0) {
+        // 三个实根 u1 < 0 < u2 < u3，u2 为转折点（b 大于临界值 3*sqrt(3)/2）
+        const double root = std::sqrt(discriminant);
+        const double u3 = 0.5 * (-p + root);
+        const double u2 = q / u3;
+        factors.a[1] = u2;
+        factors.b[1] = -1.0;
+        factors.a[2] = u3;
+        factors.b[2] = -1.0;
+        turning = std::max(u2, u0);
+    } else {
+        const Complex u2(-0.5 * p, 0.5 * std::sqrt(-discriminant));
+        factors.a[1] = -u2;
+        factors.b[1] = 1.0;
+        factors.a[2] = -std::conj(u2);
+        factors.b[2] = 1.0;
+    }
+
+    if (!inward) {
+        // 向外出发，r 单调增加
+        sample.sweep = factors.integrate(0.0, u0);
+        sample.periapsis = r0;
+        sample.exitDisk = u0 > ud ? factors.integrate(ud, u0) : 0.0;
+    } else if (turning > 0.0) {
+        // 先向内到近心点再飞向无穷远
+        const double toTurning = factors.integrate(u0, turning);
+        sample.sweep = factors.integrate(0.0, turning) + toTurning;
+        sample.periapsis = 1.0 / turning;
+        if (turning > ud) {
+            const double inside = factors.integrate(std::max(ud, u0), turning);
+            sample.enterDisk = toTurning - inside;
+            sample.exitDisk = toTurning + factors.integrate(ud, turning);
+        } else {
+            sample.enterDisk = toTurning;
+            sample.exitDisk = toTurning;
+        }
+    } else {
+        // 一对共轭复根：没有转折点，向内的光线落入视界
+        sample.sweep = factors.integrate(u0, 1.0);
+        sample.captured = true;
+        sample.enterDisk = u0 < ud ? factors.integrate(u0, ud) : 0.0;
+        sample.exitDisk = sample.sweep;
+    }
+    return sample;
+}
+
+DeflectionTable::DeflectionTable()
+    : texels(size_t(kAngleCount) * kRadiusCount * 4) {
+    for (int row = 0; row < kRadiusCount; ++row) {
+        const double r0 = rowRadius(row);
+        float* out = texels.data() + size_t(row) * kAngleCount * 4;
+        for (int column = 0; column < kAngleCount; ++column) {
+            const DeflectionSample sample = schwarzschildDeflection(r0, kPi * column / (kAngleCount - 1), kDiskRadius);
+            out[column * 4] = float(sample.sweep);
+            out[column * 4 + 1] = sample.captured ? kCapturedMark : float(1.0 / sample.periapsis);
+            out[column * 4 + 2] = float(sample.enterDisk);
+            out[column * 4 + 3] = float(sample.exitDisk);
+        }
+    }
+}
+
+float DeflectionTable::rowRadius(int row) {
+    return kMinRadius * std::pow(kMaxRadius / kMinRadius, float(row) / float(kRadiusCount - 1));
+}
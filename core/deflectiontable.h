@@ -0,0 +1,50 @@
+#ifndef DEFLECTIONTABLE_H
+#define DEFLECTIONTABLE_H
+
+#include <vector>
+
+// Schwarzschild 光线偏折的精确查表，供 circle.frag 直接得到背景光线的逃逸方向
+// 长度以Rs为单位，表与黑洞质量无关。光线由静止观察者在半径 r0 处发出，
+// 与径向向外方向夹角为 psi（观察者本地测得的角度，即着色器初始偏折之前的视线）
+// 光线在 (径向, 视线) 张成的平面内运动，表中给出它扫过的方位角和近心点
+
+// 一条光线的结果
+struct DeflectionSample {
+    double sweep = 0.0;        // 从出发到无穷远（被吞噬时到视界）扫过的方位角
+    double periapsis = 0.0;    // 近心点半径，向外出发时为 r0；被吞噬时为0
+    bool captured = false;
+    // 轨道在半径 diskRadius 的球内的方位角区间；轨道不进入该球时两者都取近心点处的方位角
+    double enterDisk = 0.0;
+    double exitDisk = 0.0;
+};
+
+// 用第一类椭圆积分（Carlson R_F）精确计算，r0 需大于 1.5（光子球之外）
+DeflectionSample schwarzschildDeflection(double r0, double psi, double diskRadius);
+
+// 二维表：列为 psi 在 [0, pi] 上均匀取样，行为 r0 在 [minRadius, maxRadius] 上对数均匀取样
+// 每个纹素四个float（RGBA）：R 为扫过的方位角，G 为近心点半径的倒数，B、A 为轨道在吸积盘外接球
+// （circle.frag 中 OuterRadius = 12 Rs，半厚 0.5 Rs）内的方位角区间，着色器只需检查这一段是否靠近盘面
+// 被吞噬的光线 G 为 kCapturedMark，线性过滤时只要混入被吞噬的纹素 G 就远大于 1/1.5，着色器据此退回逐步raymarching
+class DeflectionTable {
+public:
+    static const int kAngleCount = 2048;
+    static const int kRadiusCount = 128;
+    static constexpr float kMinRadius = 2.0f;
+    static constexpr float kMaxRadius = 4096.0f;
+    static constexpr float kCapturedMark = 1000.0f;
+    static constexpr double kDiskRadius = 12.0104;   // sqrt(12^2 + 0.5^2)
+
+    DeflectionTable();
+
+    int width() const { return kAngleCount; }
+    int height() const { return kRadiusCount; }
+    // 行优先，width * height * 4 个float，可直接作为 GL_RGBA32F 纹理上传
+    const float* data() const { return texels.data(); }
+
+    static float rowRadius(int row);
+
+private:
+    std::vector<float> texels;
+};
+
+#endif // DEFLECTIONTABLE_H
@@ -0,0 +1,44 @@
+#include "emissiontables.h"
+#include <algorithm>
+#include <cmath>
+#include "shadermath.h"
+
+EmissionTables::EmissionTables(const DiskParameters& disk)
+    : parameters(disk), texels(std::size_t(kWidth) * kRows * 4, 0.0f) {
+    // 表在double下计算，误差只来自取样间隔
+    const double minInverse = 1.0 / kMaxKelvin;
+    const double maxInverse = 1.0 / kMinKelvin;
+    float* blackbody = texels.data();
+    for (int i = 0; i < kWidth; ++i) {
+        const double u = minInverse + (maxInverse - minInverse) * i / (kWidth - 1);
+        const glsl::tvec3<double> rgb = circle::kelvinToRgb(1.0 / u);
+        blackbody[i * 4 + 0] = float(rgb.x);
+        blackbody[i * 4 + 1] = float(rgb.y);
+        blackbody[i * 4 + 2] = float(rgb.z);
+    }
+
+    const double inner = double(disk.interRadius) / disk.rs;
+    const double outer = double(disk.outerRadius) / disk.rs;
+    float* profile = texels.data() + kWidth * 4;
+    float* motion = texels.data() + kWidth * 8;
+    for (int i = 0; i < kWidth; ++i) {
+        const double x = double(i) / (kWidth - 1);
+        const double r = inner + x * (outer - inner);
+        const double er = circle::diskEffectiveRadius(r, 1.0, inner, outer);
+        profile[i * 4 + 0] = float(circle::shape(er, 4.0, 0.9));
+        profile[i * 4 + 1] = float(1.0 - 5.0 * (2.0 * (1.0 - er)) * (2.0 * (1.0 - er)));
+        profile[i * 4 + 2] = float(disk.diskA * std::pow(std::max(1.0 / r, 0.10), 3.0) *
+                                   std::max(1.0 - std::sqrt(inner / r), 0.000001));
+        profile[i * 4 + 3] = float(1.0 + 20.0 * std::exp(-10.0 * x));
+
+        motion[i * 4 + 0] = float(std::exp(x / 0.6));
+        // 1.5 Rs 以内没有圆轨道，只有 Kerr 表打开、内缘移进光子球时出现，此时速度由转移表给出，不查这一项
+        motion[i * 4 + 1] = float(std::sqrt(1.0 / std::max(2.0 * r - 3.0, 0.000001)));
+        motion[i * 4 + 2] = float(std::sqrt(std::max(1.0 - 1.0 / r, 0.000001)));
+        motion[i * 4 + 3] = float(12.0 * 2.0 / std::sqrt(3.0) * std::atan(std::sqrt(std::max(0.6666666 * r - 1.0, 0.0))));
+    }
+}
+
+bool EmissionTables::sameTables(const DiskParameters& a, const DiskParameters& b) {
+    return a.rs == b.rs && a.interRadius == b.interRadius && a.outerRadius == b.outerRadius && a.diskA == b.diskA;
+}
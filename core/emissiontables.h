@@ -0,0 +1,40 @@
+#ifndef EMISSIONTABLES_H
+#define EMISSIONTABLES_H
+
+#include <vector>
+#include "blackholekernel.h"
+
+// 吸积盘发射的查找表，代替 DiskEmission 每个样本里的 KelvinToRgb、Shape、盘温度和轨道速度等超越函数
+// 三行 kWidth 个RGBA float，作为一张 GL_RGBA32F 纹理上传，行内线性过滤：
+//   行0 黑体颜色：KelvinToRgb(1 / u)，u 在 [1 / kMaxKelvin, 1 / kMinKelvin] 上均匀取样（A 为0）。
+//       多普勒、引力红移和向外的降温都是乘在温度上的因子，按 1/K 取样后只是移动表内位置，一行即可代替
+//       (温度, 红移) 的二维表；1/K 超过 1 / kMinKelvin 时夹到最后一个纹素（黑色）
+//   行1、行2 径向剖面：x = (r - 内缘) / (外缘 - 内缘) 在 [0, 1] 上均匀取样
+//       行1 R 盘厚和密度 Shape(EffectiveRadius, 4, 0.9)，G 尘埃层厚度，B 盘温度的四次方（内缘附近仍然光滑），
+//           A 内侧增加的密度 1 + 20 exp(-10x)
+//       行2 R 降温因子 exp(x / 0.6)，G 开普勒轨道速度（以光速为单位），B 引力红移 sqrt(1 - Rs / r)，A 旋臂转角
+// 行0与盘无关；径向剖面只取决于 DiskParameters，黑洞质量和自旋（即内缘）变化时才需要重建
+class EmissionTables {
+public:
+    static const int kWidth = 1024;
+    static const int kRows = 3;
+    static constexpr float kMinKelvin = 400.0f;
+    static constexpr float kMaxKelvin = 100000.0f;
+
+    explicit EmissionTables(const DiskParameters& disk);
+
+    const DiskParameters& disk() const { return parameters; }
+    int width() const { return kWidth; }
+    int height() const { return kRows; }
+    // 行优先，width * height * 4 个float
+    const float* data() const { return texels.data(); }
+
+    // 两组参数给出的表是否相同（Rs、内外缘之比和温度系数）
+    static bool sameTables(const DiskParameters& a, const DiskParameters& b);
+
+private:
+    DiskParameters parameters;
+    std::vector<float> texels;
+};
+
+#endif // EMISSIONTABLES_H
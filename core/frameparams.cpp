@@ -0,0 +1,49 @@
+#include "frameparams.h"
+
+using namespace glsl;
+
+namespace {
+
+// 按行给出的 3x3 矩阵写成 std140 的 mat3：第 j 列为各行的第 j 个分量
+void storeRows(float (&m)[3][4], const vec3& row0, const vec3& row1, const vec3& row2) {
+    const float columns[3][4] = {{row0.x, row1.x, row2.x, 0.0f},
+                                 {row0.y, row1.y, row2.y, 0.0f},
+                                 {row0.z, row1.z, row2.z, 0.0f}};
+    for (int j = 0; j < 3; ++j) {
+        for (int i = 0; i < 4; ++i) {
+            m[j][i] = columns[j][i];
+        }
+    }
+}
+
+void storeVec3(float (&v)[4], const vec3& value) {
+    v[0] = value.x;
+    v[1] = value.y;
+    v[2] = value.z;
+    v[3] = 0.0f;
+}
+
+} // namespace
+
+BlackHoleFrameParams frameParams(const TraceParams& params, float spin) {
+    // 相机和黑洞系的变换与自旋无关，直接取 CPU 内核的每帧常量
+    const KernelConstants k = BlackHoleKernel(params).constants();
+    const DiskParameters disk = diskParameters(params.blackHoleMass, spin);
+
+    BlackHoleFrameParams frame;
+    storeRows(frame.worldToCamera, k.cameraX, k.cameraY, k.cameraZ);
+    storeRows(frame.cameraToDisk, k.diskX, k.diskY, k.diskZ);
+    storeVec3(frame.blackHolePos, k.blackHolePos);
+    storeVec3(frame.cameraPosOnDisk, vec3(dot(k.diskX, -k.blackHolePos), dot(k.diskY, -k.blackHolePos),
+                                          dot(k.diskZ, -k.blackHolePos)));
+    storeVec3(frame.diskAxis, k.diskY);
+    frame.rs = disk.rs;
+    frame.interRadius = disk.interRadius;
+    frame.outerRadius = disk.outerRadius;
+    frame.diskA = disk.diskA;
+    frame.quadraticedPeakTemperature = disk.quadraticedPeakTemperature;
+    frame.shiftMax = k.shiftMax;
+    frame.timeRate = k.timeRate;
+    frame.spin = spin;
+    return frame;
+}
@@ -0,0 +1,30 @@
+#ifndef FRAMEPARAMS_H
+#define FRAMEPARAMS_H
+
+#include "blackholekernel.h"
+
+// blackhole.glsl 中 uniform 块 BlackHoleFrameBlock（std140，binding 0）的内存布局。
+// SetupFrame 原先逐像素重算的盘参数、相机和黑洞系的变换只取决于帧参数，由 BlackHoleRenderer 每帧算一次上传。
+// std140 中 vec3 和 mat3 的每一列都按 vec4 对齐，这里一律展开成4个float
+struct BlackHoleFrameParams {
+    float worldToCamera[3][4];     // mat3（列优先），世界系到相机系的旋转，relens.frag 用其转置换回世界系
+    float cameraToDisk[3][4];      // mat3，相机系到黑洞系（y轴为盘法向）的旋转
+    float blackHolePos[4];         // 相机系中的黑洞位置
+    float cameraPosOnDisk[4];      // 黑洞系中的相机位置
+    float diskAxis[4];             // 相机系中的盘法向（单位向量）
+    float rs = 0.0f;               // 以下长度单位为光年
+    float interRadius = 0.0f;
+    float outerRadius = 0.0f;
+    float diskA = 0.0f;
+    float quadraticedPeakTemperature = 0.0f;
+    float shiftMax = 0.0f;
+    float timeRate = 0.0f;
+    float spin = 0.0f;             // 无量纲自旋，没有 Kerr 表时为0
+};
+
+static_assert(sizeof(BlackHoleFrameParams) == 176, "BlackHoleFrameParams must match the std140 layout of BlackHoleFrameBlock");
+
+// params 给出相机和黑洞质量，spin 为本帧实际使用的自旋（决定盘内缘）
+BlackHoleFrameParams frameParams(const TraceParams& params, float spin);
+
+#endif // FRAMEPARAMS_H
@@ -0,0 +1,116 @@
+#ifndef GLSLMATH_H
+#define GLSLMATH_H
+
+#include <cmath>
+
+// 与GLSL同名同义的最小向量库，用于把着色器代码逐行移植到C++
+// 分量类型T为模板参数：标量路径用float，需要时也可以换成double做参考
+namespace glsl {
+
+template <typename T>
+struct tvec2 {
+    T x, y;
+    tvec2() : x(T(0)), y(T(0)) {}
+    explicit tvec2(T s) : x(s), y(s) {}
+    tvec2(T x, T y) : x(x), y(y) {}
+
+    tvec2& operator+=(const tvec2& v) { x += v.x; y += v.y; return *this; }
+    tvec2& operator-=(const tvec2& v) { x -= v.x; y -= v.y; return *this; }
+    tvec2& operator*=(T s) { x *= s; y *= s; return *this; }
+};
+
+template <typename T>
+struct tvec3 {
+    T x, y, z;
+    tvec3() : x(T(0)), y(T(0)), z(T(0)) {}
+    explicit tvec3(T s) : x(s), y(s), z(s) {}
+    tvec3(T x, T y, T z) : x(x), y(y), z(z) {}
+
+    tvec2<T> zx() const { return tvec2<T>(z, x); }
+
+    tvec3& operator+=(const tvec3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+    tvec3& operator-=(const tvec3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+    tvec3& operator*=(const tvec3& v) { x *= v.x; y *= v.y; z *= v.z; return *this; }
+    tvec3& operator*=(T s) { x *= s; y *= s; z *= s; return *this; }
+};
+
+template <typename T>
+struct tvec4 {
+    T x, y, z, w;
+    tvec4() : x(T(0)), y(T(0)), z(T(0)), w(T(0)) {}
+    explicit tvec4(T s) : x(s), y(s), z(s), w(s) {}
+    tvec4(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+    tvec4(const tvec3<T>& v, T w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    tvec3<T> xyz() const { return tvec3<T>(x, y, z); }
+    void setXyz(const tvec3<T>& v) { x = v.x; y = v.y; z = v.z; }
+
+    tvec4& operator+=(const tvec4& v) { x += v.x; y += v.y; z += v.z; w += v.w; return *this; }
+    tvec4& operator*=(T s) { x *= s; y *= s; z *= s; w *= s; return *this; }
+};
+
+// 3x3矩阵按列存储，与GLSL的mat3一致：m * v 为列的线性组合
+template <typename T>
+struct tmat3 {
+    tvec3<T> col[3];
+    tmat3() : col{tvec3<T>(1, 0, 0), tvec3<T>(0, 1, 0), tvec3<T>(0, 0, 1)} {}
+    tmat3(const tvec3<T>& c0, const tvec3<T>& c1, const tvec3<T>& c2) : col{c0, c1, c2} {}
+};
+
+template <typename T> inline tvec2<T> operator+(tvec2<T> a, const tvec2<T>& b) { return a += b; }
+template <typename T> inline tvec2<T> operator-(tvec2<T> a, const tvec2<T>& b) { return a -= b; }
+template <typename T> inline tvec2<T> operator*(tvec2<T> a, T s) { return a *= s; }
+template <typename T> inline tvec2<T> operator*(T s, tvec2<T> a) { return a *= s; }
+template <typename T> inline tvec2<T> operator/(const tvec2<T>& a, const tvec2<T>& b) {
+    return tvec2<T>(a.x / b.x, a.y / b.y);
+}
+
+template <typename T> inline tvec3<T> operator+(tvec3<T> a, const tvec3<T>& b) { return a += b; }
+template <typename T> inline tvec3<T> operator-(tvec3<T> a, const tvec3<T>& b) { return a -= b; }
+template <typename T> inline tvec3<T> operator-(const tvec3<T>& a) { return tvec3<T>(-a.x, -a.y, -a.z); }
+template <typename T> inline tvec3<T> operator*(tvec3<T> a, const tvec3<T>& b) { return a *= b; }
+template <typename T> inline tvec3<T> operator*(tvec3<T> a, T s) { return a *= s; }
+template <typename T> inline tvec3<T> operator*(T s, tvec3<T> a) { return a *= s; }
+template <typename T> inline tvec3<T> operator/(const tvec3<T>& a, T s) { return tvec3<T>(a.x / s, a.y / s, a.z / s); }
+
+template <typename T> inline tvec4<T> operator+(tvec4<T> a, const tvec4<T>& b) { return a += b; }
+template <typename T> inline tvec4<T> operator*(tvec4<T> a, T s) { return a *= s; }
+template <typename T> inline tvec4<T> operator*(T s, tvec4<T> a) { return a *= s; }
+
+template <typename T> inline bool operator==(const tvec3<T>& a, const tvec3<T>& b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+template <typename T> inline tvec3<T> operator*(const tmat3<T>& m, const tvec3<T>& v) {
+    return m.col[0] * v.x + m.col[1] * v.y + m.col[2] * v.z;
+}
+
+template <typename T> inline T dot(const tvec2<T>& a, const tvec2<T>& b) { return a.x * b.x + a.y * b.y; }
+template <typename T> inline T dot(const tvec3<T>& a, const tvec3<T>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+template <typename T> inline T length(const tvec2<T>& v) { return std::sqrt(dot(v, v)); }
+template <typename T> inline T length(const tvec3<T>& v) { return std::sqrt(dot(v, v)); }
+template <typename T> inline tvec3<T> normalize(const tvec3<T>& v) { return v * (T(1) / length(v)); }
+template <typename T> inline tvec3<T> cross(const tvec3<T>& a, const tvec3<T>& b) {
+    return tvec3<T>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+// 一个参数为NaN时返回另一个（与GPU的min/max指令一致），着色器中 log 的负参数依赖这一点
+template <typename T> inline T min(T a, T b) { return std::fmin(a, b); }
+template <typename T> inline T max(T a, T b) { return std::fmax(a, b); }
+template <typename T> inline T clamp(T x, T lo, T hi) { return min(max(x, lo), hi); }
+template <typename T> inline T fract(T x) { return x - std::floor(x); }
+template <typename T> inline T mix(T a, T b, T t) { return a * (T(1) - t) + b * t; }
+
+template <typename T> inline tvec3<T> floor(const tvec3<T>& v) {
+    return tvec3<T>(std::floor(v.x), std::floor(v.y), std::floor(v.z));
+}
+template <typename T> inline tvec3<T> fract(const tvec3<T>& v) { return tvec3<T>(fract(v.x), fract(v.y), fract(v.z)); }
+
+using vec2 = tvec2<float>;
+using vec3 = tvec3<float>;
+using vec4 = tvec4<float>;
+using mat3 = tmat3<float>;
+
+} // namespace glsl
+
+#endif // GLSLMATH_H
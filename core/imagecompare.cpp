@@ -0,0 +1,67 @@
+#include "imagecompare.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+ImageDiff compareImages(const float* a, const float* b, int width, int height, float tolerance, int blockSize) {
+    ImageDiff diff;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const size_t offset = (size_t(y) * width + x) * 4;
+            bool exceeds = false;
+            for (int c = 0; c < 4; ++c) {
+                const double error = std::fabs(double(a[offset + c]) - double(b[offset + c]));
+                if (error > diff.maxError) {
+                    diff.maxError = error;
+                    diff.worstX = x;
+                    diff.worstY = y;
+                }
+                if (c < 3) {
+                    sum += error;
+                    sumSquares += error * error;
+                    exceeds = exceeds || error > tolerance;
+                }
+            }
+            if (exceeds) {
+                ++diff.exceedCount;
+            }
+        }
+    }
+    const double samples = double(width) * height * 3.0;
+    if (samples > 0.0) {
+        diff.meanError = sum / samples;
+        diff.rmse = std::sqrt(sumSquares / samples);
+        diff.exceedFraction = diff.exceedCount / (double(width) * height);
+    }
+
+    // 块平均误差，图像边缘不足一块的部分按实际像素数平均
+    double blockSum = 0.0;
+    int blockSamples = 0;
+    for (int by = 0; by < height; by += blockSize) {
+        for (int bx = 0; bx < width; bx += blockSize) {
+            const int bw = std::min(blockSize, width - bx);
+            const int bh = std::min(blockSize, height - by);
+            for (int c = 0; c < 3; ++c) {
+                double sumA = 0.0;
+                double sumB = 0.0;
+                for (int y = by; y < by + bh; ++y) {
+                    for (int x = bx; x < bx + bw; ++x) {
+                        const size_t offset = (size_t(y) * width + x) * 4 + c;
+                        sumA += a[offset];
+                        sumB += b[offset];
+                    }
+                }
+                const double error = std::fabs(sumA - sumB) / (double(bw) * bh);
+                blockSum += error;
+                diff.blockMaxError = std::max(diff.blockMaxError, error);
+                ++blockSamples;
+            }
+        }
+    }
+    if (blockSamples > 0) {
+        diff.blockMeanError = blockSum / blockSamples;
+    }
+    return diff;
+}
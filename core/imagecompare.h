@@ -0,0 +1,22 @@
+#ifndef IMAGECOMPARE_H
+#define IMAGECOMPARE_H
+
+// 两幅RGBA浮点图像的差异统计（CPU移植与GLSL输出对比用）
+// 着色器的噪声用 fract(sin(x) * 43758.5453) 做哈希，大参数下各家sin实现的结果不同，
+// 吸积盘纹理的单像素值在不同GPU之间本来就对不上，因此另给出按块平均后的误差，衡量结构是否一致
+struct ImageDiff {
+    double maxError = 0.0;       // 所有通道的最大绝对误差
+    double meanError = 0.0;      // RGB通道平均绝对误差
+    double rmse = 0.0;           // RGB通道均方根误差
+    int exceedCount = 0;         // 任一RGB通道误差超过容差的像素数
+    double exceedFraction = 0.0;
+    int worstX = 0;              // 最大误差所在像素（OpenGL坐标）
+    int worstY = 0;
+    double blockMeanError = 0.0;   // blockSize x blockSize 块平均后RGB通道的平均绝对误差
+    double blockMaxError = 0.0;
+};
+
+// 图像为 width * height * 4 个float；alpha只计入maxError
+ImageDiff compareImages(const float* a, const float* b, int width, int height, float tolerance, int blockSize = 8);
+
+#endif // IMAGECOMPARE_H
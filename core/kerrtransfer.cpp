@@ -0,0 +1,286 @@
+#include "kerrtransfer.h"
+#include "workstealingpool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+const uint32_t kFileVersion = 1;
+
+// 光线状态 (r, theta, phi, p_r, p_theta)，p_t = -E、p_phi = L 守恒
+struct State {
+    double v[5];
+};
+
+// 哈密顿量 H = F / (2 Sigma)，F = Delta p_r^2 + p_theta^2 - W^2 / Delta + V^2 / sin^2(theta)，
+// W = (r^2 + a^2) E - a L，V = L - a E sin^2(theta)。在 H = 0 的壳层上 dp/dlambda = -dF/dx / (2 Sigma)
+struct KerrGeodesic {
+    double a;
+    double e;
+    double l;
+
+    void derivative(const State& s, State* d) const {
+        const double r = s.v[0];
+        const double sinTheta = std::sin(s.v[1]);
+        const double cosTheta = std::cos(s.v[1]);
+        const double sin2 = std::max(sinTheta * sinTheta, 1e-12);
+        const double pr = s.v[3];
+        const double ptheta = s.v[4];
+        const double sigma = r * r + a * a * cosTheta * cosTheta;
+        const double delta = r * r - 2.0 * r + a * a;
+        const double w = (r * r + a * a) * e - a * l;
+        const double v = l - a * e * sin2;
+
+        d->v[0] = delta * pr / sigma;
+        d->v[1] = ptheta / sigma;
+        d->v[2] = (a * w / delta + v / sin2) / sigma;
+        const double dFdr = (2.0 * r - 2.0) * pr * pr - 4.0 * r * e * w / delta + w * w * (2.0 * r - 2.0) / (delta * delta);
+        const double dFdtheta = -(2.0 * a * e * v * sin2 + v * v) / (sin2 * sin2) * 2.0 * sinTheta * cosTheta;
+        d->v[3] = -dFdr / (2.0 * sigma);
+        d->v[4] = -dFdtheta / (2.0 * sigma);
+    }
+};
+
+// Dormand–Prince 5(4) 的一步，返回误差与容差之比
+double dormandPrinceStep(const KerrGeodesic& g, const State& y, double h, State* out) {
+    static const double c[7][6] = {
+        {0, 0, 0, 0, 0, 0},
+        {1.0 / 5, 0, 0, 0, 0, 0},
+        {3.0 / 40, 9.0 / 40, 0, 0, 0, 0},
+        {44.0 / 45, -56.0 / 15, 32.0 / 9, 0, 0, 0},
+        {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729, 0, 0},
+        {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656, 0},
+        {35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84},
+    };
+    static const double errorWeights[7] = {71.0 / 57600, 0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200,
+                                           22.0 / 525, -1.0 / 40};
+    State k[7];
+    g.derivative(y, &k[0]);
+    for (int stage = 1; stage < 7; ++stage) {
+        State tmp = y;
+        for (int j = 0; j < stage; ++j) {
+            for (int i = 0; i < 5; ++i) {
+                tmp.v[i] += h * c[stage][j] * k[j].v[i];
+            }
+        }
+        if (stage == 6) {
+            *out = tmp;
+        }
+        g.derivative(tmp, &k[stage]);
+    }
+    const double relative = 1e-7;
+    const double absolute = 1e-9;
+    double error = 0.0;
+    for (int i = 0; i < 5; ++i) {
+        double e = 0.0;
+        for (int j = 0; j < 7; ++j) {
+            e += errorWeights[j] * k[j].v[i];
+        }
+        const double scale = absolute + relative * std::max(std::fabs(y.v[i]), std::fabs(out->v[i]));
+        error = std::max(error, std::fabs(h * e) / scale);
+    }
+    return error;
+}
+
+// 赤道面上顺行开普勒圆轨道的发射体看到的频率与观察者（本地能量为1）之比的倒数
+double equatorialRedshift(double a, double r, double e, double l) {
+    const double omega = 1.0 / (r * std::sqrt(r) + a);
+    const double gtt = -(1.0 - 2.0 / r);
+    const double gtphi = -2.0 * a / r;
+    const double gphiphi = r * r + a * a + 2.0 * a * a / r;
+    const double norm = -(gtt + 2.0 * gtphi * omega + gphiphi * omega * omega);
+    if (norm <= 1e-9) {
+        // 光子轨道以内没有圆轨道
+        return 0.0;
+    }
+    const double ut = 1.0 / std::sqrt(norm);
+    // 光线逆时追踪，真实光子的 E、L 与追踪用的符号相反
+    const double emitted = ut * (-e + omega * l);
+    return emitted > 0.0 ? 1.0 / emitted : 0.0;
+}
+
+float roundTo(float value, float step) {
+    return std::round(value / step) * step;
+}
+
+} // namespace
+
+KerrTableKey KerrTableKey::quantized(float spin, float radius, float inclination) {
+    KerrTableKey key;
+    key.spin = std::max(-0.999f, std::min(0.999f, roundTo(spin, 0.001f)));
+    const float logStep = std::log(1.005f);
+    key.radius = std::exp(roundTo(std::log(std::max(radius, 1.0f)), logStep));
+    // 自旋轴上 e_phi 没有定义，稍微避开两极
+    const float degree = float(kPi) / 180.0f;
+    key.inclination = std::max(0.5f * degree, std::min(179.5f * degree, roundTo(inclination, 0.25f * degree)));
+    return key;
+}
+
+KerrRay traceKerrRay(double spin, double observerRadius, double observerTheta, double nr, double ntheta, double nphi) {
+    KerrRay ray;
+    const double a = spin;
+    const double r0 = 2.0 * observerRadius;
+    const double sinTheta0 = std::sin(observerTheta);
+    const double cosTheta0 = std::cos(observerTheta);
+    const double sigma0 = r0 * r0 + a * a * cosTheta0 * cosTheta0;
+    const double delta0 = r0 * r0 - 2.0 * r0 + a * a;
+    const double big0 = (r0 * r0 + a * a) * (r0 * r0 + a * a) - a * a * delta0 * sinTheta0 * sinTheta0;
+    const double lapse = std::sqrt(sigma0 * delta0 / big0);
+    const double frameDrag = 2.0 * a * r0 / big0;
+    const double cylindrical = std::sqrt(big0 / sigma0) * sinTheta0;
+
+    // 追踪用的动量是真实光子动量取反（本地能量归一为1），沿 n 前进
+    KerrGeodesic g;
+    g.a = a;
+    g.e = -(lapse - frameDrag * cylindrical * nphi);
+    g.l = cylindrical * nphi;
+    State y = {{r0, observerTheta, 0.0, nr * std::sqrt(sigma0 / delta0), ntheta * std::sqrt(sigma0)}};
+
+    const double horizon = 1.0 + std::sqrt(std::max(0.0, 1.0 - a * a));
+    const double escapeRadius = std::max(1000.0, 50.0 * r0);
+    double h = 0.01 * r0;
+    int crossings = 0;
+    for (int step = 0; step < 100000; ++step) {
+        const double r = y.v[0];
+        if (r < horizon + 0.01) {
+            return ray;
+        }
+        State d;
+        g.derivative(y, &d);
+        if (r > escapeRadius && d.v[0] > 0.0) {
+            // 远处的坐标速度方向即逃逸方向
+            const double sinTheta = std::sin(y.v[1]);
+            const double cosTheta = std::cos(y.v[1]);
+            const double sinPhi = std::sin(y.v[2]);
+            const double cosPhi = std::cos(y.v[2]);
+            const double vr = d.v[0];
+            const double vtheta = r * d.v[1];
+            const double vphi = r * sinTheta * d.v[2];
+            double dir[3] = {vr * sinTheta * cosPhi + vtheta * cosTheta * cosPhi - vphi * sinPhi,
+                             vr * sinTheta * sinPhi + vtheta * cosTheta * sinPhi + vphi * cosPhi,
+                             vr * cosTheta - vtheta * sinTheta};
+            const double length = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+            for (int i = 0; i < 3; ++i) {
+                ray.escapeDir[i] = dir[i] / length;
+            }
+            ray.escaped = true;
+            return ray;
+        }
+
+        h = std::min(h, 0.05 * r);
+        State next;
+        const double error = dormandPrinceStep(g, y, h, &next);
+        if (error > 1.0) {
+            h *= std::max(0.2, 0.9 * std::pow(error, -0.2));
+            continue;
+        }
+
+        // 穿过赤道面时按 cos(theta) 线性插值
+        const double before = std::cos(y.v[1]);
+        const double after = std::cos(next.v[1]);
+        if (crossings < 2 && before * after <= 0.0 && before != after) {
+            const double t = before / (before - after);
+            const double rc = y.v[0] + t * (next.v[0] - y.v[0]);
+            const double phic = y.v[2] + t * (next.v[2] - y.v[2]);
+            const double prc = y.v[3] + t * (next.v[3] - y.v[3]);
+            const double pthetac = y.v[4] + t * (next.v[4] - y.v[4]);
+            KerrCrossing& crossing = ray.crossings[crossings++];
+            crossing.valid = true;
+            crossing.x = 0.5 * rc * std::cos(phic);
+            crossing.y = 0.5 * rc * std::sin(phic);
+            crossing.redshift = equatorialRedshift(a, rc, g.e, g.l);
+            const double sigmac = rc * rc;
+            const double deltac = rc * rc - 2.0 * rc + a * a;
+            const double bigc = (rc * rc + a * a) * (rc * rc + a * a) - a * a * deltac;
+            const double kr = prc * std::sqrt(deltac / sigmac);
+            const double ktheta = pthetac / std::sqrt(sigmac);
+            const double kphi = g.l / std::sqrt(bigc / sigmac);
+            crossing.cosIncidence = std::fabs(ktheta) / std::sqrt(kr * kr + ktheta * ktheta + kphi * kphi);
+        }
+        y = next;
+        h *= std::min(5.0, 0.9 * std::pow(std::max(error, 1e-10), -0.2));
+    }
+    return ray;
+}
+
+bool KerrTransferTable::build(const KerrTableKey& key, WorkStealingPool& pool, const std::atomic<bool>* cancel) {
+    tableKey = key;
+    const size_t layerFloats = size_t(kChiCount) * kPsiCount * 4;
+    texels.assign(layerFloats * kLayers, 0.0f);
+    std::vector<int> rows(kPsiCount);
+    for (int row = 0; row < kPsiCount; ++row) {
+        rows[size_t(row)] = row;
+    }
+    pool.run(rows, [&](int row, int) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            return;
+        }
+        const double psi = kPi * row / (kPsiCount - 1);
+        for (int column = 0; column < kChiCount; ++column) {
+            const double chi = 2.0 * kPi * column / kChiCount;
+            const KerrRay ray = traceKerrRay(key.spin, key.radius, key.inclination, -std::cos(psi),
+                                             std::sin(psi) * std::cos(chi), std::sin(psi) * std::sin(chi));
+            const size_t texel = (size_t(row) * kChiCount + column) * 4;
+            for (int i = 0; i < 2; ++i) {
+                const KerrCrossing& crossing = ray.crossings[i];
+                if (crossing.valid) {
+                    float* out = texels.data() + layerFloats * i + texel;
+                    out[0] = float(crossing.x);
+                    out[1] = float(crossing.y);
+                    out[2] = float(crossing.redshift);
+                    out[3] = float(crossing.cosIncidence);
+                }
+            }
+            if (ray.escaped) {
+                float* out = texels.data() + layerFloats * 2 + texel;
+                out[0] = float(ray.escapeDir[0]);
+                out[1] = float(ray.escapeDir[1]);
+                out[2] = float(ray.escapeDir[2]);
+                out[3] = 1.0f;
+            }
+        }
+    });
+    return !(cancel && cancel->load());
+}
+
+bool KerrTransferTable::save(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const uint32_t header[4] = {kFileVersion, uint32_t(kChiCount), uint32_t(kPsiCount), uint32_t(kLayers)};
+    const float key[3] = {tableKey.spin, tableKey.radius, tableKey.inclination};
+    bool ok = std::fwrite("BHKERR01", 1, 8, file) == 8 && std::fwrite(header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(key, sizeof(key), 1, file) == 1 &&
+              std::fwrite(texels.data(), sizeof(float), texels.size(), file) == texels.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+bool KerrTransferTable::load(const std::string& path, const KerrTableKey& expected) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    char magic[8];
+    uint32_t header[4];
+    float key[3];
+    bool ok = std::fread(magic, 1, 8, file) == 8 && std::memcmp(magic, "BHKERR01", 8) == 0 &&
+              std::fread(header, sizeof(header), 1, file) == 1 && header[0] == kFileVersion &&
+              header[1] == uint32_t(kChiCount) && header[2] == uint32_t(kPsiCount) && header[3] == uint32_t(kLayers) &&
+              std::fread(key, sizeof(key), 1, file) == 1 && key[0] == expected.spin && key[1] == expected.radius &&
+              key[2] == expected.inclination;
+    if (ok) {
+        std::vector<float> data(size_t(kChiCount) * kPsiCount * 4 * kLayers);
+        ok = std::fread(data.data(), sizeof(float), data.size(), file) == data.size();
+        if (ok) {
+            texels.swap(data);
+            tableKey = expected;
+        }
+    }
+    std::fclose(file);
+    return ok;
+}
@@ -0,0 +1,83 @@
+#ifndef KERRTRANSFER_H
+#define KERRTRANSFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WorkStealingPool;
+
+// Kerr 黑洞的转移表：对固定的自旋、观察者半径和倾角，把观察者天空上的每个方向映射到
+// 光线（逆时追踪）穿过赤道面的位置和频移，以及最终的逃逸方向。circle.frag 每帧只查表，
+// 不做Kerr测地线积分。长度以Rs为单位，积分在Boyer–Lindquist坐标中进行（内部取 M = 1）
+//
+// 观察者是半径 r0、极角 theta0、方位角 0 处的零角动量观察者（ZAMO），本地方向 n 用
+//   psi：与指向黑洞的方向（-e_r）的夹角，chi：绕该方向的转角，n = -cos(psi) e_r + sin(psi) (cos(chi) e_theta + sin(chi) e_phi)
+// 表示。其他方位角的观察者只需把结果绕自旋轴转过相应角度。
+// BL 笛卡尔坐标 (X, Y, Z) = (r sin(theta) cos(phi), r sin(theta) sin(phi), r cos(theta))，Z 为自旋轴，
+// 自旋为正时顺行轨道的 phi 增加
+
+// 表的参数，按 quantized 取整后作为缓存的键
+struct KerrTableKey {
+    float spin = 0.0f;          // a / M，|spin| < 1
+    float radius = 10.0f;       // 观察者的BL半径（Rs）
+    float inclination = 1.0f;   // 观察者与自旋轴的夹角（弧度）
+
+    // 自旋取到0.001，半径按0.5%的对数间隔，倾角取到0.25度
+    static KerrTableKey quantized(float spin, float radius, float inclination);
+    bool operator==(const KerrTableKey& other) const {
+        return spin == other.spin && radius == other.radius && inclination == other.inclination;
+    }
+    bool operator!=(const KerrTableKey& other) const { return !(*this == other); }
+};
+
+// 一次穿过赤道面
+struct KerrCrossing {
+    bool valid = false;
+    double x = 0.0;            // BL 笛卡尔坐标（观察者在 phi = 0），Rs
+    double y = 0.0;
+    double redshift = 0.0;     // 观测频率与顺行开普勒圆轨道上发射频率之比；轨道不存在时为0
+    double cosIncidence = 0.0; // 穿越处（ZAMO系）光线与盘法向夹角余弦的绝对值
+};
+
+struct KerrRay {
+    KerrCrossing crossings[2];   // 按追踪顺序的前两次穿越
+    bool escaped = false;
+    double escapeDir[3] = {0.0, 0.0, 0.0};   // 无穷远处的方向（BL 笛卡尔坐标）
+};
+
+// 逆时追踪观察者沿本地方向 (nr, ntheta, nphi)（单位向量）看到的光线
+KerrRay traceKerrRay(double spin, double observerRadius, double observerTheta, double nr, double ntheta, double nphi);
+
+// 三层 width x height 的RGBA32F，列为 chi 在 [0, 2pi) 上均匀取样（可循环），行为 psi 在 [0, pi] 上均匀取样：
+//   层0、1：第一、二次穿越 (X, Y, 频移, 入射角余弦)，没有穿越时频移为0
+//   层2：逃逸方向 (X, Y, Z, 1)，被吞噬时为0
+class KerrTransferTable {
+public:
+    static const int kChiCount = 512;
+    static const int kPsiCount = 1024;
+    static const int kLayers = 3;
+
+    KerrTransferTable() = default;
+
+    // 按行分给线程池生成，阻塞到完成；cancel 置位后剩余的行不再追踪，返回false（表不完整）
+    bool build(const KerrTableKey& key, WorkStealingPool& pool, const std::atomic<bool>* cancel = nullptr);
+    // 小端二进制文件："BHKERR01"、版本、键、尺寸，之后是三层数据
+    bool save(const std::string& path) const;
+    // 读取 path，文件的键或版本与 expected 不符时返回false
+    bool load(const std::string& path, const KerrTableKey& expected);
+
+    bool isEmpty() const { return texels.empty(); }
+    const KerrTableKey& key() const { return tableKey; }
+    int width() const { return kChiCount; }
+    int height() const { return kPsiCount; }
+    // 层优先、行优先，width * height * kLayers * 4 个float，可直接作为 GL_RGBA32F 的二维纹理数组上传
+    const float* data() const { return texels.data(); }
+
+private:
+    KerrTableKey tableKey;
+    std::vector<float> texels;
+};
+
+#endif // KERRTRANSFER_H
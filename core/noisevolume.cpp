@@ -0,0 +1,13 @@
+#include "noisevolume.h"
+#include <cstddef>
+
+NoiseVolume::NoiseVolume() : texels(std::size_t(kSize) * kSize * kSize) {
+    std::size_t index = 0;
+    for (int z = 0; z < kSize; ++z) {
+        for (int y = 0; y < kSize; ++y) {
+            for (int x = 0; x < kSize; ++x) {
+                texels[index++] = lattice(x, y, z);
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef NOISEVOLUME_H
+#define NOISEVOLUME_H
+
+#include <cstdint>
+#include <vector>
+
+// 吸积盘噪声的格点值：整数格点上 [-1, 1] 的随机数，三个方向都以 kSize 为周期
+// blackhole.glsl 的 DiskNoise 把它作为 3D 纹理（GL_REPEAT）用硬件三线性过滤读取，代替每个格点一次 sin 哈希；
+// CPU 端 circle::latticeValue 直接调用 lattice，两边格点值逐位相同
+class NoiseVolume {
+public:
+    static const int kSize = 64;
+
+    NoiseVolume();
+
+    int size() const { return kSize; }
+    // x 最快、z 最慢，kSize^3 个float，可直接作为 GL_R16F 纹理上传（值都是 1/1024 的整数倍，半精度无损）
+    const float* data() const { return texels.data(); }
+
+    // 格点 (x, y, z) 的值，坐标先按 kSize 取模（负数同样按周期折回）
+    static float lattice(std::int64_t x, std::int64_t y, std::int64_t z) {
+        const std::uint32_t mask = kSize - 1;
+        std::uint32_t h = (std::uint32_t(x) & mask) + kSize * ((std::uint32_t(y) & mask) + kSize * (std::uint32_t(z) & mask));
+        h = h * 0x9e3779b9u + 0x6a09e667u;
+        h ^= h >> 16;
+        h *= 0x7feb352du;
+        h ^= h >> 15;
+        h *= 0x846ca68bu;
+        h ^= h >> 16;
+        return float(int(h >> 21) - 1024) / 1024.0f;
+    }
+
+private:
+    std::vector<float> texels;
+};
+
+#endif // NOISEVOLUME_H
@@ -0,0 +1,110 @@
+#include "packetkernel.h"
+#include "packetlanes.h"
+#include <cstring>
+#include <initializer_list>
+
+using namespace glsl;
+
+void lanePrimaryRay(const BlackHoleKernel& kernel, int x, int y, float* dir, float* firstStep) {
+    vec3 rayDir;
+    kernel.primaryRay(x, y, &rayDir, firstStep);
+    dir[0] = rayDir.x;
+    dir[1] = rayDir.y;
+    dir[2] = rayDir.z;
+}
+
+void laneBackground(const BlackHoleKernel& kernel, float* rgba, const float* dir) {
+    const vec4 color = kernel.background(vec4(rgba[0], rgba[1], rgba[2], rgba[3]), vec3(dir[0], dir[1], dir[2]));
+    std::memcpy(rgba, &color, sizeof(color));
+}
+
+void laneDiskColor(const BlackHoleKernel& kernel, float* rgba, float stepLength, const float* pos, const float* dir) {
+    const vec4 color = kernel.diskColor(vec4(rgba[0], rgba[1], rgba[2], rgba[3]), stepLength,
+                                        vec3(pos[0], pos[1], pos[2]), vec3(dir[0], dir[1], dir[2]));
+    std::memcpy(rgba, &color, sizeof(color));
+}
+
+void laneEncode(float* rgba) {
+    const vec4 color = BlackHoleKernel::encodeForBloom(vec4(rgba[0], rgba[1], rgba[2], rgba[3]));
+    std::memcpy(rgba, &color, sizeof(color));
+}
+
+bool simdIsaSupported(SimdIsa isa) {
+    switch (isa) {
+    case SimdIsa::Scalar:
+        return true;
+#if defined(BLACKHOLE_SIMD_X86)
+    case SimdIsa::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case SimdIsa::Avx2:
+        return __builtin_cpu_supports("avx2");
+    case SimdIsa::Avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+SimdIsa detectSimdIsa() {
+    for (SimdIsa isa : {SimdIsa::Avx512, SimdIsa::Avx2, SimdIsa::Sse2}) {
+        if (simdIsaSupported(isa)) {
+            return isa;
+        }
+    }
+    return SimdIsa::Scalar;
+}
+
+int simdWidth(SimdIsa isa) {
+    switch (isa) {
+    case SimdIsa::Sse2: return 4;
+    case SimdIsa::Avx2: return 8;
+    case SimdIsa::Avx512: return 16;
+    default: return 1;
+    }
+}
+
+const char* simdIsaName(SimdIsa isa) {
+    switch (isa) {
+    case SimdIsa::Sse2: return "sse2";
+    case SimdIsa::Avx2: return "avx2";
+    case SimdIsa::Avx512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+bool parseSimdIsa(const char* name, SimdIsa* isa) {
+    if (std::strcmp(name, "auto") == 0) {
+        *isa = detectSimdIsa();
+        return true;
+    }
+    for (SimdIsa candidate : {SimdIsa::Scalar, SimdIsa::Sse2, SimdIsa::Avx2, SimdIsa::Avx512}) {
+        if (std::strcmp(name, simdIsaName(candidate)) == 0) {
+            *isa = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void shadeRow(SimdIsa isa, const BlackHoleKernel& kernel, int x, int y, int count, float* rgba, int* steps) {
+    switch (isa) {
+#if defined(BLACKHOLE_SIMD_X86)
+    case SimdIsa::Sse2:
+        shadeRowSse2(kernel, x, y, count, rgba, steps);
+        return;
+    case SimdIsa::Avx2:
+        shadeRowAvx2(kernel, x, y, count, rgba, steps);
+        return;
+    case SimdIsa::Avx512:
+        shadeRowAvx512(kernel, x, y, count, rgba, steps);
+        return;
+#endif
+    default:
+        for (int i = 0; i < count; ++i) {
+            const vec4 color = kernel.shade(x + i, y, &steps[i]);
+            std::memcpy(rgba + i * 4, &color, sizeof(color));
+        }
+        return;
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef PACKETKERNEL_H
+#define PACKETKERNEL_H
+
+#include "blackholekernel.h"
+
+// 一次推进多条光线的SIMD包内核：测地线步进、盘包围体测试按包计算，
+// 逃逸背景、DiskColor着色和bloom编码逐通道回退到标量实现（只有进入盘内的通道才需要）
+enum class SimdIsa {
+    Scalar,   // 逐像素调用 BlackHoleKernel::shade，作为基准
+    Sse2,     // 4条光线
+    Avx2,     // 8条光线
+    Avx512,   // 16条光线
+};
+
+// 当前CPU支持的最宽指令集（运行时检测）
+SimdIsa detectSimdIsa();
+bool simdIsaSupported(SimdIsa isa);
+int simdWidth(SimdIsa isa);
+const char* simdIsaName(SimdIsa isa);
+// "auto"、"scalar"、"sse2"、"avx2"、"avx512"
+bool parseSimdIsa(const char* name, SimdIsa* isa);
+
+// 渲染第 y 行从 x 开始的 count 个像素：rgba 为 count * 4 个float（未截断），steps 为每像素步数
+// 结果与 BlackHoleKernel::shade 逐位一致
+void shadeRow(SimdIsa isa, const BlackHoleKernel& kernel, int x, int y, int count, float* rgba, int* steps);
+
+#endif // PACKETKERNEL_H
@@ -0,0 +1,169 @@
+// 包内核模板，由各指令集的编译单元在包含 simdpacket.h 之后包含
+// 每一步的运算顺序与 BlackHoleKernel::shade（circle::geodesicStep）完全相同（编译时关闭浮点收缩），结果逐位一致
+#include "packetlanes.h"
+
+namespace {
+
+template <typename P>
+void shadeRowPacket(const BlackHoleKernel& kernel, int x0, int y, int count, float* rgba, int* steps) {
+    constexpr int N = P::width;
+    const KernelConstants& k = kernel.constants();
+    const P rs(k.rs);
+    const P outerRadius(k.outerRadius);
+    const P interRadius(k.interRadius);
+    const P holeX(k.blackHolePos.x), holeY(k.blackHolePos.y), holeZ(k.blackHolePos.z);
+    const P zero(0.0f), one(1.0f);
+    const P escapeRadius(2.5f * k.outerRadius);
+    const P horizonRadius(0.1f * k.rs);
+    const P halfThickness(0.5f * k.rs);
+    const P slabMargin(0.01f * k.rs);
+    const P slabStepFraction(k.slabStepFraction);
+    const P stepScaleRadius(k.outerRadius > 10.0f * k.rs ? k.outerRadius : 10.0f * k.rs);
+    const P bendFactor(1.5f * k.rs);
+    const float startDistance = __builtin_sqrtf(k.blackHolePos.x * k.blackHolePos.x + k.blackHolePos.y * k.blackHolePos.y +
+                                                k.blackHolePos.z * k.blackHolePos.z);
+
+    alignas(64) float laneDir[3][N];
+    alignas(64) float lanePos[3][N];
+    alignas(64) float laneFirstStep[N];
+    alignas(64) float laneStepLength[N];
+    alignas(64) float laneColor[N][4];
+
+    for (int base = 0; base < count; base += N) {
+        const int lanes = count - base < N ? count - base : N;
+        for (int lane = 0; lane < N; ++lane) {
+            // 尾部空通道复制第0条光线，保证数值有效，结果不写出
+            const int source = lane < lanes ? lane : 0;
+            float dir[3];
+            lanePrimaryRay(kernel, x0 + base + source, y, dir, &laneFirstStep[lane]);
+            laneDir[0][lane] = dir[0];
+            laneDir[1][lane] = dir[1];
+            laneDir[2][lane] = dir[2];
+            laneColor[lane][0] = laneColor[lane][1] = laneColor[lane][2] = laneColor[lane][3] = 0.0f;
+        }
+
+        P dirX = P::load(laneDir[0]), dirY = P::load(laneDir[1]), dirZ = P::load(laneDir[2]);
+        P posX = zero, posY = zero, posZ = zero;
+        P lastR(startDistance);
+        P stepLength = zero;
+        int active = (1 << lanes) - 1;
+        int iteration = 0;
+
+        while (active) {
+            const P toHoleX = posX - holeX, toHoleY = posY - holeY, toHoleZ = posZ - holeZ;
+            const P distance = sqrt(toHoleX * toHoleX + toHoleY * toHoleY + toHoleZ * toHoleZ);
+            const P normalX = toHoleX / distance, normalY = toHoleY / distance, normalZ = toHoleZ / distance;
+
+            // 远离黑洞：走得比上一步远且已过50步
+            const int escaped = iteration > 50
+                ? (greaterThan(distance, escapeRadius) & greaterThan(distance, lastR) & active) : 0;
+            const int captured = lessThan(distance, horizonRadius) & active;
+            int finished = escaped | captured;
+            if (escaped) {
+                dirX.store(laneDir[0]);
+                dirY.store(laneDir[1]);
+                dirZ.store(laneDir[2]);
+                for (int bits = escaped; bits; bits &= bits - 1) {
+                    const int lane = __builtin_ctz(bits);
+                    const float dir[3] = {laneDir[0][lane], laneDir[1][lane], laneDir[2][lane]};
+                    laneBackground(kernel, laneColor[lane], dir);
+                }
+            }
+
+            // 到盘包围体（黑洞系中 |y| < 0.5Rs 且 InterRadius < r < OuterRadius）的距离（circle::diskSlabGap），
+            // 只有落在其中（含 0.01Rs 余量）的通道逐个着色，在外的通道下一步放宽步长
+            const P diskHeight = toHoleX * P(k.diskY.x) + toHoleY * P(k.diskY.y) + toHoleZ * P(k.diskY.z);
+            const P diskRadius = sqrt(max(distance * distance - diskHeight * diskHeight, zero));
+            const P slabGap = max(abs(diskHeight) - halfThickness, max(diskRadius - outerRadius, interRadius - diskRadius));
+            const int marching = active & ~finished;
+            if (marching) {
+                const int inside = lessThan(slabGap, slabMargin) & marching;
+                if (inside) {
+                    posX.store(lanePos[0]);
+                    posY.store(lanePos[1]);
+                    posZ.store(lanePos[2]);
+                    dirX.store(laneDir[0]);
+                    dirY.store(laneDir[1]);
+                    dirZ.store(laneDir[2]);
+                    stepLength.store(laneStepLength);
+                    for (int bits = inside; bits; bits &= bits - 1) {
+                        const int lane = __builtin_ctz(bits);
+                        const float pos[3] = {lanePos[0][lane], lanePos[1][lane], lanePos[2][lane]};
+                        const float dir[3] = {laneDir[0][lane], laneDir[1][lane], laneDir[2][lane]};
+                        laneDiskColor(kernel, laneColor[lane], laneStepLength[lane], pos, dir);
+                        if (laneColor[lane][3] > 0.99f) {
+                            finished |= 1 << lane;
+                        }
+                    }
+                }
+            }
+
+            if (finished) {
+                for (int bits = finished; bits; bits &= bits - 1) {
+                    const int lane = __builtin_ctz(bits);
+                    if (lane < lanes) {
+                        steps[base + lane] = iteration + 1;
+                    }
+                }
+                active &= ~finished;
+                if (!active) {
+                    break;
+                }
+            }
+
+            // 步进：所有通道一起算，已终止通道的结果不再使用
+            lastR = distance;
+            const P crossX = normalY * dirZ - normalZ * dirY;
+            const P crossY = normalZ * dirX - normalX * dirZ;
+            const P crossZ = normalX * dirY - normalY * dirX;
+            const P cosTheta = sqrt(crossX * crossX + crossY * crossY + crossZ * crossZ);
+            const P deltaPhiRate = P(-1.0f) * cosTheta * cosTheta * cosTheta * (bendFactor / distance);
+
+            P rayStep = iteration == 0 ? P::load(laneFirstStep) : one;
+            rayStep = rayStep * (P(0.15f) + P(0.25f) * min(max(zero, P(0.5f) * (P(0.5f) * distance / stepScaleRadius - one)), one));
+            const P farStep = rayStep * distance;
+            const P middleStep = rayStep * ((rs * (P(2.0f) * outerRadius - distance) +
+                                             distance * (distance - outerRadius)) / outerRadius);
+            const P nearStep = rayStep * min(rs, distance);
+            rayStep = selectGreaterEqual(distance, P(2.0f) * outerRadius, farStep,
+                                         selectGreaterEqual(distance, outerRadius, middleStep, nearStep));
+            if (iteration > 0) {
+                // slabGap > 0 的通道：max(rayStep, min(slabGap, kSlabStepFraction * r))
+                const P slabStep = max(rayStep, min(slabGap, slabStepFraction * distance));
+                rayStep = selectGreaterEqual(zero, slabGap, rayStep, slabStep);
+            }
+
+            posX = posX + dirX * rayStep;
+            posY = posY + dirY * rayStep;
+            posZ = posZ + dirZ * rayStep;
+            const P deltaPhi = rayStep / distance * deltaPhiRate;
+            const P tanDeltaPhi = deltaPhi + deltaPhi * deltaPhi * deltaPhi / P(3.0f);
+
+            // cross(cross(RayDir, N), RayDir)
+            const P bX = dirY * normalZ - dirZ * normalY;
+            const P bY = dirZ * normalX - dirX * normalZ;
+            const P bZ = dirX * normalY - dirY * normalX;
+            const P turnX = bY * dirZ - bZ * dirY;
+            const P turnY = bZ * dirX - bX * dirZ;
+            const P turnZ = bX * dirY - bY * dirX;
+            const P newX = dirX + tanDeltaPhi * turnX / cosTheta;
+            const P newY = dirY + tanDeltaPhi * turnY / cosTheta;
+            const P newZ = dirZ + tanDeltaPhi * turnZ / cosTheta;
+            const P invLength = one / sqrt(newX * newX + newY * newY + newZ * newZ);
+            dirX = newX * invLength;
+            dirY = newY * invLength;
+            dirZ = newZ * invLength;
+            stepLength = rayStep;
+            ++iteration;
+        }
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            laneEncode(laneColor[lane]);
+            for (int c = 0; c < 4; ++c) {
+                rgba[(base + lane) * 4 + c] = laneColor[lane][c];
+            }
+        }
+    }
+}
+
+} // namespace
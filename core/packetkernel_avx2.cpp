@@ -0,0 +1,16 @@
+// AVX2 包内核和后处理行内核（本文件单独以对应指令集编译，只在运行时检测到支持时调用）
+#include "simdpacket.h"
+#include "packetkernel.inl"
+#include "postrows.inl"
+
+void shadeRowAvx2(const BlackHoleKernel& kernel, int x, int y, int count, float* rgba, int* steps) {
+    shadeRowPacket<PacketAvx2>(kernel, x, y, count, rgba, steps);
+}
+
+void accumulateRowAvx2(float* dst, const float* src, float weight, int count) {
+    accumulateRowPacket<PacketAvx2>(dst, src, weight, count);
+}
+
+void convolveRowAvx2(const float* src, float* dst, int count, const float* weights, int taps) {
+    convolveRowPacket<PacketAvx2>(src, dst, count, weights, taps);
+}
@@ -0,0 +1,16 @@
+// SSE2 包内核和后处理行内核（本文件单独以对应指令集编译，只在运行时检测到支持时调用）
+#include "simdpacket.h"
+#include "packetkernel.inl"
+#include "postrows.inl"
+
+void shadeRowSse2(const BlackHoleKernel& kernel, int x, int y, int count, float* rgba, int* steps) {
+    shadeRowPacket<PacketSse2>(kernel, x, y, count, rgba, steps);
+}
+
+void accumulateRowSse2(float* dst, const float* src, float weight, int count) {
+    accumulateRowPacket<PacketSse2>(dst, src, weight, count);
+}
+
+void convolveRowSse2(const float* src, float* dst, int count, const float* weights, int taps) {
+    convolveRowPacket<PacketSse2>(src, dst, count, weights, taps);
+}
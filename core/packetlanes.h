@@ -0,0 +1,17 @@
+#ifndef PACKETLANES_H
+#define PACKETLANES_H
+
+#include "blackholekernel.h"
+
+// 包内核的逐通道标量回退，实现在基线指令集的 packetkernel.cpp 中
+// 各指令集编译单元只通过这些非内联函数接触 glsl 向量类型，避免实例化出带AVX指令的共享内联函数
+void lanePrimaryRay(const BlackHoleKernel& kernel, int x, int y, float* dir, float* firstStep);
+void laneBackground(const BlackHoleKernel& kernel, float* rgba, const float* dir);
+void laneDiskColor(const BlackHoleKernel& kernel, float* rgba, float stepLength, const float* pos, const float* dir);
+void laneEncode(float* rgba);
+
+void shadeRowSse2(const BlackHoleKernel& kernel, int x, int y, int count, float* rgba, int* steps);
+void shadeRowAvx2(const BlackHoleKernel& kernel, int x, int y, int count, float* rgba, int* steps);
+void shadeRowAvx512(const BlackHoleKernel& kernel, int x, int y, int count, float* rgba, int* steps);
+
+#endif // PACKETLANES_H
@@ -0,0 +1,365 @@
+#include "postprocess.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include "postrows.h"
+#include "tonemap.h"
+
+namespace {
+
+// horizontal.frag / vertical.frag 的权重和偏移（单位为像素的两倍）
+const float kBlurWeights[5] = {0.19638062f, 0.29675293f, 0.09442139f, 0.01037598f, 0.00025940f};
+const float kBlurOffsets[5] = {0.00000000f, 1.41176471f, 3.29411765f, 5.17647059f, 7.05882353f};
+// screen_result.frag GetBloom 中各级的权重
+const float kBloomWeights[8] = {1.0f, 1.5f, 1.0f, 1.5f, 1.8f, 1.0f, 1.0f, 0.5f};
+
+void accumulateRowScalar(float* dst, const float* src, float weight, int count) {
+    for (int x = 0; x < count; ++x) {
+        dst[x] += weight * src[x];
+    }
+}
+
+void convolveRowScalar(const float* src, float* dst, int count, const float* weights, int taps) {
+    for (int x = 0; x < count; ++x) {
+        float sum = weights[0] * src[x];
+        for (int t = 1; t < taps; ++t) {
+            sum += weights[t] * src[x + t];
+        }
+        dst[x] = sum;
+    }
+}
+
+inline int clampIndex(int i, int size) {
+    return i < 0 ? 0 : (i >= size ? size - 1 : i);
+}
+
+// GL_LINEAR + GL_CLAMP_TO_BORDER（黑色）在一个轴上的取样，position 为texel单位；落在边框上的取样权重为0
+inline void linearTaps(float position, int size, float scale, int* index, float* weight) {
+    const float p = position - 0.5f;
+    const float i = std::floor(p);
+    const float f = p - i;
+    const int taps[2] = {int(i), int(i) + 1};
+    const float weights[2] = {scale * (1.0f - f), scale * f};
+    for (int t = 0; t < 2; ++t) {
+        const bool inside = taps[t] >= 0 && taps[t] < size;
+        index[t] = inside ? taps[t] : 0;
+        weight[t] = inside ? weights[t] : 0.0f;
+    }
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+PostProcessor::PostProcessor(int threads) : pool(threads) {
+    arenas.reserve(size_t(pool.threadCount()));
+    for (int i = 0; i < pool.threadCount(); ++i) {
+        arenas.emplace_back();
+    }
+    setSimdIsa(isa);
+}
+
+void PostProcessor::setSimdIsa(SimdIsa value) {
+    isa = simdIsaSupported(value) ? value : SimdIsa::Scalar;
+    accumulateRow = accumulateRowScalar;
+    convolveRow = convolveRowScalar;
+#if defined(BLACKHOLE_SIMD_X86)
+    switch (isa) {
+    case SimdIsa::Sse2:
+        accumulateRow = accumulateRowSse2;
+        convolveRow = convolveRowSse2;
+        break;
+    case SimdIsa::Avx2:
+        accumulateRow = accumulateRowAvx2;
+        convolveRow = convolveRowAvx2;
+        break;
+    case SimdIsa::Avx512:
+        accumulateRow = accumulateRowAvx512;
+        convolveRow = convolveRowAvx512;
+        break;
+    default:
+        break;
+    }
+#endif
+}
+
+void PostProcessor::parallelFor(int count, int grain, const std::function<void(int begin, int end, int worker)>& body) {
+    const int tasks = (count + grain - 1) / grain;
+    if (tasks <= 0) {
+        return;
+    }
+    std::vector<int> order(size_t(tasks), 0);
+    std::iota(order.begin(), order.end(), 0);
+    pool.run(order, [&](int task, int worker) {
+        arenas[size_t(worker)].reset();
+        body(task * grain, std::min(count, (task + 1) * grain), worker);
+    });
+}
+
+void PostProcessor::prepare(int w, int h) {
+    if (w == width && h == height) {
+        return;
+    }
+    width = w;
+    height = h;
+
+    // 两个模糊通道都从 GL_LINEAR 的金字塔级取样：每个偏移拆成相邻两个texel，
+    // 化为整数偏移的卷积核，下标 radius 处为偏移0
+    const int radius = 4;
+    blurKernel.assign(2 * radius + 1, 0.0f);
+    float weightSum = kBlurWeights[0];
+    for (int i = 1; i < 5; ++i) {
+        weightSum += kBlurWeights[i] * 2.0f;
+    }
+    for (int i = 0; i < 5; ++i) {
+        for (int side = (i == 0 ? 1 : -1); side <= 1; side += 2) {
+            const float shift = side * kBlurOffsets[i] * 0.5f;
+            const float lower = std::floor(shift);
+            const float f = shift - lower;
+            blurKernel[size_t(radius + int(lower))] += kBlurWeights[i] * (1.0f - f) / weightSum;
+            blurKernel[size_t(radius + int(lower) + 1)] += kBlurWeights[i] * f / weightSum;
+        }
+    }
+
+    // screen_result.frag 的 BicubicTexture：两次线性取样按 s 混合，可分离。
+    // 第 level 级的取样位置为像素坐标除以 2^(level+1)，以该级texel为单位
+    auto buildBicubic = [](AxisTaps* axis, int size, int levelSize, int level, float bloomWeight) {
+        const float scale = std::exp2(float(level + 1));
+        axis->index.resize(size_t(size) * 4);
+        axis->weight.resize(size_t(size) * 4);
+        for (int pixel = 0; pixel < size; ++pixel) {
+            float coord = (float(pixel) + 0.5f) / scale;
+            float f = coord - std::floor(coord);
+            coord -= f;
+            f -= 0.5f;
+            const float f2 = f * f;
+            const float f3 = f2 * f;
+            const float w0 = (-f3 + 3.0f * f2 - 3.0f * f + 1.0f) / 6.0f;
+            const float w1 = (3.0f * f3 - 6.0f * f2 + 4.0f) / 6.0f;
+            const float w2 = (-3.0f * f3 + 3.0f * f2 + 3.0f * f + 1.0f) / 6.0f;
+            const float w3 = f3 / 6.0f;
+            const float s0 = w0 + w1;
+            const float s1 = w2 + w3;
+            const float mixWeight = s0 / (s0 + s1);
+            int* index = &axis->index[size_t(pixel) * 4];
+            float* weight = &axis->weight[size_t(pixel) * 4];
+            linearTaps(coord - 0.5f + w1 / s0, levelSize, bloomWeight * mixWeight, index, weight);
+            linearTaps(coord + 1.5f + w3 / s1, levelSize, bloomWeight * (1.0f - mixWeight), index + 2, weight + 2);
+        }
+    };
+
+    // 每级尺寸为上一级的一半（向上取整），与 BlackHoleRenderer::createTargets 相同
+    int levelWidth = width;
+    int levelHeight = height;
+    bloomRowCount = 0;
+    for (int level = 0; level < kLevels; ++level) {
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+        Level& target = levels[level];
+        target.width = levelWidth;
+        target.height = levelHeight;
+        target.planes.assign(size_t(levelWidth) * levelHeight * 3, 0.0f);
+        target.scratch.assign(target.planes.size(), 0.0f);
+        // 横向的bloom权重并入x方向
+        buildBicubic(&bloomX[level], width, levelWidth, level, kBloomWeights[level]);
+        buildBicubic(&bloomY[level], height, levelHeight, level, 1.0f);
+        bloomFirstRow[level] = bloomRowCount;
+        bloomRowCount += levelHeight;
+    }
+    bloomRows.assign(size_t(bloomRowCount) * width * 3, 0.0f);
+}
+
+void PostProcessor::buildPyramid(const float* scene) {
+    // mipmap.frag：每个输出texel是上一级2x2个texel的平均（在公共角上的一次双线性取样）。
+    // 第一级读circle通道输出（GL_CLAMP_TO_EDGE），之后各级读上一级（黑色边框）
+    for (int level = 0; level < kLevels; ++level) {
+        Level& target = levels[level];
+        const Level* source = level > 0 ? &levels[level - 1] : nullptr;
+        const int sourceWidth = source ? source->width : width;
+        const int sourceHeight = source ? source->height : height;
+        const size_t sourcePlane = source ? size_t(sourceWidth) * sourceHeight : 0;
+        const size_t plane = size_t(target.width) * target.height;
+        parallelFor(target.height, 16, [&](int begin, int end, int) {
+            for (int y = begin; y < end; ++y) {
+                float* out[3];
+                for (int c = 0; c < 3; ++c) {
+                    out[c] = target.planes.data() + c * plane + size_t(y) * target.width;
+                }
+                for (int x = 0; x < target.width; ++x) {
+                    float sum[3] = {0.0f, 0.0f, 0.0f};
+                    for (int dy = 0; dy < 2; ++dy) {
+                        for (int dx = 0; dx < 2; ++dx) {
+                            const int sx = 2 * x + dx;
+                            const int sy = 2 * y + dy;
+                            if (!source) {
+                                const float* texel = scene + (size_t(clampIndex(sy, sourceHeight)) * sourceWidth +
+                                                              size_t(clampIndex(sx, sourceWidth))) * 4;
+                                sum[0] += texel[0];
+                                sum[1] += texel[1];
+                                sum[2] += texel[2];
+                            } else if (sx < sourceWidth && sy < sourceHeight) {
+                                const size_t texel = size_t(sy) * sourceWidth + sx;
+                                for (int c = 0; c < 3; ++c) {
+                                    sum[c] += source->planes[c * sourcePlane + texel];
+                                }
+                            }
+                        }
+                    }
+                    for (int c = 0; c < 3; ++c) {
+                        out[c][x] = 0.25f * sum[c];
+                    }
+                }
+            }
+        });
+    }
+}
+
+void PostProcessor::blurHorizontal() {
+    const int radius = int(blurKernel.size() / 2);
+    for (Level& level : levels) {
+        const size_t plane = size_t(level.width) * level.height;
+        parallelFor(level.height, 16, [&](int begin, int end, int worker) {
+            // 两端各补 radius 个边框texel
+            float* padded = arenas[size_t(worker)].allocate<float>(size_t(level.width) + 2 * radius);
+            std::fill(padded, padded + radius, 0.0f);
+            std::fill(padded + radius + level.width, padded + 2 * radius + level.width, 0.0f);
+            for (int y = begin; y < end; ++y) {
+                for (int c = 0; c < 3; ++c) {
+                    const size_t row = c * plane + size_t(y) * level.width;
+                    std::copy(level.planes.data() + row, level.planes.data() + row + level.width, padded + radius);
+                    convolveRow(padded, level.scratch.data() + row, level.width, blurKernel.data(),
+                                int(blurKernel.size()));
+                }
+            }
+        });
+    }
+}
+
+void PostProcessor::blurVertical() {
+    // 每个输出行是 scratch 中相邻 2 * radius + 1 行的加权和，级外的行为0；结果写回 planes
+    const int radius = int(blurKernel.size() / 2);
+    for (Level& level : levels) {
+        const size_t plane = size_t(level.width) * level.height;
+        parallelFor(level.height, 16, [&](int begin, int end, int) {
+            for (int y = begin; y < end; ++y) {
+                for (int c = 0; c < 3; ++c) {
+                    float* row = level.planes.data() + c * plane + size_t(y) * level.width;
+                    std::fill(row, row + level.width, 0.0f);
+                    for (int t = 0; t < int(blurKernel.size()); ++t) {
+                        const int sourceRow = y + t - radius;
+                        if (sourceRow >= 0 && sourceRow < level.height) {
+                            accumulateRow(row, level.scratch.data() + c * plane + size_t(sourceRow) * level.width,
+                                          blurKernel[size_t(t)], level.width);
+                        }
+                    }
+                }
+            }
+        });
+    }
+}
+
+void PostProcessor::filterBloomRows() {
+    // 各级的每一行先在x方向按双三次权重放大到整幅宽度，所有输出行共用
+    const size_t rowsPlane = size_t(bloomRowCount) * width;
+    parallelFor(bloomRowCount, 8, [&](int begin, int end, int) {
+        for (int row = begin; row < end; ++row) {
+            int level = kLevels - 1;
+            while (bloomFirstRow[level] > row) {
+                --level;
+            }
+            const Level& source = levels[level];
+            const AxisTaps& axisX = bloomX[level];
+            const size_t plane = size_t(source.width) * source.height;
+            const int sourceRow = row - bloomFirstRow[level];
+            for (int c = 0; c < 3; ++c) {
+                const float* in = source.planes.data() + c * plane + size_t(sourceRow) * source.width;
+                float* out = bloomRows.data() + c * rowsPlane + size_t(row) * width;
+                for (int x = 0; x < width; ++x) {
+                    const int* index = &axisX.index[size_t(x) * 4];
+                    const float* weight = &axisX.weight[size_t(x) * 4];
+                    out[x] = weight[0] * in[index[0]] + weight[1] * in[index[1]] + weight[2] * in[index[2]] +
+                             weight[3] * in[index[3]];
+                }
+            }
+        }
+    });
+}
+
+void PostProcessor::bloomRow(int y, int worker, float* rgba) {
+    const size_t rowsPlane = size_t(bloomRowCount) * width;
+    float* sum[3];
+    for (int c = 0; c < 3; ++c) {
+        sum[c] = arenas[size_t(worker)].allocate<float>(size_t(width));
+        std::fill(sum[c], sum[c] + width, 0.0f);
+    }
+    // y方向每级4个权重，整行累加
+    for (int level = 0; level < kLevels; ++level) {
+        const AxisTaps& axisY = bloomY[level];
+        const int* index = &axisY.index[size_t(y) * 4];
+        const float* weight = &axisY.weight[size_t(y) * 4];
+        for (int t = 0; t < 4; ++t) {
+            if (weight[t] == 0.0f) {
+                continue;
+            }
+            const size_t row = size_t(bloomFirstRow[level] + index[t]);
+            for (int c = 0; c < 3; ++c) {
+                accumulateRow(sum[c], bloomRows.data() + c * rowsPlane + row * width, weight[t], width);
+            }
+        }
+    }
+    for (int x = 0; x < width; ++x) {
+        rgba[x * 4 + 0] = sum[0][x];
+        rgba[x * 4 + 1] = sum[1][x];
+        rgba[x * 4 + 2] = sum[2][x];
+        rgba[x * 4 + 3] = 1.0f;
+    }
+}
+
+void PostProcessor::bloom(const float* scene, int w, int h, float* bloomRgba) {
+    prepare(w, h);
+    auto start = std::chrono::steady_clock::now();
+    buildPyramid(scene);
+    stageTimings.pyramid = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    blurHorizontal();
+    stageTimings.horizontal = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    blurVertical();
+    stageTimings.vertical = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    filterBloomRows();
+    parallelFor(height, 8, [&](int begin, int end, int worker) {
+        for (int y = begin; y < end; ++y) {
+            bloomRow(y, worker, bloomRgba + size_t(y) * width * 4);
+        }
+    });
+    stageTimings.bloom = millisecondsSince(start);
+}
+
+void PostProcessor::process(const float* scene, int w, int h, uint8_t* rgba8) {
+    prepare(w, h);
+    auto start = std::chrono::steady_clock::now();
+    buildPyramid(scene);
+    stageTimings.pyramid = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    blurHorizontal();
+    stageTimings.horizontal = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    blurVertical();
+    stageTimings.vertical = millisecondsSince(start);
+    // bloom和色调映射在同一个行任务里完成，不需要整幅的bloom缓冲
+    start = std::chrono::steady_clock::now();
+    filterBloomRows();
+    parallelFor(height, 8, [&](int begin, int end, int worker) {
+        float* row = arenas[size_t(worker)].allocate<float>(size_t(width) * 4);
+        for (int y = begin; y < end; ++y) {
+            bloomRow(y, worker, row);
+            const size_t offset = size_t(y) * width * 4;
+            toneMapRow(scene + offset, row, width, rgba8 + offset);
+        }
+    });
+    stageTimings.bloom = millisecondsSince(start);
+}
@@ -0,0 +1,82 @@
+#ifndef POSTPROCESS_H
+#define POSTPROCESS_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "arena.h"
+#include "packetkernel.h"
+#include "workstealingpool.h"
+
+// 上一次处理各阶段的耗时（毫秒）
+struct PostTimings {
+    double pyramid = 0.0;      // mipmap.frag：逐级减半的bloom金字塔
+    double horizontal = 0.0;   // horizontal.frag（各级）
+    double vertical = 0.0;     // vertical.frag（各级，整行加权累加）
+    double bloom = 0.0;        // screen_result.frag：GetBloom（双三次取样八级），process 中含色调映射
+};
+
+// mipmap → horizontal → vertical → screen_result 后处理链的CPU版，供无GPU的渲染路径使用
+// 金字塔各级按R、G、B三个平面存放，各通道按行分给线程池，行内循环交给SIMD行内核；
+// 竖直方向的模糊是相邻几行的加权和，同样按整行累加，不需要按列访问
+class PostProcessor {
+public:
+    explicit PostProcessor(int threads = 0);
+
+    // 行内核的指令集，默认取CPU支持的最宽者；不支持的指令集退回标量
+    void setSimdIsa(SimdIsa value);
+    SimdIsa simdIsa() const { return isa; }
+    int threadCount() const { return pool.threadCount(); }
+
+    // scene 为circle通道输出（width * height * 4 个float，已截断到[0, 1]，自下而上行序），
+    // bloomRgba 写出 GetBloom 的结果（同样大小，alpha为1），可直接交给 toneMapToRgba8
+    void bloom(const float* scene, int width, int height, float* bloomRgba);
+    // bloom 加色调映射，输出RGBA8
+    void process(const float* scene, int width, int height, uint8_t* rgba8);
+
+    const PostTimings& timings() const { return stageTimings; }
+
+private:
+    static const int kLevels = 8;   // 与 BlackHoleRenderer::kBloomLevels 相同
+
+    // bloom金字塔的一级（1 / 2^(k+1) 分辨率），级外按黑色边框处理
+    struct Level {
+        int width = 0;
+        int height = 0;
+        std::vector<float> planes;    // mipmap.frag 输出，vertical.frag 的结果写回这里
+        std::vector<float> scratch;   // horizontal.frag 输出
+    };
+
+    // screen_result.frag 的双三次取样在一个轴上：每个输出像素4个texel下标和权重，级外的取样权重为0
+    struct AxisTaps {
+        std::vector<int> index;
+        std::vector<float> weight;
+    };
+
+    void prepare(int width, int height);
+    void buildPyramid(const float* scene);
+    void blurHorizontal();
+    void blurVertical();
+    void filterBloomRows();
+    void bloomRow(int y, int worker, float* rgba);
+    void parallelFor(int count, int grain, const std::function<void(int begin, int end, int worker)>& body);
+
+    WorkStealingPool pool;
+    std::vector<Arena> arenas;   // 每个工作线程一个，放补边的行和bloom的临时行
+    SimdIsa isa = detectSimdIsa();
+    void (*accumulateRow)(float* dst, const float* src, float weight, int count) = nullptr;
+    void (*convolveRow)(const float* src, float* dst, int count, const float* weights, int taps) = nullptr;
+
+    int width = 0;
+    int height = 0;
+    Level levels[kLevels];
+    AxisTaps bloomX[kLevels];
+    AxisTaps bloomY[kLevels];
+    std::vector<float> bloomRows;      // 各级模糊结果的全部行，已在x方向取样到整幅宽度
+    int bloomFirstRow[kLevels] = {};   // 各级在 bloomRows 中的起始行
+    int bloomRowCount = 0;
+    std::vector<float> blurKernel;     // 两个模糊通道共用，化为整数偏移的卷积核
+    PostTimings stageTimings;
+};
+
+#endif // POSTPROCESS_H
@@ -0,0 +1,14 @@
+#ifndef POSTROWS_H
+#define POSTROWS_H
+
+// 后处理的行内核，各指令集版本实现在对应的 packetkernel_*.cpp 中
+// dst[x] += weight * src[x]
+void accumulateRowSse2(float* dst, const float* src, float weight, int count);
+void accumulateRowAvx2(float* dst, const float* src, float weight, int count);
+void accumulateRowAvx512(float* dst, const float* src, float weight, int count);
+// dst[x] = sum(weights[t] * src[x + t])，src 已按边界复制补齐 taps - 1 个元素
+void convolveRowSse2(const float* src, float* dst, int count, const float* weights, int taps);
+void convolveRowAvx2(const float* src, float* dst, int count, const float* weights, int taps);
+void convolveRowAvx512(const float* src, float* dst, int count, const float* weights, int taps);
+
+#endif // POSTROWS_H
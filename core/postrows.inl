@@ -0,0 +1,40 @@
+// 后处理行内核模板，由各指令集的编译单元在包含 simdpacket.h 之后包含
+// 行数据不保证对齐，用非对齐读写；尾部不足一个包的元素逐个处理
+#include "postrows.h"
+
+namespace {
+
+template <typename P>
+void accumulateRowPacket(float* dst, const float* src, float weight, int count) {
+    constexpr int N = P::width;
+    const P w(weight);
+    int x = 0;
+    for (; x + N <= count; x += N) {
+        (P::loadu(dst + x) + w * P::loadu(src + x)).storeu(dst + x);
+    }
+    for (; x < count; ++x) {
+        dst[x] += weight * src[x];
+    }
+}
+
+template <typename P>
+void convolveRowPacket(const float* src, float* dst, int count, const float* weights, int taps) {
+    constexpr int N = P::width;
+    int x = 0;
+    for (; x + N <= count; x += N) {
+        P sum = P(weights[0]) * P::loadu(src + x);
+        for (int t = 1; t < taps; ++t) {
+            sum = sum + P(weights[t]) * P::loadu(src + x + t);
+        }
+        sum.storeu(dst + x);
+    }
+    for (; x < count; ++x) {
+        float sum = weights[0] * src[x];
+        for (int t = 1; t < taps; ++t) {
+            sum += weights[t] * src[x + t];
+        }
+        dst[x] = sum;
+    }
+}
+
+} // namespace
@@ -0,0 +1,197 @@
+#ifndef SHADERMATH_H
+#define SHADERMATH_H
+
+#include <cmath>
+#include "glslmath.h"
+#include "noisevolume.h"
+
+// circle.frag 中各个函数的逐行移植，分量类型为模板参数
+// BlackHoleKernel 用 float 实例；基准程序另用 double 实例作为精度参考
+// 常量统一写成float字面量，double实例计算的是同一个函数，误差只来自运算精度
+namespace circle {
+
+using glsl::tvec2;
+using glsl::tvec3;
+using glsl::tvec4;
+
+const float kPi              = 3.141592653589f;
+const float kGravityConstant = 6.673e-11f;
+const float kSpeedOfLight    = 299792458.0f;
+const float kSigma           = 5.670373e-8f;
+const float kLightYear       = 9460730472580800.0f;
+const float kSolarMass       = 1.9884e30f;
+const float kSlabStepFraction = 0.05f;   // 盘包围体外每步最长为到黑洞距离的这一比例
+
+template <typename T>
+T randomStep(const tvec2<T>& input, T seed) {
+    const T shift = glsl::fract(T(11.4514f) * std::sin(seed));
+    return glsl::fract(std::sin(dot(input + tvec2<T>(shift), tvec2<T>(T(12.9898f), T(78.233f)))) * T(43758.5453f));
+}
+
+template <typename T>
+T cubicInterpolate(T x) {
+    return T(3.0f) * x * x - T(2.0f) * x * x * x;
+}
+
+// 格点值与 blackhole.glsl 的 DiskNoise 一样取自 NoiseVolume（着色器打开 ANALYTIC_DISK_NOISE 时改用 sin 哈希，不再一致）
+// x、y、z 已取整
+template <typename T>
+T latticeValue(T x, T y, T z) {
+    return T(NoiseVolume::lattice(std::int64_t(x), std::int64_t(y), std::int64_t(z)));
+}
+
+template <typename T>
+T perlinNoise(const tvec3<T>& position) {
+    const tvec3<T> i = glsl::floor(position);
+    const tvec3<T> f = glsl::fract(position);
+    const T one(1.0f);
+
+    const T v000 = latticeValue(i.x,       i.y,       i.z);
+    const T v100 = latticeValue(i.x + one, i.y,       i.z);
+    const T v010 = latticeValue(i.x,       i.y + one, i.z);
+    const T v110 = latticeValue(i.x + one, i.y + one, i.z);
+    const T v001 = latticeValue(i.x,       i.y,       i.z + one);
+    const T v101 = latticeValue(i.x + one, i.y,       i.z + one);
+    const T v011 = latticeValue(i.x,       i.y + one, i.z + one);
+    const T v111 = latticeValue(i.x + one, i.y + one, i.z + one);
+
+    const T v00 = v001 * cubicInterpolate(f.z) + v000 * cubicInterpolate(one - f.z);
+    const T v10 = v101 * cubicInterpolate(f.z) + v100 * cubicInterpolate(one - f.z);
+    const T v01 = v011 * cubicInterpolate(f.z) + v010 * cubicInterpolate(one - f.z);
+    const T v11 = v111 * cubicInterpolate(f.z) + v110 * cubicInterpolate(one - f.z);
+    const T v0  = v01  * cubicInterpolate(f.y) + v00  * cubicInterpolate(one - f.y);
+    const T v1  = v11  * cubicInterpolate(f.y) + v10  * cubicInterpolate(one - f.y);
+
+    return v1 * cubicInterpolate(f.x) + v0 * cubicInterpolate(one - f.x);
+}
+
+template <typename T>
+T softSaturate(T x) {
+    return T(1.0f) - T(1.0f) / (glsl::max(x, T(0.0f)) + T(1.0f));
+}
+
+// GenerateAccretionDiskNoise
+template <typename T>
+T accretionDiskNoise(const tvec3<T>& position, int startLevel, int endLevel, T contrast) {
+    T accumulator(10.0f);
+    for (int level = startLevel; level < endLevel; ++level) {
+        const T frequency = std::pow(T(3.0f), T(level));
+        accumulator *= T(1.0f) + T(0.1f) * perlinNoise(position * frequency);
+    }
+    return std::log(T(1.0f) + std::pow(T(0.1f) * accumulator, contrast));
+}
+
+template <typename T>
+T vec2ToTheta(const tvec2<T>& v1, const tvec2<T>& v2) {
+    const T d = dot(v1, v2);
+    const T c = v1.x * v2.y - v1.y * v2.x;
+    if (d > T(0.0f)) {
+        return std::asin(T(0.999999f) * c / length(v1) / length(v2));
+    } else if (d < T(0.0f) && -c < T(0.0f)) {
+        return T(kPi) - std::asin(T(0.999999f) * c / length(v1) / length(v2));
+    } else if (d < T(0.0f) && -c > T(0.0f)) {
+        return -T(kPi) - std::asin(T(0.999999f) * c / length(v1) / length(v2));
+    }
+    // 着色器在此没有返回值（未定义），取0
+    return T(0.0f);
+}
+
+template <typename T>
+tvec3<T> kelvinToRgb(T kelvin) {
+    if (kelvin < T(400.01f)) {
+        return tvec3<T>(T(0.0f));
+    }
+    const T teff = (kelvin - T(6500.0f)) / (T(6500.0f) * kelvin * T(2.2f));
+    tvec3<T> rgb(std::exp(T(2.05539304e4f) * teff), std::exp(T(2.63463675e4f) * teff), std::exp(T(3.30145739e4f) * teff));
+    T brightnessScale = T(1.0f) / glsl::max(glsl::max(rgb.x, rgb.y), rgb.z);
+    if (kelvin < T(1000.0f)) {
+        brightnessScale *= (kelvin - T(400.0f)) / T(600.0f);
+    }
+    return rgb * brightnessScale;
+}
+
+template <typename T>
+T keplerianAngularVelocity(T radius, T rs) {
+    return std::sqrt(T(kSpeedOfLight) / T(kLightYear) * T(kSpeedOfLight) * rs / T(kLightYear) /
+                     ((T(2.0f) * radius - T(3.0f) * rs) * radius * radius));
+}
+
+template <typename T>
+T shape(T x, T alpha, T beta) {
+    const T k = std::pow(alpha + beta, alpha + beta) / (std::pow(alpha, alpha) * std::pow(beta, beta));
+    return k * std::pow(x, alpha) * std::pow(T(1.0f) - x, beta);
+}
+
+// DiskEffectiveRadius：盘的厚度和密度按半径的分布，内缘为1，外缘为0.5
+template <typename T>
+T diskEffectiveRadius(T posR, T rs, T interRadius, T outerRadius) {
+    T effectiveRadius = T(1.0f) - ((posR - interRadius) / (outerRadius - interRadius) * T(0.5f));
+    if ((outerRadius - interRadius) > T(9.0f) * rs) {
+        if (posR < T(5.0f) * rs + interRadius) {
+            effectiveRadius = T(1.0f) - ((posR - interRadius) / (T(9.0f) * rs) * T(0.5f));
+        } else {
+            effectiveRadius = T(1.0f) - (T(0.5f) / T(0.9f) * T(0.5f) + ((posR - interRadius) / (outerRadius - interRadius) -
+                              T(5.0f) * rs / (outerRadius - interRadius)) / (T(1.0f) - T(5.0f) * rs / (outerRadius - interRadius)) * T(0.5f));
+        }
+    }
+    return effectiveRadius;
+}
+
+// 着色器原先的 WorldToBlackHoleSpace：每次调用都重新构造黑洞系的三个轴
+// （现在 BlackHoleKernel 和着色器都每帧只算一次，见 KernelConstants::diskX/diskY/diskZ 和 core/frameparams.h）
+template <typename T>
+tvec3<T> worldToBlackHoleSpace(const tvec3<T>& position, const tvec3<T>& blackHolePos, tvec3<T> diskNormal,
+                               const tvec3<T>& worldUp) {
+    if (diskNormal == worldUp) {
+        diskNormal += T(0.0001f) * tvec3<T>(T(1.0f), T(0.0f), T(0.0f));
+    }
+    const tvec3<T> spaceY = normalize(diskNormal);
+    const tvec3<T> spaceZ = normalize(cross(worldUp, spaceY));
+    const tvec3<T> spaceX = normalize(cross(spaceY, spaceZ));
+    const tvec3<T> translated = position - blackHolePos;
+    return tvec3<T>(dot(spaceX, translated), dot(spaceY, translated), dot(spaceZ, translated));
+}
+
+// 到盘包围体（黑洞系中 |y| < 0.5Rs、interRadius < r < outerRadius）的距离下界，体内为负或0
+// diskAxis 为单位盘法向；只用一次点积，代替到黑洞系的整个变换
+template <typename T>
+T diskSlabGap(const tvec3<T>& posToBlackHole, T distanceToBlackHole, const tvec3<T>& diskAxis, T rs, T interRadius,
+              T outerRadius) {
+    const T height = dot(posToBlackHole, diskAxis);
+    const T radius = std::sqrt(glsl::max(distanceToBlackHole * distanceToBlackHole - height * height, T(0.0f)));
+    return glsl::max(std::fabs(height) - T(0.5f) * rs, glsl::max(radius - outerRadius, interRadius - radius));
+}
+
+// 测地线的一步：按到黑洞的距离选步长，前进并按 1.5 Rs / r 的偏折率转向
+// rayStep 传入首步抖动（第一步）或1，返回实际步长
+// slabGap > 0 时（盘包围体外，首步不传）步长放宽到 min(slabGap, kSlabStepFraction * r)：路径不短于弦长，不会越过包围体
+template <typename T>
+T geodesicStep(tvec3<T>* rayPos, tvec3<T>* rayDir, const tvec3<T>& normalizedPosToBlackHole, T distanceToBlackHole,
+               T rayStep, T rs, T outerRadius, T slabGap = T(0.0f)) {
+    const T cosTheta = length(cross(normalizedPosToBlackHole, *rayDir));   // 前进方向与切向夹角
+    const T deltaPhiRate = T(-1.0f) * cosTheta * cosTheta * cosTheta * (T(1.5f) * rs / distanceToBlackHole);   // 单位长度光偏折角
+
+    rayStep *= T(0.15f) + T(0.25f) * glsl::min(glsl::max(T(0.0f), T(0.5f) * (T(0.5f) * distanceToBlackHole /
+               glsl::max(T(10.0f) * rs, outerRadius) - T(1.0f))), T(1.0f));
+    if (distanceToBlackHole >= T(2.0f) * outerRadius) {
+        rayStep *= distanceToBlackHole;
+    } else if (distanceToBlackHole >= T(1.0f) * outerRadius) {
+        rayStep *= (rs * (T(2.0f) * outerRadius - distanceToBlackHole) +
+                    distanceToBlackHole * (distanceToBlackHole - outerRadius)) / outerRadius;
+    } else {
+        rayStep *= glsl::min(rs, distanceToBlackHole);
+    }
+    if (slabGap > T(0.0f)) {
+        rayStep = glsl::max(rayStep, glsl::min(slabGap, T(kSlabStepFraction) * distanceToBlackHole));
+    }
+
+    *rayPos += *rayDir * rayStep;
+    const T deltaPhi = rayStep / distanceToBlackHole * deltaPhiRate;
+    *rayDir = normalize(*rayDir + (deltaPhi + deltaPhi * deltaPhi * deltaPhi / T(3.0f)) *
+                        cross(cross(*rayDir, normalizedPosToBlackHole), *rayDir) / cosTheta);
+    return rayStep;
+}
+
+} // namespace circle
+
+#endif // SHADERMATH_H
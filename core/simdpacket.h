@@ -0,0 +1,100 @@
+#ifndef SIMDPACKET_H
+#define SIMDPACKET_H
+
+// 按指令集封装的浮点包：每个包装N条光线的同一个分量
+// 比较结果统一转成整数位掩码（第i位对应第i条光线），终止的光线靠掩码剔除
+// 只在对应指令集的编译单元中包含；放在匿名命名空间里，保证这些内联函数不会跨编译单元合并
+// （否则链接器可能让基线代码调用到带AVX指令的副本）
+#include <immintrin.h>
+
+namespace {
+
+#if defined(__SSE2__)
+struct PacketSse2 {
+    static constexpr int width = 4;
+    __m128 v;
+    PacketSse2() = default;
+    PacketSse2(__m128 v) : v(v) {}
+    explicit PacketSse2(float s) : v(_mm_set1_ps(s)) {}
+    static PacketSse2 load(const float* p) { return _mm_load_ps(p); }
+    void store(float* p) const { _mm_store_ps(p, v); }
+    static PacketSse2 loadu(const float* p) { return _mm_loadu_ps(p); }
+    void storeu(float* p) const { _mm_storeu_ps(p, v); }
+};
+
+inline PacketSse2 operator+(PacketSse2 a, PacketSse2 b) { return _mm_add_ps(a.v, b.v); }
+inline PacketSse2 operator-(PacketSse2 a, PacketSse2 b) { return _mm_sub_ps(a.v, b.v); }
+inline PacketSse2 operator*(PacketSse2 a, PacketSse2 b) { return _mm_mul_ps(a.v, b.v); }
+inline PacketSse2 operator/(PacketSse2 a, PacketSse2 b) { return _mm_div_ps(a.v, b.v); }
+inline PacketSse2 sqrt(PacketSse2 a) { return _mm_sqrt_ps(a.v); }
+inline PacketSse2 min(PacketSse2 a, PacketSse2 b) { return _mm_min_ps(a.v, b.v); }
+inline PacketSse2 max(PacketSse2 a, PacketSse2 b) { return _mm_max_ps(a.v, b.v); }
+inline PacketSse2 abs(PacketSse2 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+inline int lessThan(PacketSse2 a, PacketSse2 b) { return _mm_movemask_ps(_mm_cmplt_ps(a.v, b.v)); }
+inline int greaterThan(PacketSse2 a, PacketSse2 b) { return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v)); }
+// x >= t ? a : b
+inline PacketSse2 selectGreaterEqual(PacketSse2 x, PacketSse2 t, PacketSse2 a, PacketSse2 b) {
+    const __m128 mask = _mm_cmpge_ps(x.v, t.v);
+    return _mm_or_ps(_mm_and_ps(mask, a.v), _mm_andnot_ps(mask, b.v));
+}
+#endif
+
+#if defined(__AVX2__)
+struct PacketAvx2 {
+    static constexpr int width = 8;
+    __m256 v;
+    PacketAvx2() = default;
+    PacketAvx2(__m256 v) : v(v) {}
+    explicit PacketAvx2(float s) : v(_mm256_set1_ps(s)) {}
+    static PacketAvx2 load(const float* p) { return _mm256_load_ps(p); }
+    void store(float* p) const { _mm256_store_ps(p, v); }
+    static PacketAvx2 loadu(const float* p) { return _mm256_loadu_ps(p); }
+    void storeu(float* p) const { _mm256_storeu_ps(p, v); }
+};
+
+inline PacketAvx2 operator+(PacketAvx2 a, PacketAvx2 b) { return _mm256_add_ps(a.v, b.v); }
+inline PacketAvx2 operator-(PacketAvx2 a, PacketAvx2 b) { return _mm256_sub_ps(a.v, b.v); }
+inline PacketAvx2 operator*(PacketAvx2 a, PacketAvx2 b) { return _mm256_mul_ps(a.v, b.v); }
+inline PacketAvx2 operator/(PacketAvx2 a, PacketAvx2 b) { return _mm256_div_ps(a.v, b.v); }
+inline PacketAvx2 sqrt(PacketAvx2 a) { return _mm256_sqrt_ps(a.v); }
+inline PacketAvx2 min(PacketAvx2 a, PacketAvx2 b) { return _mm256_min_ps(a.v, b.v); }
+inline PacketAvx2 max(PacketAvx2 a, PacketAvx2 b) { return _mm256_max_ps(a.v, b.v); }
+inline PacketAvx2 abs(PacketAvx2 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+inline int lessThan(PacketAvx2 a, PacketAvx2 b) { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+inline int greaterThan(PacketAvx2 a, PacketAvx2 b) { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+inline PacketAvx2 selectGreaterEqual(PacketAvx2 x, PacketAvx2 t, PacketAvx2 a, PacketAvx2 b) {
+    return _mm256_blendv_ps(b.v, a.v, _mm256_cmp_ps(x.v, t.v, _CMP_GE_OQ));
+}
+#endif
+
+#if defined(__AVX512F__)
+struct PacketAvx512 {
+    static constexpr int width = 16;
+    __m512 v;
+    PacketAvx512() = default;
+    PacketAvx512(__m512 v) : v(v) {}
+    explicit PacketAvx512(float s) : v(_mm512_set1_ps(s)) {}
+    static PacketAvx512 load(const float* p) { return _mm512_load_ps(p); }
+    void store(float* p) const { _mm512_store_ps(p, v); }
+    static PacketAvx512 loadu(const float* p) { return _mm512_loadu_ps(p); }
+    void storeu(float* p) const { _mm512_storeu_ps(p, v); }
+};
+
+inline PacketAvx512 operator+(PacketAvx512 a, PacketAvx512 b) { return _mm512_add_ps(a.v, b.v); }
+inline PacketAvx512 operator-(PacketAvx512 a, PacketAvx512 b) { return _mm512_sub_ps(a.v, b.v); }
+inline PacketAvx512 operator*(PacketAvx512 a, PacketAvx512 b) { return _mm512_mul_ps(a.v, b.v); }
+inline PacketAvx512 operator/(PacketAvx512 a, PacketAvx512 b) { return _mm512_div_ps(a.v, b.v); }
+inline PacketAvx512 sqrt(PacketAvx512 a) { return _mm512_sqrt_ps(a.v); }
+inline PacketAvx512 min(PacketAvx512 a, PacketAvx512 b) { return _mm512_min_ps(a.v, b.v); }
+inline PacketAvx512 max(PacketAvx512 a, PacketAvx512 b) { return _mm512_max_ps(a.v, b.v); }
+inline PacketAvx512 abs(PacketAvx512 a) { return _mm512_abs_ps(a.v); }
+inline int lessThan(PacketAvx512 a, PacketAvx512 b) { return int(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)); }
+inline int greaterThan(PacketAvx512 a, PacketAvx512 b) { return int(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ)); }
+inline PacketAvx512 selectGreaterEqual(PacketAvx512 x, PacketAvx512 t, PacketAvx512 a, PacketAvx512 b) {
+    return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x.v, t.v, _CMP_GE_OQ), b.v, a.v);
+}
+#endif
+
+} // namespace
+
+#endif // SIMDPACKET_H
@@ -0,0 +1,114 @@
+#include "tonemap.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+float gradeChannel(float color, float channelPower) {
+    color = std::pow(color, 1.5f);
+    color = color / (1.0f + color);   // Reinhard色调映射
+    color = std::pow(color, 1.0f / 1.5f);
+    color = color * color * (3.0f - 2.0f * color);   // S形曲线
+    color = std::pow(color, channelPower);
+    color = color * 1.01f;
+    color = color < 0.0f ? 0.0f : (color > 1.0f ? 1.0f : color);
+    return std::pow(color, 0.7f / 2.2f);   // Gamma校正
+}
+
+int gradeLevel(float color, float channelPower) {
+    return int(std::lround(gradeChannel(color, channelPower) * 255.0f));
+}
+
+float floatFromBits(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// 每个通道的分级曲线单调递增，输出只有256级：预先二分出每一级的起点，
+// 逐像素先按输入所在的小区间查到起始级别，再往上比较一两次，不再调用5次pow
+struct GradeTable {
+    static constexpr int kBuckets = 4096;
+    static constexpr float kBucketScale = 1024.0f;   // 区间覆盖[0, 4)，更大的输入从最后一个区间往上找
+    float thresholds[3][257];   // thresholds[c][k]：输出达到k的最小输入，k = 0 不使用，k = 256 为哨兵
+    uint8_t bucketLevel[3][kBuckets];
+
+    GradeTable() {
+        static const float channelPower[3] = {1.3f, 1.20f, 1.0f};
+        const float top = 1.0e6f;   // 远超 scene + bloom 的范围，已映射到255
+        uint32_t topBits;
+        std::memcpy(&topBits, &top, sizeof(topBits));
+        for (int c = 0; c < 3; ++c) {
+            thresholds[c][0] = 0.0f;
+            for (int level = 1; level < 256; ++level) {
+                // 非负浮点数的位模式与数值同序，直接在位模式上二分
+                uint32_t lo = 0;
+                uint32_t hi = topBits;
+                while (hi - lo > 1) {
+                    const uint32_t mid = lo + (hi - lo) / 2;
+                    if (gradeLevel(floatFromBits(mid), channelPower[c]) >= level) {
+                        hi = mid;
+                    } else {
+                        lo = mid;
+                    }
+                }
+                thresholds[c][level] = floatFromBits(hi);
+            }
+            thresholds[c][256] = INFINITY;
+            for (int bucket = 0; bucket < kBuckets; ++bucket) {
+                bucketLevel[c][bucket] = search(c, float(bucket) / kBucketScale);
+            }
+        }
+    }
+
+    uint8_t search(int channel, float color) const {
+        const float* table = thresholds[channel];
+        int level = 0;
+        for (int step = 128; step > 0; step >>= 1) {
+            level += color >= table[level + step] ? step : 0;
+        }
+        return uint8_t(level);
+    }
+
+    uint8_t lookup(int channel, float color) const {
+        if (!(color > 0.0f)) {
+            return 0;   // 含NaN
+        }
+        const int bucket = color < float(kBuckets) / kBucketScale ? int(color * kBucketScale) : kBuckets - 1;
+        const float* table = thresholds[channel];
+        int level = bucketLevel[channel][bucket];
+        while (color >= table[level + 1]) {
+            ++level;
+        }
+        return uint8_t(level);
+    }
+};
+
+const GradeTable& gradeTable() {
+    static const GradeTable table;
+    return table;
+}
+
+} // namespace
+
+void toneMapRow(const float* scene, const float* bloom, int count, uint8_t* rgba8) {
+    const GradeTable& table = gradeTable();
+    for (int i = 0; i < count; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            float color = scene[i * 4 + c];
+            if (bloom) {
+                color += bloom[i * 4 + c] * 0.07f;   // Bloom强度控制
+            }
+            rgba8[i * 4 + c] = table.lookup(c, color);
+        }
+        rgba8[i * 4 + 3] = 255;
+    }
+}
+
+void toneMapToRgba8(const float* scene, const float* bloom, int width, int height, uint8_t* rgba8) {
+    for (int y = 0; y < height; ++y) {
+        const size_t offset = size_t(y) * width * 4;
+        toneMapRow(scene + offset, bloom ? bloom + offset : nullptr, width, rgba8 + offset);
+    }
+}
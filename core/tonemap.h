@@ -0,0 +1,14 @@
+#ifndef TONEMAP_H
+#define TONEMAP_H
+
+#include <cstdint>
+
+// screen_result.frag 的色调映射和颜色分级（CPU版）
+// scene 为circle通道输出，bloom 为已按像素取好的bloom颜色（可为空，即不加bloom）；
+// 两者均为 width * height * 4 个float。输出RGBA8，行序与输入相同
+void toneMapToRgba8(const float* scene, const float* bloom, int width, int height, uint8_t* rgba8);
+
+// 一行 count 个像素，参数含义同上；可在多个线程中对不同的行同时调用
+void toneMapRow(const float* scene, const float* bloom, int count, uint8_t* rgba8);
+
+#endif // TONEMAP_H
@@ -0,0 +1,103 @@
+#include "workstealingpool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    if (threads <= 0) {
+        threads = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threads; ++i) {
+        queues.emplace_back(new Queue());
+    }
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::run(const std::vector<int>& order, const Task& task) {
+    if (order.empty()) {
+        return;
+    }
+    // 连续段分配：Morton序下相邻任务在图像上也相邻，每个线程先处理一片紧凑区域
+    const size_t count = order.size();
+    const size_t threads = workers.size();
+    for (size_t t = 0; t < threads; ++t) {
+        const size_t begin = count * t / threads;
+        const size_t end = count * (t + 1) / threads;
+        std::lock_guard<std::mutex> guard(queues[t]->lock);
+        queues[t]->items.assign(order.begin() + begin, order.begin() + end);
+    }
+
+    std::unique_lock<std::mutex> lock(stateLock);
+    currentTask = &task;
+    steals.store(0);
+    activeWorkers = int(threads);
+    ++generation;
+    wake.notify_all();
+    done.wait(lock, [this] { return activeWorkers == 0; });
+    currentTask = nullptr;
+}
+
+bool WorkStealingPool::popLocal(int worker, int* index) {
+    Queue& queue = *queues[size_t(worker)];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.items.empty()) {
+        return false;
+    }
+    *index = queue.items.front();
+    queue.items.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(int worker, int* index) {
+    const int threads = int(queues.size());
+    for (int offset = 1; offset < threads; ++offset) {
+        Queue& victim = *queues[size_t((worker + offset) % threads)];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.items.empty()) {
+            // 从尾部取：离被窃线程当前位置最远，双方不会争抢同一片区域
+            *index = victim.items.back();
+            victim.items.pop_back();
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int worker) {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        const Task* task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(stateLock);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+            task = currentTask;
+        }
+
+        // 本轮不会再加入任务，所有队列都取空即可退出
+        int index = 0;
+        while (popLocal(worker, &index) || steal(worker, &index)) {
+            (*task)(index, worker);
+        }
+
+        std::lock_guard<std::mutex> guard(stateLock);
+        if (--activeWorkers == 0) {
+            done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 常驻线程的工作窃取线程池
+// 每次 run 把任务序列按连续段分给各线程（保持空间局部性），线程从自己队列的头部取任务，
+// 空闲时从其他线程队列的尾部窃取。适合单个任务耗时差异很大的块渲染（光子环附近的块步数多得多）
+class WorkStealingPool {
+public:
+    using Task = std::function<void(int index, int worker)>;
+
+    // threads <= 0 时使用硬件线程数
+    explicit WorkStealingPool(int threads = 0);
+    ~WorkStealingPool();
+
+    int threadCount() const { return int(workers.size()); }
+    // 按 order 的顺序执行 task(order[i], worker)，阻塞到全部完成
+    void run(const std::vector<int>& order, const Task& task);
+    // 上一次 run 中被窃取的任务数
+    uint64_t stealCount() const { return steals.load(); }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex lock;
+        std::deque<int> items;
+    };
+
+    void workerLoop(int worker);
+    bool popLocal(int worker, int* index);
+    bool steal(int worker, int* index);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;
+    const Task* currentTask = nullptr;
+
+    std::mutex stateLock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    int activeWorkers = 0;
+    bool stopping = false;
+    std::atomic<uint64_t> steals{0};
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -1,6 +1,7 @@
 #include "glcirclewidget.h"
 #include <QDebug>
 #include <QFile>
+#include <QDir>
 #include <QImage>
 #include <cmath>
 #include <QPainter>
@@ -20,125 +21,34 @@ GLCircleWidget::GLCircleWidget(QWidget* parent) : QOpenGLWidget(parent) {
     });
     timer->start(16); // ~60 FPS
     
-    // Initialize pointers
-    fbo = nullptr;
-    prevFrameTexture = nullptr;
-    screenProgram = nullptr;
-    mipmapProgram = nullptr;
-    mipmapFBO = nullptr;
-    horizontalFBO = nullptr;
-    verticalFBO = nullptr;
-    
     // 初始化帧率计数器
     frameCount = 0;
     fps = 0.0f;
 }
 
+GLCircleWidget::~GLCircleWidget() {
+    makeCurrent();
+    if (capture) {
+        capture->flush();
+        capture->release();
+        delete capture;
+    }
+    delete recorder;
+    delete renderer;
+    doneCurrent();
+}
+
 void GLCircleWidget::initializeGL() {
     initializeOpenGLFunctions();
 
     frameTimer.start();
     lastFrameTime = frameTimer.elapsed() / 1000.0f;
     
-    // Create main shader program
-    program = new QOpenGLShaderProgram(this);
-    if (!program->addShaderFromSourceFile(QOpenGLShader::Vertex, "../shaders/circle.vert")) {
-        qDebug() << "Vertex shader error:" << program->log();
-    }
-    if (!program->addShaderFromSourceFile(QOpenGLShader::Fragment, "../shaders/circle.frag")) {
-        qDebug() << "Fragment shader error:" << program->log();
-    }
-    if (!program->link()) {
-        qDebug() << "Shader link error:" << program->log();
-    }
-    
-    // Create screen shader program
-    screenProgram = new QOpenGLShaderProgram(this);
-    if (!screenProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, "../shaders/screen.vert")) {
-        qDebug() << "Screen vertex shader error:" << screenProgram->log();
-    }
-    if (!screenProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, "../shaders/screen.frag")) {
-        qDebug() << "Screen fragment shader error:" << screenProgram->log();
-    }
-    if (!screenProgram->link()) {
-        qDebug() << "Screen shader link error:" << screenProgram->log();
-    }
-    
-    // Create mipmap shader program
-    mipmapProgram = new QOpenGLShaderProgram(this);
-    if (!mipmapProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, "../shaders/screen.vert")) {
-        qDebug() << "Mipmap vertex shader error:" << mipmapProgram->log();
-    }
-    if (!mipmapProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, "../shaders/mipmap.frag")) {
-        qDebug() << "Mipmap fragment shader error:" << mipmapProgram->log();
-    }
-    if (!mipmapProgram->link()) {
-        qDebug() << "Mipmap shader link error:" << mipmapProgram->log();
-    }
-
-    // Create horizontal blur shader program
-    horizontalProgram = new QOpenGLShaderProgram(this);
-    if (!horizontalProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, "../shaders/screen.vert")) {
-        qDebug() << "Horizontal vertex shader error:" << horizontalProgram->log();
-    }
-    if (!horizontalProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, "../shaders/horizontal.frag")) {
-        qDebug() << "Horizontal fragment shader error:" << horizontalProgram->log();
+    renderer = new BlackHoleRenderer();
+    if (!renderer->initialize("../shaders/")) {
+        qDebug() << "Black hole renderer initialization failed";
     }
-    if (!horizontalProgram->link()) {
-        qDebug() << "Horizontal shader link error:" << horizontalProgram->log();
-    }
-
-    // Create vertical blur shader program
-    verticalProgram = new QOpenGLShaderProgram(this);
-    if (!verticalProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, "../shaders/screen.vert")) {
-        qDebug() << "Vertical vertex shader error:" << verticalProgram->log();
-    }
-    if (!verticalProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, "../shaders/vertical.frag")) {
-        qDebug() << "Vertical fragment shader error:" << verticalProgram->log();
-    }
-    if (!verticalProgram->link()) {
-        qDebug() << "Vertical shader link error:" << verticalProgram->log();
-    }
-
-    // Create vertical blur shader program
-    resultProgram = new QOpenGLShaderProgram(this);
-    if (!resultProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, "../shaders/screen.vert")) {
-        qDebug() << "Vertical vertex shader error:" << resultProgram->log();
-    }
-    if (!resultProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, "../shaders/screen_result.frag")) {
-        qDebug() << "Vertical fragment shader error:" << resultProgram->log();
-    }
-    if (!resultProgram->link()) {
-        qDebug() << "Vertical shader link error:" << resultProgram->log();
-    }
-    
-    // Create VAO and VBO
-    vao.create();
-    vao.bind();
-    
-    vbo.create();
-    vbo.bind();
-    
-    // Fullscreen quad vertices
-    const float vertices[] = {
-        -1.0f, -1.0f,
-         1.0f, -1.0f,
-         1.0f,  1.0f,
-         
-        -1.0f, -1.0f,
-         1.0f,  1.0f,
-        -1.0f,  1.0f
-    };
-    vbo.allocate(vertices, sizeof(vertices));
-    
-    // Configure attributes
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-    
-    // Create chess texture
-    createChessTexture();
-    
-    vao.release();
+    renderer->resize(width(), height());
 }
 
 void GLCircleWidget::paintGL() {
@@ -150,6 +60,22 @@ void GLCircleWidget::paintGL() {
         fps = frameCount * 1000.0f / fpsTimer.elapsed();
         frameCount = 0;
         fpsTimer.restart();
+        // 步数统计随帧率一起刷新，读回比当前帧晚两三帧
+        if (renderer && renderer->stepStatisticsEnabled()) {
+            const StepStatistics stats = renderer->stepStatistics();
+            const double pixels = double(stats.width) * double(stats.height);
+            if (stats.frame >= 0 && pixels > 0.0) {
+                emit stepStatisticsUpdated(QString("Frame %1: %2 steps/px (max %3), %4 disk calls/px\n"
+                                                   "escaped %5, captured %6, exhausted %7")
+                                               .arg(stats.frame)
+                                               .arg(double(stats.steps) / pixels, 0, 'f', 1)
+                                               .arg(stats.maxSteps)
+                                               .arg(double(stats.diskCalls) / pixels, 0, 'f', 2)
+                                               .arg(stats.escaped)
+                                               .arg(stats.captured)
+                                               .arg(stats.exhausted));
+            }
+        }
     } else if (!fpsTimer.isValid()) {
         fpsTimer.start();
     }
@@ -162,260 +88,19 @@ void GLCircleWidget::paintGL() {
     iTime += deltaTime;
     iFrame++;
     
-    // 第一步：渲染到帧缓冲
-    if (!fbo) {
-        QOpenGLFramebufferObjectFormat format;
-        format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-        format.setSamples(0);
-        fbo = new QOpenGLFramebufferObject(width(), height(), format);
-        
-        prevFrameTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-        prevFrameTexture->create();
-        prevFrameTexture->bind();
-        prevFrameTexture->setSize(width(), height());
-        prevFrameTexture->setFormat(QOpenGLTexture::RGBA8_UNorm);
-        prevFrameTexture->allocateStorage();
-        prevFrameTexture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
-        prevFrameTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-        prevFrameTexture->release();
-        
-        GLuint texId = fbo->texture();
-        glBindTexture(GL_TEXTURE_2D, texId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
+    BlackHoleFrameState state;
+    state.iTime = iTime;
+    state.iTimeDelta = deltaTime;
+    state.iFrame = iFrame;
+    state.iMouse = iMouse;
+    state.blackHoleMass = blackHoleMass;
+    state.backgroundType = backgroundType;
+    renderer->render(state, defaultFramebufferObject());
     
-    // 绑定FBO进行渲染
-    fbo->bind();
-    {
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        if (!program || !program->isLinked()) {
-            fbo->release();
-            return;
-        }
-        
-        program->bind();
-        vao.bind();
-        
-        // Set uniforms
-        program->setUniformValue("circleColor", circleColor);
-        program->setUniformValue("iResolution", width(), height());
-        program->setUniformValue("offset", offset);
-        program->setUniformValue("radius", radius);
-        program->setUniformValue("MBlackHole", blackHoleMass);
-        program->setUniformValue("backgroundType", backgroundType);
-        program->setUniformValue("iFrame", iFrame);
-        program->setUniformValue("iMouse", iMouse[0], iMouse[1], iMouse[2], iMouse[3]);
-        program->setUniformValue("iTime", iTime);
-        program->setUniformValue("iChannelResolution", 
-            chessTextureResolution.x(), chessTextureResolution.y(), chessTextureResolution.z());
-        program->setUniformValue("iTimeDelta", deltaTime);
-        
-        // Bind chess texture
-        if (chessTexture) {
-            glActiveTexture(GL_TEXTURE1);
-            chessTexture->bind();
-            program->setUniformValue("iChannel1", 1);
-        }
-        
-        // Bind previous frame texture
-        if (prevFrameTexture && iFrame > 0) {
-            glActiveTexture(GL_TEXTURE3);
-            prevFrameTexture->bind();
-            program->setUniformValue("iChannel3", 3);
-        }
-        
-        // Draw fullscreen quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        
-        // Copy current frame to previous frame texture
-        if (prevFrameTexture) {
-            glBindTexture(GL_TEXTURE_2D, prevFrameTexture->textureId());
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width(), height());
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
-
-        vao.release();
-        program->release();
-    }    
-    // 保存原始渲染纹理
-    GLuint originalTexture = fbo->texture();
-    fbo->release();
-    // 初始化处理后的纹理为原始纹理
-    GLuint processedTexture = originalTexture;
-    
-    // 应用 mipmap 效果
-    if (showMipmap) {
-        // Create mipmap FBO if needed
-        if (!mipmapFBO) {
-            QOpenGLFramebufferObjectFormat format;
-            format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-            format.setSamples(0);
-            mipmapFBO = new QOpenGLFramebufferObject(width(), height(), format);
-        }
-        
-        // Bind mipmap FBO
-        mipmapFBO->bind();
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        mipmapProgram->bind();
-        vao.bind();
-        
-        // Bind input texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, processedTexture);  // 使用当前处理后的纹理
-        mipmapProgram->setUniformValue("iChannel0", 0);
-        mipmapProgram->setUniformValue("iResolution", width(), height());
-        
-        // Draw fullscreen quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        
-        vao.release();
-        mipmapProgram->release();
-        mipmapFBO->release();
-        
-        // Update processed texture
-        processedTexture = mipmapFBO->texture();
-    }
-    
-    // 应用水平模糊
-    if (horizontal) {
-        // 创建水平模糊FBO（如果需要）
-        if (!horizontalFBO) {
-            QOpenGLFramebufferObjectFormat format;
-            format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-            format.setSamples(0);
-            horizontalFBO = new QOpenGLFramebufferObject(width(), height(), format);
-
-            // 设置纹理过滤和环绕模式
-            GLuint texId = horizontalFBO->texture();
-            glBindTexture(GL_TEXTURE_2D, texId);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
-        
-        // 绑定水平模糊FBO
-        horizontalFBO->bind();
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        horizontalProgram->bind();
-        vao.bind();
-        
-        // 绑定输入纹理（使用当前处理后的纹理）
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, processedTexture);
-        horizontalProgram->setUniformValue("iChannel0", 0);
-        horizontalProgram->setUniformValue("iResolution", width(), height());
-        
-        // 绘制全屏四边形
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        
-        vao.release();
-        horizontalProgram->release();
-        horizontalFBO->release();
-        
-        // 更新处理后的纹理
-        processedTexture = horizontalFBO->texture();
-    }
-    
-    // 应用垂直模糊
-    if (vertical) {
-        // 创建垂直模糊FBO（如果需要）
-        if (!verticalFBO) {
-            QOpenGLFramebufferObjectFormat format;
-            format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-            format.setSamples(0);
-            verticalFBO = new QOpenGLFramebufferObject(width(), height(), format);
-            // 设置纹理过滤和环绕模式
-            GLuint texId = verticalFBO->texture();
-            glBindTexture(GL_TEXTURE_2D, texId);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
-        
-        // 绑定垂直模糊FBO
-        verticalFBO->bind();
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        verticalProgram->bind();
-        vao.bind();
-        
-        // 绑定输入纹理（使用当前处理后的纹理）
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, processedTexture);
-        verticalProgram->setUniformValue("iChannel0", 0);
-        verticalProgram->setUniformValue("iResolution", width(), height());
-        
-        // 绘制全屏四边形
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        
-        vao.release();
-        verticalProgram->release();
-        verticalFBO->release();
-        
-        // 更新处理后的纹理
-        processedTexture = verticalFBO->texture();
-    }
-    
-    // 保存Bloom纹理（处理后的纹理）
-    GLuint bloomTexture = processedTexture;
-    
-    // Step 3: Render to screen
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    
-    if (result) {
-        // 使用resultProgram（screen_result.frag）
-        resultProgram->bind();
-        vao.bind();
-        
-        // // 绑定原始纹理到iChannel0
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, originalTexture);
-        resultProgram->setUniformValue("iChannel0", 0);
-        
-        // 绑定Bloom纹理到iChannel3
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, bloomTexture);
-        resultProgram->setUniformValue("iChannel3", 3);
-        
-        // 设置分辨率uniform
-        resultProgram->setUniformValue("iResolution", QVector2D(width(), height()));
-        
-        // 绘制全屏四边形
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        
-        vao.release();
-        resultProgram->release();
-    } else {
-        // 使用原来的screenProgram
-        screenProgram->bind();
-        vao.bind();
-        
-        // 绑定要渲染的纹理（可能是原始纹理或处理后的纹理）
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, processedTexture);
-        screenProgram->setUniformValue("screenTexture", 0);
-        
-        // 绘制全屏四边形
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        
-        vao.release();
-        screenProgram->release();
+    // 录制：在叠加帧率文字之前读取最终结果
+    if (recorder) {
+        capture->capture(defaultFramebufferObject(), renderer->width(), renderer->height());
+        capture->poll();
     }
     
     // === 在右下角绘制帧率 ===
@@ -437,26 +122,9 @@ void GLCircleWidget::resizeGL(int w, int h) {
     glViewport(0, 0, w, h);
     updateAspectRatio();
     
-    // Delete old FBO and textures
-    if (fbo) {
-        delete fbo;
-        fbo = nullptr;
-    }
-    if (prevFrameTexture) {
-        delete prevFrameTexture;
-        prevFrameTexture = nullptr;
-    }
-    if (mipmapFBO) {
-        delete mipmapFBO;
-        mipmapFBO = nullptr;
-    }
-    if (horizontalFBO) {
-        delete horizontalFBO;
-        horizontalFBO = nullptr;
-    }
-    if (verticalFBO) {
-        delete verticalFBO;
-        verticalFBO = nullptr;
+    // FBO和纹理在下一帧按新尺寸重建
+    if (renderer) {
+        renderer->resize(w, h);
     }
     
     update();
@@ -508,28 +176,6 @@ void GLCircleWidget::mouseMoveEvent(QMouseEvent* event) {
     update();
 }
 
-void GLCircleWidget::createChessTexture() {
-    const int size = 64;
-    QImage image(size, size, QImage::Format_RGBA8888);
-    
-    QColor color1(220, 220, 220);
-    QColor color2(80, 80, 100);
-    
-    const int tileSize = size / 8;
-    for (int y = 0; y < size; y++) {
-        for (int x = 0; x < size; x++) {
-            int tileX = x / tileSize;
-            int tileY = y / tileSize;
-            image.setPixelColor(x, y, (tileX + tileY) % 2 == 0 ? color1 : color2);
-        }
-    }
-    
-    chessTexture = new QOpenGLTexture(image);
-    chessTexture->setWrapMode(QOpenGLTexture::Repeat);
-    chessTexture->setMinificationFilter(QOpenGLTexture::Linear);
-    chessTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
 void GLCircleWidget::updateAspectRatio() {
     float w = width();
     float h = height();
@@ -551,28 +197,84 @@ void GLCircleWidget::setBackgroundType(int type) {
     update();
 }
 
+void GLCircleWidget::setBlackHoleSpin(double spin) {
+    if (renderer) {
+        renderer->setBlackHoleSpin(float(spin));
+    }
+    update();
+}
+
+void GLCircleWidget::setDebugView(int view) {
+    if (renderer) {
+        renderer->setDebugView(DebugView(view));
+    }
+    update();
+}
+
+void GLCircleWidget::setStepStatistics(bool enabled) {
+    if (renderer) {
+        renderer->setStepStatisticsEnabled(enabled);
+    }
+    update();
+}
+
+void GLCircleWidget::setMaxGeodesicSteps(int steps) {
+    if (renderer) {
+        renderer->setMaxGeodesicSteps(steps);
+    }
+    update();
+}
+
 void GLCircleWidget::setShowMipmap(bool show) {
-    showMipmap = show;
+    if (renderer) {
+        renderer->setShowMipmap(show);
+    }
     update();
 }
 
 void GLCircleWidget::setHorizontalBlurEnabled(bool enabled) {
-    horizontal = enabled;
+    if (renderer) {
+        renderer->setHorizontalBlurEnabled(enabled);
+    }
     update();
 }
 
 void GLCircleWidget::setVerticalBlurEnabled(bool enabled) {
-    vertical = enabled;
+    if (renderer) {
+        renderer->setVerticalBlurEnabled(enabled);
+    }
     update();
 }
 
 void GLCircleWidget::setShowRenderResult(bool show) {
     // 当需要显示渲染结果时，启用所有效果
-    if (show) {
-        result = show;
-        showMipmap = show;
-        horizontal = show;
-        vertical = show;
+    if (renderer) {
+        renderer->setShowRenderResult(show);
     }
     update();
-}
\ No newline at end of file
+}
+
+void GLCircleWidget::setRecording(bool enabled) {
+    if (!renderer || enabled == (recorder != nullptr)) {
+        return;
+    }
+    makeCurrent();
+    if (enabled) {
+        if (!capture) {
+            capture = new FrameCapture(3);
+            capture->initialize();
+        }
+        QDir().mkpath("capture");
+        recorder = new ImageSequenceWriter("capture", "frame");
+        capture->setConsumer([this](const CapturedFrame& frame) {
+            (*recorder)(frame);
+        });
+    } else {
+        // 交付仍在环中的帧后再停止
+        capture->flush();
+        capture->setConsumer(nullptr);
+        delete recorder;
+        recorder = nullptr;
+    }
+    doneCurrent();
+}
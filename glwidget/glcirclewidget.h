@@ -2,30 +2,28 @@
 #define GLCIRCLEWIDGET_H
 
 #include <QOpenGLWidget>
-#include <QOpenGLShaderProgram>
-#include <QOpenGLTexture>
-#include <QOpenGLBuffer>
-#include <QOpenGLVertexArrayObject>
 #include <QOpenGLFunctions_4_3_Core>
 #include <QSurfaceFormat>
 #include <QMouseEvent>
 #include <QTimer>
-#include <QVector3D>
-#include <QVector2D>
 #include <QVector4D>
 #include <QPoint>
-#include <QOpenGLFramebufferObject>
 #include <QElapsedTimer>
+#include "../render/blackholerenderer.h"
+#include "../render/framecapture.h"
 
 class GLCircleWidget : public QOpenGLWidget, protected QOpenGLFunctions_4_3_Core {
     Q_OBJECT
 public:
     explicit GLCircleWidget(QWidget* parent = nullptr);
+    ~GLCircleWidget() override;
     void setBackgroundType(int type);
     void setShowMipmap(bool show);
 
 signals:
     void aspectRatioChanged(const QString& ratio);
+    // 打开步数统计时每0.5秒发出一次，内容是最近读回一帧的摘要
+    void stepStatisticsUpdated(const QString& text);
 
 protected:
     void initializeGL() override;
@@ -36,48 +34,20 @@ protected:
     void mouseMoveEvent(QMouseEvent* event) override;
 
 public:
-    void createChessTexture();
     void updateAspectRatio();
 
 private:
-    // OpenGL resources
-    QOpenGLShaderProgram* program = nullptr;
-    QOpenGLVertexArrayObject vao;
-    QOpenGLBuffer vbo;
-    QOpenGLTexture* chessTexture = nullptr;
-    
-    // FBO and textures
-    QOpenGLFramebufferObject* fbo = nullptr;
-    QOpenGLTexture* prevFrameTexture = nullptr;
-    QOpenGLShaderProgram* screenProgram = nullptr;
-    
-    // Mipmap resources
-    bool showMipmap = true;
-    QOpenGLShaderProgram* mipmapProgram = nullptr;
-    QOpenGLFramebufferObject* mipmapFBO = nullptr;
-    
-    // horizontal resources
-    bool horizontal = true;
-    QOpenGLShaderProgram* horizontalProgram = nullptr;
-    QOpenGLFramebufferObject* horizontalFBO = nullptr;
-
-    // vertical resources
-    bool vertical = true;
-    QOpenGLShaderProgram* verticalProgram = nullptr;
-    QOpenGLFramebufferObject* verticalFBO = nullptr;
+    // 渲染通道链（与离线渲染器共用）
+    BlackHoleRenderer* renderer = nullptr;
+    // 帧录制：PBO环异步读取 + 线程池编码
+    FrameCapture* capture = nullptr;
+    ImageSequenceWriter* recorder = nullptr;
     QElapsedTimer frameTimer;
-
-    bool result = true;
-    QOpenGLShaderProgram* resultProgram = nullptr;
     float lastFrameTime = 0.0f;
 
     // Uniform values
-    QVector3D circleColor{1.0f, 0.0f, 0.0f};
-    QVector2D offset{0.2f, 0.2f};
-    float radius = 0.2f;
     float blackHoleMass = 1.49e7f;
     int backgroundType = 1;
-    QVector3D chessTextureResolution{64.0f, 64.0f, 0.0f};
     
     // Shadertoy-like variables
     float iTime = 0.0f;
@@ -95,6 +65,11 @@ public slots:
     void setHorizontalBlurEnabled(bool enabled);
     void setVerticalBlurEnabled(bool enabled);
     void setShowRenderResult(bool show); // 新增渲染结果槽函数
+    void setRecording(bool enabled);
+    void setBlackHoleSpin(double spin);
+    void setDebugView(int view);
+    void setStepStatistics(bool enabled);
+    void setMaxGeodesicSteps(int steps);
 };
 
 #endif // GLCIRCLEWIDGET_H
\ No newline at end of file
@@ -36,6 +36,7 @@ int main(int argc, char* argv[]) {
         ":/shaders/basic.frag",
         ":/shaders/basic.vert",
         ":/shaders/circle.frag",
+        ":/shaders/blackhole.glsl",
         ":/shaders/circle.vert",
         ":/shaders/multipass.vert",
         ":/shaders/multipass_circle.frag",
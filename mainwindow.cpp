@@ -258,6 +258,23 @@ void MainWindow::connectSignals() {
     connect(circleControl, &ControlPanel::showRenderResultChanged,
             circleCanvas, &GLCircleWidget::setShowRenderResult);
     
+    // 连接录制信号
+    connect(circleControl, &ControlPanel::recordFramesChanged,
+            circleCanvas, &GLCircleWidget::setRecording);
+    
+    connect(circleControl, &ControlPanel::spinChanged,
+            circleCanvas, &GLCircleWidget::setBlackHoleSpin);
+    
+    // 连接调试视图、步数上限和步数统计信号
+    connect(circleControl, &ControlPanel::debugViewChanged,
+            circleCanvas, &GLCircleWidget::setDebugView);
+    connect(circleControl, &ControlPanel::maxStepsChanged,
+            circleCanvas, &GLCircleWidget::setMaxGeodesicSteps);
+    connect(circleControl, &ControlPanel::stepStatisticsChanged,
+            circleCanvas, &GLCircleWidget::setStepStatistics);
+    connect(circleCanvas, &GLCircleWidget::stepStatisticsUpdated,
+            circleControl, &ControlPanel::setStepStatisticsText);
+    
     // Initial aspect ratio update
     if (circleCanvas) {
         circleCanvas->updateAspectRatio();
@@ -0,0 +1,245 @@
+#include "batchrunner.h"
+#include "framecapture.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+BlackHoleFrameState BatchJob::frameState(int frame) const {
+    BlackHoleFrameState state;
+    state.iTime = startTime + frame * timestep;
+    state.iTimeDelta = timestep;
+    // iFrame >= 2 使相机取iMouse；首帧iMouse.z > 0 丢弃之前留下的TAA历史
+    state.iFrame = frame + 2;
+    state.iMouse = QVector4D(cameraTheta * width, cameraPhi * height, frame == 0 ? 1.0f : 0.0f, 0.0f);
+    state.blackHoleMass = mass;
+    state.diskNormal = diskNormal;
+    state.cameraRadius = cameraRadius;
+    state.backgroundType = backgroundType;
+    return state;
+}
+
+BatchRunner::BatchRunner(OffscreenRenderer& offscreen) : offscreen(offscreen) {}
+
+BatchJob BatchRunner::jobFromFields(const QVariantMap& fields, const BatchJob& defaults, int index) {
+    BatchJob job = defaults;
+    job.name = QString("job%1").arg(index, 3, 10, QChar('0'));
+
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        const QString& key = it.key();
+        const QVariant& value = it.value();
+        if (key == "name") {
+            job.name = value.toString();
+        } else if (key == "width") {
+            job.width = value.toInt();
+        } else if (key == "height") {
+            job.height = value.toInt();
+        } else if (key == "frames") {
+            job.frames = value.toInt();
+        } else if (key == "timestep") {
+            job.timestep = value.toFloat();
+        } else if (key == "startTime") {
+            job.startTime = value.toFloat();
+        } else if (key == "mass") {
+            job.mass = value.toFloat();
+        } else if (key == "inclination") {
+            // 盘法向绕z轴倾斜的角度（度），0为法向朝+y；默认法向(0.2, 1, 0)约为11.3度
+            const float radians = value.toFloat() * float(M_PI) / 180.0f;
+            job.diskNormal = QVector3D(std::sin(radians), std::cos(radians), 0.0f);
+        } else if (key == "diskNormal" && value.type() == QVariant::List && value.toList().size() == 3) {
+            const QVariantList list = value.toList();
+            job.diskNormal = QVector3D(list[0].toFloat(), list[1].toFloat(), list[2].toFloat());
+        } else if (key == "diskNormalX") {
+            job.diskNormal.setX(value.toFloat());
+        } else if (key == "diskNormalY") {
+            job.diskNormal.setY(value.toFloat());
+        } else if (key == "diskNormalZ") {
+            job.diskNormal.setZ(value.toFloat());
+        } else if (key == "cameraRadius") {
+            job.cameraRadius = value.toFloat();
+        } else if (key == "cameraTheta") {
+            job.cameraTheta = value.toFloat();
+        } else if (key == "cameraPhi") {
+            job.cameraPhi = value.toFloat();
+        } else if (key == "background") {
+            job.backgroundType = value.toInt();
+        } else {
+            qWarning() << "Job" << index << "ignores unknown field" << key;
+        }
+    }
+    return job;
+}
+
+bool BatchRunner::loadJobs(const QString& path, const BatchJob& defaults, QVector<BatchJob>* jobs) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Cannot open job list" << path << file.errorString();
+        return false;
+    }
+
+    if (QFileInfo(path).suffix().compare("csv", Qt::CaseInsensitive) == 0) {
+        QTextStream in(&file);
+        QStringList header;
+        while (!in.atEnd()) {
+            const QString line = in.readLine().trimmed();
+            if (line.isEmpty() || line.startsWith('#')) {
+                continue;
+            }
+            QStringList cells = line.split(',');
+            for (QString& cell : cells) {
+                cell = cell.trimmed();
+            }
+            if (header.isEmpty()) {
+                header = cells;
+                continue;
+            }
+            QVariantMap fields;
+            for (int i = 0; i < cells.size() && i < header.size(); ++i) {
+                if (!cells[i].isEmpty()) {
+                    fields.insert(header[i], cells[i]);
+                }
+            }
+            jobs->append(jobFromFields(fields, defaults, jobs->size()));
+        }
+    } else {
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+        if (doc.isNull()) {
+            qWarning() << "Cannot parse job list" << path << error.errorString();
+            return false;
+        }
+        const QJsonArray list = doc.isArray() ? doc.array() : doc.object().value("jobs").toArray();
+        for (const QJsonValue& value : list) {
+            jobs->append(jobFromFields(value.toObject().toVariantMap(), defaults, jobs->size()));
+        }
+    }
+
+    for (const BatchJob& job : *jobs) {
+        if (job.width <= 0 || job.height <= 0 || job.frames <= 0) {
+            qWarning() << "Job" << job.name << "has an invalid size or frame count";
+            return false;
+        }
+    }
+    return !jobs->isEmpty();
+}
+
+bool BatchRunner::run(const QVector<BatchJob>& jobs, const QString& outputDir, const QString& manifestPath) {
+    struct JobResult {
+        double setupMs = 0.0;
+        double renderMs = 0.0;
+    };
+    QVector<JobResult> results(jobs.size());
+
+    // 所有任务共用同一组PBO；每个任务一个写线程池，PNG编码与下一个任务的渲染重叠
+    FrameCapture capture(3);
+    capture.initialize();
+    std::vector<std::unique_ptr<ImageSequenceWriter>> writers;
+    ImageSequenceWriter* writer = nullptr;
+    int firstFrameIndex = 0;
+    capture.setConsumer([&writer, &firstFrameIndex](const CapturedFrame& frame) {
+        CapturedFrame local = frame;
+        local.index = frame.index - firstFrameIndex;
+        (*writer)(local);
+    });
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+    int frameCounter = 0;
+    for (int i = 0; i < jobs.size(); ++i) {
+        const BatchJob& job = jobs[i];
+        if (job.width > offscreen.maxTargetSize() || job.height > offscreen.maxTargetSize()) {
+            qWarning() << "Job" << job.name << "exceeds the maximum framebuffer size" << offscreen.maxTargetSize();
+            writers.emplace_back(nullptr);
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        // 尺寸不变时resize不重建任何资源
+        offscreen.resize(job.width, job.height);
+        writers.emplace_back(new ImageSequenceWriter(outputDir, job.name));
+        writer = writers.back().get();
+        firstFrameIndex = frameCounter;
+        results[i].setupMs = timer.nsecsElapsed() / 1.0e6;
+
+        timer.restart();
+        for (int frame = 0; frame < job.frames; ++frame) {
+            const BlackHoleFrameState state = job.frameState(frame);
+            offscreen.renderFrame(state);
+            capture.capture(offscreen.target()->handle(), job.width, job.height);
+            capture.poll();
+        }
+        // 计时包含读取，下一个任务开始前本任务的帧已全部交给写线程池
+        capture.flush();
+        frameCounter += job.frames;
+        results[i].renderMs = timer.nsecsElapsed() / 1.0e6;
+
+        std::fprintf(stderr, "%s: %d frames %dx%d in %.1f ms (%.2f ms/frame)\n", qPrintable(job.name), job.frames,
+                     job.width, job.height, results[i].renderMs, results[i].renderMs / job.frames);
+    }
+    capture.release();
+    const double renderSeconds = totalTimer.nsecsElapsed() / 1.0e9;
+
+    bool ok = true;
+    QJsonArray entries;
+    for (int i = 0; i < jobs.size(); ++i) {
+        const BatchJob& job = jobs[i];
+        QJsonObject entry;
+        entry["name"] = job.name;
+        entry["width"] = job.width;
+        entry["height"] = job.height;
+        entry["frames"] = job.frames;
+        entry["timestep"] = job.timestep;
+        entry["startTime"] = job.startTime;
+        entry["mass"] = job.mass;
+        entry["diskNormal"] = QJsonArray{job.diskNormal.x(), job.diskNormal.y(), job.diskNormal.z()};
+        entry["cameraRadius"] = job.cameraRadius;
+        entry["cameraTheta"] = job.cameraTheta;
+        entry["cameraPhi"] = job.cameraPhi;
+        entry["background"] = job.backgroundType;
+
+        ImageSequenceWriter* jobWriter = writers[size_t(i)].get();
+        if (!jobWriter) {
+            entry["status"] = "skipped";
+            ok = false;
+        } else {
+            jobWriter->waitForDone();
+            const int failed = jobWriter->failedCount();
+            entry["status"] = failed == 0 ? "ok" : "failed";
+            entry["failedFrames"] = failed;
+            entry["setupMs"] = results[i].setupMs;
+            entry["renderMs"] = results[i].renderMs;
+            entry["msPerFrame"] = results[i].renderMs / job.frames;
+            QJsonArray files;
+            for (int frame = 0; frame < job.frames; ++frame) {
+                files.append(QString("%1_%2.png").arg(job.name).arg(frame, 4, 10, QChar('0')));
+            }
+            entry["files"] = files;
+            ok = ok && failed == 0;
+        }
+        entries.append(entry);
+    }
+
+    QJsonObject root;
+    root["jobs"] = entries;
+    root["totalFrames"] = frameCounter;
+    root["renderSeconds"] = renderSeconds;
+    root["framesPerSecond"] = frameCounter / renderSeconds;
+
+    QFile file(manifestPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot write manifest" << manifestPath << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    return ok;
+}
@@ -0,0 +1,46 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+#include "offscreenrenderer.h"
+
+// 参数扫描中的一个任务，未给出的字段沿用命令行的默认值
+struct BatchJob {
+    QString name;
+    int width = 1920;
+    int height = 1080;
+    int frames = 1;
+    float timestep = 1.0f / 60.0f;
+    float startTime = 0.0f;
+    float mass = 1.49e7f;
+    QVector3D diskNormal{0.2f, 1.0f, 0.0f};
+    float cameraRadius = 0.000057f;
+    float cameraTheta = 0.45f;   // 与iMouse.x / iResolution.x 相同的比例
+    float cameraPhi = 0.55f;     // 与iMouse.y / iResolution.y 相同的比例
+    int backgroundType = 1;
+
+    // 任务第 frame 帧的渲染输入；frame == 0 时丢弃TAA历史
+    BlackHoleFrameState frameState(int frame) const;
+};
+
+// 在一个进程、一个OpenGL上下文中依次渲染任务列表
+// 着色器程序、棋盘纹理和相同尺寸的FBO在任务之间复用，吞吐量只受渲染本身限制
+class BatchRunner {
+public:
+    explicit BatchRunner(OffscreenRenderer& offscreen);
+
+    // 读取JSON（对象数组或 {"jobs": [...]}) 或CSV（首行为字段名）任务列表
+    static bool loadJobs(const QString& path, const BatchJob& defaults, QVector<BatchJob>* jobs);
+
+    // 渲染全部任务，帧写入 outputDir/<任务名>_NNNN.png，并写出清单 manifestPath
+    bool run(const QVector<BatchJob>& jobs, const QString& outputDir, const QString& manifestPath);
+
+private:
+    static BatchJob jobFromFields(const QVariantMap& fields, const BatchJob& defaults, int index);
+
+    OffscreenRenderer& offscreen;
+};
+
+#endif // BATCHRUNNER_H
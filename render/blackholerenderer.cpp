@@ -0,0 +1,1481 @@
+#include "blackholerenderer.h"
+#include "lensingmap.h"
+#include "../core/deflectiontable.h"
+#include "../core/noisevolume.h"
+#include "../core/bluenoise.h"
+#include "../core/emissiontables.h"
+#include "../core/blackholekernel.h"
+#include <QDebug>
+#include <QFile>
+#include <QImage>
+#include <QColor>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const GLuint kWavefrontGroupSize = 256;   // wavefront_queue.glsl 的 kWavefrontGroupSize
+const GLuint kWavefrontGroupRow = 65535;  // wavefront_queue.glsl 的 kWavefrontGroupRow
+const int kWavefrontTile = 8;             // 逐像素通道的工作组边长
+const int kWavefrontCheckInterval = 4;    // 每推进几次回读一次存活光线数
+const GLintptr kWavefrontHeaderSize = 4 * sizeof(GLuint);   // WavefrontQueueHeader
+const GLuint kFrameBlockBinding = 0;      // blackhole.glsl 的 BlackHoleFrameBlock
+const GLuint kStepCounterBinding = 4;     // circle.frag 的 StepCounters（SSBO 0~3 是测地线缓存）
+const GLuint kStepImageUnit = 0;          // circle.frag 的 stepCountImage
+const float kKerrTableTolerance = 0.1f;   // Kerr 表可用的半径对数差和倾角差（弧度）
+const int kStepReadbackCount = 3;         // 与 BlackHoleRenderer::stepReadbacks 的长度相同
+// 测地线缓存：相机静止后先完整追踪这么多帧，让 TAA 历史积累不同抖动的样本；
+// 之后每隔 kCacheRetraceInterval 帧用当帧的抖动重新记录，复用帧之间的抖动仍在变化
+const int kCacheHistoryFrames = 16;
+const int kCacheRetraceInterval = 4;
+
+// circle.frag 的 StepCounters（std430）
+struct StepCounters {
+    GLuint stepsLow;
+    GLuint stepsHigh;
+    GLuint diskCallsLow;
+    GLuint diskCallsHigh;
+    GLuint stepsMax;
+    GLuint escaped;
+    GLuint captured;
+    GLuint exhausted;
+};
+
+// circle.frag 的相机和黑洞几何对应的 CPU 输入，w、h 为整幅图像尺寸
+TraceParams traceParams(const BlackHoleFrameState& state, int w, int h) {
+    TraceParams params;
+    params.width = w;
+    params.height = h;
+    params.iFrame = state.iFrame;
+    params.iMouse = glsl::vec4(state.iMouse.x(), state.iMouse.y(), state.iMouse.z(), state.iMouse.w());
+    params.blackHoleMass = state.blackHoleMass;
+    params.diskNormal = glsl::vec3(state.diskNormal.x(), state.diskNormal.y(), state.diskNormal.z());
+    params.cameraRadius = state.cameraRadius;
+    params.fov = state.fov;
+    return params;
+}
+
+// 在 #version 行之后插入特性键的 #define
+QByteArray injectDefines(const QByteArray& source, const QByteArray& defines) {
+    if (defines.isEmpty()) {
+        return source;
+    }
+    const int lineEnd = source.startsWith("#version") ? source.indexOf('\n') + 1 : 0;
+    return source.left(lineEnd) + defines + source.mid(lineEnd);
+}
+
+} // namespace
+
+quint32 ShaderPermutation::key() const {
+    return quint32(backgroundType & 0xff) | quint32(disk) << 8 | quint32(noise) << 9 | quint32(temporalBlend) << 10 |
+           quint32(stepStatistics) << 11 | quint32(debugView) << 12;
+}
+
+QByteArray ShaderPermutation::defines() const {
+    QByteArray text;
+    text += "#define BACKGROUND_TYPE " + QByteArray::number(backgroundType) + "\n";
+    text += "#define DISK_ENABLED " + QByteArray::number(disk ? 1 : 0) + "\n";
+    text += "#define TEMPORAL_BLEND " + QByteArray::number(temporalBlend ? 1 : 0) + "\n";
+    text += "#define DEBUG_VIEW " + QByteArray::number(int(debugView)) + "\n";
+    text += "#define STEP_STATS " + QByteArray::number(stepStatistics ? 1 : 0) + "\n";
+    if (noise == DiskNoiseQuality::Analytic) {
+        text += "#define ANALYTIC_DISK_NOISE\n";
+    }
+    return text;
+}
+
+BlackHoleRenderer::~BlackHoleRenderer() {
+    releaseTargets();
+    qDeleteAll(circleVariants);
+    delete screenProgram;
+    delete mipmapProgram;
+    delete horizontalProgram;
+    delete verticalProgram;
+    delete resultProgram;
+    delete equirectProgram;
+    releaseCubeTarget();
+    delete chessTexture;
+    if (deflectionTexture) {
+        glDeleteTextures(1, &deflectionTexture);
+    }
+    if (kerrTexture) {
+        glDeleteTextures(1, &kerrTexture);
+    }
+    if (noiseTexture) {
+        glDeleteTextures(1, &noiseTexture);
+    }
+    if (blueNoiseTexture) {
+        glDeleteTextures(1, &blueNoiseTexture);
+    }
+    if (emissionTexture) {
+        glDeleteTextures(1, &emissionTexture);
+    }
+    if (frameBuffer) {
+        glDeleteBuffers(1, &frameBuffer);
+    }
+    releaseGeodesicCache();
+    releaseStepStatistics();
+    delete wavefrontScanProgram;
+    delete wavefrontScanGroupsProgram;
+    delete wavefrontScatterProgram;
+    releaseWavefrontBuffers();
+    releaseLensingMap();
+    delete skyTexture;
+    vao.destroy();
+    vbo.destroy();
+}
+
+// 读入着色器源码并展开 #include "file"（相对 shaderDir），circle.frag 和计算着色器共用 blackhole.glsl
+QByteArray BlackHoleRenderer::loadShaderSource(const QString& file) {
+    QFile source(shaderDir + file);
+    if (!source.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open shader" << shaderDir + file;
+        return QByteArray();
+    }
+    QByteArray expanded;
+    while (!source.atEnd()) {
+        const QByteArray line = source.readLine();
+        const QByteArray directive = line.trimmed();
+        if (directive.startsWith("#include")) {
+            const int begin = directive.indexOf('"');
+            const int end = directive.lastIndexOf('"');
+            if (begin >= 0 && end > begin) {
+                expanded += loadShaderSource(QString::fromUtf8(directive.mid(begin + 1, end - begin - 1)));
+                if (!expanded.endsWith('\n')) {
+                    expanded += '\n';
+                }
+                continue;
+            }
+        }
+        expanded += line;
+    }
+    return expanded;
+}
+
+QOpenGLShaderProgram* BlackHoleRenderer::createProgram(const QString& vertexFile, const QString& fragmentFile,
+                                                       const char* name, const QString& geometryFile,
+                                                       const QByteArray& defines) {
+    QOpenGLShaderProgram* shader = new QOpenGLShaderProgram();
+    if (!shader->addShaderFromSourceCode(QOpenGLShader::Vertex, loadShaderSource(vertexFile))) {
+        qDebug() << name << "vertex shader error:" << shader->log();
+    }
+    if (!geometryFile.isEmpty() &&
+        !shader->addShaderFromSourceCode(QOpenGLShader::Geometry, loadShaderSource(geometryFile))) {
+        qDebug() << name << "geometry shader error:" << shader->log();
+    }
+    if (!shader->addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                         injectDefines(loadShaderSource(fragmentFile), defines))) {
+        qDebug() << name << "fragment shader error:" << shader->log();
+    }
+    if (!shader->link()) {
+        qDebug() << name << "shader link error:" << shader->log();
+    }
+    return shader;
+}
+
+QOpenGLShaderProgram* BlackHoleRenderer::createComputeProgram(const QString& computeFile, const char* name,
+                                                              const QByteArray& defines) {
+    QOpenGLShaderProgram* shader = new QOpenGLShaderProgram();
+    if (!shader->addShaderFromSourceCode(QOpenGLShader::Compute,
+                                         injectDefines(loadShaderSource(computeFile), defines))) {
+        qDebug() << name << "compute shader error:" << shader->log();
+    }
+    if (!shader->link()) {
+        qDebug() << name << "shader link error:" << shader->log();
+    }
+    return shader;
+}
+
+QOpenGLShaderProgram* BlackHoleRenderer::circleVariant(CircleProgram kind, const ShaderPermutation& permutation) {
+    const quint32 key = quint32(kind) << 24 | permutation.key();
+    QHash<quint32, QOpenGLShaderProgram*>::const_iterator found = circleVariants.constFind(key);
+    if (found != circleVariants.constEnd()) {
+        return found.value();
+    }
+    const QByteArray defines = permutation.defines();
+    QOpenGLShaderProgram* variant = nullptr;
+    switch (kind) {
+    case CircleProgram::Fragment:
+        variant = createProgram("circle.vert", "circle.frag", "Circle", QString(), defines);
+        break;
+    case CircleProgram::Cubemap:
+        variant = createProgram("circle.vert", "circle.frag", "Cubemap", "cubeface.geom", defines);
+        break;
+    case CircleProgram::Relens:
+        variant = createProgram("screen.vert", "relens.frag", "Relens", QString(), defines);
+        break;
+    case CircleProgram::WavefrontInit:
+        variant = createComputeProgram("wavefront_init.comp", "Wavefront init", defines);
+        break;
+    case CircleProgram::WavefrontMarch:
+        variant = createComputeProgram("wavefront_march.comp", "Wavefront march", defines);
+        break;
+    case CircleProgram::WavefrontShade:
+        variant = createComputeProgram("wavefront_shade.comp", "Wavefront shade", defines);
+        break;
+    }
+    circleVariants.insert(key, variant);
+    return variant;
+}
+
+ShaderPermutation BlackHoleRenderer::permutation(int backgroundType) const {
+    ShaderPermutation result;
+    result.backgroundType = backgroundType;
+    result.disk = diskEnabled;
+    result.noise = diskNoiseQuality;
+    result.debugView = debugView;
+    return result;
+}
+
+bool BlackHoleRenderer::precompileBackgroundVariants() {
+    bool linked = true;
+    for (int backgroundType = 0; backgroundType < 4; ++backgroundType) {
+        linked = circleVariant(CircleProgram::Fragment, permutation(backgroundType))->isLinked() && linked;
+    }
+    return linked;
+}
+
+bool BlackHoleRenderer::initialize(const QString& dir) {
+    initializeOpenGLFunctions();
+    shaderDir = dir;
+
+    const bool circleLinked = precompileBackgroundVariants();
+    screenProgram = createProgram("screen.vert", "screen.frag", "Screen");
+    mipmapProgram = createProgram("screen.vert", "mipmap.frag", "Mipmap");
+    horizontalProgram = createProgram("screen.vert", "horizontal.frag", "Horizontal");
+    verticalProgram = createProgram("screen.vert", "vertical.frag", "Vertical");
+    resultProgram = createProgram("screen.vert", "screen_result.frag", "Result");
+    passUniformLocations(screenProgram);
+    mipmapLocations = passUniformLocations(mipmapProgram);
+    horizontalLocations = passUniformLocations(horizontalProgram);
+    verticalLocations = passUniformLocations(verticalProgram);
+    resultLocations = passUniformLocations(resultProgram);
+
+    // Create VAO and VBO
+    vao.create();
+    vao.bind();
+
+    vbo.create();
+    vbo.bind();
+
+    // Fullscreen quad vertices
+    const float vertices[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+         1.0f,  1.0f,
+
+        -1.0f, -1.0f,
+         1.0f,  1.0f,
+        -1.0f,  1.0f
+    };
+    vbo.allocate(vertices, sizeof(vertices));
+
+    // Configure attributes
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    // Create chess texture
+    createChessTexture();
+    createDeflectionTexture();
+    createNoiseTexture();
+    createBlueNoiseTexture();
+
+    vao.release();
+
+    return circleLinked && screenProgram->isLinked() && mipmapProgram->isLinked() &&
+           horizontalProgram->isLinked() && verticalProgram->isLinked() && resultProgram->isLinked();
+}
+
+void BlackHoleRenderer::resize(int w, int h) {
+    if (w == viewWidth && h == viewHeight) {
+        return;
+    }
+    viewWidth = w;
+    viewHeight = h;
+    // FBO在下一次render时按新尺寸重建
+    releaseTargets();
+    releaseGeodesicCache();
+    releaseWavefrontBuffers();
+    releaseLensingMap();
+}
+
+QOpenGLFramebufferObject* BlackHoleRenderer::createTarget(bool linearFilter) {
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+    format.setSamples(0);
+    QOpenGLFramebufferObject* target = new QOpenGLFramebufferObject(viewWidth, viewHeight, format);
+
+    if (linearFilter) {
+        // 设置纹理过滤和环绕模式
+        GLuint texId = target->texture();
+        glBindTexture(GL_TEXTURE_2D, texId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    return target;
+}
+
+// bloom金字塔的一级：线性过滤供下一级和模糊取样；级外按黑色边框取样，
+// 图像边缘之外没有光源，分块渲染时保护带之外同样为黑
+QOpenGLFramebufferObject* BlackHoleRenderer::createBloomTarget(const QSize& size) {
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::NoAttachment);
+    QOpenGLFramebufferObject* target = new QOpenGLFramebufferObject(size, format);
+
+    const GLfloat border[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    glBindTexture(GL_TEXTURE_2D, target->texture());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return target;
+}
+
+void BlackHoleRenderer::createTargets() {
+    fbo = createTarget(true);
+
+    prevFrameTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    prevFrameTexture->create();
+    prevFrameTexture->bind();
+    prevFrameTexture->setSize(viewWidth, viewHeight);
+    prevFrameTexture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    prevFrameTexture->allocateStorage();
+    prevFrameTexture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+    prevFrameTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    prevFrameTexture->release();
+
+    // 每级尺寸为上一级的一半（向上取整）
+    QSize levelSize(viewWidth, viewHeight);
+    for (int level = 0; level < kBloomLevels; ++level) {
+        levelSize = QSize((levelSize.width() + 1) / 2, (levelSize.height() + 1) / 2);
+        bloomLevels[level] = createBloomTarget(levelSize);
+        bloomScratch[level] = createBloomTarget(levelSize);
+    }
+}
+
+void BlackHoleRenderer::releaseTargets() {
+    delete fbo;
+    fbo = nullptr;
+    delete prevFrameTexture;
+    prevFrameTexture = nullptr;
+    for (int level = 0; level < kBloomLevels; ++level) {
+        delete bloomLevels[level];
+        bloomLevels[level] = nullptr;
+        delete bloomScratch[level];
+        bloomScratch[level] = nullptr;
+    }
+}
+
+// 视口和 iResolution 取目标的尺寸（bloom金字塔各级小于视口），iChannel0 在链接后已设为单元 0
+void BlackHoleRenderer::drawPass(QOpenGLShaderProgram* pass, const PassUniformLocations& loc, GLuint inputTexture,
+                                 QOpenGLFramebufferObject* target) {
+    target->bind();
+    glViewport(0, 0, target->width(), target->height());
+
+    pass->bind();
+    vao.bind();
+
+    // 绑定输入纹理（使用当前处理后的纹理）
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, inputTexture);
+    pass->setUniformValue(loc.iResolution, GLfloat(target->width()), GLfloat(target->height()));
+
+    // 绘制全屏四边形
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    vao.release();
+    pass->release();
+    target->release();
+}
+
+void BlackHoleRenderer::setCircleUniforms(QOpenGLShaderProgram* circle, const BlackHoleFrameState& state, int w, int h) {
+    const CircleUniformLocations& loc = circleUniformLocations(circle);
+    // 相机和光线方向按整幅图像计算，分块时视口只是其中一个窗口
+    const int imageWidth = state.imageSize.isEmpty() ? w : state.imageSize.width();
+    const int imageHeight = state.imageSize.isEmpty() ? h : state.imageSize.height();
+    circle->setUniformValue(loc.circleColor, circleColor);
+    circle->setUniformValue(loc.iResolution, GLfloat(imageWidth), GLfloat(imageHeight));
+    circle->setUniformValue(loc.iTileOffset, GLfloat(state.tileOffset.x()), GLfloat(state.tileOffset.y()));
+    circle->setUniformValue(loc.offset, offset);
+    circle->setUniformValue(loc.radius, radius);
+    circle->setUniformValue(loc.backgroundType, state.backgroundType);
+    circle->setUniformValue(loc.iFrame, state.iFrame);
+    circle->setUniformValue(loc.iMouse, state.iMouse);
+    circle->setUniformValue(loc.iTime, state.iTime);
+    circle->setUniformValue(loc.iChannelResolution, chessTextureResolution);
+    circle->setUniformValue(loc.iTimeDelta, state.iTimeDelta);
+    circle->setUniformValue(loc.iFov, state.fov);
+    // 针孔相机只用第0个基（单位阵），非分层渲染时gl_Layer恒为0
+    const QMatrix3x3 identity;
+    circle->setUniformValueArray(loc.iCameraBasis, &identity, 1);
+    circle->setUniformValue(loc.useDeflectionTable, deflectionTableEnabled && deflectionTexture ? 1 : 0);
+    circle->setUniformValue(loc.deflectionTableRange, DeflectionTable::kMinRadius, DeflectionTable::kMaxRadius);
+    circle->setUniformValue(loc.geodesicIntegrator, int(integrator));
+    circle->setUniformValue(loc.geodesicTolerance, geodesicTolerance);
+    circle->setUniformValue(loc.maxGeodesicSteps, maxGeodesicSteps);
+    kerrTableActive = prepareKerrTable(state, imageWidth, imageHeight);
+    circle->setUniformValue(loc.useKerrTable, kerrTableActive ? 1 : 0);
+    prepareEmissionTables(state);
+    // 盘参数、相机和黑洞系的变换只取决于帧参数，CPU 算一次，不必每个像素在 SetupFrame 里重算
+    uploadFrameParams(frameParams(traceParams(state, imageWidth, imageHeight), kerrTableActive ? blackHoleSpin : 0.0f));
+    // 全景等其他通道不用缓存，render() 再按需改写
+    circle->setUniformValue(loc.geodesicCacheMode, 0);
+}
+
+const BlackHoleRenderer::CircleUniformLocations& BlackHoleRenderer::circleUniformLocations(QOpenGLShaderProgram* circle) {
+    QHash<QOpenGLShaderProgram*, CircleUniformLocations>::const_iterator found = circleLocations.constFind(circle);
+    if (found != circleLocations.constEnd()) {
+        return found.value();
+    }
+    CircleUniformLocations loc;
+    loc.circleColor = circle->uniformLocation("circleColor");
+    loc.iResolution = circle->uniformLocation("iResolution");
+    loc.iTileOffset = circle->uniformLocation("iTileOffset");
+    loc.offset = circle->uniformLocation("offset");
+    loc.radius = circle->uniformLocation("radius");
+    loc.backgroundType = circle->uniformLocation("backgroundType");
+    loc.iFrame = circle->uniformLocation("iFrame");
+    loc.iMouse = circle->uniformLocation("iMouse");
+    loc.iTime = circle->uniformLocation("iTime");
+    loc.iChannelResolution = circle->uniformLocation("iChannelResolution");
+    loc.iTimeDelta = circle->uniformLocation("iTimeDelta");
+    loc.iFov = circle->uniformLocation("iFov");
+    loc.iCameraBasis = circle->uniformLocation("iCameraBasis");
+    loc.useDeflectionTable = circle->uniformLocation("useDeflectionTable");
+    loc.deflectionTableRange = circle->uniformLocation("deflectionTableRange");
+    loc.geodesicIntegrator = circle->uniformLocation("geodesicIntegrator");
+    loc.geodesicTolerance = circle->uniformLocation("geodesicTolerance");
+    loc.maxGeodesicSteps = circle->uniformLocation("maxGeodesicSteps");
+    loc.useKerrTable = circle->uniformLocation("useKerrTable");
+    loc.geodesicCacheMode = circle->uniformLocation("geodesicCacheMode");
+    loc.geodesicCacheWidth = circle->uniformLocation("geodesicCacheWidth");
+    loc.geodesicCacheCapacity = circle->uniformLocation("geodesicCacheCapacity");
+    loc.wavefrontWidth = circle->uniformLocation("wavefrontWidth");
+    loc.wavefrontHeight = circle->uniformLocation("wavefrontHeight");
+    loc.wavefrontSteps = circle->uniformLocation("wavefrontSteps");
+    loc.wavefrontQueue = circle->uniformLocation("wavefrontQueue");
+    loc.useSky = circle->uniformLocation("useSky");
+    // 采样器的纹理单元固定（见 bindCircleTextures，3 为上一帧，4~6 为透镜映射和天空），查位置时设一次即可
+    circle->setUniformValue("iChannel1", 1);
+    circle->setUniformValue("deflectionTable", 2);
+    circle->setUniformValue("iChannel3", 3);
+    circle->setUniformValue("lensingDisk", 4);
+    circle->setUniformValue("lensingEscape", 5);
+    circle->setUniformValue("skyTexture", 6);
+    circle->setUniformValue("kerrTransfer", 7);
+    circle->setUniformValue("diskNoise", 8);
+    circle->setUniformValue("emissionTables", 9);
+    circle->setUniformValue("blueNoise", 10);
+    return circleLocations.insert(circle, loc).value();
+}
+
+// 后处理通道的采样器单元固定：iChannel0（screenTexture）为 0，bloom金字塔各级为 1 .. kBloomLevels
+BlackHoleRenderer::PassUniformLocations BlackHoleRenderer::passUniformLocations(QOpenGLShaderProgram* pass) {
+    PassUniformLocations loc;
+    if (!pass->isLinked()) {
+        return loc;
+    }
+    pass->bind();
+    pass->setUniformValue("iChannel0", 0);
+    pass->setUniformValue("screenTexture", 0);
+    GLint bloomUnits[kBloomLevels];
+    for (int level = 0; level < kBloomLevels; ++level) {
+        bloomUnits[level] = 1 + level;
+    }
+    pass->setUniformValueArray("bloomLevels", bloomUnits, kBloomLevels);
+    loc.iResolution = pass->uniformLocation("iResolution");
+    loc.bloomEnabled = pass->uniformLocation("bloomEnabled");
+    pass->release();
+    return loc;
+}
+
+// 每帧常量写入 BlackHoleFrameBlock 的 uniform 缓冲；同一帧的多个通道参数相同，不重复上传
+void BlackHoleRenderer::uploadFrameParams(const BlackHoleFrameParams& frame) {
+    if (!frameBuffer) {
+        glGenBuffers(1, &frameBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(BlackHoleFrameParams), &frame, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        frameUploaded = frame;
+    } else if (std::memcmp(&frame, &frameUploaded, sizeof(BlackHoleFrameParams)) != 0) {
+        glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(BlackHoleFrameParams), &frame);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        frameUploaded = frame;
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, kFrameBlockBinding, frameBuffer);
+}
+
+void BlackHoleRenderer::bindCircleTextures() {
+    // 采样器 uniform 已在 circleUniformLocations 中设好；类型不同的采样器即使没有纹理也不能与单元0的 sampler2D 共用
+    if (chessTexture) {
+        glActiveTexture(GL_TEXTURE1);
+        chessTexture->bind();
+    }
+    if (deflectionTexture) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, deflectionTexture);
+    }
+    if (kerrTexture) {
+        glActiveTexture(GL_TEXTURE7);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, kerrTexture);
+    }
+    if (noiseTexture) {
+        glActiveTexture(GL_TEXTURE8);
+        glBindTexture(GL_TEXTURE_3D, noiseTexture);
+    }
+    if (emissionTexture) {
+        glActiveTexture(GL_TEXTURE9);
+        glBindTexture(GL_TEXTURE_2D, emissionTexture);
+    }
+    if (blueNoiseTexture) {
+        glActiveTexture(GL_TEXTURE10);
+        glBindTexture(GL_TEXTURE_2D, blueNoiseTexture);
+    }
+}
+
+// 盘参数（黑洞质量，有 Kerr 表时还有自旋）变化时重建发射查找表，须在 kerrTableActive 确定之后调用
+void BlackHoleRenderer::prepareEmissionTables(const BlackHoleFrameState& state) {
+    const DiskParameters disk = diskParameters(state.blackHoleMass, kerrTableActive ? blackHoleSpin : 0.0f);
+    if (emissionTexture && EmissionTables::sameTables(disk, emissionDisk)) {
+        return;
+    }
+    const EmissionTables tables(disk);
+    if (!emissionTexture) {
+        glGenTextures(1, &emissionTexture);
+        glBindTexture(GL_TEXTURE_2D, emissionTexture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, tables.width(), tables.height());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, emissionTexture);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tables.width(), tables.height(), GL_RGBA, GL_FLOAT, tables.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    emissionDisk = disk;
+}
+
+// 按本帧相机位置取 Kerr 转移表并在需要时上传，返回 circle 通道是否查表
+bool BlackHoleRenderer::prepareKerrTable(const BlackHoleFrameState& state, int w, int h) {
+    if (blackHoleSpin == 0.0f) {
+        return false;
+    }
+    // 表的键是相机在黑洞系中的位置（与 SetupFrame 相同的每帧常量），BL 坐标的自旋轴即盘法向
+    const KernelConstants k = BlackHoleKernel(traceParams(state, w, h)).constants();
+    const glsl::vec3 camera = -k.blackHolePos;
+    const float distance = glsl::length(camera);
+    const float height = glsl::dot(camera, k.diskY);
+    const KerrTableKey key = KerrTableKey::quantized(blackHoleSpin, distance / k.rs,
+                                                     std::acos(std::max(-1.0f, std::min(1.0f, height / distance))));
+    // 表与相机位置的半径对数差、倾角差（弧度）不超过 tolerance 时可用
+    const auto acceptable = [&key](const std::shared_ptr<const KerrTransferTable>& table, float tolerance) {
+        return table && table->key().spin == key.spin &&
+               std::fabs(std::log(table->key().radius / key.radius)) <= tolerance &&
+               std::fabs(table->key().inclination - key.inclination) <= tolerance;
+    };
+
+    // 交互时相机连续移动，每 0.25 度都生成一张新表会不停占用后台线程并写满磁盘缓存：
+    // 已上传的表离得足够近时直接沿用，离远了再请求，离线渲染总是等精确的表
+    std::shared_ptr<const KerrTransferTable> table = kerrUploaded;
+    if (kerrTableWait || !acceptable(table, 0.5f * kKerrTableTolerance)) {
+        table = kerrTables.request(key, kerrTableWait);
+    }
+    // 相机绕自旋轴转动不需要新表；半径、倾角变化时后台生成新表，期间沿用相差不大的旧表，否则按 Schwarzschild 渲染
+    if (!acceptable(table, kKerrTableTolerance)) {
+        return false;
+    }
+    if (table != kerrUploaded) {
+        if (!kerrTexture) {
+            glGenTextures(1, &kerrTexture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, kerrTexture);
+            glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA32F, table->width(), table->height(), KerrTransferTable::kLayers);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            // chi 方向循环，psi 方向到两极为止
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        } else {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, kerrTexture);
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, table->width(), table->height(), KerrTransferTable::kLayers,
+                        GL_RGBA, GL_FLOAT, table->data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        kerrUploaded = table;
+    }
+    return true;
+}
+
+void BlackHoleRenderer::render(const BlackHoleFrameState& state, GLuint targetFbo) {
+    if (viewWidth <= 0 || viewHeight <= 0) {
+        return;
+    }
+    ShaderPermutation features = permutation(state.backgroundType);
+    features.stepStatistics = stepStatisticsOn;
+    QOpenGLShaderProgram* program = circleVariant(CircleProgram::Fragment, features);
+    if (!program->isLinked()) {
+        return;
+    }
+    if (!fbo) {
+        createTargets();
+    }
+    glViewport(0, 0, viewWidth, viewHeight);
+
+    if (!wavefrontEnabled && wavefrontBuffers[0]) {
+        releaseWavefrontBuffers();
+    }
+
+    // 第一步：渲染到帧缓冲
+    fbo->bind();
+    // 波前路径由计算着色器直接写入fbo的纹理，不可用或统计步数时走片元路径
+    if (!wavefrontEnabled || stepStatisticsOn || !renderWavefront(state)) {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        program->bind();
+        vao.bind();
+
+        setCircleUniforms(program, state, viewWidth, viewHeight);
+        bindCircleTextures();
+        const int cacheMode = geodesicCacheMode(state);
+        if (cacheMode != 0) {
+            for (GLuint binding = 0; binding < 4; ++binding) {
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, cacheBuffers[binding]);
+            }
+            const CircleUniformLocations& loc = circleUniformLocations(program);
+            program->setUniformValue(loc.geodesicCacheMode, cacheMode);
+            program->setUniformValue(loc.geodesicCacheWidth, viewWidth);
+            program->setUniformValue(loc.geodesicCacheCapacity, cacheCapacity);
+        }
+
+        // Bind previous frame texture
+        if (prevFrameTexture && state.iFrame > 0) {
+            glActiveTexture(GL_TEXTURE3);
+            prevFrameTexture->bind();
+        }
+
+        if (stepStatisticsOn) {
+            beginStepStatistics();
+        }
+
+        // Draw fullscreen quad
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        if (cacheMode == 1) {
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        }
+        if (stepStatisticsOn) {
+            endStepStatistics(state);
+        }
+
+        vao.release();
+        program->release();
+    }
+    // Copy current frame to previous frame texture
+    if (prevFrameTexture) {
+        glBindTexture(GL_TEXTURE_2D, prevFrameTexture->textureId());
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, viewWidth, viewHeight);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    // 保存原始渲染纹理
+    GLuint originalTexture = fbo->texture();
+    fbo->release();
+    renderPost(originalTexture, targetFbo);
+}
+
+void BlackHoleRenderer::renderPost(GLuint originalTexture, GLuint targetFbo) {
+    // 初始化处理后的纹理为原始纹理
+    GLuint processedTexture = originalTexture;
+
+    // 应用 mipmap 效果：逐级减半，每级只读上一级
+    GLuint bloomTextures[kBloomLevels] = {};
+    if (showMipmap) {
+        for (int level = 0; level < kBloomLevels; ++level) {
+            const GLuint source = level == 0 ? originalTexture : bloomLevels[level - 1]->texture();
+            drawPass(mipmapProgram, mipmapLocations, source, bloomLevels[level]);
+            bloomTextures[level] = bloomLevels[level]->texture();
+        }
+        // 两个模糊在每一级的两个目标之间来回
+        for (int level = 0; level < kBloomLevels; ++level) {
+            // 应用水平模糊
+            if (horizontal) {
+                drawPass(horizontalProgram, horizontalLocations, bloomTextures[level], bloomScratch[level]);
+                bloomTextures[level] = bloomScratch[level]->texture();
+            }
+            // 应用垂直模糊
+            if (vertical) {
+                QOpenGLFramebufferObject* target = horizontal ? bloomLevels[level] : bloomScratch[level];
+                drawPass(verticalProgram, verticalLocations, bloomTextures[level], target);
+                bloomTextures[level] = target->texture();
+            }
+        }
+        processedTexture = bloomTextures[0];
+    }
+
+    // Step 3: Render to target
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFbo);
+    glViewport(0, 0, viewWidth, viewHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (result) {
+        // 使用resultProgram（screen_result.frag）
+        resultProgram->bind();
+        vao.bind();
+
+        // 绑定原始纹理到iChannel0
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, originalTexture);
+
+        // bloom金字塔各级绑定到纹理单元 1 .. kBloomLevels
+        for (int level = 0; level < kBloomLevels; ++level) {
+            glActiveTexture(GL_TEXTURE1 + level);
+            glBindTexture(GL_TEXTURE_2D, bloomTextures[level]);
+        }
+        resultProgram->setUniformValue(resultLocations.bloomEnabled, showMipmap);
+
+        // 设置分辨率uniform
+        resultProgram->setUniformValue(resultLocations.iResolution, QVector2D(viewWidth, viewHeight));
+
+        // 绘制全屏四边形
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glActiveTexture(GL_TEXTURE0);
+
+        vao.release();
+        resultProgram->release();
+    } else {
+        // 使用原来的screenProgram
+        screenProgram->bind();
+        vao.bind();
+
+        // 绑定要渲染的纹理（可能是原始纹理或处理后的纹理）
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, processedTexture);
+
+        // 绘制全屏四边形
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        vao.release();
+        screenProgram->release();
+    }
+}
+
+void BlackHoleRenderer::applySettings(const RendererSettings& settings) {
+    setBlackHoleSpin(settings.spin);
+    setGeodesicIntegrator(settings.integrator);
+    setGeodesicTolerance(settings.tolerance);
+    setMaxGeodesicSteps(settings.maxSteps);
+    setDebugView(settings.debugView);
+    setDiskEnabled(settings.disk);
+    setDiskNoiseQuality(settings.noise);
+    setWavefrontEnabled(settings.wavefront);
+    setDeflectionTableEnabled(settings.deflectionTable);
+    setGeodesicCacheEnabled(settings.geodesicCache);
+}
+
+void BlackHoleRenderer::setGeodesicCacheEnabled(bool enabled) {
+    geodesicCacheEnabled = enabled;
+    cacheValid = false;
+}
+
+void BlackHoleRenderer::setGeodesicIntegrator(GeodesicIntegrator value) {
+    integrator = value;
+    cacheValid = false;
+}
+
+void BlackHoleRenderer::setGeodesicTolerance(float value) {
+    geodesicTolerance = value;
+    cacheValid = false;
+}
+
+void BlackHoleRenderer::setMaxGeodesicSteps(int value) {
+    maxGeodesicSteps = std::max(kMinGeodesicSteps, std::min(value, kMaxGeodesicStepsLimit));
+    cacheValid = false;
+}
+
+void BlackHoleRenderer::createGeodesicCache(GLuint sampleCapacity) {
+    releaseGeodesicCache();
+    const GLsizeiptr pixels = GLsizeiptr(viewWidth) * viewHeight;
+    const GLsizeiptr sizes[4] = {
+        pixels * 8 * GLsizeiptr(sizeof(GLuint)),        // CachedPixel：uvec4 + vec4
+        GLsizeiptr(sampleCapacity) * 4 * GLsizeiptr(sizeof(GLfloat)),
+        GLsizeiptr(sampleCapacity) * GLsizeiptr(sizeof(GLuint)),
+        GLsizeiptr(sizeof(GLuint)),
+    };
+    glGenBuffers(4, cacheBuffers);
+    for (int i = 0; i < 4; ++i) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, cacheBuffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizes[i], nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    cacheCapacity = sampleCapacity;
+}
+
+void BlackHoleRenderer::releaseGeodesicCache() {
+    if (cacheBuffers[0]) {
+        glDeleteBuffers(4, cacheBuffers);
+        for (GLuint& buffer : cacheBuffers) {
+            buffer = 0;
+        }
+    }
+    cacheCapacity = 0;
+    cacheValid = false;
+    cacheReadback = false;
+}
+
+// 每帧清零计数器，视口尺寸变化时重建逐像素纹理；须在 circle 程序绑定之后、绘制之前调用
+void BlackHoleRenderer::beginStepStatistics() {
+    if (!stepCounterBuffer) {
+        glGenBuffers(1, &stepCounterBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, stepCounterBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(StepCounters), nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        for (StepReadback& readback : stepReadbacks) {
+            glGenBuffers(1, &readback.buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, readback.buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, sizeof(StepCounters), nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    if (stepTextureWidth != viewWidth || stepTextureHeight != viewHeight) {
+        if (stepTexture) {
+            glDeleteTextures(1, &stepTexture);
+        }
+        glGenTextures(1, &stepTexture);
+        glBindTexture(GL_TEXTURE_2D, stepTexture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, viewWidth, viewHeight);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        stepTextureWidth = viewWidth;
+        stepTextureHeight = viewHeight;
+    }
+    const StepCounters zero = {};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, stepCounterBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(StepCounters), &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kStepCounterBinding, stepCounterBuffer);
+    glBindImageTexture(kStepImageUnit, stepTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+}
+
+// 绘制之后把计数器复制到读回环的下一个缓冲并插入栅栏，已完成的旧帧顺便读回
+void BlackHoleRenderer::endStepStatistics(const BlackHoleFrameState& state) {
+    if (stepPending == kStepReadbackCount) {
+        // 环已满：GPU 已落后三帧，等最旧的一帧是合理的
+        readStepStatistics(GL_TIMEOUT_IGNORED);
+    }
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT |
+                    GL_TEXTURE_UPDATE_BARRIER_BIT);
+    StepReadback& readback = stepReadbacks[stepWriteIndex];
+    glBindBuffer(GL_COPY_READ_BUFFER, stepCounterBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readback.buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(StepCounters));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.frame = state.iFrame;
+    readback.width = viewWidth;
+    readback.height = viewHeight;
+    stepWriteIndex = (stepWriteIndex + 1) % kStepReadbackCount;
+    stepPending++;
+    while (stepPending > 1 && readStepStatistics(0)) {
+    }
+}
+
+// 按提交顺序读回最旧的一帧，栅栏在 timeout 内未完成时返回false
+bool BlackHoleRenderer::readStepStatistics(GLuint64 timeout) {
+    StepReadback& readback = stepReadbacks[stepReadIndex];
+    const GLenum status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    StepCounters counters;
+    glBindBuffer(GL_COPY_READ_BUFFER, readback.buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(StepCounters), &counters);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    stepLatest.frame = readback.frame;
+    stepLatest.width = readback.width;
+    stepLatest.height = readback.height;
+    stepLatest.steps = quint64(counters.stepsHigh) << 32 | counters.stepsLow;
+    stepLatest.diskCalls = quint64(counters.diskCallsHigh) << 32 | counters.diskCallsLow;
+    stepLatest.maxSteps = counters.stepsMax;
+    stepLatest.escaped = counters.escaped;
+    stepLatest.captured = counters.captured;
+    stepLatest.exhausted = counters.exhausted;
+
+    stepReadIndex = (stepReadIndex + 1) % kStepReadbackCount;
+    stepPending--;
+    return true;
+}
+
+StepStatistics BlackHoleRenderer::stepStatistics(bool wait) {
+    while (stepPending > 0 && readStepStatistics(wait ? GL_TIMEOUT_IGNORED : 0)) {
+    }
+    return stepLatest;
+}
+
+void BlackHoleRenderer::releaseStepStatistics() {
+    for (StepReadback& readback : stepReadbacks) {
+        if (readback.fence) {
+            glDeleteSync(readback.fence);
+            readback.fence = nullptr;
+        }
+        if (readback.buffer) {
+            glDeleteBuffers(1, &readback.buffer);
+            readback.buffer = 0;
+        }
+    }
+    if (stepCounterBuffer) {
+        glDeleteBuffers(1, &stepCounterBuffer);
+        stepCounterBuffer = 0;
+    }
+    if (stepTexture) {
+        glDeleteTextures(1, &stepTexture);
+        stepTexture = 0;
+    }
+    stepTextureWidth = 0;
+    stepTextureHeight = 0;
+    stepWriteIndex = 0;
+    stepReadIndex = 0;
+    stepPending = 0;
+}
+
+int BlackHoleRenderer::geodesicCacheMode(const BlackHoleFrameState& state) {
+    // 查 Kerr 表的帧没有raymarching，不需要缓存；缓存的样本只用于重算吸积盘，不着色吸积盘、看调试视图或统计步数时不用
+    if (!geodesicCacheEnabled || kerrTableActive || !diskEnabled || debugView != DebugView::None || stepStatisticsOn) {
+        return 0;
+    }
+    // 分块渲染每次调用的视口偏移都不同，缓存永远不会复用，只会多付记录的开销
+    if (!state.tileOffset.isNull() || (!state.imageSize.isEmpty() && state.imageSize != QSize(viewWidth, viewHeight))) {
+        return 0;
+    }
+    if (!cacheBuffers[0]) {
+        // 初始容量：平均每像素两个盘内样本
+        createGeodesicCache(GLuint(viewWidth) * GLuint(viewHeight) * 2);
+    }
+    // 光线路径只由这些量决定；iFrame < 2 时着色器用固定的初始相机，这样的帧不算静止
+    const bool still = cacheValid && state.iFrame >= 2 && cacheKey.iFrame >= 2 && cacheKey.iMouse == state.iMouse &&
+                       cacheKey.blackHoleMass == state.blackHoleMass && cacheKey.diskNormal == state.diskNormal &&
+                       cacheKey.cameraRadius == state.cameraRadius && cacheKey.fov == state.fov &&
+                       cacheKey.imageSize == state.imageSize && cacheTableEnabled == deflectionTableEnabled && cacheSpin == blackHoleSpin;
+    if (!still) {
+        cacheStillFrames = 0;
+        cacheRecorded = false;
+    }
+    cacheKey = state;
+    cacheTableEnabled = deflectionTableEnabled;
+    cacheSpin = blackHoleSpin;
+    cacheValid = true;
+    // 相机移动时每帧完整追踪比记录便宜；静止后 TAA 历史还在积累时也完整追踪，每帧换抖动
+    if (!still || ++cacheStillFrames < kCacheHistoryFrames) {
+        return 0;
+    }
+    bool replay = cacheRecorded && (cacheStillFrames - kCacheHistoryFrames) % kCacheRetraceInterval != 0;
+    if (replay && cacheReadback) {
+        // 第一次复用前检查分配的样本数：超过容量的像素只能每帧完整追踪，扩容后重建一次
+        // （同一相机位置只查一次，避免每次重新记录都同步）
+        cacheReadback = false;
+        GLuint used = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, cacheBuffers[3]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &used);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        if (used > cacheCapacity) {
+            createGeodesicCache(used + used / 4);
+            cacheValid = true;
+            cacheRecorded = false;
+            replay = false;
+        }
+    }
+    if (replay) {
+        return 2;
+    }
+    const GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cacheBuffers[3]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    cacheReadback = !cacheRecorded;
+    cacheRecorded = true;
+    return 1;
+}
+
+void BlackHoleRenderer::createWavefrontBuffers(GLuint rayCount, bool geodesics) {
+    releaseWavefrontBuffers();
+    const GLsizeiptr rays = rayCount;
+    const GLsizeiptr groups = (rays + kWavefrontGroupSize - 1) / kWavefrontGroupSize;
+    const GLsizeiptr sizes[8] = {
+        rays * 12 * GLsizeiptr(sizeof(GLfloat)),                  // WavefrontRay：3个vec4
+        (geodesics ? rays : 1) * 12 * GLsizeiptr(sizeof(GLfloat)), // WavefrontGeodesic，手调步长表不用
+        rays * GLsizeiptr(sizeof(GLuint)),
+        rays * GLsizeiptr(sizeof(GLuint)),
+        rays * GLsizeiptr(sizeof(GLuint)),
+        rays * 2 * GLsizeiptr(sizeof(GLuint)),
+        groups * GLsizeiptr(sizeof(GLuint)),
+        2 * kWavefrontHeaderSize,
+    };
+    glGenBuffers(8, wavefrontBuffers);
+    for (int i = 0; i < 8; ++i) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, wavefrontBuffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizes[i], nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    wavefrontRayCount = rayCount;
+    wavefrontGeodesics = geodesics;
+}
+
+void BlackHoleRenderer::releaseWavefrontBuffers() {
+    if (wavefrontBuffers[0]) {
+        glDeleteBuffers(8, wavefrontBuffers);
+        for (GLuint& buffer : wavefrontBuffers) {
+            buffer = 0;
+        }
+    }
+    wavefrontRayCount = 0;
+}
+
+// 压缩 queue 中的存活光线，写入另一个队列并交换两个队列的绑定点，返回新的输入队列
+int BlackHoleRenderer::compactWavefrontQueue(int queue) {
+    const GLintptr groups = queue * kWavefrontHeaderSize + sizeof(GLuint);
+    wavefrontScanProgram->bind();
+    wavefrontScanProgram->setUniformValue(wavefrontQueueLocations[0], queue);
+    glDispatchComputeIndirect(groups);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    wavefrontScanGroupsProgram->bind();
+    wavefrontScanGroupsProgram->setUniformValue(wavefrontQueueLocations[1], queue);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    wavefrontScatterProgram->bind();
+    wavefrontScatterProgram->setUniformValue(wavefrontQueueLocations[2], queue);
+    glDispatchComputeIndirect(groups);
+    // 下一个队列的光线数和dispatch参数由着色器写入，供间接dispatch和回读使用
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    const int next = 1 - queue;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, wavefrontBuffers[3 + next]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, wavefrontBuffers[3 + queue]);
+    return next;
+}
+
+bool BlackHoleRenderer::renderWavefront(const BlackHoleFrameState& state) {
+    const ShaderPermutation variant = permutation(state.backgroundType);
+    QOpenGLShaderProgram* wavefrontInitProgram = circleVariant(CircleProgram::WavefrontInit, variant);
+    QOpenGLShaderProgram* wavefrontMarchProgram = circleVariant(CircleProgram::WavefrontMarch, variant);
+    QOpenGLShaderProgram* wavefrontShadeProgram = circleVariant(CircleProgram::WavefrontShade, variant);
+    if (!wavefrontScanProgram) {
+        wavefrontScanProgram = createComputeProgram("wavefront_scan.comp", "Wavefront scan");
+        wavefrontScanGroupsProgram = createComputeProgram("wavefront_scangroups.comp", "Wavefront scan groups");
+        wavefrontScatterProgram = createComputeProgram("wavefront_scatter.comp", "Wavefront scatter");
+        wavefrontQueueLocations[0] = wavefrontScanProgram->uniformLocation("wavefrontQueue");
+        wavefrontQueueLocations[1] = wavefrontScanGroupsProgram->uniformLocation("wavefrontQueue");
+        wavefrontQueueLocations[2] = wavefrontScatterProgram->uniformLocation("wavefrontQueue");
+    }
+    if (!wavefrontInitProgram->isLinked() || !wavefrontMarchProgram->isLinked() || !wavefrontScanProgram->isLinked() ||
+        !wavefrontScanGroupsProgram->isLinked() || !wavefrontScatterProgram->isLinked() ||
+        !wavefrontShadeProgram->isLinked()) {
+        return false;
+    }
+    const GLuint rayCount = GLuint(viewWidth) * GLuint(viewHeight);
+    const GLuint groups = (rayCount + kWavefrontGroupSize - 1) / kWavefrontGroupSize;
+    const bool adaptive = integrator == GeodesicIntegrator::Adaptive;
+    if (rayCount != wavefrontRayCount || adaptive != wavefrontGeodesics) {
+        createWavefrontBuffers(rayCount, adaptive);
+    }
+
+    // 队列0是全部像素，队列1为空；工作组数超出一行的上限（8K图像）时按行排成二维
+    const GLuint headers[8] = {rayCount, std::min(groups, kWavefrontGroupRow),
+                               (groups + kWavefrontGroupRow - 1) / kWavefrontGroupRow, 1, 0, 0, 1, 1};
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, wavefrontBuffers[7]);
+    glBufferSubData(GL_DISPATCH_INDIRECT_BUFFER, 0, sizeof(headers), headers);
+    for (GLuint binding = 0; binding < 8; ++binding) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, wavefrontBuffers[binding]);
+    }
+
+    QOpenGLShaderProgram* rayPasses[3] = {wavefrontInitProgram, wavefrontMarchProgram, wavefrontShadeProgram};
+    for (QOpenGLShaderProgram* pass : rayPasses) {
+        pass->bind();
+        setCircleUniforms(pass, state, viewWidth, viewHeight);
+        bindCircleTextures();
+        const CircleUniformLocations& loc = circleUniformLocations(pass);
+        pass->setUniformValue(loc.wavefrontWidth, viewWidth);
+        pass->setUniformValue(loc.wavefrontHeight, viewHeight);
+        pass->setUniformValue(loc.wavefrontSteps, wavefrontSteps);
+        if (prevFrameTexture && state.iFrame > 0) {
+            glActiveTexture(GL_TEXTURE3);
+            prevFrameTexture->bind();
+        }
+    }
+    const int marchQueueLocation = circleUniformLocations(wavefrontMarchProgram).wavefrontQueue;
+    const int tilesX = (viewWidth + kWavefrontTile - 1) / kWavefrontTile;
+    const int tilesY = (viewHeight + kWavefrontTile - 1) / kWavefrontTile;
+
+    // 初始光线：查表命中的光线直接得到颜色，不进入队列
+    wavefrontInitProgram->bind();
+    glDispatchCompute(tilesX, tilesY, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    int queue = compactWavefrontQueue(0);
+
+    // 每条光线最多 maxGeodesicSteps 步，多一次让用完步数的光线完成终止判断
+    const int maxDispatches = (maxGeodesicSteps + wavefrontSteps - 1) / wavefrontSteps + 1;
+    for (int dispatch = 0; dispatch < maxDispatches; ++dispatch) {
+        wavefrontMarchProgram->bind();
+        wavefrontMarchProgram->setUniformValue(marchQueueLocation, queue);
+        glDispatchComputeIndirect(queue * kWavefrontHeaderSize + sizeof(GLuint));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        queue = compactWavefrontQueue(queue);
+        if ((dispatch + 1) % kWavefrontCheckInterval == 0) {
+            // 空队列的dispatch几乎不花时间，只隔几次回读一次，减少同步
+            GLuint live = 0;
+            glGetBufferSubData(GL_DISPATCH_INDIRECT_BUFFER, queue * kWavefrontHeaderSize, sizeof(GLuint), &live);
+            if (live == 0) {
+                break;
+            }
+        }
+    }
+
+    // 逐像素bloom逆处理和TAA，写入fbo的RGBA8纹理
+    wavefrontShadeProgram->bind();
+    glBindImageTexture(0, fbo->texture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    glDispatchCompute(tilesX, tilesY, 1);
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    wavefrontShadeProgram->release();
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    return true;
+}
+
+bool BlackHoleRenderer::exportLensingMap(const BlackHoleFrameState& state, float* disk, float* escape) {
+    if (viewWidth <= 0 || viewHeight <= 0) {
+        return false;
+    }
+    QOpenGLShaderProgram* program = circleVariant(CircleProgram::Fragment, permutation(state.backgroundType));
+    if (!program->isLinked()) {
+        return false;
+    }
+    if (!fbo) {
+        createTargets();
+    }
+    // circle.frag 的 location 1、2 只在导出时挂接附件，平时的写入被丢弃
+    GLuint planes[2];
+    glGenTextures(2, planes);
+    for (GLuint plane : planes) {
+        glBindTexture(GL_TEXTURE_2D, plane);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, viewWidth, viewHeight);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    GLuint exportFbo = 0;
+    glGenFramebuffers(1, &exportFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, exportFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fbo->texture(), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, planes[0], 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, planes[1], 0);
+    const GLenum drawBuffers[3] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+    glDrawBuffers(3, drawBuffers);
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        glViewport(0, 0, viewWidth, viewHeight);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        program->bind();
+        vao.bind();
+        setCircleUniforms(program, state, viewWidth, viewHeight);
+        bindCircleTextures();
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        vao.release();
+        program->release();
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadBuffer(GL_COLOR_ATTACHMENT1);
+        glReadPixels(0, 0, viewWidth, viewHeight, GL_RGBA, GL_FLOAT, disk);
+        glReadBuffer(GL_COLOR_ATTACHMENT2);
+        glReadPixels(0, 0, viewWidth, viewHeight, GL_RGBA, GL_FLOAT, escape);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+    } else {
+        qDebug() << "Lensing map framebuffer incomplete";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &exportFbo);
+    glDeleteTextures(2, planes);
+    return complete;
+}
+
+bool BlackHoleRenderer::loadLensingMap(const LensingMapFile& map) {
+    if (!map.isOpen() || map.width() != viewWidth || map.height() != viewHeight) {
+        qDebug() << "Lensing map size" << map.width() << "x" << map.height()
+                 << "does not match viewport" << viewWidth << "x" << viewHeight;
+        return false;
+    }
+    releaseLensingMap();
+    glGenTextures(2, lensingTextures);
+    for (int i = 0; i < 2; ++i) {
+        glBindTexture(GL_TEXTURE_2D, lensingTextures[i]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, viewWidth, viewHeight);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewWidth, viewHeight, GL_RGBA, GL_FLOAT, map.plane(i));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    lensingState = map.frameState();
+    return true;
+}
+
+void BlackHoleRenderer::releaseLensingMap() {
+    if (lensingTextures[0]) {
+        glDeleteTextures(2, lensingTextures);
+        lensingTextures[0] = lensingTextures[1] = 0;
+    }
+}
+
+void BlackHoleRenderer::setLensingSky(const QImage& sky) {
+    delete skyTexture;
+    skyTexture = nullptr;
+    if (sky.isNull()) {
+        return;
+    }
+    // 图像第一行为北极，翻转后 v = 1 对应纬度 +90°；不生成mipmap：经度在接缝处跳变，按导数选的mip层会在接缝上留下一条线
+    skyTexture = new QOpenGLTexture(sky.mirrored(), QOpenGLTexture::DontGenerateMipMaps);
+    skyTexture->setMinificationFilter(QOpenGLTexture::Linear);
+    skyTexture->setMagnificationFilter(QOpenGLTexture::Linear);
+    skyTexture->setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::Repeat);
+    skyTexture->setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
+}
+
+void BlackHoleRenderer::renderLensingMap(int backgroundType, GLuint targetFbo) {
+    if (viewWidth <= 0 || viewHeight <= 0 || !lensingTextures[0]) {
+        return;
+    }
+    QOpenGLShaderProgram* relensProgram = circleVariant(CircleProgram::Relens, permutation(backgroundType));
+    if (!relensProgram->isLinked()) {
+        return;
+    }
+    if (!fbo) {
+        createTargets();
+    }
+    glViewport(0, 0, viewWidth, viewHeight);
+
+    // 第一步：查映射叠加背景，写入与circle通道相同的fbo
+    fbo->bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    relensProgram->bind();
+    vao.bind();
+    BlackHoleFrameState state = lensingState;
+    state.backgroundType = backgroundType;
+    setCircleUniforms(relensProgram, state, viewWidth, viewHeight);
+    bindCircleTextures();
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, lensingTextures[0]);
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, lensingTextures[1]);
+    relensProgram->setUniformValue(circleUniformLocations(relensProgram).useSky, skyTexture ? 1 : 0);
+    if (skyTexture) {
+        glActiveTexture(GL_TEXTURE6);
+        skyTexture->bind();
+    }
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glActiveTexture(GL_TEXTURE0);
+    vao.release();
+    relensProgram->release();
+    fbo->release();
+
+    // 第二步：与正常渲染相同的bloom和色调映射
+    renderPost(fbo->texture(), targetFbo);
+}
+
+void BlackHoleRenderer::createCubeTarget(int faceSize) {
+    releaseCubeTarget();
+    glGenTextures(1, &cubeTexture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeTexture);
+    // 与针孔模式的fbo相同的RGBA8，bloom输入保持一致
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGBA8, faceSize, faceSize);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    // 整个立方体贴图作为分层附件，几何着色器用gl_Layer选择面
+    glGenFramebuffers(1, &cubeFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, cubeFbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, cubeTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        qDebug() << "Layered cubemap framebuffer incomplete";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    cubeFaceSize = faceSize;
+}
+
+void BlackHoleRenderer::releaseCubeTarget() {
+    if (cubeFbo) {
+        glDeleteFramebuffers(1, &cubeFbo);
+        cubeFbo = 0;
+    }
+    if (cubeTexture) {
+        glDeleteTextures(1, &cubeTexture);
+        cubeTexture = 0;
+    }
+    cubeFaceSize = 0;
+}
+
+void BlackHoleRenderer::renderEquirect(const BlackHoleFrameState& state, int faceSize, GLuint targetFbo) {
+    if (viewWidth <= 0 || viewHeight <= 0 || faceSize <= 0) {
+        return;
+    }
+    // 全景不做TAA
+    ShaderPermutation variant = permutation(state.backgroundType);
+    variant.temporalBlend = false;
+    QOpenGLShaderProgram* cubeProgram = circleVariant(CircleProgram::Cubemap, variant);
+    if (!equirectProgram) {
+        equirectProgram = createProgram("screen.vert", "equirect.frag", "Equirect");
+        equirectLocations = passUniformLocations(equirectProgram);
+    }
+    if (!cubeProgram->isLinked() || !equirectProgram->isLinked()) {
+        return;
+    }
+    if (!fbo) {
+        createTargets();
+    }
+    if (faceSize != cubeFaceSize) {
+        createCubeTarget(faceSize);
+    }
+
+    // 各面的视线基（列为 s轴、t轴、-主轴），与OpenGL立方体贴图的面坐标约定一致，
+    // 面上 (u, v) 的光线方向 = 主轴 + (2u-1) * s轴 + (2v-1) * t轴（相机系，-Z为正前方）
+    static const float faceBasis[6][9] = {
+        { 0, 0, -1,   0, -1, 0,   -1, 0, 0 },   // +X（按行存储）
+        { 0, 0,  1,   0, -1, 0,    1, 0, 0 },   // -X
+        { 1, 0,  0,   0,  0, -1,   0, 1, 0 },   // +Y
+        { 1, 0,  0,   0,  0, 1,    0, -1, 0 },  // -Y
+        { 1, 0,  0,   0, -1, 0,    0, 0, -1 },  // +Z
+        { -1, 0, 0,   0, -1, 0,    0, 0, 1 },   // -Z
+    };
+    QMatrix3x3 basis[6];
+    for (int face = 0; face < 6; ++face) {
+        basis[face] = QMatrix3x3(faceBasis[face]);
+    }
+
+    // 第一步：一次绘制，几何着色器把全屏三角形实例化到六个图层
+    glBindFramebuffer(GL_FRAMEBUFFER, cubeFbo);
+    glViewport(0, 0, faceSize, faceSize);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    BlackHoleFrameState faceState = state;
+    faceState.iMouse = QVector4D(state.iMouse.x() * faceSize / viewWidth, state.iMouse.y() * faceSize / viewHeight,
+                                 1.0f, 0.0f);
+    faceState.fov = 1.0f;   // 90度视场
+    faceState.imageSize = QSize();
+    faceState.tileOffset = QPoint();
+
+    cubeProgram->bind();
+    vao.bind();
+    setCircleUniforms(cubeProgram, faceState, faceSize, faceSize);
+    cubeProgram->setUniformValueArray(circleUniformLocations(cubeProgram).iCameraBasis, basis, 6);
+    bindCircleTextures();
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    cubeProgram->release();
+
+    // 第二步：重采样为等距柱状投影，写入与针孔模式相同的fbo
+    fbo->bind();
+    glViewport(0, 0, viewWidth, viewHeight);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    equirectProgram->bind();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubeTexture);
+    equirectProgram->setUniformValue(equirectLocations.iResolution, QVector2D(viewWidth, viewHeight));
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    vao.release();
+    equirectProgram->release();
+    fbo->release();
+
+    // 第三步：bloom和色调映射只在全景图上做一次
+    renderPost(fbo->texture(), targetFbo);
+}
+
+void BlackHoleRenderer::setShowRenderResult(bool show) {
+    // 当需要显示渲染结果时，启用所有效果
+    if (show) {
+        result = show;
+        showMipmap = show;
+        horizontal = show;
+        vertical = show;
+    }
+}
+
+void BlackHoleRenderer::createChessTexture() {
+    const int size = 64;
+    QImage image(size, size, QImage::Format_RGBA8888);
+
+    QColor color1(220, 220, 220);
+    QColor color2(80, 80, 100);
+
+    const int tileSize = size / 8;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            int tileX = x / tileSize;
+            int tileY = y / tileSize;
+            image.setPixelColor(x, y, (tileX + tileY) % 2 == 0 ? color1 : color2);
+        }
+    }
+
+    chessTexture = new QOpenGLTexture(image);
+    chessTexture->setWrapMode(QOpenGLTexture::Repeat);
+    chessTexture->setMinificationFilter(QOpenGLTexture::Linear);
+    chessTexture->setMagnificationFilter(QOpenGLTexture::Linear);
+    chessTextureResolution = QVector3D(size, size, 0.0f);
+}
+
+void BlackHoleRenderer::createDeflectionTexture() {
+    // 表只与 r0 / Rs 和视线角有关，与黑洞质量、相机位置无关，初始化时生成一次
+    const DeflectionTable table;
+    glGenTextures(1, &deflectionTexture);
+    glBindTexture(GL_TEXTURE_2D, deflectionTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, table.width(), table.height());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, table.width(), table.height(), GL_RGBA, GL_FLOAT, table.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void BlackHoleRenderer::createNoiseTexture() {
+    // 格点值都是 1/1024 的整数倍，存成半精度无损；GL_REPEAT 让 DiskNoise 直接按周期平铺
+    const NoiseVolume volume;
+    glGenTextures(1, &noiseTexture);
+    glBindTexture(GL_TEXTURE_3D, noiseTexture);
+    glTexStorage3D(GL_TEXTURE_3D, 1, GL_R16F, volume.size(), volume.size(), volume.size());
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, volume.size(), volume.size(), volume.size(), GL_RED, GL_FLOAT,
+                    volume.data());
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void BlackHoleRenderer::createBlueNoiseTexture() {
+    // 整数纹理只能最近点采样，着色器按像素 texelFetch；排名要原样取出，不能归一化
+    const BlueNoiseTile& tile = BlueNoiseTile::instance();
+    glGenTextures(1, &blueNoiseTexture);
+    glBindTexture(GL_TEXTURE_2D, blueNoiseTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB16UI, tile.size(), tile.size());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tile.size(), tile.size(), GL_RGB_INTEGER, GL_UNSIGNED_SHORT, tile.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,396 @@
+#ifndef BLACKHOLERENDERER_H
+#define BLACKHOLERENDERER_H
+
+#include <QOpenGLFunctions_4_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLFramebufferObject>
+#include <QVector2D>
+#include <QVector3D>
+#include <QVector4D>
+#include <QGenericMatrix>
+#include <QByteArray>
+#include <QString>
+#include <QPoint>
+#include <QSize>
+#include <QImage>
+#include <QHash>
+#include <memory>
+#include "kerrtablecache.h"
+#include "../core/blackholekernel.h"
+#include "../core/frameparams.h"
+
+class LensingMapFile;
+
+// 单帧渲染所需的输入（Shadertoy风格的uniform）
+struct BlackHoleFrameState {
+    float iTime = 0.0f;
+    float iTimeDelta = 0.0f;
+    int iFrame = 0;
+    QVector4D iMouse;
+    float blackHoleMass = 1.49e7f;
+    QVector3D diskNormal{0.2f, 1.0f, 0.0f};   // 吸积盘世界法向
+    float cameraRadius = 0.000057f;           // 相机轨道半径（光年）
+    float fov = 0.5f;                         // 针孔相机视场（半宽与焦距之比）
+    int backgroundType = 1;
+    // 分块渲染：视口左下角在整幅图像中的像素偏移和整幅图像尺寸，imageSize为空时视口即整幅图像
+    QPoint tileOffset;
+    QSize imageSize;
+};
+
+// circle.frag 的测地线积分方式
+enum class GeodesicIntegrator {
+    Fixed = 0,      // 手调步长表（与CPU参考路径一致）
+    Adaptive = 1,   // Dormand–Prince 5(4)，每步误差不超过 geodesicTolerance
+};
+
+// 吸积盘噪声：Texture 查 diskNoise 体纹理，Analytic 逐格点 sin 哈希（对照画面和耗时用）
+enum class DiskNoiseQuality {
+    Analytic = 0,
+    Texture = 1,
+};
+
+// circle 通道的调试视图，代替最终颜色
+enum class DebugView {
+    None = 0,
+    EscapeDirection = 1,   // 逃逸光线的相机系方向
+    Termination = 2,       // 不透明、逃逸、落入视界
+    StepHeatMap = 3,       // 每像素测地线步数（相对 maxGeodesicSteps）
+};
+
+// circle 通道一帧的步数统计（BlackHoleRenderer::setStepStatisticsEnabled），由着色器的原子计数器累加后异步读回
+struct StepStatistics {
+    int frame = -1;            // 所属帧的 iFrame，-1 表示还没有读回的结果
+    int width = 0;             // 统计的视口尺寸
+    int height = 0;
+    quint64 steps = 0;         // 测地线步数之和（含被拒绝的自适应尝试）
+    quint64 diskCalls = 0;     // DiskColorAt 调用次数之和
+    quint32 maxSteps = 0;      // 单像素最大步数
+    quint32 escaped = 0;       // 逃逸到背景的光线
+    quint32 captured = 0;      // 落入视界、被盘挡住或步数用完的光线
+    quint32 exhausted = 0;     // 其中步数用完的光线，多了说明 maxGeodesicSteps 太小
+};
+
+// 影响画面的渲染器设置（BlackHoleRenderer::applySettings）；分布式渲染时随 RenderSetup 发给每个工作进程，
+// 各主机渲染的块用同一套设置
+struct RendererSettings {
+    float spin = 0.0f;
+    GeodesicIntegrator integrator = GeodesicIntegrator::Fixed;
+    float tolerance = 1e-5f;
+    int maxSteps = 1000;
+    DebugView debugView = DebugView::None;
+    bool disk = true;
+    DiskNoiseQuality noise = DiskNoiseQuality::Texture;
+    bool wavefront = false;
+    bool deflectionTable = true;
+    bool geodesicCache = true;
+};
+
+// circle.frag 等共用 blackhole.glsl 的程序的编译期特性，以 #define 注入（默认值见 blackhole.glsl 开头）。
+// 每种组合编译一个变体，热循环里只有当前配置用到的代码
+struct ShaderPermutation {
+    int backgroundType = 1;
+    bool disk = true;
+    DiskNoiseQuality noise = DiskNoiseQuality::Texture;
+    bool temporalBlend = true;
+    DebugView debugView = DebugView::None;
+    bool stepStatistics = false;
+
+    quint32 key() const;
+    QByteArray defines() const;
+};
+
+// 黑洞渲染通道链：circle.frag -> mipmap.frag -> horizontal.frag -> vertical.frag -> screen_result.frag
+// mipmap.frag 把circle通道输出逐级减半成 kBloomLevels 级bloom金字塔，两个模糊通道逐级作用，screen_result 直接取样各级
+// 由GLCircleWidget和离线渲染器共用，调用方负责保证OpenGL上下文为当前上下文
+class BlackHoleRenderer : protected QOpenGLFunctions_4_3_Core {
+public:
+    // 步数上限的取值范围，界面、命令行和 setMaxGeodesicSteps 共用；最大值受逐像素统计的16位步数限制
+    static const int kMinGeodesicSteps = 1;
+    static const int kMaxGeodesicStepsLimit = 65535;
+    // bloom金字塔的级数，第 k 级为 1 / 2^(k+1) 分辨率（与 screen_result.frag 的 bloomLevels 相同）
+    static const int kBloomLevels = 8;
+
+    BlackHoleRenderer() = default;
+    ~BlackHoleRenderer();
+
+    // shaderDir 可以是磁盘目录（"../shaders/"）或资源路径（":/shaders/"）
+    bool initialize(const QString& shaderDir);
+    void resize(int w, int h);
+    // 渲染一帧，最终结果写入 targetFbo（0 表示默认帧缓冲）
+    void render(const BlackHoleFrameState& state, GLuint targetFbo);
+    // 全景：一次分层绘制渲染 faceSize 的立方体贴图六个面，重采样为视口大小（2:1）的等距柱状投影，
+    // bloom和色调映射只在全景图上做一次。iMouse按视口像素给出，全景模式不做TAA
+    void renderEquirect(const BlackHoleFrameState& state, int faceSize, GLuint targetFbo);
+
+    int width() const { return viewWidth; }
+    int height() const { return viewHeight; }
+    // circle通道（bloom之前）的fbo，尚未渲染过时为0
+    GLuint sceneFramebuffer() const { return fbo ? fbo->handle() : 0; }
+
+    void setShowMipmap(bool show) { showMipmap = show; }
+    void setHorizontalBlurEnabled(bool enabled) { horizontal = enabled; }
+    void setVerticalBlurEnabled(bool enabled) { vertical = enabled; }
+    void setShowRenderResult(bool show);
+    // 关闭后每条光线都逐步raymarching（与CPU参考路径一致），默认打开
+    void setDeflectionTableEnabled(bool enabled) { deflectionTableEnabled = enabled; }
+    // 无量纲自旋 a/M，非零时按相机位置查 Kerr 转移表（core/kerrtransfer.h），不做raymarching。
+    // 表不在磁盘缓存中时后台生成，期间按 Schwarzschild 渲染；waitForTables 为真时阻塞到表生成完（离线渲染）
+    void setBlackHoleSpin(float spin) { blackHoleSpin = spin; }
+    void setKerrTableWait(bool waitForTables) { kerrTableWait = waitForTables; }
+    void setKerrTableDirectory(const QString& dir) { kerrTables.setDirectory(dir); }
+    // 相机和黑洞几何不变时由缓存的吸积盘样本重算颜色，省去raymarching；关闭后每帧完整追踪
+    void setGeodesicCacheEnabled(bool enabled);
+    // 积分方式、自适应积分的每步相对误差和每条光线的步数上限，改变后测地线缓存失效
+    void setGeodesicIntegrator(GeodesicIntegrator value);
+    void setGeodesicTolerance(float value);
+    // 步数上限夹到 [kMinGeodesicSteps, kMaxGeodesicStepsLimit]，每次片元调用的工作量有上界，高分辨率下单帧不会拖到驱动的看门狗超时
+    void setMaxGeodesicSteps(int value);
+    // 用计算着色器按波前追踪circle通道：光线状态存在SSBO中，每次dispatch把存活光线推进固定步数，
+    // 之后按前缀和把存活光线压缩到下一个队列；结果与片元路径逐位一致，不使用测地线缓存，默认关闭
+    void setWavefrontEnabled(bool enabled) { wavefrontEnabled = enabled; }
+    // circle 通道的编译期特性（ShaderPermutation），改变后下一帧换用对应的变体，没用过的变体在那时编译
+    void setDiskEnabled(bool enabled) { diskEnabled = enabled; }
+    void setDiskNoiseQuality(DiskNoiseQuality quality) { diskNoiseQuality = quality; }
+    void setDebugView(DebugView view) { debugView = view; }
+    // 步数统计：circle 通道逐像素把步数和吸积盘着色次数写入 R32UI 纹理（stepCountTexture，低16位步数、高16位着色次数），
+    // 并用原子计数器累加全帧的和；计数器复制到读回缓冲后等两三帧再读，不阻塞渲染。
+    // 只在片元路径上统计，打开时不走波前路径和测地线缓存
+    void setStepStatisticsEnabled(bool enabled) { stepStatisticsOn = enabled; }
+    bool stepStatisticsEnabled() const { return stepStatisticsOn; }
+    GLuint stepCountTexture() const { return stepTexture; }
+    // 最近读回的一帧；wait 为真时先等最后提交的一帧读回（离线渲染结束时用）
+    StepStatistics stepStatistics(bool wait = false);
+    // 一次设置 RendererSettings 中的全部选项
+    void applySettings(const RendererSettings& settings);
+    // 按当前特性编译四种背景的片元路径变体，切换背景时不必等编译（initialize 时已调用一次）
+    bool precompileBackgroundVariants();
+
+    // 透镜映射（render/lensingmap.h）：按 state 渲染一次circle通道（不用缓存和波前路径），
+    // 把每像素的吸积盘颜色和逃逸方向读回 disk、escape（各 width * height * 4 个float，自下而上）
+    bool exportLensingMap(const BlackHoleFrameState& state, float* disk, float* escape);
+    // 上传映射的两个平面，之后 renderLensingMap 只需查纹理和叠加背景；映射尺寸须与视口相同
+    bool loadLensingMap(const LensingMapFile& map);
+    // 等距柱状投影的天空（世界系），空图像表示按 backgroundType 取背景
+    void setLensingSky(const QImage& sky);
+    void renderLensingMap(int backgroundType, GLuint targetFbo);
+
+private:
+    // 共用 blackhole.glsl、按 ShaderPermutation 编译变体的程序
+    enum class CircleProgram {
+        Fragment = 0,
+        Cubemap = 1,
+        Relens = 2,
+        WavefrontInit = 3,
+        WavefrontMarch = 4,
+        WavefrontShade = 5,
+    };
+
+    QOpenGLShaderProgram* createProgram(const QString& vertexFile, const QString& fragmentFile, const char* name,
+                                        const QString& geometryFile = QString(),
+                                        const QByteArray& defines = QByteArray());
+    QOpenGLShaderProgram* createComputeProgram(const QString& computeFile, const char* name,
+                                               const QByteArray& defines = QByteArray());
+    QOpenGLShaderProgram* circleVariant(CircleProgram kind, const ShaderPermutation& permutation);
+    ShaderPermutation permutation(int backgroundType) const;
+    QByteArray loadShaderSource(const QString& file);
+    QOpenGLFramebufferObject* createTarget(bool linearFilter);
+    QOpenGLFramebufferObject* createBloomTarget(const QSize& size);
+    void createTargets();
+    void releaseTargets();
+    void createChessTexture();
+    void createDeflectionTexture();
+    void createNoiseTexture();
+    void createBlueNoiseTexture();
+    bool prepareKerrTable(const BlackHoleFrameState& state, int w, int h);
+    void prepareEmissionTables(const BlackHoleFrameState& state);
+    void bindCircleTextures();
+    void createGeodesicCache(GLuint sampleCapacity);
+    void releaseGeodesicCache();
+    int geodesicCacheMode(const BlackHoleFrameState& state);
+    void createWavefrontBuffers(GLuint rayCount, bool geodesics);
+    void releaseWavefrontBuffers();
+    bool renderWavefront(const BlackHoleFrameState& state);
+    int compactWavefrontQueue(int queue);
+    void releaseLensingMap();
+    void createCubeTarget(int faceSize);
+    void releaseCubeTarget();
+    void beginStepStatistics();
+    void endStepStatistics(const BlackHoleFrameState& state);
+    bool readStepStatistics(GLuint64 timeout);
+    void releaseStepStatistics();
+    void setCircleUniforms(QOpenGLShaderProgram* circle, const BlackHoleFrameState& state, int w, int h);
+    void uploadFrameParams(const BlackHoleFrameParams& frame);
+    void renderPost(GLuint originalTexture, GLuint targetFbo);
+
+    QString shaderDir;
+    int viewWidth = 0;
+    int viewHeight = 0;
+
+    // OpenGL resources
+    // circle 通道的着色器变体，按 (CircleProgram, ShaderPermutation::key) 缓存，第一次用到时编译
+    QHash<quint32, QOpenGLShaderProgram*> circleVariants;
+    bool diskEnabled = true;
+    DiskNoiseQuality diskNoiseQuality = DiskNoiseQuality::Texture;
+    DebugView debugView = DebugView::None;
+    QOpenGLVertexArrayObject vao;
+    QOpenGLBuffer vbo;
+    QOpenGLTexture* chessTexture = nullptr;
+    QVector3D chessTextureResolution{64.0f, 64.0f, 0.0f};
+    // Schwarzschild 偏折表（core/deflectiontable.h），不进入吸积盘的光线查表得到背景方向
+    GLuint deflectionTexture = 0;
+    bool deflectionTableEnabled = true;
+    GeodesicIntegrator integrator = GeodesicIntegrator::Fixed;
+    float geodesicTolerance = 1e-5f;
+    int maxGeodesicSteps = 1000;
+    // 吸积盘噪声格点值（core/noisevolume.h，64^3 R16F 3D纹理），初始化时生成一次
+    GLuint noiseTexture = 0;
+    // 像素和首步抖动的蓝噪声（core/bluenoise.h，64x64 RGB16UI），初始化时上传一次
+    GLuint blueNoiseTexture = 0;
+    // 吸积盘发射查找表（core/emissiontables.h，RGBA32F），盘参数变化时重建
+    GLuint emissionTexture = 0;
+    DiskParameters emissionDisk;
+
+    // Kerr 转移表（GL_TEXTURE_2D_ARRAY，三层RGBA32F），首次需要时创建
+    float blackHoleSpin = 0.0f;
+    bool kerrTableWait = false;
+    KerrTableCache kerrTables;
+    std::shared_ptr<const KerrTransferTable> kerrUploaded;   // 纹理中的表
+    GLuint kerrTexture = 0;
+    bool kerrTableActive = false;   // 本帧 circle 通道是否查表
+
+    // 测地线缓存（circle.frag 的 SSBO 0~3）：每像素的样本区间和逃逸方向、盘内样本、样本方向、分配计数
+    GLuint cacheBuffers[4] = {0, 0, 0, 0};
+    GLuint cacheCapacity = 0;
+    bool geodesicCacheEnabled = true;
+    bool cacheValid = false;      // cacheKey 是上一帧的参数
+    bool cacheReadback = false;   // 这一相机位置第一次记录了缓存，需检查样本缓冲是否够用
+    bool cacheRecorded = false;   // 相机静止后已记录过缓存
+    int cacheStillFrames = 0;     // 相机和参数连续不变的帧数
+    BlackHoleFrameState cacheKey;   // 上一帧的帧参数
+    bool cacheTableEnabled = true;
+    float cacheSpin = 0.0f;
+
+    // 波前路径（wavefront_*.comp），首次使用时创建
+    bool wavefrontEnabled = false;
+    int wavefrontSteps = 16;   // 每次dispatch推进的步数
+    QOpenGLShaderProgram* wavefrontScanProgram = nullptr;
+    QOpenGLShaderProgram* wavefrontScanGroupsProgram = nullptr;
+    QOpenGLShaderProgram* wavefrontScatterProgram = nullptr;
+    // SSBO 0~7：光线状态、自适应积分状态、步数和标志、输入队列、输出队列、存活标志和前缀和、组偏移、队列头
+    GLuint wavefrontBuffers[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    GLuint wavefrontRayCount = 0;
+    bool wavefrontGeodesics = false;
+
+    // 步数统计（circle.frag 的 stepCountImage 和 SSBO 4），首次打开时创建
+    bool stepStatisticsOn = false;
+    GLuint stepTexture = 0;
+    int stepTextureWidth = 0;
+    int stepTextureHeight = 0;
+    GLuint stepCounterBuffer = 0;
+    struct StepReadback {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        int frame = 0;
+        int width = 0;
+        int height = 0;
+    };
+    StepReadback stepReadbacks[3];
+    int stepWriteIndex = 0;
+    int stepReadIndex = 0;
+    int stepPending = 0;
+    StepStatistics stepLatest;
+
+    // 透镜映射换背景（relens.frag 的变体），首次使用时创建
+    GLuint lensingTextures[2] = {0, 0};   // 吸积盘颜色、逃逸方向（RGBA32F）
+    BlackHoleFrameState lensingState;     // 生成映射时的帧参数
+    QOpenGLTexture* skyTexture = nullptr;
+
+    // FBO and textures
+    QOpenGLFramebufferObject* fbo = nullptr;
+    QOpenGLTexture* prevFrameTexture = nullptr;
+    QOpenGLShaderProgram* screenProgram = nullptr;
+
+    // Mipmap resources：bloom金字塔各级，每级两个目标供两个模糊通道来回使用
+    bool showMipmap = true;
+    QOpenGLShaderProgram* mipmapProgram = nullptr;
+    QOpenGLFramebufferObject* bloomLevels[kBloomLevels] = {};
+    QOpenGLFramebufferObject* bloomScratch[kBloomLevels] = {};
+
+    // horizontal resources
+    bool horizontal = true;
+    QOpenGLShaderProgram* horizontalProgram = nullptr;
+
+    // vertical resources
+    bool vertical = true;
+    QOpenGLShaderProgram* verticalProgram = nullptr;
+
+    bool result = true;
+    QOpenGLShaderProgram* resultProgram = nullptr;
+
+    // 全景资源（circle.frag 的分层变体在 circleVariants 中），首次使用时创建
+    QOpenGLShaderProgram* equirectProgram = nullptr;
+    GLuint cubeTexture = 0;
+    GLuint cubeFbo = 0;
+    int cubeFaceSize = 0;
+
+    // circle.frag 等共用 blackhole.glsl 的程序每帧都要设的uniform，位置在第一次使用时按程序查一次（-1 表示被优化掉）
+    struct CircleUniformLocations {
+        int circleColor = -1;
+        int iResolution = -1;
+        int iTileOffset = -1;
+        int offset = -1;
+        int radius = -1;
+        int backgroundType = -1;
+        int iFrame = -1;
+        int iMouse = -1;
+        int iTime = -1;
+        int iChannelResolution = -1;
+        int iTimeDelta = -1;
+        int iFov = -1;
+        int iCameraBasis = -1;
+        int useDeflectionTable = -1;
+        int deflectionTableRange = -1;
+        int geodesicIntegrator = -1;
+        int geodesicTolerance = -1;
+        int maxGeodesicSteps = -1;
+        int useKerrTable = -1;
+        int geodesicCacheMode = -1;
+        int geodesicCacheWidth = -1;
+        int geodesicCacheCapacity = -1;
+        int wavefrontWidth = -1;
+        int wavefrontHeight = -1;
+        int wavefrontSteps = -1;
+        int wavefrontQueue = -1;
+        int useSky = -1;
+    };
+    const CircleUniformLocations& circleUniformLocations(QOpenGLShaderProgram* circle);
+    QHash<QOpenGLShaderProgram*, CircleUniformLocations> circleLocations;   // 程序只在析构时删除
+    // 后处理通道（screen.vert 的全屏程序）的 uniform 位置，采样器单元在链接后设一次
+    struct PassUniformLocations {
+        int iResolution = -1;
+        int bloomEnabled = -1;
+    };
+    PassUniformLocations passUniformLocations(QOpenGLShaderProgram* pass);
+    void drawPass(QOpenGLShaderProgram* pass, const PassUniformLocations& loc, GLuint inputTexture,
+                  QOpenGLFramebufferObject* target);
+    PassUniformLocations mipmapLocations;
+    PassUniformLocations horizontalLocations;
+    PassUniformLocations verticalLocations;
+    PassUniformLocations resultLocations;
+    PassUniformLocations equirectLocations;
+    // 光线队列压缩程序的 wavefrontQueue（scan、scangroups、scatter）
+    int wavefrontQueueLocations[3] = {-1, -1, -1};
+    // 每帧常量（BlackHoleFrameBlock，uniform 缓冲 binding 0），与上次上传相同时不再上传
+    GLuint frameBuffer = 0;
+    BlackHoleFrameParams frameUploaded;
+
+    // Uniform values
+    QVector3D circleColor{1.0f, 0.0f, 0.0f};
+    QVector2D offset{0.2f, 0.2f};
+    float radius = 0.2f;
+};
+
+#endif // BLACKHOLERENDERER_H
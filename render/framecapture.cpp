@@ -0,0 +1,261 @@
+#include "framecapture.h"
+#include <QDebug>
+#include <QDir>
+#include <QImage>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+
+FrameCapture::FrameCapture(int ringSize) {
+    ring.resize(std::max(2, ringSize));
+}
+
+FrameCapture::~FrameCapture() {
+    // 资源释放需要当前上下文，由调用方在上下文有效时调用 release()
+}
+
+void FrameCapture::initialize() {
+    if (initialized) {
+        return;
+    }
+    initializeOpenGLFunctions();
+    for (Slot& slot : ring) {
+        glGenBuffers(1, &slot.pbo);
+    }
+    initialized = true;
+}
+
+void FrameCapture::release() {
+    if (!initialized) {
+        return;
+    }
+    for (Slot& slot : ring) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        glDeleteBuffers(1, &slot.pbo);
+        slot.pbo = 0;
+        slot.size = 0;
+    }
+    if (resolveFbo) {
+        glDeleteFramebuffers(1, &resolveFbo);
+        glDeleteRenderbuffers(1, &resolveRenderbuffer);
+        resolveFbo = 0;
+        resolveRenderbuffer = 0;
+    }
+    pending = 0;
+    readIndex = writeIndex = 0;
+    initialized = false;
+}
+
+void FrameCapture::setPixelFormat(GLenum format, GLenum type, int bytesPerPixel) {
+    pixelFormat = format;
+    pixelType = type;
+    pixelBytes = bytesPerPixel;
+}
+
+GLuint FrameCapture::resolveSource(GLuint fbo, int w, int h) {
+    GLint samples = 0;
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glGetIntegerv(GL_SAMPLES, &samples);
+    if (samples == 0) {
+        return fbo;
+    }
+
+    // 多重采样帧缓冲不能直接glReadPixels，先blit到单采样渲染缓冲
+    if (!resolveFbo || resolveWidth != w || resolveHeight != h) {
+        if (!resolveFbo) {
+            glGenFramebuffers(1, &resolveFbo);
+            glGenRenderbuffers(1, &resolveRenderbuffer);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, resolveRenderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, pixelType == GL_UNSIGNED_BYTE ? GL_RGBA8 : GL_RGBA16F, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, resolveFbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveRenderbuffer);
+        resolveWidth = w;
+        resolveHeight = h;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFbo);
+    glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    return resolveFbo;
+}
+
+void FrameCapture::capture(GLuint fbo, int x, int y, int w, int h) {
+    if (!initialized || w <= 0 || h <= 0) {
+        return;
+    }
+
+    // 环已满：最旧的一帧必须先交付（此时GPU已落后ring.size()帧，等待是合理的）
+    if (pending == ring.size() && !deliver(ring[readIndex], GL_TIMEOUT_IGNORED)) {
+        qWarning() << "FrameCapture: frame" << ring[readIndex].frameIndex << "did not complete, dropped";
+        discard(ring[readIndex]);
+    }
+
+    GLint previousFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+
+    GLuint source = resolveSource(fbo, x + w, y + h);
+
+    Slot& slot = ring[writeIndex];
+    const qint64 size = qint64(w) * h * pixelBytes;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.size != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        slot.size = size;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glReadBuffer(source == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    // 目标为PBO时glReadPixels立即返回，拷贝由驱动异步完成
+    glReadPixels(x, y, w, h, pixelFormat, pixelType, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frameIndex = frameCounter++;
+    slot.width = w;
+    slot.height = h;
+    glFlush();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+
+    writeIndex = (writeIndex + 1) % ring.size();
+    pending++;
+}
+
+bool FrameCapture::deliver(Slot& slot, GLuint64 timeout) {
+    if (!slot.fence) {
+        qWarning() << "FrameCapture: frame" << slot.frameIndex << "has no fence";
+        discard(slot);
+        return true;
+    }
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (status == GL_WAIT_FAILED) {
+        qWarning() << "FrameCapture: waiting for frame" << slot.frameIndex << "failed";
+        discard(slot);
+        return true;
+    }
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+    if (!mapped) {
+        qWarning() << "FrameCapture: failed to map pixel buffer for frame" << slot.frameIndex;
+    }
+    notify(slot, static_cast<const uchar*>(mapped));
+    if (mapped) {
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readIndex = (readIndex + 1) % ring.size();
+    pending--;
+    return true;
+}
+
+void FrameCapture::notify(const Slot& slot, const uchar* data) {
+    if (!consumer) {
+        return;
+    }
+    CapturedFrame frame;
+    frame.index = slot.frameIndex;
+    frame.width = slot.width;
+    frame.height = slot.height;
+    frame.format = pixelFormat;
+    frame.type = pixelType;
+    frame.bytesPerPixel = pixelBytes;
+    frame.data = data;
+    frame.bytes = data ? slot.size : 0;
+    consumer(frame);
+}
+
+void FrameCapture::discard(Slot& slot) {
+    if (slot.fence) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    notify(slot, nullptr);
+    readIndex = (readIndex + 1) % ring.size();
+    pending--;
+}
+
+void FrameCapture::poll() {
+    // 按提交顺序交付，遇到尚未完成的帧即停止
+    while (pending > 0 && deliver(ring[readIndex], 0)) {
+    }
+}
+
+void FrameCapture::flush() {
+    while (pending > 0) {
+        if (!deliver(ring[readIndex], GL_TIMEOUT_IGNORED)) {
+            qWarning() << "FrameCapture: frame" << ring[readIndex].frameIndex << "did not complete, dropped";
+            discard(ring[readIndex]);
+        }
+    }
+}
+
+namespace {
+
+class SaveImageTask : public QRunnable {
+public:
+    SaveImageTask(QImage image, QString fileName, QAtomicInt* failures)
+        : image(std::move(image)), fileName(std::move(fileName)), failures(failures) {}
+
+    void run() override {
+        // 翻转为自上而下的行顺序
+        image = image.mirrored();
+        if (!image.save(fileName)) {
+            qWarning() << "Failed to write" << fileName;
+            failures->ref();
+        }
+    }
+
+private:
+    QImage image;
+    QString fileName;
+    QAtomicInt* failures;
+};
+
+} // namespace
+
+ImageSequenceWriter::ImageSequenceWriter(const QString& directory, const QString& prefix)
+    : directory(directory), prefix(prefix) {
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+}
+
+ImageSequenceWriter::~ImageSequenceWriter() {
+    waitForDone();
+}
+
+void ImageSequenceWriter::operator()(const CapturedFrame& frame) {
+    const QString fileName = QDir(directory).filePath(
+        QString("%1_%2.png").arg(prefix).arg(frame.index, 4, 10, QChar('0')));
+    if (!frame.data) {
+        qWarning() << "Frame" << frame.index << "was not read back, skipping" << fileName;
+        failures.ref();
+        return;
+    }
+    if (frame.format != GL_RGBA || frame.type != GL_UNSIGNED_BYTE) {
+        qWarning() << "ImageSequenceWriter only supports RGBA8 frames, skipping" << fileName;
+        failures.ref();
+        return;
+    }
+    // 映射的PBO在回调结束后即失效，GL线程上只做一次拷贝，翻转留给编码线程
+    QImage image(frame.data, frame.width, frame.height, frame.width * 4, QImage::Format_RGBA8888);
+    pool.start(new SaveImageTask(image.copy(), fileName, &failures));
+}
+
+void ImageSequenceWriter::waitForDone() {
+    pool.waitForDone();
+}
+
+int ImageSequenceWriter::failedCount() const {
+    return failures.loadAcquire();
+}
@@ -0,0 +1,104 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <QOpenGLFunctions_4_3_Core>
+#include <QVector>
+#include <QString>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <functional>
+
+// 一帧已完成读取的像素数据，data 只在回调期间有效（指向映射中的PBO）；
+// 读取失败的帧也按顺序交付，此时 data 为空、bytes 为 0
+struct CapturedFrame {
+    int index = 0;
+    int width = 0;
+    int height = 0;
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    int bytesPerPixel = 4;
+    const uchar* data = nullptr;   // 自下而上的行顺序（OpenGL约定）
+    qint64 bytes = 0;
+};
+
+// 基于 GL_PIXEL_PACK_BUFFER 环和 glFenceSync 的异步帧读取
+// 第N帧的PBO在第N+1、N+2帧仍在渲染时被映射，渲染线程不会因读取而阻塞
+class FrameCapture : protected QOpenGLFunctions_4_3_Core {
+public:
+    using Consumer = std::function<void(const CapturedFrame&)>;
+
+    explicit FrameCapture(int ringSize = 3);
+    ~FrameCapture();
+
+    // 需要在当前OpenGL上下文中调用
+    void initialize();
+    void release();
+
+    void setConsumer(Consumer callback) { consumer = std::move(callback); }
+    void setPixelFormat(GLenum format, GLenum type, int bytesPerPixel);
+
+    // 发起对 fbo 颜色附件0的异步读取（多重采样的fbo会先解析）
+    void capture(GLuint fbo, int w, int h) { capture(fbo, 0, 0, w, h); }
+    // 只读取 (x, y, w, h) 区域，分块渲染用它去掉保护带
+    void capture(GLuint fbo, int x, int y, int w, int h);
+    // 把已完成的读取按顺序交给consumer，不阻塞
+    void poll();
+    // 阻塞直到所有读取完成并交付
+    void flush();
+
+    int pendingCount() const { return pending; }
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        qint64 size = 0;
+        int frameIndex = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    // 交付最旧的一帧；timeout 内未完成时返回 false，等待失败的帧被丢弃
+    bool deliver(Slot& slot, GLuint64 timeout);
+    // 删除 slot 的fence并出队，consumer 收到 data 为空的帧
+    void discard(Slot& slot);
+    void notify(const Slot& slot, const uchar* data);
+    GLuint resolveSource(GLuint fbo, int w, int h);
+
+    QVector<Slot> ring;
+    int writeIndex = 0;
+    int readIndex = 0;
+    int pending = 0;
+    int frameCounter = 0;
+    bool initialized = false;
+
+    GLenum pixelFormat = GL_RGBA;
+    GLenum pixelType = GL_UNSIGNED_BYTE;
+    int pixelBytes = 4;
+    Consumer consumer;
+
+    // 多重采样源的解析目标
+    GLuint resolveFbo = 0;
+    GLuint resolveRenderbuffer = 0;
+    int resolveWidth = 0;
+    int resolveHeight = 0;
+};
+
+// 把捕获的RGBA8帧复制后交给线程池编码成PNG，编码不占用渲染线程
+class ImageSequenceWriter {
+public:
+    ImageSequenceWriter(const QString& directory, const QString& prefix);
+    ~ImageSequenceWriter();
+
+    void operator()(const CapturedFrame& frame);
+    void waitForDone();
+    int failedCount() const;
+
+private:
+    QString directory;
+    QString prefix;
+    QThreadPool pool;
+    QAtomicInt failures;
+};
+
+#endif // FRAMECAPTURE_H
@@ -0,0 +1,305 @@
+#include "framestream.h"
+#include <QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// 阻塞写入文件描述符（stdout、FIFO或普通文件）
+class PipeSink : public FrameSink {
+public:
+    PipeSink(int fd, bool ownsFd) : fd(fd), ownsFd(ownsFd) {}
+    ~PipeSink() override {
+        if (ownsFd) {
+            ::close(fd);
+        }
+    }
+
+    bool write(const uint8_t* data, size_t bytes, uint64_t) override {
+        while (bytes > 0) {
+            ssize_t n = ::write(fd, data, bytes);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                qWarning() << "Frame stream write failed:" << std::strerror(errno);
+                return false;
+            }
+            data += n;
+            bytes -= size_t(n);
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    bool ownsFd;
+};
+
+// 固定头 + N个槽的共享内存环，读取方可随时映射同一文件
+class MappedRingSink : public FrameSink {
+public:
+    ~MappedRingSink() override {
+        if (mapping) {
+            ::msync(mapping, mappingBytes, MS_ASYNC);
+            ::munmap(mapping, mappingBytes);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool open(const QByteArray& path, int width, int height, StreamPixelFormat format,
+              size_t frameBytes, uint32_t slots) {
+        const size_t page = 4096;
+        const size_t headerBytes = page;
+        const size_t slotStride = (sizeof(FrameRingSlotHeader) + frameBytes + page - 1) / page * page;
+        mappingBytes = headerBytes + slotStride * slots;
+
+        fd = ::open(path.constData(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ::ftruncate(fd, off_t(mappingBytes)) != 0) {
+            qWarning() << "Cannot create ring file" << path << std::strerror(errno);
+            return false;
+        }
+        void* ptr = ::mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            qWarning() << "Cannot map ring file" << path << std::strerror(errno);
+            return false;
+        }
+        mapping = static_cast<uint8_t*>(ptr);
+
+        header = new (mapping) FrameRingHeader();
+        std::memcpy(header->magic, "BHRING01", 8);
+        header->version = 1;
+        header->headerBytes = uint32_t(headerBytes);
+        header->width = uint32_t(width);
+        header->height = uint32_t(height);
+        header->pixelFormat = uint32_t(format);
+        header->slotCount = slots;
+        header->frameBytes = frameBytes;
+        header->slotStride = slotStride;
+        for (uint32_t i = 0; i < slots; ++i) {
+            FrameRingSlotHeader* slot = new (slotAt(i)) FrameRingSlotHeader();
+            slot->sequence.store(UINT64_MAX, std::memory_order_relaxed);
+        }
+        header->writeIndex.store(0, std::memory_order_release);
+        return true;
+    }
+
+    bool write(const uint8_t* data, size_t bytes, uint64_t frameIndex) override {
+        std::memcpy(beginFrame(frameIndex), data, bytes);
+        commitFrame(frameIndex);
+        return true;
+    }
+
+    uint8_t* beginFrame(uint64_t frameIndex) override {
+        FrameRingSlotHeader* slot = slotFor(frameIndex);
+        slot->sequence.store(UINT64_MAX, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return reinterpret_cast<uint8_t*>(slot) + sizeof(FrameRingSlotHeader);
+    }
+
+    void commitFrame(uint64_t frameIndex) override {
+        slotFor(frameIndex)->sequence.store(frameIndex, std::memory_order_release);
+        header->writeIndex.store(frameIndex + 1, std::memory_order_release);
+    }
+
+private:
+    uint8_t* slotAt(uint64_t index) const {
+        return mapping + header->headerBytes + index * header->slotStride;
+    }
+
+    FrameRingSlotHeader* slotFor(uint64_t frameIndex) const {
+        return reinterpret_cast<FrameRingSlotHeader*>(slotAt(frameIndex % header->slotCount));
+    }
+
+    int fd = -1;
+    uint8_t* mapping = nullptr;
+    size_t mappingBytes = 0;
+    FrameRingHeader* header = nullptr;
+};
+
+} // namespace
+
+FrameStream::~FrameStream() {
+    close();
+}
+
+void FrameStream::pixelLayout(StreamPixelFormat format, GLenum* glFormat, GLenum* glType, int* bytesPerPixel) {
+    if (format == StreamPixelFormat::Rgb16F) {
+        *glFormat = GL_RGB;
+        *glType = GL_HALF_FLOAT;
+        *bytesPerPixel = 6;
+    } else {
+        *glFormat = GL_RGBA;
+        *glType = GL_UNSIGNED_BYTE;
+        *bytesPerPixel = 4;
+    }
+}
+
+bool FrameStream::open(const QString& spec, int width, int height, StreamPixelFormat format, int queueDepth) {
+    GLenum glFormat;
+    GLenum glType;
+    int bytesPerPixel;
+    pixelLayout(format, &glFormat, &glType, &bytesPerPixel);
+    rowBytes = size_t(width) * bytesPerPixel;
+    frameBytes = rowBytes * height;
+    frameHeight = height;
+
+    bool inPlace = false;
+    if (spec == "-" || spec == "stdout") {
+        sink.reset(new PipeSink(STDOUT_FILENO, false));
+    } else if (spec.startsWith("fifo:")) {
+        // 打开FIFO会阻塞到读取方（如编码器）就绪
+        const QByteArray path = spec.mid(5).toLocal8Bit();
+        int fd = ::open(path.constData(), O_WRONLY | O_CREAT, 0644);
+        if (fd < 0) {
+            qWarning() << "Cannot open" << path << std::strerror(errno);
+            return false;
+        }
+        sink.reset(new PipeSink(fd, true));
+    } else if (spec.startsWith("ring:")) {
+        QString path = spec.mid(5);
+        uint32_t slots = 8;
+        const int colon = path.lastIndexOf(':');
+        if (colon > 0) {
+            bool ok = false;
+            const uint32_t count = path.mid(colon + 1).toUInt(&ok);
+            if (ok && count > 0) {
+                slots = count;
+                path = path.left(colon);
+            }
+        }
+        MappedRingSink* ring = new MappedRingSink();
+        sink.reset(ring);
+        if (!ring->open(path.toLocal8Bit(), width, height, format, frameBytes, slots)) {
+            sink.reset();
+            return false;
+        }
+        inPlace = true;
+    } else {
+        qWarning() << "Unknown stream target" << spec << "(expected -, fifo:PATH or ring:PATH[:SLOTS])";
+        return false;
+    }
+
+    stopping.store(false);
+    failed.store(false);
+    written.store(0);
+    submitted = 0;
+    // 环文件的槽不会阻塞，GL线程直接翻转写入，不需要缓冲池和写线程
+    if (inPlace) {
+        return true;
+    }
+
+    // 预分配缓冲池，热路径上不再分配内存
+    const int depth = std::max(2, queueDepth);
+    buffers.assign(size_t(depth), std::vector<uint8_t>(frameBytes));
+    filledQueue.reset(new SpscQueue<Ticket>(size_t(depth)));
+    freeQueue.reset(new SpscQueue<int>(size_t(depth)));
+    for (int i = 0; i < depth; ++i) {
+        freeQueue->tryPush(i);
+    }
+    writer = std::thread(&FrameStream::writerLoop, this);
+    return true;
+}
+
+void FrameStream::submit(const CapturedFrame& frame) {
+    if (!sink || failed.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // 缺一帧或帧尺寸不对的视频不完整，按写入失败处理
+    if (!frame.data) {
+        qWarning() << "Frame stream: frame" << frame.index << "was not read back";
+        failed.store(true);
+        return;
+    }
+    if (size_t(frame.bytes) != frameBytes) {
+        qWarning() << "Frame stream: unexpected frame size" << frame.bytes << "expected" << frameBytes;
+        failed.store(true);
+        return;
+    }
+
+    // OpenGL行序自下而上，拷贝时翻转为读取方期望的自上而下
+    const auto flip = [this, &frame](uint8_t* dst) {
+        for (int y = 0; y < frameHeight; ++y) {
+            std::memcpy(dst + size_t(y) * rowBytes, frame.data + size_t(frameHeight - 1 - y) * rowBytes, rowBytes);
+        }
+    };
+
+    // 环文件：直接翻转写入下一个槽，读取方按序号判断槽是否完整
+    if (!writer.joinable()) {
+        const uint64_t frameIndex = submitted++;
+        flip(sink->beginFrame(frameIndex));
+        sink->commitFrame(frameIndex);
+        written.fetch_add(1, std::memory_order_release);
+        return;
+    }
+
+    // 写线程（编码器）跟不上时施加背压，不丢帧
+    int buffer = 0;
+    {
+        std::unique_lock<std::mutex> guard(waitLock);
+        bufferFreed.wait(guard, [&] { return freeQueue->tryPop(buffer) || failed.load(std::memory_order_relaxed); });
+    }
+    if (failed.load(std::memory_order_relaxed)) {
+        return;
+    }
+    flip(buffers[size_t(buffer)].data());
+
+    Ticket ticket;
+    ticket.buffer = buffer;
+    ticket.frameIndex = submitted++;
+    {
+        std::lock_guard<std::mutex> guard(waitLock);
+        filledQueue->tryPush(ticket);
+    }
+    frameFilled.notify_one();
+}
+
+void FrameStream::writerLoop() {
+    Ticket ticket;
+    for (;;) {
+        bool popped = false;
+        {
+            std::unique_lock<std::mutex> guard(waitLock);
+            frameFilled.wait(guard, [&] {
+                popped = filledQueue->tryPop(ticket);
+                return popped || stopping.load(std::memory_order_acquire);
+            });
+        }
+        // close 在最后一次 submit 之后，停止时队列已写完
+        if (!popped) {
+            break;
+        }
+        if (!failed.load(std::memory_order_relaxed)) {
+            if (sink->write(buffers[size_t(ticket.buffer)].data(), frameBytes, ticket.frameIndex)) {
+                written.fetch_add(1, std::memory_order_release);
+            } else {
+                failed.store(true);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard(waitLock);
+            freeQueue->tryPush(ticket.buffer);
+        }
+        bufferFreed.notify_one();
+    }
+}
+
+bool FrameStream::close() {
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(waitLock);
+            stopping.store(true, std::memory_order_release);
+        }
+        frameFilled.notify_one();
+        writer.join();
+    }
+    sink.reset();
+    return !failed.load();
+}
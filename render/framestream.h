@@ -0,0 +1,97 @@
+#ifndef FRAMESTREAM_H
+#define FRAMESTREAM_H
+
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "framecapture.h"
+#include "spscqueue.h"
+
+enum class StreamPixelFormat : uint32_t {
+    Rgba8 = 0,   // GL_RGBA / GL_UNSIGNED_BYTE，4字节每像素
+    Rgb16F = 1,  // GL_RGB / GL_HALF_FLOAT，6字节每像素
+};
+
+// 内存映射环文件布局，外部进程以只读方式映射即可读取
+// [FrameRingHeader | 填充到 headerBytes] [槽0] [槽1] ... ，每个槽为 FrameRingSlotHeader + 一帧像素（自上而下行序）
+// 写入顺序：slot.sequence = UINT64_MAX -> 写像素 -> slot.sequence = 帧号 -> writeIndex = 帧号 + 1
+// 读取方：读 sequence，拷贝像素，再读 sequence，两次相同且不为 UINT64_MAX 才有效
+struct FrameRingHeader {
+    char magic[8];                      // "BHRING01"
+    uint32_t version;                   // 1
+    uint32_t headerBytes;               // 第一个槽的文件偏移
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelFormat;               // StreamPixelFormat
+    uint32_t slotCount;
+    uint64_t frameBytes;                // 一帧像素字节数
+    uint64_t slotStride;                // 相邻槽的间隔（4096对齐）
+    std::atomic<uint64_t> writeIndex;   // 已完整写入的帧数
+};
+
+struct FrameRingSlotHeader {
+    std::atomic<uint64_t> sequence;     // 槽中帧的帧号
+    uint64_t reserved[7];               // 保持像素数据64字节对齐
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring file requires address-free 64-bit atomics");
+
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+    virtual bool write(const uint8_t* data, size_t bytes, uint64_t frameIndex) = 0;
+    // 可直接写入的目标（如环文件的槽）：返回该帧像素的写入位置，写完后调用 commitFrame；
+    // 返回nullptr表示需要经写线程调用 write
+    virtual uint8_t* beginFrame(uint64_t) { return nullptr; }
+    virtual void commitFrame(uint64_t) {}
+};
+
+// 把最终通道的原始帧交给写线程输出到 stdout/FIFO，或直接写入内存映射环文件
+// GL线程只做一次从映射PBO到预分配缓冲（环文件则是下一个槽）的拷贝，编码和管道写入都不在渲染热路径上
+class FrameStream {
+public:
+    FrameStream() = default;
+    ~FrameStream();
+
+    // spec: "-" 表示stdout，"fifo:路径" 写入命名管道或文件，"ring:路径[:槽数]" 写入内存映射环文件
+    bool open(const QString& spec, int width, int height, StreamPixelFormat format, int queueDepth = 4);
+    // 由FrameCapture的consumer在GL线程调用；写线程落后时阻塞等待空闲缓冲
+    void submit(const CapturedFrame& frame);
+    // 写完队列中剩余帧并结束写线程，返回是否全部成功
+    bool close();
+
+    uint64_t framesWritten() const { return written.load(std::memory_order_acquire); }
+
+    static void pixelLayout(StreamPixelFormat format, GLenum* glFormat, GLenum* glType, int* bytesPerPixel);
+
+private:
+    struct Ticket {
+        int buffer = 0;
+        uint64_t frameIndex = 0;
+    };
+
+    void writerLoop();
+
+    std::unique_ptr<FrameSink> sink;
+    std::vector<std::vector<uint8_t>> buffers;
+    std::unique_ptr<SpscQueue<Ticket>> filledQueue;   // GL线程 -> 写线程
+    std::unique_ptr<SpscQueue<int>> freeQueue;        // 写线程 -> GL线程
+    std::thread writer;
+    std::mutex waitLock;                       // 只配合下面两个条件变量使用，队列本身无锁
+    std::condition_variable bufferFreed;       // 写线程归还缓冲或失败
+    std::condition_variable frameFilled;       // GL线程提交一帧或要求停止
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> failed{false};
+    std::atomic<uint64_t> written{0};
+    uint64_t submitted = 0;
+    size_t frameBytes = 0;
+    size_t rowBytes = 0;
+    int frameHeight = 0;
+};
+
+#endif // FRAMESTREAM_H
@@ -0,0 +1,143 @@
+#include "kerrtablecache.h"
+#include "../core/workstealingpool.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// 磁盘缓存的上限，一张表约25 MB，超出时删除最久没用过的表
+const qint64 kMaxCacheBytes = qint64(2) << 30;
+
+} // namespace
+
+KerrTableCache::KerrTableCache() = default;
+
+KerrTableCache::~KerrTableCache() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void KerrTableCache::setDirectory(const QString& dir) {
+    cacheDir = dir;
+}
+
+QString KerrTableCache::directory() const {
+    if (!cacheDir.isEmpty()) {
+        return cacheDir;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/kerr";
+}
+
+// 键已按 KerrTableKey::quantized 取整，文件名用各自网格上的整数下标
+QString KerrTableCache::pathFor(const KerrTableKey& key) const {
+    const long spin = std::lround(key.spin * 1000.0);
+    const long radius = std::lround(std::log(key.radius) / std::log(1.005));
+    const long inclination = std::lround(key.inclination * 180.0 / 3.14159265358979323846 * 4.0);
+    return QString("%1/a%2_r%3_i%4.bhkerr").arg(directory()).arg(spin).arg(radius).arg(inclination);
+}
+
+std::shared_ptr<const KerrTransferTable> KerrTableCache::request(const KerrTableKey& key, bool wait) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (finished) {
+        current = finished;
+        finished.reset();
+    }
+    if (current && current->key() == key) {
+        return current;
+    }
+    const bool queued = (building && buildingKey == key) || (hasWanted && wanted == key);
+    if (!queued) {
+        guard.unlock();
+        std::shared_ptr<KerrTransferTable> table = std::make_shared<KerrTransferTable>();
+        const QString path = pathFor(key);
+        if (table->load(QFile::encodeName(path).toStdString(), key)) {
+            // 修改时间记作最近使用时间，淘汰时按它排序
+            QFile file(path);
+            if (file.open(QIODevice::ReadWrite)) {
+                file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+            }
+            current = table;
+            return current;
+        }
+        guard.lock();
+        wanted = key;
+        hasWanted = true;
+        if (!worker.joinable()) {
+            worker = std::thread(&KerrTableCache::workerLoop, this);
+        }
+        wake.notify_one();
+    }
+    if (wait) {
+        built.wait(guard, [&] { return finished && finished->key() == key; });
+        current = finished;
+        finished.reset();
+    }
+    return current;
+}
+
+void KerrTableCache::workerLoop() {
+    WorkStealingPool pool;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this] { return stopping || hasWanted; });
+        if (stopping) {
+            return;
+        }
+        const KerrTableKey key = wanted;
+        hasWanted = false;
+        building = true;
+        buildingKey = key;
+        guard.unlock();
+
+        qDebug() << "Building Kerr transfer table: spin" << key.spin << "radius" << key.radius << "Rs, inclination"
+                 << key.inclination * 180.0 / 3.14159265358979323846 << "deg";
+        std::shared_ptr<KerrTransferTable> table = std::make_shared<KerrTransferTable>();
+        if (!table->build(key, pool, &stopping)) {
+            return;
+        }
+        // 先写临时文件再改名，同时渲染的多个进程不会读到写了一半的表
+        const QString path = pathFor(key);
+        const QString temporary = path + QString(".%1.tmp").arg(QCoreApplication::applicationPid());
+        if (!QDir().mkpath(directory()) || !table->save(QFile::encodeName(temporary).toStdString()) ||
+            std::rename(QFile::encodeName(temporary).constData(), QFile::encodeName(path).constData()) != 0) {
+            qDebug() << "Cannot write Kerr transfer table" << path;
+            QFile::remove(temporary);
+        } else {
+            evict();
+        }
+
+        guard.lock();
+        building = false;
+        finished = table;
+        built.notify_all();
+    }
+}
+
+// 删除最久没用过的表直到总大小不超过 kMaxCacheBytes；其他进程正在读的文件删除后仍可读完
+void KerrTableCache::evict() const {
+    QFileInfoList tables = QDir(directory()).entryInfoList({"*.bhkerr"}, QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo& info : tables) {
+        total += info.size();
+    }
+    // QDir::Time 按修改时间从新到旧排列
+    while (total > kMaxCacheBytes && tables.size() > 1) {
+        const QFileInfo oldest = tables.takeLast();
+        if (QFile::remove(oldest.filePath())) {
+            total -= oldest.size();
+        }
+    }
+}
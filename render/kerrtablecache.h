@@ -0,0 +1,51 @@
+#ifndef KERRTABLECACHE_H
+#define KERRTABLECACHE_H
+
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "../core/kerrtransfer.h"
+
+// Kerr 转移表的磁盘缓存和后台生成。生成一张表要追踪五十多万条测地线（单线程约半分钟），
+// 所以按键存到磁盘，之后同一自旋、相机位置直接读取；缓存里没有的表交给后台线程生成，
+// 生成期间 request 返回上一张表，由调用方决定是否使用。磁盘缓存有总大小上限，超出时按最近使用时间淘汰
+class KerrTableCache {
+public:
+    KerrTableCache();
+    ~KerrTableCache();
+    KerrTableCache(const KerrTableCache&) = delete;
+    KerrTableCache& operator=(const KerrTableCache&) = delete;
+
+    // 缓存目录，空字符串表示 QStandardPaths::CacheLocation 下的 kerr/
+    void setDirectory(const QString& dir);
+    QString directory() const;
+
+    // 返回 key 对应的表：磁盘上有时同步读取，否则后台生成，wait 为真时阻塞到生成完成；
+    // 生成期间返回最近一张可用的表（可能为空或键不同）
+    std::shared_ptr<const KerrTransferTable> request(const KerrTableKey& key, bool wait);
+
+private:
+    QString pathFor(const KerrTableKey& key) const;
+    void workerLoop();
+    void evict() const;
+
+    QString cacheDir;
+    std::shared_ptr<const KerrTransferTable> current;   // 只由调用 request 的线程访问
+
+    // 后台生成：总是生成最近一次请求的键，未开始的旧请求直接丢弃
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable built;
+    std::thread worker;
+    KerrTableKey wanted;
+    KerrTableKey buildingKey;
+    bool hasWanted = false;
+    bool building = false;
+    std::atomic<bool> stopping{false};
+    std::shared_ptr<const KerrTransferTable> finished;
+};
+
+#endif // KERRTABLECACHE_H
@@ -0,0 +1,287 @@
+#include "lensingmap.h"
+#include <QByteArray>
+#include <QFile>
+#include <QtEndian>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t kPage = 4096;
+
+size_t alignToPage(size_t bytes) {
+    return (bytes + kPage - 1) / kPage * kPage;
+}
+
+// OpenEXR 头的写入辅助，所有数值按小端存储
+void appendInt(QByteArray& out, int32_t value) {
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 4);
+}
+
+void appendFloat(QByteArray& out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    char bytes[4];
+    qToLittleEndian(bits, bytes);
+    out.append(bytes, 4);
+}
+
+void appendAttribute(QByteArray& out, const char* name, const char* type, const QByteArray& value) {
+    out.append(name, int(std::strlen(name)) + 1);
+    out.append(type, int(std::strlen(type)) + 1);
+    appendInt(out, int32_t(value.size()));
+    out.append(value);
+}
+
+QByteArray box2i(int width, int height) {
+    QByteArray value;
+    appendInt(value, 0);
+    appendInt(value, 0);
+    appendInt(value, width - 1);
+    appendInt(value, height - 1);
+    return value;
+}
+
+} // namespace
+
+LensingMapFile::~LensingMapFile() {
+    close();
+}
+
+bool LensingMapFile::fail(const QString& message) {
+    error = message;
+    close();
+    return false;
+}
+
+bool LensingMapFile::create(const QString& path, int width, int height, const BlackHoleFrameState& state) {
+    close();
+    if (width <= 0 || height <= 0) {
+        return fail(QString("Invalid lensing map size %1x%2").arg(width).arg(height));
+    }
+    const size_t planeBytes = size_t(width) * height * 4 * sizeof(float);
+    const size_t planeOffset = alignToPage(sizeof(LensingMapHeader));
+    const size_t planeStride = alignToPage(planeBytes);
+    mappingBytes = planeOffset + planeStride * kLensingMapPlanes;
+
+    const QByteArray file = path.toLocal8Bit();
+    fd = ::open(file.constData(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ::ftruncate(fd, off_t(mappingBytes)) != 0) {
+        return fail(QString("Cannot create %1: %2").arg(path, std::strerror(errno)));
+    }
+    void* ptr = ::mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        return fail(QString("Cannot map %1: %2").arg(path, std::strerror(errno)));
+    }
+    mapping = static_cast<uint8_t*>(ptr);
+    writable = true;
+
+    header = new (mapping) LensingMapHeader();
+    std::memcpy(header->magic, "BHLMAP01", 8);
+    header->version = kLensingMapVersion;
+    header->headerBytes = uint32_t(sizeof(LensingMapHeader));
+    header->width = uint32_t(width);
+    header->height = uint32_t(height);
+    header->planeCount = kLensingMapPlanes;
+    header->planeOffset = planeOffset;
+    header->planeStride = planeStride;
+    header->iTime = state.iTime;
+    header->iFrame = state.iFrame;
+    for (int i = 0; i < 4; ++i) {
+        header->iMouse[i] = state.iMouse[i];
+    }
+    header->blackHoleMass = state.blackHoleMass;
+    for (int i = 0; i < 3; ++i) {
+        header->diskNormal[i] = state.diskNormal[i];
+    }
+    header->cameraRadius = state.cameraRadius;
+    header->fov = state.fov;
+    return true;
+}
+
+bool LensingMapFile::open(const QString& path) {
+    close();
+    const QByteArray file = path.toLocal8Bit();
+    fd = ::open(file.constData(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || ::fstat(fd, &info) != 0) {
+        return fail(QString("Cannot open %1: %2").arg(path, std::strerror(errno)));
+    }
+    if (size_t(info.st_size) < sizeof(LensingMapHeader)) {
+        return fail(QString("%1 is not a lensing map").arg(path));
+    }
+    mappingBytes = size_t(info.st_size);
+    void* ptr = ::mmap(nullptr, mappingBytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        return fail(QString("Cannot map %1: %2").arg(path, std::strerror(errno)));
+    }
+    mapping = static_cast<uint8_t*>(ptr);
+    writable = false;
+    header = reinterpret_cast<LensingMapHeader*>(mapping);
+
+    if (std::memcmp(header->magic, "BHLMAP01", 8) != 0) {
+        return fail(QString("%1 is not a lensing map").arg(path));
+    }
+    if (header->version != kLensingMapVersion || header->headerBytes != sizeof(LensingMapHeader)) {
+        return fail(QString("%1: unsupported lensing map version %2").arg(path).arg(header->version));
+    }
+    const size_t planeBytes = size_t(header->width) * header->height * 4 * sizeof(float);
+    if (header->width == 0 || header->height == 0 || header->planeCount != uint32_t(kLensingMapPlanes) ||
+        header->planeOffset < sizeof(LensingMapHeader) || header->planeStride < planeBytes ||
+        header->planeOffset + header->planeStride * (kLensingMapPlanes - 1) + planeBytes > mappingBytes) {
+        return fail(QString("%1: truncated or corrupt lensing map").arg(path));
+    }
+    return true;
+}
+
+void LensingMapFile::close() {
+    if (mapping) {
+        if (writable) {
+            ::msync(mapping, mappingBytes, MS_ASYNC);
+        }
+        ::munmap(mapping, mappingBytes);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = -1;
+    mapping = nullptr;
+    mappingBytes = 0;
+    writable = false;
+    header = nullptr;
+}
+
+float* LensingMapFile::plane(int index) {
+    if (!writable || index < 0 || index >= kLensingMapPlanes) {
+        return nullptr;
+    }
+    return reinterpret_cast<float*>(mapping + header->planeOffset + header->planeStride * index);
+}
+
+const float* LensingMapFile::plane(int index) const {
+    if (!header || index < 0 || index >= kLensingMapPlanes) {
+        return nullptr;
+    }
+    return reinterpret_cast<const float*>(mapping + header->planeOffset + header->planeStride * index);
+}
+
+BlackHoleFrameState LensingMapFile::frameState() const {
+    BlackHoleFrameState state;
+    if (!header) {
+        return state;
+    }
+    state.iTime = header->iTime;
+    state.iFrame = header->iFrame;
+    state.iMouse = QVector4D(header->iMouse[0], header->iMouse[1], header->iMouse[2], header->iMouse[3]);
+    state.blackHoleMass = header->blackHoleMass;
+    state.diskNormal = QVector3D(header->diskNormal[0], header->diskNormal[1], header->diskNormal[2]);
+    state.cameraRadius = header->cameraRadius;
+    state.fov = header->fov;
+    return state;
+}
+
+bool writeLensingMapExr(const QString& path, const LensingMapFile& map, QString* error) {
+    if (!map.isOpen()) {
+        if (error) {
+            *error = "Lensing map is not open";
+        }
+        return false;
+    }
+    const int width = map.width();
+    const int height = map.height();
+
+    // OpenEXR 要求通道按名字（ASCII）排序；(平面, 分量)
+    struct Channel {
+        const char* name;
+        int plane;
+        int component;
+    };
+    const Channel channels[] = {
+        {"A", 0, 3}, {"B", 0, 2}, {"G", 0, 1}, {"R", 0, 0},
+        {"escape.x", 1, 0}, {"escape.y", 1, 1}, {"escape.z", 1, 2}, {"state", 1, 3},
+    };
+    const int channelCount = int(sizeof(channels) / sizeof(channels[0]));
+
+    QByteArray out;
+    appendInt(out, 20000630);   // magic
+    appendInt(out, 2);          // 版本2，单部分扫描线
+
+    QByteArray channelList;
+    for (const Channel& channel : channels) {
+        channelList.append(channel.name, int(std::strlen(channel.name)) + 1);
+        appendInt(channelList, 2);                    // FLOAT
+        channelList.append(QByteArray(4, '\0'));      // pLinear + 保留
+        appendInt(channelList, 1);                    // xSampling
+        appendInt(channelList, 1);                    // ySampling
+    }
+    channelList.append('\0');
+    appendAttribute(out, "channels", "chlist", channelList);
+    appendAttribute(out, "compression", "compression", QByteArray(1, '\0'));   // NO_COMPRESSION
+    appendAttribute(out, "dataWindow", "box2i", box2i(width, height));
+    appendAttribute(out, "displayWindow", "box2i", box2i(width, height));
+    appendAttribute(out, "lineOrder", "lineOrder", QByteArray(1, '\0'));       // INCREASING_Y
+    QByteArray value;
+    appendFloat(value, 1.0f);
+    appendAttribute(out, "pixelAspectRatio", "float", value);
+    value.clear();
+    appendFloat(value, 0.0f);
+    appendFloat(value, 0.0f);
+    appendAttribute(out, "screenWindowCenter", "v2f", value);
+    value.clear();
+    appendFloat(value, 1.0f);
+    appendAttribute(out, "screenWindowWidth", "float", value);
+    out.append('\0');
+
+    // 偏移表：不压缩时每个块是一行
+    const int64_t rowBytes = int64_t(width) * channelCount * 4;
+    const int64_t firstRow = out.size() + int64_t(height) * 8;
+    for (int y = 0; y < height; ++y) {
+        char bytes[8];
+        qToLittleEndian(uint64_t(firstRow + y * (rowBytes + 8)), bytes);
+        out.append(bytes, 8);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = QString("Cannot write %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+    if (file.write(out) != out.size()) {
+        if (error) {
+            *error = QString("Cannot write %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+
+    // EXR 的 y 向下，映射按OpenGL行序自下而上
+    QByteArray row;
+    row.reserve(int(rowBytes + 8));
+    for (int y = 0; y < height; ++y) {
+        row.clear();
+        appendInt(row, y);
+        appendInt(row, int32_t(rowBytes));
+        const size_t source = size_t(height - 1 - y) * width * 4;
+        for (const Channel& channel : channels) {
+            const float* pixels = map.plane(channel.plane) + source + channel.component;
+            for (int x = 0; x < width; ++x) {
+                appendFloat(row, pixels[size_t(x) * 4]);
+            }
+        }
+        if (file.write(row) != row.size()) {
+            if (error) {
+                *error = QString("Cannot write %1: %2").arg(path, file.errorString());
+            }
+            return false;
+        }
+    }
+    return true;
+}
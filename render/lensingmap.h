@@ -0,0 +1,83 @@
+#ifndef LENSINGMAP_H
+#define LENSINGMAP_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include "blackholerenderer.h"
+
+// 平面1 w 分量的终止状态，与 blackhole.glsl 的 kLensing* 一致
+enum class LensingState : uint32_t {
+    Captured = 0,   // 落入视界、被不透明的盘挡住或步数用完，不取背景
+    Escaped = 1,    // 逃逸到背景，xyz 为相机系中的逃逸方向
+    Outside = 2,    // 分块保护带超出整幅图像的像素
+};
+
+// 透镜映射文件布局（小端），读取方以只读方式映射即可直接使用，多个进程可共享同一份映射
+// [LensingMapHeader | 填充到 planeOffset] [平面0] [平面1]，平面间隔 planeStride（4096对齐）
+// 每个平面 width * height 个 RGBA32F，按OpenGL行序（自下而上）：
+//   平面0：吸积盘颜色（未叠加背景，未做bloom逆处理），a 为吸积盘覆盖度
+//   平面1：xyz 为相机系中的逃逸方向，w 为 LensingState
+struct LensingMapHeader {
+    char magic[8];              // "BHLMAP01"
+    uint32_t version;           // kLensingMapVersion
+    uint32_t headerBytes;       // sizeof(LensingMapHeader)
+    uint32_t width;
+    uint32_t height;
+    uint32_t planeCount;        // 2
+    uint32_t reserved0;
+    uint64_t planeOffset;       // 平面0的文件偏移
+    uint64_t planeStride;       // 相邻平面的间隔
+    // 生成时的帧参数，换背景时据此恢复相机（BackgroundColor 和天空都需要相机朝向）
+    float iTime;
+    int32_t iFrame;
+    float iMouse[4];
+    float blackHoleMass;
+    float diskNormal[3];
+    float cameraRadius;
+    float fov;
+    uint32_t reserved[16];
+};
+
+const uint32_t kLensingMapVersion = 1;
+const int kLensingMapPlanes = 2;
+
+class LensingMapFile {
+public:
+    LensingMapFile() = default;
+    ~LensingMapFile();
+    LensingMapFile(const LensingMapFile&) = delete;
+    LensingMapFile& operator=(const LensingMapFile&) = delete;
+
+    // 新建 width x height 的映射文件并以读写方式映射，平面由调用方填入
+    bool create(const QString& path, int width, int height, const BlackHoleFrameState& state);
+    // 以只读方式映射已有文件，检查 magic、版本和文件大小
+    bool open(const QString& path);
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+    int width() const { return header ? int(header->width) : 0; }
+    int height() const { return header ? int(header->height) : 0; }
+    const LensingMapHeader* fileHeader() const { return header; }
+    // 第 index 个平面的 width * height * 4 个float；只读映射时可写版本返回nullptr
+    float* plane(int index);
+    const float* plane(int index) const;
+    // 生成时的帧参数（imageSize 为空，即整幅图像）
+    BlackHoleFrameState frameState() const;
+    QString errorString() const { return error; }
+
+private:
+    bool fail(const QString& message);
+
+    int fd = -1;
+    uint8_t* mapping = nullptr;
+    size_t mappingBytes = 0;
+    bool writable = false;
+    LensingMapHeader* header = nullptr;
+    QString error;
+};
+
+// 写成未压缩的单部分扫描线OpenEXR（32位float）：R G B A 为平面0，escape.x/y/z 和 state 为平面1
+bool writeLensingMapExr(const QString& path, const LensingMapFile& map, QString* error = nullptr);
+
+#endif // LENSINGMAP_H
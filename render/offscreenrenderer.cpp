@@ -0,0 +1,83 @@
+#include "offscreenrenderer.h"
+#include <QDebug>
+#include <QSurfaceFormat>
+#include <algorithm>
+
+OffscreenRenderer::~OffscreenRenderer() {
+    if (context.isValid()) {
+        context.makeCurrent(&surface);
+        delete finalTarget;
+        finalTarget = nullptr;
+    }
+    // renderer 成员先于 context 析构，此时上下文仍为当前上下文
+}
+
+bool OffscreenRenderer::create(const QString& shaderDir) {
+    QSurfaceFormat fmt;
+    fmt.setVersion(4, 3);
+    fmt.setProfile(QSurfaceFormat::CoreProfile);
+
+    surface.setFormat(fmt);
+    surface.create();
+
+    context.setFormat(fmt);
+    if (!context.create()) {
+        qCritical() << "Failed to create OpenGL 4.3 context";
+        return false;
+    }
+    if (!context.makeCurrent(&surface)) {
+        qCritical() << "Failed to make offscreen context current";
+        return false;
+    }
+    initializeOpenGLFunctions();
+
+    // FBO最大尺寸受纹理和渲染缓冲双重限制
+    GLint maxTexture = 0;
+    GLint maxRenderbuffer = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexture);
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbuffer);
+    maxSize = std::min(maxTexture, maxRenderbuffer);
+
+    qInfo() << "OpenGL renderer:" << reinterpret_cast<const char*>(glGetString(GL_RENDERER))
+            << reinterpret_cast<const char*>(glGetString(GL_VERSION));
+
+    return renderer.initialize(shaderDir);
+}
+
+void OffscreenRenderer::resize(int w, int h) {
+    if (finalTarget && finalTarget->width() == w && finalTarget->height() == h &&
+        finalTarget->format().internalTextureFormat() == targetFormat) {
+        return;
+    }
+    delete finalTarget;
+
+    QOpenGLFramebufferObjectFormat format;
+    format.setSamples(0);
+    format.setInternalTextureFormat(targetFormat);
+    finalTarget = new QOpenGLFramebufferObject(w, h, format);
+    renderer.resize(w, h);
+}
+
+void OffscreenRenderer::renderFrame(const BlackHoleFrameState& state) {
+    if (cubemapFaceSize > 0) {
+        renderer.renderEquirect(state, cubemapFaceSize, finalTarget->handle());
+        return;
+    }
+    renderer.render(state, finalTarget->handle());
+}
+
+void OffscreenRenderer::renderLensingMap(int backgroundType) {
+    renderer.renderLensingMap(backgroundType, finalTarget->handle());
+}
+
+bool OffscreenRenderer::readScene(float* rgba) {
+    const GLuint sceneFbo = renderer.sceneFramebuffer();
+    if (!sceneFbo) {
+        return false;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, renderer.width(), renderer.height(), GL_RGBA, GL_FLOAT, rgba);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    return true;
+}
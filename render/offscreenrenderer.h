@@ -0,0 +1,43 @@
+#ifndef OFFSCREENRENDERER_H
+#define OFFSCREENRENDERER_H
+
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_4_3_Core>
+#include "blackholerenderer.h"
+
+// 无窗口渲染：在QOffscreenSurface上创建4.3核心上下文，驱动BlackHoleRenderer渲染到FBO
+class OffscreenRenderer : protected QOpenGLFunctions_4_3_Core {
+public:
+    OffscreenRenderer() = default;
+    ~OffscreenRenderer();
+
+    bool create(const QString& shaderDir);
+    // 最终目标的内部格式，需在resize之前设置（默认GL_RGBA8）
+    void setTargetFormat(GLenum internalFormat) { targetFormat = internalFormat; }
+    void resize(int w, int h);
+    // 大于0时renderFrame输出等距柱状全景，六个立方体面各为 size x size
+    void setCubemapFaceSize(int size) { cubemapFaceSize = size; }
+    void renderFrame(const BlackHoleFrameState& state);
+    // 对已载入的透镜映射叠加背景（BlackHoleRenderer::loadLensingMap），不做raymarching
+    void renderLensingMap(int backgroundType);
+    // 同步读回上一帧circle通道的输出（width * height * 4 个float，自下而上），用于与CPU移植对比
+    bool readScene(float* rgba);
+
+    int maxTargetSize() const { return maxSize; }
+    QOpenGLContext* glContext() { return &context; }
+    QOpenGLFramebufferObject* target() { return finalTarget; }
+    BlackHoleRenderer& blackHoleRenderer() { return renderer; }
+
+private:
+    QOffscreenSurface surface;
+    QOpenGLContext context;
+    QOpenGLFramebufferObject* finalTarget = nullptr;
+    BlackHoleRenderer renderer;
+    GLenum targetFormat = GL_RGBA8;
+    int cubemapFaceSize = 0;
+    int maxSize = 0;
+};
+
+#endif // OFFSCREENRENDERER_H
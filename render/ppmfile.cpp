@@ -0,0 +1,42 @@
+#include "ppmfile.h"
+#include <QDebug>
+
+bool PpmFile::open(const QString& path, int width, int height) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot open" << path << file.errorString();
+        return false;
+    }
+    const QByteArray header = QByteArray("P6\n") + QByteArray::number(width) + ' ' +
+                              QByteArray::number(height) + "\n255\n";
+    headerBytes = header.size();
+    imageWidth = width;
+    imageHeight = height;
+    file.write(header);
+    // 预先设定文件大小，之后各区域按行seek写入
+    if (!file.resize(headerBytes + qint64(width) * height * 3)) {
+        qWarning() << "Cannot allocate" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool PpmFile::writeRegion(const QRect& rect, const uchar* rows) {
+    const qint64 rowBytes = qint64(rect.width()) * 3;
+    // 读回的行自下而上，PPM自上而下
+    for (int row = 0; row < rect.height(); ++row) {
+        const qint64 fileRow = imageHeight - 1 - (rect.y() + row);
+        const qint64 offset = headerBytes + (fileRow * imageWidth + rect.x()) * 3;
+        if (!file.seek(offset) ||
+            file.write(reinterpret_cast<const char*>(rows) + row * rowBytes, rowBytes) != rowBytes) {
+            qWarning() << "Failed to write region at" << rect.x() << rect.y() << "to" << file.fileName()
+                       << file.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+void PpmFile::close() {
+    file.close();
+}
@@ -0,0 +1,27 @@
+#ifndef PPMFILE_H
+#define PPMFILE_H
+
+#include <QFile>
+#include <QRect>
+#include <QString>
+
+// 可随机写入的二进制PPM（P6，8位RGB）：文件先按整幅尺寸分配，之后按区域逐行seek写入
+// 用于分块结果的拼接，内存中只需要保留一块
+class PpmFile {
+public:
+    bool open(const QString& path, int width, int height);
+    // rect 为OpenGL坐标（y向上），rows 为自下而上的紧密RGB行
+    bool writeRegion(const QRect& rect, const uchar* rows);
+    void close();
+
+    QString errorString() const { return file.errorString(); }
+    QString fileName() const { return file.fileName(); }
+
+private:
+    QFile file;
+    qint64 headerBytes = 0;
+    int imageWidth = 0;
+    int imageHeight = 0;
+};
+
+#endif // PPMFILE_H
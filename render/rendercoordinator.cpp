@@ -0,0 +1,341 @@
+#include "rendercoordinator.h"
+#include "tiledrenderer.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <algorithm>
+
+namespace {
+
+// 每个工作进程最多同时持有的工作项：一个在渲染，一个在排队，避免往返延迟造成空闲
+const int kPrefetchDepth = 2;
+// 每块实际追踪的面积（含保护带）超过核心区域的这个倍数时提醒换更大的块
+const double kMaxTileOverhead = 4.0;
+
+} // namespace
+
+RenderCoordinator::RenderCoordinator(const RenderSetup& renderSetup, int framesPerItem, const QString& outputDir,
+                                     const QString& prefix, QObject* parent)
+    : QObject(parent), setup(renderSetup), outputDir(outputDir), prefix(prefix) {
+    const BatchJob& job = setup.job;
+    quint32 id = 0;
+    if (setup.mode == DistributedMode::Tiles) {
+        if (setup.tileSize <= 0) {
+            setup.tileSize = TiledRenderer::defaultTileSize(QSize(job.width, job.height));
+        }
+        // 与TiledRenderer相同的对齐，保证各块bloom在接缝处一致
+        setup.tileSize = std::max(TiledRenderer::alignment(),
+                                  setup.tileSize / TiledRenderer::alignment() * TiledRenderer::alignment());
+        const int tileSize = setup.tileSize;
+        const double traced = double(tileSize + 2 * TiledRenderer::guardBand()) / tileSize;
+        if (traced * traced > kMaxTileOverhead) {
+            qWarning() << "Tile size" << tileSize << "traces" << traced * traced << "times the core area with the"
+                       << TiledRenderer::guardBand() << "pixel guard band, use a larger --tile";
+        }
+        const int tilesX = (job.width + tileSize - 1) / tileSize;
+        const int tilesY = (job.height + tileSize - 1) / tileSize;
+        for (int frame = 0; frame < job.frames; ++frame) {
+            frameOutputs[frame].remaining = tilesX * tilesY;
+            for (int ty = 0; ty < tilesY; ++ty) {
+                for (int tx = 0; tx < tilesX; ++tx) {
+                    WorkItem item;
+                    item.id = id++;
+                    item.frame = frame;
+                    item.core = QRect(tx * tileSize, ty * tileSize, std::min(tileSize, job.width - tx * tileSize),
+                                      std::min(tileSize, job.height - ty * tileSize));
+                    queue.enqueue(item);
+                }
+            }
+        }
+    } else {
+        framesPerItem = std::max(1, framesPerItem);
+        for (int frame = 0; frame < job.frames; frame += framesPerItem) {
+            WorkItem item;
+            item.id = id++;
+            item.frame = frame;
+            item.frameCount = std::min(framesPerItem, job.frames - frame);
+            item.core = QRect(0, 0, job.width, job.height);
+            queue.enqueue(item);
+            for (int i = 0; i < item.frameCount; ++i) {
+                frameOutputs[frame + i].remaining = 1;
+            }
+        }
+    }
+    totalItems = queue.size();
+
+    connect(&timeoutTimer, &QTimer::timeout, this, &RenderCoordinator::checkTimeouts);
+    timeoutTimer.start(5000);
+    elapsed.start();
+    idleSince.start();
+}
+
+RenderCoordinator::~RenderCoordinator() {
+    for (QProcess* process : processes) {
+        if (process->state() != QProcess::NotRunning && !process->waitForFinished(5000)) {
+            process->kill();
+            process->waitForFinished();
+        }
+    }
+    for (FrameOutput& output : frameOutputs) {
+        delete output.file;
+    }
+    qDeleteAll(workers);
+}
+
+bool RenderCoordinator::listen(const QString& address) {
+    if (address.startsWith("local:")) {
+        const QString name = address.mid(6);
+        QLocalServer::removeServer(name);
+        localServer = new QLocalServer(this);
+        if (!localServer->listen(name)) {
+            qWarning() << "Cannot listen on" << address << localServer->errorString();
+            return false;
+        }
+        connect(localServer, &QLocalServer::newConnection, this, [this]() {
+            while (QLocalSocket* socket = localServer->nextPendingConnection()) {
+                addWorker(new RenderConnection(socket, this));
+            }
+        });
+        workerAddress = "local:" + localServer->fullServerName();
+    } else if (address.startsWith("tcp:")) {
+        tcpServer = new QTcpServer(this);
+        if (!tcpServer->listen(QHostAddress::Any, quint16(address.mid(4).toUInt()))) {
+            qWarning() << "Cannot listen on" << address << tcpServer->errorString();
+            return false;
+        }
+        connect(tcpServer, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket* socket = tcpServer->nextPendingConnection()) {
+                addWorker(new RenderConnection(socket, this));
+            }
+        });
+        workerAddress = QString("tcp:127.0.0.1:%1").arg(tcpServer->serverPort());
+    } else {
+        qWarning() << "Unknown listen address" << address << "(expected local:NAME or tcp:PORT)";
+        return false;
+    }
+    qInfo() << "Coordinator waiting for workers on" << workerAddress << "with" << totalItems << "work items";
+    return true;
+}
+
+void RenderCoordinator::spawnLocalWorkers(int count, const QStringList& arguments) {
+    for (int i = 0; i < count; ++i) {
+        QProcess* process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this, i](int exitCode, QProcess::ExitStatus status) {
+            if (done) {
+                return;
+            }
+            qWarning() << "Local worker" << i << "exited with code" << exitCode
+                       << (status == QProcess::CrashExit ? "(crashed)" : "");
+            bool anyRunning = false;
+            for (QProcess* other : processes) {
+                anyRunning = anyRunning || other->state() != QProcess::NotRunning;
+            }
+            if (!anyRunning && workers.isEmpty()) {
+                fail("all local workers exited");
+            }
+        });
+        processes.append(process);
+        process->start(QCoreApplication::applicationFilePath(), QStringList{"--worker", workerAddress} + arguments);
+    }
+}
+
+void RenderCoordinator::addWorker(RenderConnection* connection) {
+    Worker* worker = new Worker();
+    worker->connection = connection;
+    workers.append(worker);
+    connect(connection, &RenderConnection::messageReceived, this, [this, worker](quint8 type, const QByteArray& payload) {
+        onMessage(worker, type, payload);
+    });
+    connect(connection, &RenderConnection::closed, this, [this, worker]() {
+        removeWorker(worker, "connection closed");
+    });
+}
+
+void RenderCoordinator::onMessage(Worker* worker, quint8 type, const QByteArray& payload) {
+    QDataStream in(payload);
+    switch (type) {
+    case RenderProtocol::Hello: {
+        quint32 version = 0;
+        in >> version;
+        if (version != RenderProtocol::kVersion) {
+            removeWorker(worker, QString("protocol version %1").arg(version));
+            return;
+        }
+        worker->connection->send(RenderProtocol::Setup, setup);
+        worker->ready = true;
+        qInfo() << "Worker connected," << workers.size() << "active";
+        dispatch();
+        break;
+    }
+    case RenderProtocol::Result: {
+        WorkResult result;
+        in >> result;
+        if (in.status() != QDataStream::Ok ||
+            result.pixels.size() != qint64(result.rect.width()) * result.rect.height() * 3) {
+            removeWorker(worker, "malformed result");
+            return;
+        }
+        writeResult(result);
+        break;
+    }
+    case RenderProtocol::WorkDone: {
+        quint32 id = 0;
+        in >> id;
+        for (int i = 0; i < worker->assigned.size(); ++i) {
+            if (worker->assigned[i].id == id) {
+                worker->assigned.removeAt(i);
+                completedItems++;
+                break;
+            }
+        }
+        worker->busySince.restart();
+        qInfo() << completedItems << "/" << totalItems << "work items done," << elapsed.elapsed() / 1000.0 << "s";
+        if (completedItems == totalItems) {
+            finish();
+            return;
+        }
+        dispatch();
+        break;
+    }
+    case RenderProtocol::WorkFailed: {
+        quint32 id = 0;
+        QString reason;
+        in >> id >> reason;
+        // 工作进程自身的问题（如尺寸超限）重试也无济于事，但换一个进程可能成功，交给重试计数处理
+        removeWorker(worker, QString("work item %1 failed: %2").arg(id).arg(reason));
+        break;
+    }
+    default:
+        removeWorker(worker, QString("unexpected message type %1").arg(type));
+        break;
+    }
+}
+
+void RenderCoordinator::removeWorker(Worker* worker, const QString& reason) {
+    if (!workers.removeOne(worker)) {
+        return;
+    }
+    if (!done) {
+        qWarning() << "Dropping worker:" << reason;
+    }
+    // 未完成的工作项放回队首重新分配
+    for (int i = worker->assigned.size() - 1; i >= 0; --i) {
+        WorkItem item = worker->assigned[i];
+        item.attempts++;
+        if (item.attempts >= maxAttempts) {
+            fail(QString("work item %1 (frame %2) failed %3 times").arg(item.id).arg(item.frame).arg(item.attempts));
+            break;
+        }
+        queue.prepend(item);
+    }
+    worker->connection->disconnect(this);
+    worker->connection->close();
+    worker->connection->deleteLater();
+    delete worker;
+    dispatch();
+}
+
+void RenderCoordinator::writeResult(const WorkResult& result) {
+    auto it = frameOutputs.find(result.frame);
+    if (it == frameOutputs.end() || it->remaining == 0) {
+        return;  // 该帧已完整写出，重试产生的重复结果
+    }
+    FrameOutput& output = *it;
+    if (!output.file) {
+        output.file = new PpmFile();
+        const QString path = QDir(outputDir).filePath(
+            QString("%1_%2.ppm").arg(prefix).arg(result.frame, 4, 10, QChar('0')));
+        if (!output.file->open(path, setup.job.width, setup.job.height)) {
+            fail("cannot create " + path);
+            return;
+        }
+    }
+    if (!output.file->writeRegion(result.rect, reinterpret_cast<const uchar*>(result.pixels.constData()))) {
+        fail("cannot write " + output.file->fileName());
+        return;
+    }
+    const quint64 key = (quint64(quint32(result.frame)) << 32) | result.id;
+    if (!writtenRegions.contains(key)) {
+        writtenRegions.insert(key);
+        if (--output.remaining == 0) {
+            output.file->close();
+            delete output.file;
+            output.file = nullptr;
+        }
+    }
+}
+
+void RenderCoordinator::dispatch() {
+    if (done) {
+        return;
+    }
+    // 轮流给每个工作进程补一个工作项，直到预取深度或队列耗尽
+    bool assigned = true;
+    while (assigned && !queue.isEmpty()) {
+        assigned = false;
+        for (Worker* worker : workers) {
+            if (queue.isEmpty()) {
+                break;
+            }
+            if (!worker->ready || worker->assigned.size() >= kPrefetchDepth) {
+                continue;
+            }
+            const WorkItem item = queue.dequeue();
+            if (worker->assigned.isEmpty()) {
+                worker->busySince.restart();
+            }
+            worker->assigned.append(item);
+            worker->connection->send(RenderProtocol::Work, item);
+            assigned = true;
+        }
+    }
+}
+
+void RenderCoordinator::checkTimeouts() {
+    const QList<Worker*> snapshot = workers;
+    for (Worker* worker : snapshot) {
+        if (!worker->assigned.isEmpty() && worker->busySince.isValid() &&
+            worker->busySince.elapsed() > workTimeoutMs) {
+            removeWorker(worker, QString("work item %1 timed out").arg(worker->assigned.first().id));
+        }
+    }
+    if (!workers.isEmpty()) {
+        idleSince.invalidate();
+    } else if (!idleSince.isValid()) {
+        idleSince.start();
+    } else if (idleSince.elapsed() > idleTimeoutMs) {
+        fail(QString("no workers connected for %1 s").arg(idleSince.elapsed() / 1000));
+    }
+}
+
+void RenderCoordinator::fail(const QString& reason) {
+    if (done) {
+        return;
+    }
+    qWarning() << "Distributed render failed:" << reason;
+    done = true;
+    for (Worker* worker : workers) {
+        worker->connection->send(RenderProtocol::Shutdown);
+        worker->connection->flush();
+    }
+    emit finished(false);
+}
+
+void RenderCoordinator::finish() {
+    done = true;
+    for (Worker* worker : workers) {
+        worker->connection->send(RenderProtocol::Shutdown);
+        worker->connection->flush();
+    }
+    const double seconds = elapsed.elapsed() / 1000.0;
+    qInfo() << "Rendered" << setup.job.frames << "frames in" << seconds << "s ("
+            << setup.job.frames / seconds << "fps)";
+    emit finished(true);
+}
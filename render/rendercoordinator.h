@@ -0,0 +1,84 @@
+#ifndef RENDERCOORDINATOR_H
+#define RENDERCOORDINATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QSet>
+#include <QTimer>
+#include "renderprotocol.h"
+#include "ppmfile.h"
+
+class QLocalServer;
+class QTcpServer;
+class QProcess;
+
+// 分布式渲染的协调进程：把动画切成块或帧区间派给工作进程，按区域拼回PPM，失败的工作项重新排队
+// 不需要OpenGL上下文；工作进程可以是本机派生的子进程，也可以是远程主机上手动启动的 --worker
+class RenderCoordinator : public QObject {
+    Q_OBJECT
+public:
+    RenderCoordinator(const RenderSetup& setup, int framesPerItem, const QString& outputDir, const QString& prefix,
+                      QObject* parent = nullptr);
+    ~RenderCoordinator();
+
+    // address: "local:名称" 或 "tcp:端口"
+    bool listen(const QString& address);
+    // 在本机启动 count 个工作进程，arguments 附加在 --worker <地址> 之后
+    void spawnLocalWorkers(int count, const QStringList& arguments);
+
+    void setMaxAttempts(int attempts) { maxAttempts = attempts; }
+    void setWorkTimeout(int seconds) { workTimeoutMs = qint64(seconds) * 1000; }
+    // 连续这么久没有任何工作进程连接时渲染失败，只有远程工作进程时不会一直等下去
+    void setIdleTimeout(int seconds) { idleTimeoutMs = qint64(seconds) * 1000; }
+
+signals:
+    void finished(bool ok);
+
+private:
+    struct Worker {
+        RenderConnection* connection = nullptr;
+        QList<WorkItem> assigned;     // 第一个为正在渲染的工作项
+        QElapsedTimer busySince;
+        bool ready = false;
+    };
+    struct FrameOutput {
+        PpmFile* file = nullptr;
+        int remaining = 0;
+    };
+
+    void addWorker(RenderConnection* connection);
+    void onMessage(Worker* worker, quint8 type, const QByteArray& payload);
+    void removeWorker(Worker* worker, const QString& reason);
+    void writeResult(const WorkResult& result);
+    void dispatch();
+    void checkTimeouts();
+    void fail(const QString& reason);
+    void finish();
+
+    RenderSetup setup;
+    QString outputDir;
+    QString prefix;
+    QLocalServer* localServer = nullptr;
+    QTcpServer* tcpServer = nullptr;
+    QString workerAddress;
+    QList<QProcess*> processes;
+
+    QQueue<WorkItem> queue;
+    QList<Worker*> workers;
+    QHash<int, FrameOutput> frameOutputs;
+    QSet<quint64> writtenRegions;   // (帧, 工作项) 已写入，重试产生的重复结果不重复计数
+    int totalItems = 0;
+    int completedItems = 0;
+    int maxAttempts = 3;
+    qint64 workTimeoutMs = 600000;
+    qint64 idleTimeoutMs = 300000;
+    bool done = false;
+    QTimer timeoutTimer;
+    QElapsedTimer elapsed;
+    QElapsedTimer idleSince;   // 最后一个工作进程断开（或开始监听）的时间，有连接时无效
+};
+
+#endif // RENDERCOORDINATOR_H
@@ -0,0 +1,171 @@
+#include "renderprotocol.h"
+#include <QDebug>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QVector>
+#include <QPair>
+#include <QtEndian>
+
+QDataStream& operator<<(QDataStream& out, const RenderSetup& setup) {
+    const BatchJob& job = setup.job;
+    out << RenderProtocol::kVersion << quint8(setup.mode) << qint32(setup.tileSize);
+    out << job.name << qint32(job.width) << qint32(job.height) << qint32(job.frames) << job.timestep
+        << job.startTime << job.mass << job.diskNormal << job.cameraRadius << job.cameraTheta << job.cameraPhi
+        << qint32(job.backgroundType);
+    const RendererSettings& renderer = setup.renderer;
+    out << renderer.spin << quint8(renderer.integrator) << renderer.tolerance << qint32(renderer.maxSteps)
+        << quint8(renderer.debugView) << renderer.disk << quint8(renderer.noise) << renderer.wavefront
+        << renderer.deflectionTable << renderer.geodesicCache;
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, RenderSetup& setup) {
+    BatchJob& job = setup.job;
+    quint32 version = 0;
+    quint8 mode = 0;
+    qint32 tileSize = 0, width = 0, height = 0, frames = 0, background = 0;
+    in >> version;
+    if (version != RenderProtocol::kVersion) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+    in >> mode >> tileSize;
+    in >> job.name >> width >> height >> frames >> job.timestep >> job.startTime >> job.mass >> job.diskNormal
+       >> job.cameraRadius >> job.cameraTheta >> job.cameraPhi >> background;
+    RendererSettings& renderer = setup.renderer;
+    quint8 integrator = 0, debugView = 0, noise = 0;
+    qint32 maxSteps = 0;
+    in >> renderer.spin >> integrator >> renderer.tolerance >> maxSteps >> debugView >> renderer.disk >> noise >>
+        renderer.wavefront >> renderer.deflectionTable >> renderer.geodesicCache;
+    renderer.integrator = GeodesicIntegrator(integrator);
+    renderer.maxSteps = maxSteps;
+    renderer.debugView = DebugView(debugView);
+    renderer.noise = DiskNoiseQuality(noise);
+    setup.mode = DistributedMode(mode);
+    setup.tileSize = tileSize;
+    job.width = width;
+    job.height = height;
+    job.frames = frames;
+    job.backgroundType = background;
+    return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const WorkItem& item) {
+    return out << item.id << qint32(item.frame) << qint32(item.frameCount) << item.core;
+}
+
+QDataStream& operator>>(QDataStream& in, WorkItem& item) {
+    qint32 frame = 0, frameCount = 0;
+    in >> item.id >> frame >> frameCount >> item.core;
+    item.frame = frame;
+    item.frameCount = frameCount;
+    return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const WorkResult& result) {
+    return out << result.id << qint32(result.frame) << result.rect << result.pixels;
+}
+
+QDataStream& operator>>(QDataStream& in, WorkResult& result) {
+    qint32 frame = 0;
+    in >> result.id >> frame >> result.rect >> result.pixels;
+    result.frame = frame;
+    return in;
+}
+
+RenderConnection::RenderConnection(QLocalSocket* socket, QObject* parent) : QObject(parent), device(socket) {
+    socket->setParent(this);
+    connect(socket, &QLocalSocket::readyRead, this, &RenderConnection::readMessages);
+    connect(socket, &QLocalSocket::disconnected, this, &RenderConnection::closed);
+}
+
+RenderConnection::RenderConnection(QTcpSocket* socket, QObject* parent) : QObject(parent), device(socket) {
+    socket->setParent(this);
+    // 结果消息很大，关闭Nagle只影响小的控制消息
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QTcpSocket::readyRead, this, &RenderConnection::readMessages);
+    connect(socket, &QTcpSocket::disconnected, this, &RenderConnection::closed);
+}
+
+RenderConnection* RenderConnection::connectTo(const QString& address, int timeoutMs, QObject* parent) {
+    if (address.startsWith("local:")) {
+        QLocalSocket* socket = new QLocalSocket();
+        socket->connectToServer(address.mid(6));
+        if (!socket->waitForConnected(timeoutMs)) {
+            qWarning() << "Cannot connect to" << address << socket->errorString();
+            delete socket;
+            return nullptr;
+        }
+        return new RenderConnection(socket, parent);
+    }
+    if (address.startsWith("tcp:")) {
+        const QString hostPort = address.mid(4);
+        const int colon = hostPort.lastIndexOf(':');
+        QTcpSocket* socket = new QTcpSocket();
+        socket->connectToHost(hostPort.left(colon), quint16(hostPort.mid(colon + 1).toUInt()));
+        if (colon <= 0 || !socket->waitForConnected(timeoutMs)) {
+            qWarning() << "Cannot connect to" << address << socket->errorString();
+            delete socket;
+            return nullptr;
+        }
+        return new RenderConnection(socket, parent);
+    }
+    qWarning() << "Unknown address" << address << "(expected local:NAME or tcp:HOST:PORT)";
+    return nullptr;
+}
+
+void RenderConnection::sendRaw(RenderProtocol::MessageType type, const QByteArray& payload) {
+    uchar header[5];
+    qToBigEndian<quint32>(quint32(payload.size() + 1), header);
+    header[4] = type;
+    device->write(reinterpret_cast<const char*>(header), sizeof(header));
+    device->write(payload);
+}
+
+void RenderConnection::readMessages() {
+    if (corrupted) {
+        device->readAll();
+        return;
+    }
+    buffer.append(device->readAll());
+    // 先把完整消息全部取出再发信号，处理函数里的waitFor*可能重入本函数
+    QVector<QPair<quint8, QByteArray>> messages;
+    int consumed = 0;
+    while (buffer.size() - consumed >= 5) {
+        const quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(buffer.constData() + consumed));
+        // 长度至少包含类型字节；超过上限的长度说明流已失步，不能再按帧解析
+        if (length == 0 || length > RenderProtocol::kMaxMessage) {
+            qWarning() << "Invalid message length" << length << "- closing the connection";
+            corrupted = true;
+            buffer.clear();
+            close();
+            return;
+        }
+        if (quint32(buffer.size() - consumed - 4) < length) {
+            break;
+        }
+        messages.append(qMakePair(quint8(buffer.at(consumed + 4)), buffer.mid(consumed + 5, int(length) - 1)));
+        consumed += 4 + int(length);
+    }
+    buffer.remove(0, consumed);
+    for (const auto& message : messages) {
+        emit messageReceived(message.first, message.second);
+    }
+}
+
+void RenderConnection::close() {
+    if (QLocalSocket* local = qobject_cast<QLocalSocket*>(device)) {
+        local->disconnectFromServer();
+    } else if (QTcpSocket* tcp = qobject_cast<QTcpSocket*>(device)) {
+        tcp->disconnectFromHost();
+    }
+}
+
+bool RenderConnection::isOpen() const {
+    return device->isOpen();
+}
+
+void RenderConnection::flush() {
+    while (device->bytesToWrite() > 0 && device->waitForBytesWritten(30000)) {
+    }
+}
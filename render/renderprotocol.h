@@ -0,0 +1,105 @@
+#ifndef RENDERPROTOCOL_H
+#define RENDERPROTOCOL_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QDataStream>
+#include <QRect>
+#include "batchrunner.h"
+
+class QIODevice;
+class QLocalSocket;
+class QTcpSocket;
+
+// 协调进程与渲染进程之间的消息，帧格式：quint32 长度 + quint8 类型 + QDataStream负载
+namespace RenderProtocol {
+
+enum MessageType : quint8 {
+    Hello = 1,      // worker -> coordinator
+    Setup,          // coordinator -> worker：RenderSetup，连接后发送一次
+    Work,           // coordinator -> worker：WorkItem
+    Result,         // worker -> coordinator：WorkResult，帧区间模式下每帧一个
+    WorkDone,       // worker -> coordinator：quint32 id
+    WorkFailed,     // worker -> coordinator：quint32 id + QString 原因
+    Shutdown        // coordinator -> worker
+};
+
+const quint32 kVersion = 2;   // 2：Setup 带渲染器设置
+// 长度字段（类型 + 负载）的上限：最大的消息是整帧结果，16384x16384 的RGB8为768 MiB
+const quint32 kMaxMessage = 1u << 30;
+
+} // namespace RenderProtocol
+
+enum class DistributedMode : quint8 {
+    Tiles = 0,    // 每个工作项是某一帧的一块（带bloom保护带），适合超大分辨率
+    Frames = 1,   // 每个工作项是连续的若干整帧，区间内TAA连续
+};
+
+struct RenderSetup {
+    BatchJob job;
+    RendererSettings renderer;   // 工作进程收到后覆盖自身命令行的设置
+    DistributedMode mode = DistributedMode::Tiles;
+    int tileSize = 0;   // 0：协调进程按图像大小选择
+};
+
+struct WorkItem {
+    quint32 id = 0;
+    int frame = 0;
+    int frameCount = 1;
+    QRect core;        // Tiles：该块核心区域（OpenGL坐标）；Frames：整帧
+    int attempts = 0;  // 仅协调进程使用
+};
+
+// 自下而上的紧密RGB8行
+struct WorkResult {
+    quint32 id = 0;
+    int frame = 0;
+    QRect rect;
+    QByteArray pixels;
+};
+
+QDataStream& operator<<(QDataStream& out, const RenderSetup& setup);
+QDataStream& operator>>(QDataStream& in, RenderSetup& setup);
+QDataStream& operator<<(QDataStream& out, const WorkItem& item);
+QDataStream& operator>>(QDataStream& in, WorkItem& item);
+QDataStream& operator<<(QDataStream& out, const WorkResult& result);
+QDataStream& operator>>(QDataStream& in, WorkResult& result);
+
+// 在QLocalSocket或QTcpSocket之上收发完整消息
+class RenderConnection : public QObject {
+    Q_OBJECT
+public:
+    explicit RenderConnection(QLocalSocket* socket, QObject* parent = nullptr);
+    explicit RenderConnection(QTcpSocket* socket, QObject* parent = nullptr);
+
+    // address: "local:名称" 或 "tcp:主机:端口"；阻塞直到连接成功或超时
+    static RenderConnection* connectTo(const QString& address, int timeoutMs, QObject* parent = nullptr);
+
+    template <typename T>
+    void send(RenderProtocol::MessageType type, const T& payload) {
+        QByteArray bytes;
+        QDataStream out(&bytes, QIODevice::WriteOnly);
+        out << payload;
+        sendRaw(type, bytes);
+    }
+    void send(RenderProtocol::MessageType type) { sendRaw(type, QByteArray()); }
+
+    void close();
+    bool isOpen() const;
+    // 等待所有已排队数据写入内核缓冲
+    void flush();
+
+signals:
+    void messageReceived(quint8 type, const QByteArray& payload);
+    void closed();
+
+private:
+    void sendRaw(RenderProtocol::MessageType type, const QByteArray& payload);
+    void readMessages();
+
+    QIODevice* device;
+    QByteArray buffer;
+    bool corrupted = false;   // 收到非法长度后丢弃之后的所有数据
+};
+
+#endif // RENDERPROTOCOL_H
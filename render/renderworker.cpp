@@ -0,0 +1,158 @@
+#include "renderworker.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+RenderWorker::RenderWorker(OffscreenRenderer& offscreen, QObject* parent)
+    : QObject(parent), offscreen(offscreen), tiled(offscreen), capture(3) {}
+
+RenderWorker::~RenderWorker() {
+    capture.release();
+}
+
+bool RenderWorker::start(const QString& address) {
+    connection = RenderConnection::connectTo(address, 30000, this);
+    if (!connection) {
+        return false;
+    }
+    connect(connection, &RenderConnection::messageReceived, this, &RenderWorker::onMessage);
+    connect(connection, &RenderConnection::closed, this, [this]() {
+        qWarning() << "Coordinator closed the connection";
+        emit finished(1);
+    });
+
+    capture.initialize();
+    capture.setPixelFormat(GL_RGB, GL_UNSIGNED_BYTE, 3);
+    capture.setConsumer([this](const CapturedFrame& frame) {
+        sendResult(frame);
+    });
+    connection->send(RenderProtocol::Hello, RenderProtocol::kVersion);
+    return true;
+}
+
+void RenderWorker::onMessage(quint8 type, const QByteArray& payload) {
+    QDataStream in(payload);
+    switch (type) {
+    case RenderProtocol::Setup:
+        in >> setup;
+        hasSetup = in.status() == QDataStream::Ok;
+        if (!hasSetup) {
+            qWarning() << "Incompatible render setup from coordinator";
+            emit finished(1);
+            break;
+        }
+        // 画面相关的设置以协调进程为准，本进程命令行上的同名选项不起作用
+        offscreen.blackHoleRenderer().applySettings(setup.renderer);
+        break;
+    case RenderProtocol::Work: {
+        WorkItem item;
+        in >> item;
+        // 协调进程会预先多派一个工作项，在事件循环中逐个处理，避免在信号处理函数中重入
+        queue.enqueue(item);
+        if (!busy) {
+            busy = true;
+            QMetaObject::invokeMethod(this, &RenderWorker::processNext, Qt::QueuedConnection);
+        }
+        break;
+    }
+    case RenderProtocol::Shutdown:
+        emit finished(0);
+        break;
+    default:
+        qWarning() << "Unexpected message type" << type;
+        break;
+    }
+}
+
+void RenderWorker::processNext() {
+    if (queue.isEmpty()) {
+        busy = false;
+        return;
+    }
+    const WorkItem item = queue.dequeue();
+    QString error;
+    if (!renderItem(item, &error)) {
+        connection->send(RenderProtocol::WorkFailed, qMakePair(item.id, error));
+        qWarning() << "work item" << item.id << "failed:" << error;
+    }
+    // 读取与下一项的渲染重叠，没有下一项时交付剩余结果，WorkDone 随最后一个结果发出
+    if (queue.isEmpty()) {
+        capture.flush();
+    }
+    // 结果写入套接字后再渲染下一项，大块数据不会在内存中堆积
+    connection->flush();
+    QMetaObject::invokeMethod(this, &RenderWorker::processNext, Qt::QueuedConnection);
+}
+
+bool RenderWorker::renderItem(const WorkItem& item, QString* error) {
+    if (!hasSetup) {
+        *error = "no render setup received";
+        return false;
+    }
+    const BatchJob& job = setup.job;
+
+    if (setup.mode == DistributedMode::Tiles) {
+        if (setup.tileSize > tiled.maxTileSize()) {
+            *error = QString("tile size %1 exceeds this worker's limit %2").arg(setup.tileSize).arg(tiled.maxTileSize());
+            return false;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        tiled.renderTile(job.frameState(item.frame), QSize(job.width, job.height), item.core, setup.tileSize);
+        pendingResults.enqueue({item.id, item.frame, item.core, true, timer});
+        const int guard = TiledRenderer::guardBand();
+        capture.capture(offscreen.target()->handle(), guard, guard, item.core.width(), item.core.height());
+        capture.poll();
+        return true;
+    }
+
+    if (job.width > offscreen.maxTargetSize() || job.height > offscreen.maxTargetSize()) {
+        *error = QString("frame size exceeds this worker's limit %1, use tile mode").arg(offscreen.maxTargetSize());
+        return false;
+    }
+    if (item.frameCount <= 0) {
+        *error = "empty frame range";
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    offscreen.resize(job.width, job.height);
+    for (int frame = item.frame; frame < item.frame + item.frameCount; ++frame) {
+        BlackHoleFrameState state = job.frameState(frame);
+        // 区间的第一帧丢弃TAA历史，之后的帧正常累积
+        if (frame == item.frame) {
+            state.iMouse.setZ(1.0f);
+        }
+        offscreen.renderFrame(state);
+        const bool last = frame == item.frame + item.frameCount - 1;
+        pendingResults.enqueue({item.id, frame, QRect(0, 0, job.width, job.height), last, timer});
+        capture.capture(offscreen.target()->handle(), job.width, job.height);
+        capture.poll();
+    }
+    return true;
+}
+
+void RenderWorker::sendResult(const CapturedFrame& frame) {
+    const PendingResult pending = pendingResults.dequeue();
+    if (frame.data) {
+        WorkResult result;
+        result.id = pending.id;
+        result.frame = pending.frame;
+        result.rect = pending.rect;
+        result.pixels = QByteArray(reinterpret_cast<const char*>(frame.data), int(frame.bytes));
+        connection->send(RenderProtocol::Result, result);
+    } else {
+        // 读取失败的结果不回传，工作项按失败上报，由协调进程重新分配
+        unreadItems.insert(pending.id);
+    }
+    if (!pending.last) {
+        return;
+    }
+    // 工作项的最后一个结果交付后才上报完成，协调进程收到 WorkDone 时所有结果都已在它之前
+    if (unreadItems.remove(pending.id)) {
+        connection->send(RenderProtocol::WorkFailed, qMakePair(pending.id, QString("frame readback failed")));
+        qWarning() << "work item" << pending.id << "failed: frame readback failed";
+    } else {
+        connection->send(RenderProtocol::WorkDone, pending.id);
+        qInfo() << "work item" << pending.id << "frame" << pending.frame << "done in" << pending.timer.elapsed() << "ms";
+    }
+}
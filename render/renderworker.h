@@ -0,0 +1,51 @@
+#ifndef RENDERWORKER_H
+#define RENDERWORKER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include "renderprotocol.h"
+#include "offscreenrenderer.h"
+#include "tiledrenderer.h"
+#include "framecapture.h"
+
+// 分布式渲染的工作进程：连接协调进程，按收到的工作项渲染块或帧区间并回传RGB像素
+class RenderWorker : public QObject {
+    Q_OBJECT
+public:
+    explicit RenderWorker(OffscreenRenderer& offscreen, QObject* parent = nullptr);
+    ~RenderWorker();
+
+    bool start(const QString& address);
+
+signals:
+    void finished(int exitCode);
+
+private:
+    struct PendingResult {
+        quint32 id = 0;
+        int frame = 0;
+        QRect rect;
+        bool last = true;       // 工作项的最后一个结果，交付后发送 WorkDone
+        QElapsedTimer timer;    // 工作项开始渲染的时刻
+    };
+
+    void onMessage(quint8 type, const QByteArray& payload);
+    void processNext();
+    bool renderItem(const WorkItem& item, QString* error);
+    void sendResult(const CapturedFrame& frame);
+
+    OffscreenRenderer& offscreen;
+    TiledRenderer tiled;
+    FrameCapture capture;
+    RenderConnection* connection = nullptr;
+    RenderSetup setup;
+    bool hasSetup = false;
+    QQueue<WorkItem> queue;
+    QQueue<PendingResult> pendingResults;   // 与PBO环中的读取一一对应
+    QSet<quint32> unreadItems;              // 有结果读取失败的工作项
+    bool busy = false;
+};
+
+#endif // RENDERWORKER_H
@@ -0,0 +1,60 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// 无锁单生产者/单消费者环形队列
+// 生产者只写tail，消费者只写head；容量向上取整为2的幂，实际可用容量为 capacity - 1
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity + 1) {
+            size <<= 1;
+        }
+        items.resize(size);
+        mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // 仅由生产者线程调用
+    bool tryPush(const T& item) {
+        const size_t tail = tailIndex.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) & mask;
+        if (next == headIndex.load(std::memory_order_acquire)) {
+            return false;  // 队列已满
+        }
+        items[tail] = item;
+        tailIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // 仅由消费者线程调用
+    bool tryPop(T& item) {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) {
+            return false;  // 队列为空
+        }
+        item = items[head];
+        headIndex.store((head + 1) & mask, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> items;
+    size_t mask = 0;
+    // 分开缓存行，避免生产者与消费者伪共享
+    alignas(64) std::atomic<size_t> headIndex{0};
+    alignas(64) std::atomic<size_t> tailIndex{0};
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,113 @@
+#include "tiledrenderer.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// bloom金字塔的最后一级为 1 / 2^8 分辨率，一个纹素对应 2^8 个全分辨率像素
+const int kMaxBloomOctave = BlackHoleRenderer::kBloomLevels;
+// OpenGL 4.3 要求 GL_MAX_TEXTURE_SIZE 和 GL_MAX_RENDERBUFFER_SIZE 至少为此值
+const int kGuaranteedTargetSize = 16384;
+
+} // namespace
+
+TiledRenderer::TiledRenderer(OffscreenRenderer& offscreen) : offscreen(offscreen) {}
+
+int TiledRenderer::alignment() {
+    return 1 << kMaxBloomOctave;
+}
+
+int TiledRenderer::guardBand() {
+    // 单轴上以最后一级纹素计的影响半径：
+    // screen_result双三次采样2 + 模糊最大偏移0.5*7.06 + 线性过滤1；逐级的2x2盒滤波与对齐的格子重合，不向外扩
+    const double texels = 2.0 + 0.5 * 7.05882353 + 1.0;
+    const int radius = int(std::ceil(texels * alignment()));
+    return (radius + alignment() - 1) / alignment() * alignment();
+}
+
+int TiledRenderer::tileLimit(int targetSize) {
+    const int size = targetSize - 2 * guardBand();
+    return std::max(0, size / alignment() * alignment());
+}
+
+int TiledRenderer::maxTileSize() const {
+    return tileLimit(offscreen.maxTargetSize());
+}
+
+int TiledRenderer::defaultTileSize(const QSize& imageSize) {
+    const int limit = tileLimit(kGuaranteedTargetSize);
+    const int extent = std::max(1, std::max(imageSize.width(), imageSize.height()));
+    const int tiles = (extent + limit - 1) / limit;
+    const int size = (extent + tiles - 1) / tiles;
+    // limit 已对齐，向上对齐后不会超出
+    return (size + alignment() - 1) / alignment() * alignment();
+}
+
+bool TiledRenderer::render(const BlackHoleFrameState& state, int width, int height, int tileSize,
+                           const QString& outputPath) {
+    tileSize = std::min(tileSize / alignment() * alignment(), maxTileSize());
+    if (tileSize <= 0) {
+        qWarning() << "Tile size must be at least" << alignment() << "pixels and fit in"
+                   << offscreen.maxTargetSize() << "with a" << guardBand() << "pixel guard band";
+        return false;
+    }
+    if (!output.open(outputPath, width, height)) {
+        return false;
+    }
+
+    const int guard = guardBand();
+    FrameCapture capture(2);
+    capture.initialize();
+    capture.setPixelFormat(GL_RGB, GL_UNSIGNED_BYTE, 3);
+    capture.setConsumer([this](const CapturedFrame& frame) {
+        if (!frame.data) {
+            qWarning() << "Tile" << frame.index << "was not read back";
+            writeFailed = true;
+        } else if (!writeFailed && !output.writeRegion(submittedTiles[frame.index], frame.data)) {
+            writeFailed = true;
+        }
+    });
+    submittedTiles.clear();
+    writeFailed = false;
+
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+    qInfo() << "Rendering" << width << "x" << height << "as" << tilesX * tilesY << "tiles of" << tileSize
+            << "pixels (" << tileSize + 2 * guard << "with guard band)";
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            const QRect core(tx * tileSize, ty * tileSize,
+                             std::min(tileSize, width - tx * tileSize), std::min(tileSize, height - ty * tileSize));
+            renderTile(state, QSize(width, height), core, tileSize);
+
+            submittedTiles.append(core);
+            capture.capture(offscreen.target()->handle(), guard, guard, core.width(), core.height());
+            capture.poll();
+            qInfo() << "tile" << submittedTiles.size() << "/" << tilesX * tilesY << "at" << core.x() << core.y()
+                    << timer.elapsed() / 1000.0 << "s";
+        }
+    }
+    capture.flush();
+    capture.release();
+    output.close();
+    return !writeFailed;
+}
+
+void TiledRenderer::renderTile(const BlackHoleFrameState& state, const QSize& imageSize, const QRect& core,
+                               int tileSize) {
+    const int guard = guardBand();
+    offscreen.resize(tileSize + 2 * guard, tileSize + 2 * guard);
+
+    // 每块都是独立的单帧：iFrame >= 2 使相机取iMouse，iMouse.z > 0 使TAA权重为1，不读取上一块留下的历史
+    BlackHoleFrameState tileState = state;
+    tileState.iFrame = std::max(state.iFrame, 2);
+    tileState.iMouse.setZ(1.0f);
+    tileState.imageSize = imageSize;
+    tileState.tileOffset = QPoint(core.x() - guard, core.y() - guard);
+    offscreen.renderFrame(tileState);
+}
@@ -0,0 +1,43 @@
+#ifndef TILEDRENDERER_H
+#define TILEDRENDERER_H
+
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include "offscreenrenderer.h"
+#include "framecapture.h"
+#include "ppmfile.h"
+
+// 超大静帧（16K–32K）的分块渲染：每块单独跑完整通道链，只保留去掉保护带后的核心区域
+// 每块渲染尺寸固定为 tileSize + 2 * guard，且块原点按最大bloom八度（256像素）对齐，
+// 这样bloom金字塔各级的降采样格子与所有块对齐，接缝处的bloom与整幅渲染一致。
+// 结果按行写入二进制PPM（P6），峰值内存只与块大小有关
+class TiledRenderer {
+public:
+    explicit TiledRenderer(OffscreenRenderer& offscreen);
+
+    // bloom在全分辨率像素下的最大影响半径（已按对齐粒度取整）
+    static int guardBand();
+    static int alignment();
+    // 在最大帧缓冲尺寸限制下可用的最大核心块尺寸
+    int maxTileSize() const;
+    // 没有OpenGL上下文时（协调进程）的默认块尺寸：按 OpenGL 4.3 保证的帧缓冲尺寸取最大的块，
+    // 再让各块均分图像，保护带的重复追踪尽量少
+    static int defaultTileSize(const QSize& imageSize);
+
+    bool render(const BlackHoleFrameState& state, int width, int height, int tileSize,
+                const QString& outputPath);
+    // 渲染核心区域为 core 的一块（OpenGL坐标），完成后核心位于 offscreen.target() 的 (guard, guard) 处
+    void renderTile(const BlackHoleFrameState& state, const QSize& imageSize, const QRect& core, int tileSize);
+
+private:
+    static int tileLimit(int targetSize);
+
+    OffscreenRenderer& offscreen;
+    PpmFile output;
+    QVector<QRect> submittedTiles;   // 按提交顺序记录每块的核心区域（OpenGL坐标，y向上）
+    bool writeFailed = false;
+};
+
+#endif // TILEDRENDERER_H
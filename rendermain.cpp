@@ -0,0 +1,580 @@
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <cstdint>
+#include <cstdio>
+#include <csignal>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "render/offscreenrenderer.h"
+#include "render/framecapture.h"
+#include "render/framestream.h"
+#include "render/tiledrenderer.h"
+#include "render/batchrunner.h"
+#include "render/rendercoordinator.h"
+#include "render/renderworker.h"
+#include "render/lensingmap.h"
+#include "core/cputracer.h"
+#include "core/imagecompare.h"
+#include "core/postprocess.h"
+
+namespace {
+
+TraceParams traceParams(const BlackHoleFrameState& state, int width, int height) {
+    TraceParams params;
+    params.width = width;
+    params.height = height;
+    params.iTime = state.iTime;
+    params.iFrame = state.iFrame;
+    params.iMouse = glsl::vec4(state.iMouse.x(), state.iMouse.y(), state.iMouse.z(), state.iMouse.w());
+    params.blackHoleMass = state.blackHoleMass;
+    params.diskNormal = glsl::vec3(state.diskNormal.x(), state.diskNormal.y(), state.diskNormal.z());
+    params.cameraRadius = state.cameraRadius;
+    params.fov = state.fov;
+    params.backgroundType = state.backgroundType;
+    return params;
+}
+
+// 每块的步数分布：光子环附近的块远比背景块贵，这也是按块窃取调度的原因
+void printTileSummary(const CpuTracer& tracer) {
+    const std::vector<TileStats>& stats = tracer.tileStats();
+    if (stats.empty()) {
+        return;
+    }
+    uint64_t total = 0;
+    uint64_t minSteps = UINT64_MAX;
+    uint64_t maxSteps = 0;
+    for (const TileStats& tile : stats) {
+        total += tile.steps;
+        minSteps = std::min(minSteps, tile.steps);
+        maxSteps = std::max(maxSteps, tile.steps);
+    }
+    std::fprintf(stderr, "cpu: %s, %d threads, %zu tiles, %llu steps (per tile min %llu, mean %llu, max %llu), %llu steals\n",
+                 simdIsaName(tracer.simdIsa()), tracer.threadCount(), stats.size(), static_cast<unsigned long long>(total),
+                 static_cast<unsigned long long>(minSteps), static_cast<unsigned long long>(total / stats.size()),
+                 static_cast<unsigned long long>(maxSteps), static_cast<unsigned long long>(tracer.stealCount()));
+}
+
+void printStepStatistics(const StepStatistics& stats) {
+    const double pixels = double(stats.width) * double(stats.height);
+    std::fprintf(stderr, "steps frame %d: %llu steps (%.1f per pixel, max %u), %.2f disk calls per pixel, "
+                 "%u escaped, %u captured, %u exhausted\n",
+                 stats.frame, static_cast<unsigned long long>(stats.steps), double(stats.steps) / pixels,
+                 stats.maxSteps, double(stats.diskCalls) / pixels, stats.escaped, stats.captured, stats.exhausted);
+}
+
+bool writeTileStats(const QString& path, const CpuTracer& tracer, int frame) {
+    QFile file(path);
+    const bool header = frame == 0;
+    if (!file.open(header ? QIODevice::WriteOnly | QIODevice::Truncate : QIODevice::Append)) {
+        qWarning() << "Cannot write tile statistics" << path << file.errorString();
+        return false;
+    }
+    QTextStream out(&file);
+    if (header) {
+        out << "frame,x,y,width,height,steps,max_steps,ms,worker\n";
+    }
+    for (const TileStats& tile : tracer.tileStats()) {
+        out << frame << ',' << tile.x << ',' << tile.y << ',' << tile.width << ',' << tile.height << ','
+            << tile.steps << ',' << tile.maxSteps << ',' << QString::number(tile.milliseconds, 'f', 3) << ','
+            << tile.worker << '\n';
+    }
+    return true;
+}
+
+// 本机启动的工作进程沿用的本机路径；影响画面的设置随 RenderSetup 下发，不经命令行
+QStringList workerArguments(const QCommandLineParser& parser) {
+    QStringList arguments = {"--shader-dir", parser.value("shader-dir")};
+    if (parser.isSet("kerr-cache")) {
+        arguments << "--kerr-cache" << parser.value("kerr-cache");
+    }
+    return arguments;
+}
+
+} // namespace
+
+// 黑洞离线渲染命令行工具：与GLCircleWidget使用同一套通道链，无需窗口系统
+int main(int argc, char* argv[]) {
+    // 渲染节点没有显示服务时，默认使用EGL无表面平台（Mesa llvmpipe可用）
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") &&
+        qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")) {
+        qputenv("QT_QPA_PLATFORM", "minimalegl");
+        if (qEnvironmentVariableIsEmpty("EGL_PLATFORM")) {
+            qputenv("EGL_PLATFORM", "surfaceless");
+        }
+    }
+
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("blackhole-render");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless black hole renderer");
+    parser.addHelpOption();
+    parser.addOptions({
+        {{"W", "width"}, "Output width in pixels.", "pixels", "1920"},
+        {{"H", "height"}, "Output height in pixels.", "pixels", "1080"},
+        {{"n", "frames"}, "Number of frames to render.", "count", "1"},
+        {"timestep", "Fixed time step per frame in seconds.", "seconds", "0.016666667"},
+        {"start-time", "Simulation time of the first frame in seconds.", "seconds", "0"},
+        {"camera", "Camera orbit as fractions of the view (theta,phi), same as iMouse / iResolution.",
+         "theta,phi", "0.45,0.55"},
+        {"background", "Background type (0: chess, 1: black, 2: stars, 3: texture).", "type", "1"},
+        {"mass", "Black hole mass in solar masses.", "msun", "1.49e7"},
+        {"spin", "Dimensionless black hole spin a/M; nonzero spins look rays up in precomputed Kerr transfer tables.",
+         "a", "0"},
+        {"kerr-cache", "Directory for cached Kerr transfer tables (default: the user cache directory).", "dir"},
+        {{"o", "output-dir"}, "Directory for rendered frames.", "dir", "."},
+        {"prefix", "File name prefix for rendered frames.", "name", "frame"},
+        {"shader-dir", "Shader directory (defaults to the embedded resources).", "dir", ":/shaders/"},
+        {"no-deflection-table", "March every ray instead of looking up rays that miss the disk in the deflection table."},
+        {"no-geodesic-cache", "Re-march every frame instead of reshading cached disk samples while the camera is still."},
+        {"integrator", "Geodesic integrator (fixed or adaptive).", "name", "fixed"},
+        {"tolerance", "Per-step relative error of the adaptive integrator.", "error", "1e-5"},
+        {"max-steps", "Geodesic step budget per ray.", "steps", "1000"},
+        {"wavefront", "Trace the scene with compute shaders that compact the live rays between dispatches."},
+        {"no-disk", "Compile the shaders without the accretion disk (lensed background only)."},
+        {"analytic-noise", "Evaluate the disk noise analytically instead of sampling the noise texture."},
+        {"debug-view", "Replace the final color with a debug view (none, escape, termination or heatmap).", "view",
+         "none"},
+        {"step-stats", "Count geodesic steps and disk shading calls per frame and report them (fragment path only)."},
+        {"stream", "Stream raw frames instead of writing PNGs: - (stdout), fifo:PATH or ring:PATH[:SLOTS].",
+         "target"},
+        {"stream-format", "Raw stream pixel format (rgba8 or rgb16f).", "format", "rgba8"},
+        {"batch", "Render every job of a JSON or CSV job list in this process; options above are the job defaults.",
+         "file"},
+        {"manifest", "Manifest with per-job results and timings (default <output-dir>/manifest.json).", "file"},
+        {"tile",
+         "Render one still in tiles of this size (plus a bloom guard band) into <output-dir>/<prefix>.ppm; "
+         "with --coordinator, the work item tile size (default: the largest tile any OpenGL 4.3 worker supports).",
+         "pixels"},
+        {"equirect", "Render full-sphere equirectangular frames (use a 2:1 size) from a six-face cubemap."},
+        {"face-size", "Cubemap face size for --equirect (default width / 4).", "pixels"},
+        {"coordinator", "Distribute the render to worker processes listening on local:NAME or tcp:PORT.", "address"},
+        {"workers", "Number of worker processes the coordinator starts on this machine.", "count", "0"},
+        {"distribute", "Work item type for the coordinator (tiles or frames).", "mode", "tiles"},
+        {"frames-per-item", "Consecutive frames per work item in frames mode.", "count", "8"},
+        {"retries", "Attempts per work item before the render fails.", "count", "3"},
+        {"work-timeout", "Seconds before an unfinished work item is reassigned.", "seconds", "600"},
+        {"idle-timeout", "Seconds the coordinator waits without any connected worker before failing.", "seconds",
+         "300"},
+        {"worker", "Run as a render worker connected to local:NAME or tcp:HOST:PORT; rendering settings come from "
+         "the coordinator.", "address"},
+        {"cpu", "Render on the CPU reference tracer and post-processing chain without OpenGL."},
+        {"compare-cpu", "Render the first frame on both the GPU and the CPU tracer and report the difference."},
+        {"cpu-threads", "CPU tracer threads (0 = all hardware threads).", "count", "0"},
+        {"cpu-tile", "CPU tracer tile size.", "pixels", "32"},
+        {"cpu-isa", "SIMD instruction set of the CPU tracer (auto, scalar, sse2, avx2 or avx512).", "isa", "auto"},
+        {"cpu-tolerance", "Maximum 8x8 block-averaged mean error for --compare-cpu to pass.", "error", "0.05"},
+        {"tile-stats", "Write per-tile step counts and timings of the CPU tracer to a CSV file.", "file"},
+        {"lensing-map", "Write the lensing map (disk color, escape direction and termination state) of the first "
+         "frame to this memory-mappable file instead of rendering frames.", "file"},
+        {"lensing-exr", "Also write the lensing map as a 32-bit float OpenEXR image.", "file"},
+        {"relens", "Composite the background onto a saved lensing map instead of ray marching (same --width/--height).",
+         "file"},
+        {"sky", "Equirectangular sky image (world space) for --relens; without it --background is used.", "image"},
+    });
+    parser.process(app);
+
+    const int width = parser.value("width").toInt();
+    const int height = parser.value("height").toInt();
+    const int frames = parser.value("frames").toInt();
+    const float timestep = parser.value("timestep").toFloat();
+    const QStringList camera = parser.value("camera").split(',');
+    if (width <= 0 || height <= 0 || frames <= 0 || camera.size() != 2) {
+        std::fprintf(stderr, "Invalid size, frame count or camera\n");
+        return 1;
+    }
+
+    QDir outputDir(parser.value("output-dir"));
+    if (!outputDir.exists() && !QDir().mkpath(outputDir.path())) {
+        std::fprintf(stderr, "Cannot create output directory %s\n", qPrintable(outputDir.path()));
+        return 1;
+    }
+
+    const bool streaming = parser.isSet("stream");
+    StreamPixelFormat streamFormat = StreamPixelFormat::Rgba8;
+    if (parser.value("stream-format") == "rgb16f") {
+        streamFormat = StreamPixelFormat::Rgb16F;
+    } else if (parser.value("stream-format") != "rgba8") {
+        std::fprintf(stderr, "Unknown stream format %s\n", qPrintable(parser.value("stream-format")));
+        return 1;
+    }
+    GeodesicIntegrator integrator = GeodesicIntegrator::Fixed;
+    if (parser.value("integrator") == "adaptive") {
+        integrator = GeodesicIntegrator::Adaptive;
+    } else if (parser.value("integrator") != "fixed") {
+        std::fprintf(stderr, "Unknown integrator %s\n", qPrintable(parser.value("integrator")));
+        return 1;
+    }
+    DebugView debugView = DebugView::None;
+    if (parser.value("debug-view") == "escape") {
+        debugView = DebugView::EscapeDirection;
+    } else if (parser.value("debug-view") == "termination") {
+        debugView = DebugView::Termination;
+    } else if (parser.value("debug-view") == "heatmap") {
+        debugView = DebugView::StepHeatMap;
+    } else if (parser.value("debug-view") != "none") {
+        std::fprintf(stderr, "Unknown debug view %s\n", qPrintable(parser.value("debug-view")));
+        return 1;
+    }
+    bool maxStepsOk = false;
+    const int maxSteps = parser.value("max-steps").toInt(&maxStepsOk);
+    if (!maxStepsOk || maxSteps < BlackHoleRenderer::kMinGeodesicSteps ||
+        maxSteps > BlackHoleRenderer::kMaxGeodesicStepsLimit) {
+        std::fprintf(stderr, "Max steps must be between %d and %d\n", BlackHoleRenderer::kMinGeodesicSteps,
+                     BlackHoleRenderer::kMaxGeodesicStepsLimit);
+        return 1;
+    }
+    const float spin = parser.value("spin").toFloat();
+    if (!(std::fabs(spin) < 1.0f)) {
+        std::fprintf(stderr, "Spin must be between -1 and 1\n");
+        return 1;
+    }
+    // CPU参考追踪器只有 Schwarzschild 测地线
+    if (spin != 0.0f && (parser.isSet("cpu") || parser.isSet("compare-cpu"))) {
+        std::fprintf(stderr, "--spin is not supported by the CPU tracer\n");
+        return 1;
+    }
+    SimdIsa cpuIsa = SimdIsa::Scalar;
+    if (!parseSimdIsa(qPrintable(parser.value("cpu-isa")), &cpuIsa)) {
+        std::fprintf(stderr, "Unknown SIMD instruction set %s\n", qPrintable(parser.value("cpu-isa")));
+        return 1;
+    }
+    if (!simdIsaSupported(cpuIsa)) {
+        std::fprintf(stderr, "This CPU does not support %s\n", simdIsaName(cpuIsa));
+        return 1;
+    }
+
+    RendererSettings rendererSettings;
+    rendererSettings.spin = spin;
+    rendererSettings.integrator = integrator;
+    rendererSettings.tolerance = parser.value("tolerance").toFloat();
+    rendererSettings.maxSteps = maxSteps;
+    rendererSettings.debugView = debugView;
+    rendererSettings.disk = !parser.isSet("no-disk");
+    rendererSettings.noise = parser.isSet("analytic-noise") ? DiskNoiseQuality::Analytic : DiskNoiseQuality::Texture;
+    rendererSettings.wavefront = parser.isSet("wavefront");
+    rendererSettings.deflectionTable = !parser.isSet("no-deflection-table");
+    rendererSettings.geodesicCache = !parser.isSet("no-geodesic-cache");
+
+    // 编码器提前退出时由write返回EPIPE处理，而不是被信号终止
+    std::signal(SIGPIPE, SIG_IGN);
+
+    BatchJob defaults;
+    defaults.name = parser.value("prefix");
+    defaults.width = width;
+    defaults.height = height;
+    defaults.frames = frames;
+    defaults.timestep = timestep;
+    defaults.startTime = parser.value("start-time").toFloat();
+    defaults.mass = parser.value("mass").toFloat();
+    defaults.cameraTheta = camera[0].toFloat();
+    defaults.cameraPhi = camera[1].toFloat();
+    defaults.backgroundType = parser.value("background").toInt();
+
+    // 协调模式：自身不渲染，不需要OpenGL上下文
+    if (parser.isSet("coordinator")) {
+        RenderSetup setup;
+        setup.job = defaults;
+        setup.renderer = rendererSettings;
+        setup.mode = parser.value("distribute") == "frames" ? DistributedMode::Frames : DistributedMode::Tiles;
+        setup.tileSize = parser.isSet("tile") ? parser.value("tile").toInt() : 0;
+
+        RenderCoordinator coordinator(setup, parser.value("frames-per-item").toInt(), outputDir.path(),
+                                      parser.value("prefix"));
+        coordinator.setMaxAttempts(parser.value("retries").toInt());
+        coordinator.setWorkTimeout(parser.value("work-timeout").toInt());
+        coordinator.setIdleTimeout(parser.value("idle-timeout").toInt());
+        if (!coordinator.listen(parser.value("coordinator"))) {
+            return 1;
+        }
+        coordinator.spawnLocalWorkers(parser.value("workers").toInt(), workerArguments(parser));
+        QObject::connect(&coordinator, &RenderCoordinator::finished, &app, [&app](bool ok) {
+            app.exit(ok ? 0 : 1);
+        });
+        return app.exec();
+    }
+
+    // CPU参考渲染：没有可用GPU的节点，circle通道之后走同样的bloom和色调映射
+    if (parser.isSet("cpu")) {
+        CpuTracer tracer(parser.value("cpu-threads").toInt());
+        tracer.setTileSize(parser.value("cpu-tile").toInt());
+        tracer.setSimdIsa(cpuIsa);
+        PostProcessor post(parser.value("cpu-threads").toInt());
+        post.setSimdIsa(cpuIsa);
+        ImageSequenceWriter writer(outputDir.path(), parser.value("prefix"));
+        std::vector<float> scene(size_t(width) * height * 4);
+        std::vector<uint8_t> pixels(scene.size());
+
+        QElapsedTimer totalTimer;
+        totalTimer.start();
+        for (int frame = 0; frame < frames; ++frame) {
+            const BlackHoleFrameState state = defaults.frameState(frame);
+
+            QElapsedTimer frameTimer;
+            frameTimer.start();
+            tracer.render(traceParams(state, width, height), scene.data());
+            const double traceMilliseconds = frameTimer.nsecsElapsed() / 1.0e6;
+            post.process(scene.data(), width, height, pixels.data());
+            CapturedFrame captured;
+            captured.index = frame;
+            captured.width = width;
+            captured.height = height;
+            captured.data = pixels.data();
+            captured.bytes = qint64(pixels.size());
+            writer(captured);
+            const PostTimings& postTimings = post.timings();
+            std::fprintf(stderr, "frame %d: %.2f ms (trace %.2f, post: pyramid %.2f, blur %.2f + %.2f, bloom %.2f)\n",
+                         frame, frameTimer.nsecsElapsed() / 1.0e6, traceMilliseconds, postTimings.pyramid,
+                         postTimings.horizontal, postTimings.vertical, postTimings.bloom);
+            printTileSummary(tracer);
+            if (parser.isSet("tile-stats")) {
+                writeTileStats(parser.value("tile-stats"), tracer, frame);
+            }
+        }
+        writer.waitForDone();
+        const double seconds = totalTimer.nsecsElapsed() / 1.0e9;
+        std::fprintf(stderr, "%d frames in %.2f s (%.3f MP/s)\n", frames, seconds,
+                     double(width) * height * frames / seconds / 1.0e6);
+        return writer.failedCount() > 0 ? 1 : 0;
+    }
+
+    OffscreenRenderer offscreen;
+    if (!offscreen.create(parser.value("shader-dir"))) {
+        return 1;
+    }
+    if (parser.isSet("compare-cpu")) {
+        // CPU参考追踪器逐步raymarching且只有手调步长表，对比时GPU也不查表
+        rendererSettings.deflectionTable = false;
+        rendererSettings.integrator = GeodesicIntegrator::Fixed;
+    }
+    // 工作进程的设置在收到 Setup 时被协调进程的覆盖
+    offscreen.blackHoleRenderer().applySettings(rendererSettings);
+    offscreen.blackHoleRenderer().setStepStatisticsEnabled(parser.isSet("step-stats"));
+    // 离线渲染每帧都要正确的表，缓存里没有时等它生成
+    offscreen.blackHoleRenderer().setKerrTableWait(true);
+    if (parser.isSet("kerr-cache")) {
+        offscreen.blackHoleRenderer().setKerrTableDirectory(parser.value("kerr-cache"));
+    }
+
+    if (parser.isSet("worker")) {
+        RenderWorker worker(offscreen);
+        if (!worker.start(parser.value("worker"))) {
+            return 1;
+        }
+        QObject::connect(&worker, &RenderWorker::finished, &app, [&app](int exitCode) {
+            app.exit(exitCode);
+        });
+        return app.exec();
+    }
+
+    // 批处理模式：一个进程一个上下文渲染全部任务
+    if (parser.isSet("batch")) {
+        QVector<BatchJob> jobs;
+        if (!BatchRunner::loadJobs(parser.value("batch"), defaults, &jobs)) {
+            return 1;
+        }
+        const QString manifest = parser.isSet("manifest") ? parser.value("manifest")
+                                                          : outputDir.filePath("manifest.json");
+        BatchRunner batch(offscreen);
+        return batch.run(jobs, outputDir.path(), manifest) ? 0 : 1;
+    }
+
+    // 分块模式：输出尺寸不受帧缓冲上限约束
+    if (parser.isSet("tile")) {
+        const BlackHoleFrameState state = defaults.frameState(0);
+        TiledRenderer tiled(offscreen);
+        const QString path = outputDir.filePath(parser.value("prefix") + ".ppm");
+        QElapsedTimer timer;
+        timer.start();
+        if (!tiled.render(state, width, height, parser.value("tile").toInt(), path)) {
+            return 1;
+        }
+        std::fprintf(stderr, "Wrote %s in %.2f s\n", qPrintable(path), timer.nsecsElapsed() / 1.0e9);
+        return 0;
+    }
+    if (width > offscreen.maxTargetSize() || height > offscreen.maxTargetSize()) {
+        std::fprintf(stderr, "Resolution %dx%d exceeds the maximum framebuffer size %d, use --tile\n",
+                     width, height, offscreen.maxTargetSize());
+        return 1;
+    }
+    if (streaming && streamFormat == StreamPixelFormat::Rgb16F) {
+        offscreen.setTargetFormat(GL_RGBA16F);
+    }
+    offscreen.resize(width, height);
+
+    // 同一帧分别在GPU和CPU上渲染，比较circle通道的输出；不混合历史帧，两边输入完全相同
+    if (parser.isSet("compare-cpu")) {
+        const BlackHoleFrameState state = defaults.frameState(0);
+        std::vector<float> gpu(size_t(width) * height * 4);
+        std::vector<float> cpu(gpu.size());
+        QElapsedTimer timer;
+        timer.start();
+        offscreen.renderFrame(state);
+        offscreen.readScene(gpu.data());
+        const double gpuSeconds = timer.nsecsElapsed() / 1.0e9;
+
+        CpuTracer tracer(parser.value("cpu-threads").toInt());
+        tracer.setTileSize(parser.value("cpu-tile").toInt());
+        tracer.setSimdIsa(cpuIsa);
+        timer.restart();
+        tracer.render(traceParams(state, width, height), cpu.data());
+        const double cpuSeconds = timer.nsecsElapsed() / 1.0e9;
+        printTileSummary(tracer);
+        if (parser.isSet("tile-stats")) {
+            writeTileStats(parser.value("tile-stats"), tracer, 0);
+        }
+
+        const float tolerance = parser.value("cpu-tolerance").toFloat();
+        const ImageDiff diff = compareImages(cpu.data(), gpu.data(), width, height, tolerance);
+        std::fprintf(stderr, "gpu %.2f s, cpu %.2f s\n", gpuSeconds, cpuSeconds);
+        std::fprintf(stderr, "per pixel: max %.4f at (%d, %d), mean %.5f, rmse %.5f, %.2f%% above %.3f\n",
+                     diff.maxError, diff.worstX, diff.worstY, diff.meanError, diff.rmse,
+                     100.0 * diff.exceedFraction, tolerance);
+        const bool pass = diff.blockMeanError <= tolerance;
+        std::fprintf(stderr, "8x8 blocks: mean %.5f, max %.4f -> %s\n", diff.blockMeanError, diff.blockMaxError,
+                     pass ? "PASS" : "FAIL");
+        return pass ? 0 : 1;
+    }
+    // 透镜映射：吸积盘颜色和逃逸方向与背景无关，导出一次之后换背景只需 --relens
+    if (parser.isSet("lensing-map")) {
+        const BlackHoleFrameState state = defaults.frameState(0);
+        LensingMapFile map;
+        if (!map.create(parser.value("lensing-map"), width, height, state)) {
+            std::fprintf(stderr, "%s\n", qPrintable(map.errorString()));
+            return 1;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        if (!offscreen.blackHoleRenderer().exportLensingMap(state, map.plane(0), map.plane(1))) {
+            std::fprintf(stderr, "Lensing map export failed\n");
+            return 1;
+        }
+        std::fprintf(stderr, "Wrote %s in %.2f s\n", qPrintable(parser.value("lensing-map")),
+                     timer.nsecsElapsed() / 1.0e9);
+        if (parser.isSet("lensing-exr")) {
+            QString error;
+            if (!writeLensingMapExr(parser.value("lensing-exr"), map, &error)) {
+                std::fprintf(stderr, "%s\n", qPrintable(error));
+                return 1;
+            }
+        }
+        return 0;
+    }
+    const bool relens = parser.isSet("relens");
+    LensingMapFile relensMap;
+    if (relens) {
+        if (!relensMap.open(parser.value("relens"))) {
+            std::fprintf(stderr, "%s\n", qPrintable(relensMap.errorString()));
+            return 1;
+        }
+        if (parser.isSet("sky")) {
+            const QImage sky(parser.value("sky"));
+            if (sky.isNull()) {
+                std::fprintf(stderr, "Cannot read sky image %s\n", qPrintable(parser.value("sky")));
+                return 1;
+            }
+            offscreen.blackHoleRenderer().setLensingSky(sky);
+        }
+        if (!offscreen.blackHoleRenderer().loadLensingMap(relensMap)) {
+            std::fprintf(stderr, "Lensing map is %dx%d, render it with --width %d --height %d\n", relensMap.width(),
+                         relensMap.height(), relensMap.width(), relensMap.height());
+            return 1;
+        }
+    }
+    int faceSize = 0;
+    if (parser.isSet("equirect")) {
+        faceSize = parser.isSet("face-size") ? parser.value("face-size").toInt() : std::max(1, width / 4);
+        if (faceSize > offscreen.maxTargetSize()) {
+            std::fprintf(stderr, "Face size %d exceeds the maximum framebuffer size %d\n", faceSize,
+                         offscreen.maxTargetSize());
+            return 1;
+        }
+        offscreen.setCubemapFaceSize(faceSize);
+    }
+
+    // 异步读取：PBO环交付的帧由线程池编码为PNG，或直接交给原始帧流
+    FrameCapture capture(3);
+    capture.initialize();
+    ImageSequenceWriter writer(outputDir.path(), parser.value("prefix"));
+    FrameStream stream;
+    if (streaming) {
+        GLenum glFormat;
+        GLenum glType;
+        int bytesPerPixel;
+        FrameStream::pixelLayout(streamFormat, &glFormat, &glType, &bytesPerPixel);
+        capture.setPixelFormat(glFormat, glType, bytesPerPixel);
+        if (!stream.open(parser.value("stream"), width, height, streamFormat)) {
+            return 1;
+        }
+        capture.setConsumer([&stream](const CapturedFrame& frame) {
+            stream.submit(frame);
+        });
+    } else {
+        capture.setConsumer([&writer](const CapturedFrame& frame) {
+            writer(frame);
+        });
+    }
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+    int lastStepFrame = -1;
+    for (int frame = 0; frame < frames; ++frame) {
+        // 固定相机：各帧与 --batch、--tile 和分布式渲染用同一套输入，首帧丢弃TAA历史
+        const BlackHoleFrameState state = defaults.frameState(frame);
+
+        QElapsedTimer frameTimer;
+        frameTimer.start();
+        if (relens) {
+            offscreen.renderLensingMap(state.backgroundType);
+        } else {
+            offscreen.renderFrame(state);
+        }
+        capture.capture(offscreen.target()->handle(), width, height);
+        capture.poll();
+        std::fprintf(stderr, "frame %d: %.2f ms\n", frame, frameTimer.nsecsElapsed() / 1.0e6);
+        // 计数器晚几帧读回，只打印新读到的帧
+        if (parser.isSet("step-stats")) {
+            const StepStatistics stats = offscreen.blackHoleRenderer().stepStatistics();
+            if (stats.frame > lastStepFrame) {
+                printStepStatistics(stats);
+                lastStepFrame = stats.frame;
+            }
+        }
+    }
+    if (parser.isSet("step-stats")) {
+        const StepStatistics stats = offscreen.blackHoleRenderer().stepStatistics(true);
+        if (stats.frame > lastStepFrame) {
+            printStepStatistics(stats);
+        }
+    }
+    capture.flush();
+    capture.release();
+    writer.waitForDone();
+    const bool streamOk = stream.close();
+
+    // stdout可能是原始帧流，统计信息一律输出到stderr
+    const double seconds = totalTimer.nsecsElapsed() / 1.0e9;
+    std::fprintf(stderr, "%d frames in %.2f s (%.2f fps, %.1f MP/s output)\n", frames, seconds, frames / seconds,
+                 double(width) * height * frames / seconds / 1.0e6);
+    if (faceSize > 0) {
+        std::fprintf(stderr, "cubemap: 6 x %d^2 rays per frame, %.1f MP/s traced\n", faceSize,
+                     6.0 * faceSize * faceSize * frames / seconds / 1.0e6);
+    }
+    if (streaming && (!streamOk || stream.framesWritten() != uint64_t(frames))) {
+        std::fprintf(stderr, "Frame stream incomplete: %llu of %d frames written\n",
+                     static_cast<unsigned long long>(stream.framesWritten()), frames);
+        return 1;
+    }
+    if (writer.failedCount() > 0) {
+        std::fprintf(stderr, "%d frames failed to write\n", writer.failedCount());
+        return 1;
+    }
+    return 0;
+}
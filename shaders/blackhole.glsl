@@ -0,0 +1,933 @@
+// circle.frag 与波前计算着色器（wavefront_*.comp）共用的uniform、物理常量和测地raymarching。
+// 由 BlackHoleRenderer 在编译前按 #include 展开，不单独编译
+uniform vec3 circleColor;
+uniform vec2 iResolution;  // 视口分辨率（分块渲染时为整幅图像分辨率）
+uniform vec2 iTileOffset;  // 分块渲染时视口在整幅图像中的像素偏移
+uniform float iFov;        // 针孔相机视场（半宽与焦距之比），立方体贴图的面为1.0
+uniform mat3 iCameraBasis[6]; // 按gl_Layer选择的视线旋转，非分层渲染时gl_Layer为0
+uniform vec2 offset;       // 偏移参数
+uniform float radius;      // 半径参数
+uniform sampler2D backgroundTexture;  // 背景纹理
+uniform int backgroundType; // 0: 棋盘, 1: 纯黑, 2: 星空, 3: 纹理
+uniform vec4 iMouse; // 添加 iMouse 变量
+uniform float iTime;              // 添加 iTime 变量 (类似Shadertoy)
+uniform sampler2D iChannel1;         // 棋盘格纹理 (类似Shadertoy)
+uniform sampler2D iChannel3;        // 上一帧纹理
+uniform float iTimeDelta;
+uniform vec3 iChannelResolution;  // 声明为vec3数组
+uniform int iFrame;           // 添加 iFrame 变量 (类似Shadertoy)
+uniform sampler2D deflectionTable;  // Schwarzschild 偏折表（RGBA32F，见 core/deflectiontable.h）
+uniform vec2 deflectionTableRange;  // 偏折表行覆盖的 r0 范围（Rs）
+uniform int useDeflectionTable;     // 0: 所有光线都逐步raymarching
+uniform int geodesicIntegrator;     // 0: 手调步长表, 1: 自适应 Dormand–Prince 5(4)
+uniform float geodesicTolerance;   // 自适应积分每步允许的相对误差
+uniform int maxGeodesicSteps;      // 每条光线的步数上限（含被拒绝的尝试），用完按逃逸或吞噬处理
+uniform sampler2DArray kerrTransfer; // Kerr 转移表（RGBA32F，见 core/kerrtransfer.h）
+uniform int useKerrTable;           // 0: Schwarzschild（a = 0），逐步raymarching或查偏折表
+uniform sampler3D diskNoise;         // 吸积盘噪声格点值（R16F，GL_REPEAT，见 core/noisevolume.h）
+uniform sampler2D emissionTables;    // 黑体颜色和盘的径向剖面（RGBA32F，三行，见 core/emissiontables.h）
+uniform usampler2D blueNoise;        // 像素和首步抖动的蓝噪声排名（RGB16UI，64x64 平铺，见 core/bluenoise.h）
+
+// 每帧常量，由 BlackHoleRenderer 按黑洞质量、盘法向和相机位置算好上传（布局见 core/frameparams.h）
+layout(std140, binding = 0) uniform BlackHoleFrameBlock
+{
+    mat3  FrameWorldToCamera;     // 世界系到相机系的旋转
+    mat3  FrameCameraToDisk;      // 相机系到黑洞系（y轴为盘法向）的旋转
+    vec4  FrameBlackHolePos;      // 相机系中的黑洞位置（xyz，下同；用vec4免得后面的float挤进vec3的第四个分量）
+    vec4  FrameCameraPosOnDisk;   // 黑洞系中的相机位置
+    vec4  FrameDiskAxis;          // 相机系中的盘法向
+    float FrameRs;                // 以下长度单位为光年
+    float FrameInterRadius;
+    float FrameOuterRadius;
+    float FrameDiskA;
+    float FrameQuadraticedPeakTemperature;
+    float FrameShiftMax;
+    float FrameTimeRate;
+    float FrameSpin;              // 无量纲自旋 a/M，只在 useKerrTable 时非零
+};
+
+// 着色器变体的特性键：BlackHoleRenderer 按 ShaderPermutation 在 #version 之后注入 #define，
+// 每种组合单独编译，循环里只留当前配置用到的代码。没有注入时取下面的默认值，背景按 backgroundType 运行时选择
+#ifndef BACKGROUND_TYPE
+#define BACKGROUND_TYPE backgroundType
+#endif
+#ifndef DISK_ENABLED
+#define DISK_ENABLED 1    // 0: 不着色吸积盘，只看背景的透镜
+#endif
+#ifndef TEMPORAL_BLEND
+#define TEMPORAL_BLEND 1  // 0: 不与上一帧混合（全景）
+#endif
+#ifndef DEBUG_VIEW
+#define DEBUG_VIEW 0      // 1: 逃逸方向, 2: 终止状态, 3: 步数热度图（见 CompositeBackground）
+#endif
+#ifndef STEP_STATS
+#define STEP_STATS 0      // 1: 统计每像素步数和吸积盘着色次数（circle.frag 的 RecordStepStats）
+#endif
+// 打开后 DiskNoise 退回逐格点 sin 哈希的 PerlinNoise，用于对照画面和耗时
+// #define ANALYTIC_DISK_NOISE
+// 打开后 DiskProfileAt、BlackbodyColor 不查 emissionTables，逐样本按公式计算
+// #define ANALYTIC_DISK_EMISSION
+
+// 物理常量
+#define PI 3.141592653589
+#define G0 6.673e-11
+#define lightspeed 299792458.0
+#define sigma 5.670373e-8
+#define ly 9460730472580800.0
+#define Msun 1.9891e30
+#define FOV 0.5
+
+const float kPi              = 3.141592653589;
+const float kGravityConstant = 6.673e-11;
+const float kSpeedOfLight    = 299792458.0;
+const float kSigma           = 5.670373e-8;
+const float kLightYear       = 9460730472580800.0;
+const float kSolarMass       = 1.9884e30;
+const float kSlabStepFraction = 0.05;  // 盘包围体外每步最长为到黑洞距离的这一比例
+
+// 像素的三个 [0, 1) 抖动值（x、y、首步步长）：蓝噪声平铺按像素取值，每帧按 R2 / 黄金分割序列平移，
+// 32 位定点相加保证与 BlueNoiseTile::sample 逐位相同
+vec3 JitterNoise(vec2 FragUv)
+{
+    ivec2 Pixel = ivec2(floor(FragUv * iResolution.xy)) & 63;
+    uvec3 Rank  = texelFetch(blueNoise, Pixel, 0).rgb;
+    uvec3 Fixed = (Rank << 20) + (1u << 19) + uint(iFrame) * uvec3(3242174889u, 2447445413u, 2654435769u);
+    return vec3(Fixed >> 8) * (1.0 / 16777216.0);
+}
+
+float CubicInterpolate(float x)
+{
+    return 3.0 * x * x - 2.0 * x * x * x;
+}
+
+float PerlinNoise(vec3 Position)
+{
+    vec3 PosInt   = floor(Position);
+    vec3 PosFloat = fract(Position);
+
+    float v000 = 2.0 * fract(sin(dot(vec3(PosInt.x,       PosInt.y,       PosInt.z),       vec3(12.9898, 78.233, 213.765))) * 43758.5453) - 1.0;
+    float v100 = 2.0 * fract(sin(dot(vec3(PosInt.x + 1.0, PosInt.y,       PosInt.z),       vec3(12.9898, 78.233, 213.765))) * 43758.5453) - 1.0;
+    float v010 = 2.0 * fract(sin(dot(vec3(PosInt.x,       PosInt.y + 1.0, PosInt.z),       vec3(12.9898, 78.233, 213.765))) * 43758.5453) - 1.0;
+    float v110 = 2.0 * fract(sin(dot(vec3(PosInt.x + 1.0, PosInt.y + 1.0, PosInt.z),       vec3(12.9898, 78.233, 213.765))) * 43758.5453) - 1.0;
+    float v001 = 2.0 * fract(sin(dot(vec3(PosInt.x,       PosInt.y,       PosInt.z + 1.0), vec3(12.9898, 78.233, 213.765))) * 43758.5453) - 1.0;
+    float v101 = 2.0 * fract(sin(dot(vec3(PosInt.x + 1.0, PosInt.y,       PosInt.z + 1.0), vec3(12.9898, 78.233, 213.765))) * 43758.5453) - 1.0;
+    float v011 = 2.0 * fract(sin(dot(vec3(PosInt.x,       PosInt.y + 1.0, PosInt.z + 1.0), vec3(12.9898, 78.233, 213.765))) * 43758.5453) - 1.0;
+    float v111 = 2.0 * fract(sin(dot(vec3(PosInt.x + 1.0, PosInt.y + 1.0, PosInt.z + 1.0), vec3(12.9898, 78.233, 213.765))) * 43758.5453) - 1.0;
+
+    float v00 = v001 * CubicInterpolate(PosFloat.z) + v000 * CubicInterpolate(1.0 - PosFloat.z);
+    float v10 = v101 * CubicInterpolate(PosFloat.z) + v100 * CubicInterpolate(1.0 - PosFloat.z);
+    float v01 = v011 * CubicInterpolate(PosFloat.z) + v010 * CubicInterpolate(1.0 - PosFloat.z);
+    float v11 = v111 * CubicInterpolate(PosFloat.z) + v110 * CubicInterpolate(1.0 - PosFloat.z);
+    float v0  = v01  * CubicInterpolate(PosFloat.y) + v00  * CubicInterpolate(1.0 - PosFloat.y);
+    float v1  = v11  * CubicInterpolate(PosFloat.y) + v10  * CubicInterpolate(1.0 - PosFloat.y);
+
+    return v1 * CubicInterpolate(PosFloat.x) + v0 * CubicInterpolate(1.0 - PosFloat.x);
+}
+
+// PerlinNoise 的查表版：格点值取自 kDiskNoiseSize^3 的可平铺体纹理。小数部分先过 CubicInterpolate
+// 再交给硬件三线性过滤，插值曲线与 PerlinNoise 相同，只是格点值不同，8个 sin 换成一次纹理读取
+const float kDiskNoiseSize = 64.0;
+
+float DiskNoise(vec3 Position)
+{
+#ifdef ANALYTIC_DISK_NOISE
+    return PerlinNoise(Position);
+#else
+    vec3 PosInt   = floor(Position);
+    vec3 PosFloat = Position - PosInt;
+    vec3 Weight   = PosFloat * PosFloat * (3.0 - 2.0 * PosFloat);
+    // 整数部分先取模，坐标很大时小数部分也不丢精度
+    return textureLod(diskNoise, (mod(PosInt, kDiskNoiseSize) + Weight + 0.5) / kDiskNoiseSize, 0.0).r;
+#endif
+}
+
+float SoftSaturate(float x)
+{
+    return 1.0 - 1.0 / (max(x, 0.0) + 1.0);
+}
+
+float GenerateAccretionDiskNoise(vec3 Position, int NoiseStartLevel, int NoiseEndLevel, float ContrastLevel)
+{
+    float NoiseAccumulator = 10.0;
+    float NoiseFrequency   = 1.0;
+    
+    for (int Level = NoiseStartLevel; Level < NoiseEndLevel; ++Level)
+    {
+        NoiseFrequency = pow(3.0, float(Level));
+        vec3 ScaledPosition = vec3(NoiseFrequency * Position.x, NoiseFrequency * Position.y, NoiseFrequency * Position.z);
+
+        NoiseAccumulator *= (1.0 + 0.1 * DiskNoise(ScaledPosition));
+    }
+    
+    return log(1.0 + pow(0.1 * NoiseAccumulator, ContrastLevel));
+}
+
+float Vec2ToTheta(vec2 v1, vec2 v2)
+{
+    if (dot(v1, v2) > 0.0)
+    {
+        return asin(0.999999 * (v1.x * v2.y - v1.y * v2.x) / length(v1) / length(v2));
+    }
+    else if (dot(v1, v2) < 0.0 && (-v1.x * v2.y + v1.y * v2.x) < 0.0)
+    {
+        return kPi - asin(0.999999 * (v1.x * v2.y - v1.y * v2.x) / length(v1) / length(v2));
+    }
+    else if (dot(v1, v2) < 0.0 && (-v1.x * v2.y + v1.y * v2.x) > 0.0)
+    {
+        return -kPi - asin(0.999999 * (v1.x * v2.y - v1.y * v2.x) / length(v1) / length(v2));
+    }
+}
+
+vec3 KelvinToRgb(float Kelvin)
+{
+    if (Kelvin < 400.01)
+    {
+        return vec3(0.0);
+    }
+
+    float Teff     = (Kelvin - 6500.0) / (6500.0 * Kelvin * 2.2);
+    vec3  RgbColor = vec3(0.0);
+    
+    RgbColor.r = exp(2.05539304e4 * Teff);
+    RgbColor.g = exp(2.63463675e4 * Teff);
+    RgbColor.b = exp(3.30145739e4 * Teff);
+
+    float BrightnessScale = 1.0 / max(max(RgbColor.r, RgbColor.g), RgbColor.b);
+    
+    if (Kelvin < 1000.0)
+    {
+        BrightnessScale *= (Kelvin - 400.0) / 600.0;
+    }
+    
+    RgbColor *= BrightnessScale;
+    return RgbColor;
+}
+
+float GetKeplerianAngularVelocity(float Radius, float Rs)
+{
+    return sqrt(kSpeedOfLight / kLightYear * kSpeedOfLight * Rs / kLightYear / ((2.0 * Radius - 3.0 * Rs) * Radius * Radius));
+}
+
+vec3 FragUvToDir(vec2 FragUv, float Fov)
+{
+    return normalize(vec3(Fov * (2.0 * FragUv.x - 1.0), Fov * (2.0 * FragUv.y - 1.0) * iResolution.y / iResolution.x, -1.0));
+}
+
+vec2 PosToNdc(vec4 Pos)
+{
+    return vec2(-Pos.x / Pos.z, -Pos.y / Pos.z * iResolution.x / iResolution.y);
+}
+
+vec2 DirToNdc(vec3 Dir)
+{
+    return vec2(-Dir.x / Dir.z, -Dir.y / Dir.z * iResolution.x / iResolution.y);
+}
+
+vec2 DirToFragUv(vec3 Dir)
+{
+    return vec2(0.5 - 0.5 * Dir.x / Dir.z, 0.5 - 0.5 * Dir.y / Dir.z * iResolution.x / iResolution.y);
+}
+
+vec2 PosToFragUv(vec4 Pos)
+{
+    return vec2(0.5 - 0.5 * Pos.x / Pos.z, 0.5 - 0.5 * Pos.y / Pos.z * iResolution.x / iResolution.y);
+}
+
+float Shape(float x, float Alpha, float Beta)
+{
+    float k = pow(Alpha + Beta, Alpha + Beta) / (pow(Alpha, Alpha) * pow(Beta, Beta));
+    return k * pow(x, Alpha) * pow(1.0 - x, Beta);
+}
+
+vec4 BackgroundColor(vec4 BaseColor, vec3 RayDir)  // 光线远离黑洞后按方向取背景
+{
+    vec2 FragUv = DirToFragUv(RayDir);
+    if (BACKGROUND_TYPE == 0) { // 棋盘背景
+        BaseColor += 0.5 * texelFetch(iChannel1, ivec2(vec2(fract(FragUv.x), fract(FragUv.y)) * iChannelResolution.xy), 0) * (1.0 - BaseColor.a);
+    } else if (BACKGROUND_TYPE == 1) { // 纯黑背景
+        BaseColor += vec4(0.0, 0.0, 0.0, 1.0) * (1.0 - BaseColor.a);
+    } else if (BACKGROUND_TYPE == 3) { // 使用第一通道的纹理
+        BaseColor += 0.5 * texture(backgroundTexture, vec2(fract(FragUv.x), fract(FragUv.y)) * (1.0 - BaseColor.a));
+    } else { // 其他背景类型使用棋盘
+        BaseColor += 0.5 * texture(iChannel1, vec2(fract(FragUv.x), fract(FragUv.y)) * (1.0 - BaseColor.a));
+    }
+    return BaseColor;
+}
+
+// 查 Schwarzschild 偏折表（DeflectionTable）。光线在 (径向, 视线) 平面内扫过 Sweep 的方位角，
+// 其中在吸积盘外接球内的一段为 [DiskEnter, DiskExit]；只要这一段离盘面的高度始终不小于盘的半厚度，
+// 光线就不可能进入吸积盘，返回true并给出结果：Captured 为落入视界，否则 EscapeDir 为无穷远处的方向
+// 表外、光子环附近或可能进入吸积盘时返回false，由调用方逐步raymarching。表按 OuterRadius = 12 Rs 生成
+bool LookupDeflection(vec3 ViewDir, vec3 BlackHolePos, vec3 DiskNormal, float Rs, float InterRadius,
+                      out vec3 EscapeDir, out bool Captured)
+{
+    EscapeDir = ViewDir;
+    Captured  = false;
+    vec3  ToCamera = -BlackHolePos;
+    float R0       = length(ToCamera) / Rs;
+    if (R0 < deflectionTableRange.x || R0 > deflectionTableRange.y)
+    {
+        return false;
+    }
+    vec3  Radial = ToCamera / (R0 * Rs);
+    float Psi    = acos(clamp(dot(ViewDir, Radial), -1.0, 1.0));
+    vec2  Size   = vec2(textureSize(deflectionTable, 0));
+    vec2  Texel  = vec2(Psi / kPi, log(R0 / deflectionTableRange.x) / log(deflectionTableRange.y / deflectionTableRange.x));
+    vec4  Entry  = texture(deflectionTable, (Texel * (Size - 1.0) + 0.5) / Size);
+    float Sweep  = Entry.r;
+    if (Entry.g > 999.0)
+    {
+        Captured = true;
+    }
+    else if (Entry.g > 0.7 || Sweep > 1.5 * kPi)
+    {  // 混入了被吞噬的纹素，或在光子环附近：插值不可靠
+        return false;
+    }
+
+    vec3 Tangent = ViewDir - Radial * dot(ViewDir, Radial);
+    Tangent = dot(Tangent, Tangent) > 1e-12 ? normalize(Tangent) : normalize(cross(Radial, abs(Radial.x) < 0.9 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0)));
+
+    // 方位角 Phi 处单位半径到盘面的有向高度为 A cos(Phi) + B sin(Phi) = C cos(Phi - Alpha)
+    // 盘只在 InterRadius 之外，轨道半径不小于 max(近心点, InterRadius)；被吞噬的光线按 InterRadius 算
+    float RLow = max(Captured ? 0.0 : 1.0 / max(Entry.g, 1e-6), InterRadius / Rs);
+    if (RLow < 12.0104 && Entry.a > Entry.b)
+    {
+        vec3  Normal    = normalize(DiskNormal);
+        float A         = dot(Radial, Normal);
+        float B         = dot(Tangent, Normal);
+        float FirstZero = Entry.b + mod(atan(B, A) + 0.5 * kPi - Entry.b, kPi);
+        float Clearance = min(abs(A * cos(Entry.b) + B * sin(Entry.b)), abs(A * cos(Entry.a) + B * sin(Entry.a)));
+        if (FirstZero <= Entry.a || Clearance * RLow < 0.5)
+        {
+            return false;
+        }
+    }
+    EscapeDir = cos(Sweep) * Radial + sin(Sweep) * Tangent;
+    return true;
+}
+
+bool InDiskSlab(vec3 PosOnDisk, float Rs, float InterRadius, float OuterRadius)  // DiskColor 可能非零的薄层
+{
+    float PosR = length(PosOnDisk.zx);
+    return abs(PosOnDisk.y) < 0.5 * Rs && PosR < OuterRadius && PosR > InterRadius;
+}
+
+// 盘的厚度和密度按半径的分布，内缘为1，外缘为0.5
+float DiskEffectiveRadius(float PosR, float Rs, float InterRadius, float OuterRadius)
+{
+    float EffectiveRadius = 1.0 - ((PosR - InterRadius) / (OuterRadius - InterRadius) * 0.5);
+    if ((OuterRadius - InterRadius) > 9.0 * Rs)
+    {
+        if (PosR < 5.0 * Rs + InterRadius)
+        {
+            EffectiveRadius = 1.0 - ((PosR - InterRadius) / (9.0 * Rs) * 0.5);
+        }
+        else
+        {
+            EffectiveRadius = 1.0 - (0.5 / 0.9 * 0.5 + ((PosR - InterRadius) / (OuterRadius - InterRadius) -
+                              5.0 * Rs / (OuterRadius - InterRadius)) / (1.0 - 5.0 * Rs / (OuterRadius - InterRadius)) * 0.5);
+        }
+    }
+    return EffectiveRadius;
+}
+
+// 样本所在半径上与方位、高度无关的盘参数
+struct DiskProfile
+{
+    float Density;       // Shape(EffectiveRadius, 4, 0.9)，盘的半厚度（0.5Rs为单位）和密度
+    float Dust;          // 尘埃层的半厚度（0.5Rs为单位）
+    float Temperature;   // 未频移的盘温度（K）
+    float InnerBoost;    // 内侧增加的密度
+    float Cooling;       // 颜色温度向外降低的倍数
+    float OrbitRate;     // 开普勒角速度乘 kLightYear / kSpeedOfLight，乘 cross(y, PosOnDisk) 即云的速度（光速为单位）
+    float GravityShift;  // 引力红移 sqrt(1 - Rs / PosR)
+    float SpiralTheta;   // 旋臂转角
+};
+
+const float kEmissionTableWidth = 1024.0;
+const float kEmissionMinKelvin  = 400.0;
+const float kEmissionMaxKelvin  = 100000.0;
+
+// emissionTables 第 Row 行在 x（0~1）处的值，行内线性插值，行间不混合
+vec4 EmissionTableRow(float x, float Row)
+{
+    return textureLod(emissionTables, vec2((clamp(x, 0.0, 1.0) * (kEmissionTableWidth - 1.0) + 0.5) / kEmissionTableWidth, (Row + 0.5) / 3.0), 0.0);
+}
+
+DiskProfile DiskProfileAt(float PosR, float Rs, float InterRadius, float OuterRadius, float DiskTemperatureArgument)
+{
+    DiskProfile Profile;
+#ifdef ANALYTIC_DISK_EMISSION
+    float EffectiveRadius = DiskEffectiveRadius(PosR, Rs, InterRadius, OuterRadius);
+    Profile.Density      = Shape(EffectiveRadius, 4.0, 0.9);
+    Profile.Dust         = 1.0 - 5.0 * pow(2.0 * (1.0 - EffectiveRadius), 2.0);
+    Profile.Temperature  = pow(DiskTemperatureArgument * pow(max(Rs/PosR,0.10),3.0) * max(1.0 - sqrt(InterRadius / PosR), 0.000001), 0.25);
+    Profile.InnerBoost   = 1.0 + 20.0 * exp(-10.0 * (PosR - InterRadius) / (OuterRadius - InterRadius));
+    Profile.Cooling      = exp((PosR - InterRadius) / (0.6 * (OuterRadius - InterRadius)));
+    Profile.OrbitRate    = kLightYear / kSpeedOfLight * GetKeplerianAngularVelocity(PosR, Rs);
+    Profile.GravityShift = sqrt(max(1.0 - Rs / PosR, 0.000001));
+    Profile.SpiralTheta  = 12.0*2.0/sqrt(3.0)*(atan(sqrt(max(0.6666666*(PosR/Rs)-1.0,0.0))));
+#else
+    float x       = (PosR - InterRadius) / (OuterRadius - InterRadius);
+    vec4  Shape0  = EmissionTableRow(x, 1.0);
+    vec4  Motion  = EmissionTableRow(x, 2.0);
+    Profile.Density      = Shape0.r;
+    Profile.Dust         = Shape0.g;
+    Profile.Temperature  = sqrt(sqrt(Shape0.b));
+    Profile.InnerBoost   = Shape0.a;
+    Profile.Cooling      = Motion.r;
+    Profile.OrbitRate    = Motion.g / PosR;
+    Profile.GravityShift = Motion.b;
+    Profile.SpiralTheta  = Motion.a;
+#endif
+    return Profile;
+}
+
+// KelvinToRgb(Kelvin / Cooling)；表按 1/K 均匀取样，低于 kEmissionMinKelvin 时夹到黑色
+vec3 BlackbodyColor(float Kelvin, float Cooling)
+{
+#ifdef ANALYTIC_DISK_EMISSION
+    return KelvinToRgb(Kelvin / Cooling);
+#else
+    float Inverse = Cooling / Kelvin;
+    return EmissionTableRow((Inverse - 1.0 / kEmissionMaxKelvin) / (1.0 / kEmissionMinKelvin - 1.0 / kEmissionMaxKelvin), 0.0).rgb;
+#endif
+}
+
+// 盘包围体内一个样本的吸积盘颜色（未与 BaseColor 叠加），频移由调用方给出：
+// Dopler 为发射体运动造成的多普勒因子，RedShift 为观测与发射频率之比（含引力红移），DirY 为光线方向在盘法向上的分量
+vec4 DiskEmission(float TimeRate, float StepLength, vec3 PosOnDisk, float DirY, float Dopler, float RedShift,
+                  DiskProfile Profile, float Rs, float InterRadius, float OuterRadius,
+                  float QuadraticedPeakTemperature, float ShiftMax)
+{
+    float PosR = length(PosOnDisk.zx);
+    float PosY = PosOnDisk.y;
+
+    vec4  Color           = vec4(0.0);
+
+    if ((abs(PosY) < 0.5 * Rs * Profile.Density) || (PosY < 0.5 * Rs * Profile.Dust))
+    {
+        float HalfPiTimeInside = kPi / GetKeplerianAngularVelocity(3.0 * Rs, Rs);
+
+        float SpiralTheta = Profile.SpiralTheta;
+        float InnerTheta= kPi / HalfPiTimeInside *iTime * TimeRate ;
+        float PosThetaForInnerCloud = Vec2ToTheta(PosOnDisk.zx, vec2(cos(0.666666*InnerTheta),sin(0.666666*InnerTheta)));
+        float PosTheta            = Vec2ToTheta(PosOnDisk.zx, vec2(cos(-SpiralTheta), sin(-SpiralTheta)));
+
+        // 计算盘温度
+        float DiskTemperature = Profile.Temperature;
+
+        float Density           = 0.0;
+        float Thick             = 0.0;
+        float VerticalMixFactor = 0.0;
+        float DustColor         = 0.0;
+        
+        float RotPosR=PosR/Rs+0.3*sqrt(3.0)*kSpeedOfLight/kLightYear /3.0/sqrt(3.0)/Rs*TimeRate*iTime;
+        
+        vec4  Color0            = vec4(0.0);
+        
+        Density = Profile.Density;
+        if (abs(PosY) < 0.5 * Rs * Density)
+        {
+            Thick = 0.5 * Rs * Density * (0.4 + 0.6 * SoftSaturate(GenerateAccretionDiskNoise(vec3(1.5 * PosTheta,RotPosR, 1.0), 1, 3, 80.0))); // 盘厚
+            VerticalMixFactor = max(0.0, (1.0 - abs(PosY) / Thick));
+            Density    *= 0.7 * VerticalMixFactor * Density;
+            Color0      = vec4(GenerateAccretionDiskNoise(vec3(1.0 * RotPosR, 1.0 * PosY / Rs, 0.5 * PosTheta), 3, 6, 80.0)); // 云本体
+            Color0.xyz *= Density * 1.4 * (0.2 + 0.8 * VerticalMixFactor + (0.8 - 0.8 * VerticalMixFactor) *
+                          GenerateAccretionDiskNoise(vec3(RotPosR, 1.5 * PosTheta, PosY / Rs), 1, 3, 80.0));
+            Color0.a   *= (Density); // * (1.0 + VerticalMixFactor);
+        }
+        if (abs(PosY) < 0.5 * Rs * Profile.Dust)
+        {
+            DustColor = max(1.0 - pow(PosY / (0.5 * Rs * max(Profile.Dust, 0.0001)), 2.0), 0.0) * GenerateAccretionDiskNoise(vec3(1.5 * fract((1.5 *  PosThetaForInnerCloud + kPi / HalfPiTimeInside *iTime*TimeRate) / 2.0 / kPi) * 2.0 * kPi, PosR / Rs, PosY / Rs), 0, 6, 80.0);
+            Color0 += 0.02 * vec4(vec3(DustColor), 0.2 * DustColor) * sqrt(1.0001 - DirY * DirY) * min(1.0, Dopler * Dopler);
+        }
+       
+        Color =  Color0;
+        Color *= Profile.InnerBoost; // 内侧增加密度
+
+        float BrightWithoutRedshift = 4.5 * DiskTemperature * DiskTemperature * DiskTemperature * DiskTemperature / QuadraticedPeakTemperature;  // 原亮度
+        if (DiskTemperature > 1000.0)
+        {
+            DiskTemperature = max(1000.0, DiskTemperature * RedShift * Dopler * Dopler);
+        }
+
+        DiskTemperature = min(100000.0, DiskTemperature);
+
+        Color.xyz *= BrightWithoutRedshift * min(1.0, 1.8 * (OuterRadius - PosR) / (OuterRadius - InterRadius)) *
+                     BlackbodyColor(DiskTemperature, Profile.Cooling);
+        Color.xyz *= min(ShiftMax, RedShift) * min(ShiftMax, Dopler);
+
+        RedShift=min(RedShift,ShiftMax);
+        Color.xyz *= pow((1.0 - (1.0 - min(1., RedShift)) * (PosR - InterRadius) / (OuterRadius - InterRadius)), 9.0);
+        Color.xyz *= min(1.0, 1.0 + 0.5 * ((PosR - InterRadius) / InterRadius + InterRadius / (PosR - InterRadius)) - max(1.0, RedShift));
+
+        Color *= StepLength / Rs;
+    }
+    return Color;
+}
+
+// 黑洞系中一个样本的吸积盘颜色。光线路径只决定 PosOnDisk、DirOnDisk 和 StepLength，其余随 iTime 变化
+vec4 DiskColorAt(vec4 BaseColor, float TimeRate, float StepLength, vec3 CameraPos, vec3 PosOnDisk, vec3 DirOnDisk,
+                 float Rs, float InterRadius, float OuterRadius, float DiskTemperatureArgument,
+                 float QuadraticedPeakTemperature, float ShiftMax)
+{
+    vec4 Color = vec4(0.0);
+    if (InDiskSlab(PosOnDisk, Rs, InterRadius, OuterRadius))
+    {
+        float       PosR    = length(PosOnDisk.zx);
+        DiskProfile Profile = DiskProfileAt(PosR, Rs, InterRadius, OuterRadius, DiskTemperatureArgument);
+        // 计算云相对速度
+        vec3  CloudVelocity    = Profile.OrbitRate * cross(vec3(0., 1., 0.), PosOnDisk);
+        float RelativeVelocity = dot(-DirOnDisk, CloudVelocity);
+        // 计算多普勒因子
+        float Dopler = sqrt((1.0 + RelativeVelocity) / (1.0 - RelativeVelocity));
+        // 总红移量，含多普勒因子和引力红移和
+        float RedShift = Dopler * Profile.GravityShift / sqrt(max(1.0 - Rs / length(CameraPos), 0.000001));
+        Color = DiskEmission(TimeRate, StepLength, PosOnDisk, DirOnDisk.y, Dopler, RedShift, Profile, Rs, InterRadius,
+                             OuterRadius, QuadraticedPeakTemperature, ShiftMax);
+    }
+
+    return BaseColor + Color * (1.0 - BaseColor.a);
+}
+
+// 自适应积分：位置以Rs为单位、相对黑洞，光线满足 d²P/ds² = -1.5 L² P / |P|^5（L = |P × V| 守恒），
+// 与 Binet 方程 u'' + u = 1.5 u² 给出同一条轨道
+vec3 GeodesicAcceleration(vec3 P, float L2)
+{
+    float R2 = dot(P, P);
+    return -1.5 * L2 * P / (R2 * R2 * sqrt(R2));
+}
+
+// Dormand–Prince 5(4) 的一步，返回误差与容差之比（<= 1 时接受）
+// Accel 传入 P 处的加速度，接受时即为新位置处的加速度（FSAL，下一步不必重算）
+float DormandPrinceStep(vec3 P, vec3 V, float L2, float H, float Tolerance, inout vec3 Accel, out vec3 NewP, out vec3 NewV)
+{
+    vec3 K1p = V;
+    vec3 K1v = Accel;
+    vec3 K2p = V + H * (0.2 * K1v);
+    vec3 K2v = GeodesicAcceleration(P + H * (0.2 * K1p), L2);
+    vec3 K3p = V + H * (3.0 / 40.0 * K1v + 9.0 / 40.0 * K2v);
+    vec3 K3v = GeodesicAcceleration(P + H * (3.0 / 40.0 * K1p + 9.0 / 40.0 * K2p), L2);
+    vec3 K4p = V + H * (44.0 / 45.0 * K1v - 56.0 / 15.0 * K2v + 32.0 / 9.0 * K3v);
+    vec3 K4v = GeodesicAcceleration(P + H * (44.0 / 45.0 * K1p - 56.0 / 15.0 * K2p + 32.0 / 9.0 * K3p), L2);
+    vec3 K5p = V + H * (19372.0 / 6561.0 * K1v - 25360.0 / 2187.0 * K2v + 64448.0 / 6561.0 * K3v - 212.0 / 729.0 * K4v);
+    vec3 K5v = GeodesicAcceleration(P + H * (19372.0 / 6561.0 * K1p - 25360.0 / 2187.0 * K2p + 64448.0 / 6561.0 * K3p - 212.0 / 729.0 * K4p), L2);
+    vec3 K6p = V + H * (9017.0 / 3168.0 * K1v - 355.0 / 33.0 * K2v + 46732.0 / 5247.0 * K3v + 49.0 / 176.0 * K4v - 5103.0 / 18656.0 * K5v);
+    vec3 K6v = GeodesicAcceleration(P + H * (9017.0 / 3168.0 * K1p - 355.0 / 33.0 * K2p + 46732.0 / 5247.0 * K3p + 49.0 / 176.0 * K4p - 5103.0 / 18656.0 * K5p), L2);
+    NewP = P + H * (35.0 / 384.0 * K1p + 500.0 / 1113.0 * K3p + 125.0 / 192.0 * K4p - 2187.0 / 6784.0 * K5p + 11.0 / 84.0 * K6p);
+    NewV = V + H * (35.0 / 384.0 * K1v + 500.0 / 1113.0 * K3v + 125.0 / 192.0 * K4v - 2187.0 / 6784.0 * K5v + 11.0 / 84.0 * K6v);
+    vec3 K7p = NewV;
+    vec3 K7v = GeodesicAcceleration(NewP, L2);
+    // 五阶与四阶之差
+    vec3 ErrorP = H * (71.0 / 57600.0 * K1p - 71.0 / 16695.0 * K3p + 71.0 / 1920.0 * K4p - 17253.0 / 339200.0 * K5p + 22.0 / 525.0 * K6p - 1.0 / 40.0 * K7p);
+    vec3 ErrorV = H * (71.0 / 57600.0 * K1v - 71.0 / 16695.0 * K3v + 71.0 / 1920.0 * K4v - 17253.0 / 339200.0 * K5v + 22.0 / 525.0 * K6v - 1.0 / 40.0 * K7v);
+    float Error = max(length(ErrorP) / length(P), length(ErrorV) / length(V)) / Tolerance;
+    if (Error <= 1.0)
+    {
+        Accel = K7v;
+    }
+    return Error;
+}
+
+// 每帧常量，从 BlackHoleFrameBlock 取出，长度单位为光年
+struct BlackHoleFrame
+{
+    float TimeRate;  // 所有iTime*TimeRate应替换为游戏内时间
+    float Rs;
+    float InterRadius;  // 盘内缘，正常情况下等于最内稳定圆轨
+    float OuterRadius;
+    float DiskA;        // 吸积盘温度系数
+    float QuadraticedPeakTemperature;  // 峰值温度的四次方，用于自适应亮度
+    float ShiftMax;     // 蓝移的亮度增加上限，以免亮部过于亮
+    vec3  BlackHolePos;   // 以下在相机系
+    vec3  DiskAxis;
+    mat3  CameraToDisk;   // 相机系到黑洞系的旋转
+    vec3  CameraPosOnDisk;
+};
+
+BlackHoleFrame SetupFrame()
+{
+    BlackHoleFrame Frame;
+    Frame.TimeRate                   = FrameTimeRate;
+    Frame.Rs                         = FrameRs;
+    Frame.InterRadius                = FrameInterRadius;
+    Frame.OuterRadius                = FrameOuterRadius;
+    Frame.DiskA                      = FrameDiskA;
+    Frame.QuadraticedPeakTemperature = FrameQuadraticedPeakTemperature;
+    Frame.ShiftMax                   = FrameShiftMax;
+    Frame.BlackHolePos               = FrameBlackHolePos.xyz;
+    // 盘的包围体（黑洞系中 |y| < 0.5Rs、InterRadius < r < OuterRadius）只需盘法向：
+    // 包围体外的步不调用DiskColorAt，并可一步走到离包围体最近的距离
+    Frame.DiskAxis        = FrameDiskAxis.xyz;
+    Frame.CameraToDisk    = FrameCameraToDisk;
+    Frame.CameraPosOnDisk = FrameCameraPosOnDisk.xyz;
+    return Frame;
+}
+
+// 像素的初始视线方向（含抖动），Layer 选择 iCameraBasis
+vec3 PrimaryViewDir(vec2 FragUv, int Layer)
+{
+    return iCameraBasis[Layer] * FragUvToDir(FragUv + 0.5 * JitterNoise(FragUv).xy / iResolution.xy, iFov);
+}
+
+// 一条光线的raymarching状态，逐步推进时由 MarchShade/MarchAdvance 更新
+struct MarchState
+{
+    vec2  FragUv;
+    vec3  RayPos;
+    vec3  RayDir;
+    float StepLength;
+    float LastR;
+    int   Count;
+    int   DiskCalls;   // DiskColorAt 的调用次数，只在 STEP_STATS 时累加
+    vec4  Color;
+    bool  Opaque;
+    bool  Escaped;
+    vec3  EscapeDir;
+    // 自适应积分的状态（以Rs为单位）
+    vec3  GeodesicPos;
+    vec3  GeodesicVel;
+    vec3  GeodesicAccel;
+    float GeodesicL2;
+    float GeodesicH;   // 下一步的建议步长
+    // 本步的中间量，MarchShade 算出供 MarchAdvance 使用
+    float Distance;
+    vec3  NormalizedPos;
+    float SlabGap;
+};
+
+MarchState StartRay(BlackHoleFrame Frame, vec2 FragUv, vec3 ViewDir)
+{
+    MarchState Ray;
+    Ray.FragUv = FragUv;
+    Ray.RayPos = vec3(0.0, 0.0, 0.0);
+
+    vec3  PosToBlackHole           = Ray.RayPos - Frame.BlackHolePos;
+    float DistanceToBlackHole      = length(PosToBlackHole);
+    vec3  NormalizedPosToBlackHole = PosToBlackHole / DistanceToBlackHole;
+    float Rs                       = Frame.Rs;
+
+    Ray.RayDir=normalize(ViewDir-NormalizedPosToBlackHole*dot(NormalizedPosToBlackHole,ViewDir)*(-sqrt(max(1.0-Rs*CubicInterpolate(max(min(1.0-(0.01*DistanceToBlackHole/Rs-1.0)/4.0,1.0),0.0))/DistanceToBlackHole,0.00000000000000001))+1.0));
+    Ray.StepLength    = 0.;
+    Ray.LastR         = length(PosToBlackHole);
+    Ray.Count         = 0;
+    Ray.DiskCalls     = 0;
+    Ray.Color         = vec4(0., 0., 0., 0.);
+    Ray.Opaque        = false;
+    Ray.Escaped       = false;
+    Ray.EscapeDir     = vec3(0.0);
+    Ray.GeodesicPos   = PosToBlackHole / Rs;
+    Ray.GeodesicVel   = Ray.RayDir;
+    Ray.GeodesicAccel = vec3(0.0);
+    Ray.GeodesicL2    = dot(cross(Ray.GeodesicPos, Ray.GeodesicVel), cross(Ray.GeodesicPos, Ray.GeodesicVel));
+    Ray.GeodesicH     = 0.15;
+    Ray.SlabGap       = 0.;
+    return Ray;
+}
+
+// 不会进入吸积盘的光线直接查表得到逃逸方向，省去整个raymarching；查到时返回true，背景由 CompositeBackground 叠加
+bool TraceByDeflectionTable(BlackHoleFrame Frame, vec3 ViewDir, inout MarchState Ray)
+{
+    bool Captured;
+    vec3 EscapeDir;
+    if (LookupDeflection(ViewDir, Frame.BlackHolePos, Frame.DiskAxis, Frame.Rs, Frame.InterRadius, EscapeDir, Captured))
+    {
+        Ray.Escaped   = !Captured;
+        Ray.EscapeDir = EscapeDir;
+        return true;
+    }
+    return false;
+}
+
+// 查 Kerr 转移表的一个穿越层：四个纹素都有穿越且位置相近时双线性插值，
+// 否则（盘边缘、光子环附近的跳变处）取最近的纹素
+vec4 SampleKerrCrossing(vec3 Uvw)
+{
+    vec4 Xs     = textureGather(kerrTransfer, Uvw, 0);
+    vec4 Ys     = textureGather(kerrTransfer, Uvw, 1);
+    vec4 Gs     = textureGather(kerrTransfer, Uvw, 2);
+    vec2 Center = vec2(dot(Xs, vec4(0.25)), dot(Ys, vec4(0.25)));
+    vec4 Spread = abs(Xs - Center.x) + abs(Ys - Center.y);
+    if (min(min(Gs.x, Gs.y), min(Gs.z, Gs.w)) > 0.0 && max(max(Spread.x, Spread.y), max(Spread.z, Spread.w)) < 0.1 + 0.2 * length(Center))
+    {
+        return texture(kerrTransfer, Uvw);
+    }
+    ivec2 Size  = textureSize(kerrTransfer, 0).xy;
+    ivec2 Texel = ivec2(floor(Uvw.xy * vec2(Size)));
+    Texel = ivec2((Texel.x % Size.x + Size.x) % Size.x, clamp(Texel.y, 0, Size.y - 1));
+    return texelFetch(kerrTransfer, ivec3(Texel, int(Uvw.z)), 0);
+}
+
+// 转移表给出的一次赤道面穿越的吸积盘颜色。薄盘近似：只在中面取一个样本，步长取光线斜穿半厚度的路径长度，
+// 中面以外的密度随高度线性衰减，平均约为中面的一半
+vec4 KerrDiskColor(vec4 BaseColor, BlackHoleFrame Frame, vec4 Crossing, vec2 ObserverRot, float CameraRedShift)
+{
+    if (Crossing.z <= 0.0)
+    {
+        return BaseColor;
+    }
+    float Rs = Frame.Rs;
+    // 表按观察者方位角为0生成，绕自旋轴转到实际方位；BL 笛卡尔 (X, Y) 即黑洞系的 (z, x)
+    vec2 Pos       = vec2(ObserverRot.x * Crossing.x - ObserverRot.y * Crossing.y, ObserverRot.y * Crossing.x + ObserverRot.x * Crossing.y);
+    vec3 PosOnDisk = vec3(Pos.y, 0.0, Pos.x) * Rs;
+    if (!InDiskSlab(PosOnDisk, Rs, Frame.InterRadius, Frame.OuterRadius))
+    {
+        return BaseColor;
+    }
+    float       PosR       = length(Pos) * Rs;
+    DiskProfile Profile    = DiskProfileAt(PosR, Rs, Frame.InterRadius, Frame.OuterRadius, Frame.DiskA);
+    float       StepLength = 0.25 * Rs * Profile.Density / max(Crossing.w, 0.05);
+    // 表中的频移已含引力红移和盘的运动，按 DiskColorAt 的约定拆出多普勒部分
+    float RedShift = Crossing.z;
+    float Dopler   = RedShift * CameraRedShift / Profile.GravityShift;
+    vec4  Color    = DiskEmission(Frame.TimeRate, StepLength, PosOnDisk, Crossing.w, Dopler, RedShift, Profile, Rs,
+                                  Frame.InterRadius, Frame.OuterRadius, Frame.QuadraticedPeakTemperature, Frame.ShiftMax);
+    return BaseColor + Color * (1.0 - BaseColor.a);
+}
+
+// Kerr 黑洞的光线不做raymarching，查转移表得到两次赤道面穿越和逃逸方向，总是返回true
+// 相机按零角动量观察者处理，ViewDir 即其本地方向
+bool TraceByKerrTable(BlackHoleFrame Frame, vec3 ViewDir, inout MarchState Ray)
+{
+    // 黑洞系 (x, y, z) 即 BL 笛卡尔 (Y, Z, X)
+    vec3 Camera = Frame.CameraPosOnDisk.zxy;
+    vec3 Dir    = (Frame.CameraToDisk * ViewDir).zxy;
+
+    float Radius      = length(Camera);
+    float CosTheta    = Camera.z / Radius;
+    float SinTheta    = length(Camera.xy) / Radius;
+    vec2  ObserverRot = SinTheta > 0.0 ? Camera.xy / length(Camera.xy) : vec2(1.0, 0.0);
+    vec3  Er          = vec3(SinTheta * ObserverRot, CosTheta);
+    vec3  Etheta      = vec3(CosTheta * ObserverRot, -SinTheta);
+    vec3  Ephi        = vec3(-ObserverRot.y, ObserverRot.x, 0.0);
+    float Psi         = acos(clamp(-dot(Dir, Er), -1.0, 1.0));
+    float Chi         = atan(dot(Dir, Ephi), dot(Dir, Etheta));
+    Chi += Chi < 0.0 ? 2.0 * kPi : 0.0;
+    vec2 Size = vec2(textureSize(kerrTransfer, 0).xy);
+    vec2 Uv   = vec2(Chi / (2.0 * kPi) + 0.5 / Size.x, (Psi / kPi * (Size.y - 1.0) + 0.5) / Size.y);
+
+#if DISK_ENABLED
+    float CameraRedShift = sqrt(max(1.0 - Frame.Rs / Radius, 0.000001));
+    for (int Layer = 0; Layer < 2 && Ray.Color.a <= 0.99; ++Layer)
+    {
+        Ray.Color = KerrDiskColor(Ray.Color, Frame, SampleKerrCrossing(vec3(Uv, float(Layer))), ObserverRot, CameraRedShift);
+    }
+#endif
+    Ray.Opaque = Ray.Color.a > 0.99;
+
+    vec4 Escape = texture(kerrTransfer, vec3(Uv, 2.0));
+    Ray.Escaped = Escape.w > 0.5;
+    if (Ray.Escaped)
+    {
+        vec3 EscapeDir = vec3(ObserverRot.x * Escape.x - ObserverRot.y * Escape.y, ObserverRot.y * Escape.x + ObserverRot.x * Escape.y, Escape.z);
+        Ray.EscapeDir  = normalize(EscapeDir.yzx) * Frame.CameraToDisk;
+    }
+    return true;
+}
+
+// 测地raymarching的一步：终止判断和吸积盘着色，返回光线是否继续。
+// TraceWhenOpaque 为真时不透明后继续追踪（只是不再累加颜色）
+bool MarchShade(BlackHoleFrame Frame, inout MarchState Ray, bool TraceWhenOpaque)
+{
+    bool  flag     = true;
+    bool  Adaptive = geodesicIntegrator == 1;
+    float Rs       = Frame.Rs;
+
+    vec3 PosToBlackHole = Ray.RayPos - Frame.BlackHolePos;
+    Ray.Distance        = length(PosToBlackHole);
+    Ray.NormalizedPos   = PosToBlackHole / Ray.Distance;
+    float DistanceToBlackHole = Ray.Distance;
+
+    if (Ray.Count >= maxGeodesicSteps && DistanceToBlackHole > Frame.OuterRadius && DistanceToBlackHole > Ray.LastR)
+    {  // 步数用完时已在盘外向外飞的光线按逃逸处理
+        flag          = false;
+        Ray.Escaped   = true;
+        Ray.EscapeDir = Ray.RayDir;
+    }
+    if (Ray.Count >= maxGeodesicSteps)
+    {
+        flag = false;
+    }
+    // 自适应积分没有初始方向的近似误差，向外飞出 2.5 倍盘半径即可判定逃逸（r 只有一个极小值）
+    if (flag == true && DistanceToBlackHole > (2.5 * Frame.OuterRadius) && DistanceToBlackHole > Ray.LastR && (Ray.Count > 50 || Adaptive))
+    {  // 远离黑洞
+        flag          = false;
+        Ray.Escaped   = true;
+        Ray.EscapeDir = Ray.RayDir;
+    }
+    if (DistanceToBlackHole < (Adaptive ? Rs : 0.1 * Rs))
+    {  // 自适应积分精确到视界为止
+        flag = false;
+    }
+    float DiskHeight = dot(PosToBlackHole, Frame.DiskAxis);
+    float DiskRadius = sqrt(max(DistanceToBlackHole * DistanceToBlackHole - DiskHeight * DiskHeight, 0.0));
+    Ray.SlabGap = max(abs(DiskHeight) - 0.5 * Rs, max(DiskRadius - Frame.OuterRadius, Frame.InterRadius - DiskRadius));
+#if DISK_ENABLED
+    // 留 0.01Rs 余量吸收与 CameraToDisk 的舍入差，边界上的判断仍由DiskColorAt自己做
+    if (flag == true && !Ray.Opaque && Ray.SlabGap < 0.01 * Rs)
+    {  // 吸积盘颜色
+        Ray.Color = DiskColorAt(Ray.Color, Frame.TimeRate, Ray.StepLength, Frame.CameraPosOnDisk,
+                                Frame.CameraToDisk * PosToBlackHole, Frame.CameraToDisk * Ray.RayDir, Rs,
+                                Frame.InterRadius, Frame.OuterRadius, Frame.DiskA, Frame.QuadraticedPeakTemperature,
+                                Frame.ShiftMax);
+#if STEP_STATS
+        Ray.DiskCalls++;
+#endif
+    }
+#endif
+    if (Ray.Color.a > 0.99)
+    {
+        Ray.Opaque = true;
+        flag       = flag && TraceWhenOpaque;
+    }
+    return flag;
+}
+
+// 测地raymarching的一步：按 MarchShade 算出的距离推进光线
+void MarchAdvance(BlackHoleFrame Frame, inout MarchState Ray)
+{
+    float Rs                       = Frame.Rs;
+    float OuterRadius              = Frame.OuterRadius;
+    float DistanceToBlackHole      = Ray.Distance;
+    vec3  NormalizedPosToBlackHole = Ray.NormalizedPos;
+    Ray.LastR = DistanceToBlackHole;
+    if (geodesicIntegrator == 1)
+    {
+        // 盘内按固定步长表的盘内间隔采样（体积着色需要），盘外最多走到包围体边缘，其余交给误差控制
+        float SlabStep = 0.15 * min(1.0, DistanceToBlackHole / Rs);
+        float MaxStep  = min(max(Ray.SlabGap / Rs, SlabStep), 0.5 * DistanceToBlackHole / Rs);
+        float H;
+        vec3  NewPos;
+        vec3  NewVel;
+        if (Ray.Count == 0)
+        {
+            Ray.GeodesicAccel = GeodesicAcceleration(Ray.GeodesicPos, Ray.GeodesicL2);
+            H = SlabStep * JitterNoise(Ray.FragUv).z;  // 光起步步长抖动，不做误差控制
+            DormandPrinceStep(Ray.GeodesicPos, Ray.GeodesicVel, Ray.GeodesicL2, H, 1e30, Ray.GeodesicAccel, NewPos, NewVel);
+        }
+        else
+        {
+            H = min(Ray.GeodesicH, MaxStep);
+            for (int Attempt = 0; Attempt < 8; ++Attempt)
+            {
+                float Error = DormandPrinceStep(Ray.GeodesicPos, Ray.GeodesicVel, Ray.GeodesicL2, H, geodesicTolerance, Ray.GeodesicAccel, NewPos, NewVel);
+                float Scale = 0.9 * pow(max(Error, 1e-4), -0.2);
+                if (Error <= 1.0 || Attempt == 7)
+                {
+                    if (Error > 1.0)
+                    {
+                        Ray.GeodesicAccel = GeodesicAcceleration(NewPos, Ray.GeodesicL2);
+                    }
+                    Ray.GeodesicH = H * min(Scale, 5.0);
+                    break;
+                }
+                H *= max(Scale, 0.2);
+                Ray.Count++;  // 被拒绝的尝试也计入步数上限
+            }
+        }
+        Ray.StepLength  = length(NewPos - Ray.GeodesicPos) * Rs;
+        Ray.GeodesicPos = NewPos;
+        Ray.GeodesicVel = NewVel;
+        Ray.RayPos      = Frame.BlackHolePos + Ray.GeodesicPos * Rs;
+        Ray.RayDir      = normalize(Ray.GeodesicVel);
+    }
+    else
+    {
+        vec3  RayDir       = Ray.RayDir;
+        float CosTheta     = length(cross(NormalizedPosToBlackHole, RayDir));                           // 前进方向与切向夹角
+        float DeltaPhiRate = -1.0 * CosTheta * CosTheta * CosTheta * (1.5 * Rs / DistanceToBlackHole);  // 单位长度光偏折角
+        float RayStep;
+        if (Ray.Count == 0)
+        {
+            RayStep = JitterNoise(Ray.FragUv).z;  // 光起步步长抖动
+        }
+        else
+        {
+            RayStep = 1.0;
+        }
+
+        RayStep *= 0.15 + 0.25 * min(max(0.0, 0.5 * (0.5 * DistanceToBlackHole / max(10.0 * Rs, OuterRadius) - 1.0)), 1.0);
+
+        if ((DistanceToBlackHole) >= 2.0 * OuterRadius)
+        {
+            RayStep *= DistanceToBlackHole;
+        }
+        else if ((DistanceToBlackHole) >= 1.0 * OuterRadius)
+        {
+            RayStep *= ((Rs) * (2.0 * OuterRadius - DistanceToBlackHole) +
+                        DistanceToBlackHole * (DistanceToBlackHole - OuterRadius)) / OuterRadius;
+        }
+        else
+        {
+            RayStep *= min(Rs,DistanceToBlackHole);
+        }
+        if (Ray.Count > 0 && Ray.SlabGap > 0.0)
+        {  // 路径长度不小于弦长，走 SlabGap 不会越过包围体；同时限制每步的偏折角
+            RayStep = max(RayStep, min(Ray.SlabGap, kSlabStepFraction * DistanceToBlackHole));
+        }
+
+        Ray.RayPos += RayDir * RayStep;
+        float DeltaPhi = RayStep / DistanceToBlackHole * DeltaPhiRate;
+        Ray.RayDir     = normalize(RayDir + (DeltaPhi + DeltaPhi * DeltaPhi * DeltaPhi / 3.0) *
+                         cross(cross(RayDir, NormalizedPosToBlackHole), RayDir) / CosTheta);  // 更新方向，里面的（dthe +DeltaPhi^3/3）是tan（dthe）
+        Ray.StepLength = RayStep;
+    }
+
+    Ray.Count++;
+}
+
+// 逃逸的光线最后叠加背景（不透明之后逃逸的不叠加），之前的颜色和逃逸方向即透镜映射的内容
+// 调试视图代替最终颜色（不超过0.9，经过 EncodeForBloom 仍是有限值）
+vec4 CompositeBackground(MarchState Ray)
+{
+#if DEBUG_VIEW == 1
+    return Ray.Escaped ? vec4(0.45 + 0.45 * Ray.EscapeDir, 0.9) : vec4(0.0, 0.0, 0.0, 0.9);
+#elif DEBUG_VIEW == 2
+    // 不透明：橙，逃逸：蓝，落入视界或步数用完：黑
+    return Ray.Opaque ? vec4(0.9, 0.5, 0.1, 0.9) : (Ray.Escaped ? vec4(0.1, 0.3, 0.9, 0.9) : vec4(0.0, 0.0, 0.0, 0.9));
+#elif DEBUG_VIEW == 3
+    // 步数相对 maxGeodesicSteps 开平方后查色带：黑、蓝、绿、黄、红（用完步数）
+    const vec3 kHeatRamp[5] = vec3[5](vec3(0.0), vec3(0.1, 0.2, 0.9), vec3(0.1, 0.8, 0.3), vec3(0.9, 0.9, 0.1), vec3(0.9, 0.1, 0.1));
+    float Heat  = 4.0 * sqrt(clamp(float(Ray.Count) / float(maxGeodesicSteps), 0.0, 1.0));
+    int   Index = min(int(Heat), 3);
+    return vec4(mix(kHeatRamp[Index], kHeatRamp[Index + 1], Heat - float(Index)), 0.9);
+#else
+    return Ray.Escaped && !Ray.Opaque ? BackgroundColor(Ray.Color, Ray.EscapeDir) : Ray.Color;
+#endif
+}
+
+// 透镜映射（circle.frag 的 lensingEscape 输出）的终止状态，与 render/lensingmap.h 的 LensingState 一致
+const float kLensingCaptured = 0.0;  // 落入视界、被不透明的盘挡住或步数用完
+const float kLensingEscaped  = 1.0;  // 逃逸到背景
+const float kLensingOutside  = 2.0;  // 分块保护带超出整幅图像的像素
+
+// 为了套bloom先逆处理一遍
+vec4 EncodeForBloom(vec4 fragColor)
+{
+    float colorRFactor = 3.0*fragColor.r / (fragColor.g+fragColor.g+fragColor.b);
+    float colorBFactor = 3.0*fragColor.b / (fragColor.g+fragColor.g+fragColor.b);
+    float colorGFactor = 3.0*fragColor.g / (fragColor.g+fragColor.g+fragColor.b);
+
+    float bloomMax = 12.0;
+    fragColor.r    = min(-4.0 * log(1. - pow(fragColor.r, 2.2)), bloomMax * colorRFactor);
+    fragColor.g    = min(-4.0 * log(1. - pow(fragColor.g, 2.2)), bloomMax * colorGFactor);
+    fragColor.b    = min(-4.0 * log(1. - pow(fragColor.b, 2.2)), bloomMax * colorBFactor);
+    fragColor.a    = min(-4.0 * log(1. - pow(fragColor.a, 2.2)), 4.0);
+    return fragColor;
+}
+
+// TAA：与 iChannel3 中上一帧的同一像素混合
+vec4 BlendWithPreviousFrame(vec4 fragColor, ivec2 Pixel, BlackHoleFrame Frame)
+{
+#if TEMPORAL_BLEND
+    float blendWeight = 1.0 - pow(0.5, (iTimeDelta) / max(min((0.131 * 36.0 / (Frame.TimeRate) * (GetKeplerianAngularVelocity(3. * 0.00000465, 0.00000465)) / (GetKeplerianAngularVelocity(3. * Frame.Rs, Frame.Rs))), 0.3),
+                                                          0.02));  // 本部分在实际使用时max(min((0.131*36.0/(TimeRate)*(omega(3.*0.00000465,0.00000465))/(omega(3.*Rs,Rs))),0.3),0.02)由uniform输入
+    blendWeight = (iFrame < 2 || iMouse.z > 0.0) ? 1.0 : blendWeight;
+
+    vec4 previousColor = texelFetch(iChannel3, Pixel, 0);                         // 获取前一帧的颜色
+    return (blendWeight)*fragColor + (1.0 - blendWeight) * previousColor;  // 混合当前帧和前一帧
+#else
+    return fragColor;
+#endif
+}
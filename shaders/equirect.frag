@@ -0,0 +1,15 @@
+#version 430 core
+out vec4 fragColor;
+uniform samplerCube iChannel0;  // circle.frag 渲染的六个面（相机系，-Z为正前方）
+uniform vec2 iResolution;       // 等距柱状投影图分辨率
+
+const float kPi = 3.14159265358979323846;
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / iResolution.xy;
+    // 图像中心为正前方，经度向右增加，纬度向上增加
+    float Longitude = (2.0 * uv.x - 1.0) * kPi;
+    float Latitude  = (uv.y - 0.5) * kPi;
+    vec3 Dir = vec3(sin(Longitude) * cos(Latitude), sin(Latitude), -cos(Longitude) * cos(Latitude));
+    fragColor = texture(iChannel0, Dir);
+}
@@ -0,0 +1,48 @@
+#version 430 core
+out vec4 fragColor;
+#include "blackhole.glsl"
+
+// 透镜映射换背景：circle.frag 导出的吸积盘颜色和逃逸方向（render/lensingmap.h）不随背景变化，
+// 这里只查两张纹理、叠加背景，不做raymarching。帧参数与导出时相同，逃逸方向在相机系中
+uniform sampler2D lensingDisk;    // 平面0：吸积盘颜色（未叠加背景）
+uniform sampler2D lensingEscape;  // 平面1：相机系逃逸方向和终止状态
+uniform sampler2D skyTexture;     // 等距柱状投影天空（世界系，y轴向上，图像中心为 -Z）
+uniform int useSky;               // 0: 按 backgroundType 取背景
+
+// 相机系方向转到世界系：FrameWorldToCamera 是旋转，其转置即逆
+vec3 CameraToWorld(vec3 Dir)
+{
+    return Dir * FrameWorldToCamera;
+}
+
+// 与 equirect.frag 相同的约定：经度向右增加，纬度向上增加
+vec2 DirToEquirectUv(vec3 Dir)
+{
+    float Longitude = atan(Dir.x, -Dir.z);
+    float Latitude  = asin(clamp(Dir.y, -1.0, 1.0));
+    return vec2(0.5 + 0.5 * Longitude / kPi, 0.5 + Latitude / kPi);
+}
+
+void main()
+{
+    ivec2 Pixel  = ivec2(gl_FragCoord.xy);
+    vec4  Color  = texelFetch(lensingDisk, Pixel, 0);
+    vec4  Escape = texelFetch(lensingEscape, Pixel, 0);
+    if (Escape.w == kLensingOutside)
+    {
+        fragColor = vec4(0.0);
+        return;
+    }
+    if (Escape.w == kLensingEscaped)
+    {
+        if (useSky != 0)
+        {
+            Color += texture(skyTexture, DirToEquirectUv(CameraToWorld(normalize(Escape.xyz)))) * (1.0 - Color.a);
+        }
+        else
+        {
+            Color = BackgroundColor(Color, Escape.xyz);
+        }
+    }
+    fragColor = EncodeForBloom(Color);
+}
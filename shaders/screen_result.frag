@@ -2,7 +2,8 @@
 
 out vec4 FragColor;
 uniform sampler2D iChannel0;  // 主颜色纹理
-uniform sampler2D iChannel3;  // Bloom纹理
+uniform sampler2D bloomLevels[8];  // bloom金字塔（mipmap.frag 逐级减半后模糊），第 k 级为 1 / 2^(k+1) 分辨率
+uniform bool bloomEnabled;         // 关闭 mipmap 时不加bloom
 uniform vec2 iResolution;     // 视口分辨率
 
 vec3 saturate(vec3 x) {
@@ -20,9 +21,9 @@ vec4 cubic(float x) {
     return w / 6.0;
 }
 
+// coord 以纹素为单位
 vec4 BicubicTexture(sampler2D tex, vec2 coord) {
     vec2 texSize = vec2(textureSize(tex, 0));
-    coord = coord * texSize;
     
     float fx = fract(coord.x);
     float fy = fract(coord.y);
@@ -54,38 +55,21 @@ vec3 ColorFetch(vec2 coord) {
     return texture(iChannel0, coord).rgb;   
 }
 
-vec3 BloomFetch(vec2 coord) {
-    return BicubicTexture(iChannel3, coord).rgb;   
+// 金字塔一级中与当前像素对应的位置：像素坐标除以 2^octave 即为该级的纹素坐标
+vec3 Grab(sampler2D level, float octave, vec2 fragCoord) {
+    return BicubicTexture(level, fragCoord / exp2(octave)).rgb;
 }
 
-vec3 Grab(vec2 coord, float octave, vec2 offset) {
-    float scale = exp2(octave);
-    coord /= scale;
-    coord -= offset;
-    return BloomFetch(coord);
-}
-
-vec2 CalcOffset(float octave) {
-    vec2 offset = vec2(0.0);
-    vec2 padding = vec2(10.0) / iResolution.xy;
-    
-    offset.x = -min(1.0, floor(octave / 3.0)) * (0.25 + padding.x);
-    offset.y = -(1.0 - (1.0 / exp2(octave))) - padding.y * octave;
-    offset.y += min(1.0, floor(octave / 3.0)) * 0.35;
-    
-    return offset;   
-}
-
-vec3 GetBloom(vec2 coord) {
+vec3 GetBloom(vec2 fragCoord) {
     vec3 bloom = vec3(0.0);
-    bloom += Grab(coord, 1.0, CalcOffset(0.0)) * 1.0;
-    bloom += Grab(coord, 2.0, CalcOffset(1.0)) * 1.5;
-    bloom += Grab(coord, 3.0, CalcOffset(2.0)) * 1.0;
-    bloom += Grab(coord, 4.0, CalcOffset(3.0)) * 1.5;
-    bloom += Grab(coord, 5.0, CalcOffset(4.0)) * 1.8;
-    bloom += Grab(coord, 6.0, CalcOffset(5.0)) * 1.0;
-    bloom += Grab(coord, 7.0, CalcOffset(6.0)) * 1.0;
-    bloom += Grab(coord, 8.0, CalcOffset(7.0)) * 0.5;
+    bloom += Grab(bloomLevels[0], 1.0, fragCoord) * 1.0;
+    bloom += Grab(bloomLevels[1], 2.0, fragCoord) * 1.5;
+    bloom += Grab(bloomLevels[2], 3.0, fragCoord) * 1.0;
+    bloom += Grab(bloomLevels[3], 4.0, fragCoord) * 1.5;
+    bloom += Grab(bloomLevels[4], 5.0, fragCoord) * 1.8;
+    bloom += Grab(bloomLevels[5], 6.0, fragCoord) * 1.0;
+    bloom += Grab(bloomLevels[6], 7.0, fragCoord) * 1.0;
+    bloom += Grab(bloomLevels[7], 8.0, fragCoord) * 0.5;
 
     return bloom;
 }
@@ -94,7 +78,9 @@ void main() {
     vec2 uv = gl_FragCoord.xy / iResolution;
     
     vec3 color = ColorFetch(uv);
-    color += GetBloom(uv) * 0.07;  // Bloom强度控制
+    if (bloomEnabled) {
+        color += GetBloom(gl_FragCoord.xy) * 0.07;  // Bloom强度控制
+    }
 
     // 色调映射
     color = pow(color, vec3(1.5));
@@ -23,23 +23,19 @@ void main() {
     offsets[3] = 5.17647059;
     offsets[4] = 7.05882353;
     
+    // 作用于bloom金字塔的一级，iResolution 为该级尺寸；级外按纹理边框取0
     vec2 uv = gl_FragCoord.xy / iResolution.xy;
-    vec3 color = vec3(0.0);
-    float weightSum = 0.0;
-    
-    if (uv.x < 0.52) {
-        color += ColorFetch(uv) * weights[0];
-        weightSum += weights[0];
-
-        for(int i = 1; i < 5; i++) {
-            vec2 offset = vec2(offsets[i]) / iResolution.xy;
-            color += ColorFetch(uv + offset * vec2(0.0, 0.5)) * weights[i];
-            color += ColorFetch(uv - offset * vec2(0.0, 0.5)) * weights[i];
-            weightSum += weights[i] * 2.0;
-        }
+    vec3 color = ColorFetch(uv) * weights[0];
+    float weightSum = weights[0];
 
-        color /= weightSum;
+    for(int i = 1; i < 5; i++) {
+        vec2 offset = vec2(offsets[i]) / iResolution.xy;
+        color += ColorFetch(uv + offset * vec2(0.0, 0.5)) * weights[i];
+        color += ColorFetch(uv - offset * vec2(0.0, 0.5)) * weights[i];
+        weightSum += weights[i] * 2.0;
     }
 
+    color /= weightSum;
+
     fragColor = vec4(color, 1.0);
 }
\ No newline at end of file
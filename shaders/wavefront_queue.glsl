@@ -0,0 +1,70 @@
+// 波前路径的光线队列和压缩（wavefront_*.comp 共用）
+// 队列里是光线在 WavefrontRays 中的下标；每次推进后按存活标志做前缀和，把存活的光线紧凑地写入另一个队列
+const uint kWavefrontGroupSize = 256u;  // 推进和压缩的工作组大小，与 BlackHoleRenderer 一致
+const uint kWavefrontGroupRow  = 65535u; // 间接dispatch每行最多的工作组数（GL保证的最小上限），超出时按行排成二维
+
+uniform int wavefrontQueue;  // 本次dispatch读取的队列（0或1），压缩结果写入另一个
+
+struct WavefrontQueueHeader
+{
+    uint Count;      // 队列中的光线数
+    uint Groups[3];  // 处理该队列的间接dispatch参数，每组 kWavefrontGroupSize 条，最后一行可能多出空组
+};
+layout(std430, binding = 3) buffer WavefrontQueueIn
+{
+    uint QueueIn[];
+};
+layout(std430, binding = 4) buffer WavefrontQueueOut
+{
+    uint QueueOut[];
+};
+layout(std430, binding = 5) buffer WavefrontCompaction
+{
+    uvec2 Compaction[];  // 队列中每个位置：光线是否存活、组内的排他前缀和
+};
+layout(std430, binding = 6) buffer WavefrontGroupSums
+{
+    uint GroupSums[];    // 每组的存活数，扫描后为该组在输出队列中的偏移
+};
+layout(std430, binding = 7) buffer WavefrontControl
+{
+    WavefrontQueueHeader Queues[2];
+};
+
+shared uint ScanPartial[kWavefrontGroupSize];
+
+// 二维dispatch中工作组的线性编号和调用在队列中的位置
+uint WavefrontGroup()
+{
+    return gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+}
+
+uint WavefrontSlot()
+{
+    return WavefrontGroup() * kWavefrontGroupSize + gl_LocalInvocationID.x;
+}
+
+// count 条光线所需的工作组数
+uint WavefrontGroupCount(uint Count)
+{
+    return (Count + kWavefrontGroupSize - 1u) / kWavefrontGroupSize;
+}
+
+// 工作组内的包含前缀和，所有调用都必须到达
+uint GroupInclusiveScan(uint Value)
+{
+    uint Lane = gl_LocalInvocationID.x;
+    ScanPartial[Lane] = Value;
+    memoryBarrierShared();
+    barrier();
+    for (uint Offset = 1u; Offset < kWavefrontGroupSize; Offset <<= 1u)
+    {
+        uint Sum = Lane >= Offset ? ScanPartial[Lane - Offset] : 0u;
+        memoryBarrierShared();
+        barrier();
+        ScanPartial[Lane] += Sum;
+        memoryBarrierShared();
+        barrier();
+    }
+    return ScanPartial[Lane];
+}
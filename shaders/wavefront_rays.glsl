@@ -0,0 +1,98 @@
+// 波前路径的光线状态（wavefront_*.comp 共用），按视口内的像素下标存储，需先包含 blackhole.glsl
+uniform int wavefrontWidth;   // 视口尺寸
+uniform int wavefrontHeight;
+
+const uint kRayCountMask = 0x00ffffffu;  // RayFlags 低24位为步数，其上为标志
+const uint kRayOpaque    = 0x01000000u;
+const uint kRayEscaped   = 0x02000000u;
+
+struct WavefrontRay
+{
+    vec4 PosStep;   // RayPos, StepLength
+    vec4 DirLastR;  // RayDir, LastR
+    vec4 Color;
+};
+// 自适应积分的状态，只在 geodesicIntegrator == 1 时读写
+struct WavefrontGeodesic
+{
+    vec4 PosH;      // GeodesicPos, GeodesicH
+    vec4 VelL2;     // GeodesicVel, GeodesicL2
+    vec4 Accel;     // GeodesicAccel
+};
+layout(std430, binding = 0) buffer WavefrontRays
+{
+    WavefrontRay Rays[];
+};
+layout(std430, binding = 1) buffer WavefrontGeodesics
+{
+    WavefrontGeodesic Geodesics[];
+};
+layout(std430, binding = 2) buffer WavefrontRayFlags
+{
+    uint RayFlags[];
+};
+
+// 视口内像素 (x, y) 在整幅图像中的像素中心，与 circle.frag 的 gl_FragCoord.xy + iTileOffset 相同
+vec2 WavefrontFragCoord(ivec2 Pixel)
+{
+    return vec2(Pixel) + 0.5 + iTileOffset;
+}
+
+ivec2 WavefrontPixel(uint Index)
+{
+    return ivec2(int(Index) % wavefrontWidth, int(Index) / wavefrontWidth);
+}
+
+void StoreRay(uint Index, MarchState Ray)
+{
+    Rays[Index].PosStep  = vec4(Ray.RayPos, Ray.StepLength);
+    // 逃逸的光线不再推进，方向的位置存逃逸方向
+    Rays[Index].DirLastR = vec4(Ray.Escaped ? Ray.EscapeDir : Ray.RayDir, Ray.LastR);
+    Rays[Index].Color    = Ray.Color;
+    RayFlags[Index]      = uint(Ray.Count) | (Ray.Opaque ? kRayOpaque : 0u) | (Ray.Escaped ? kRayEscaped : 0u);
+    if (geodesicIntegrator == 1)
+    {
+        Geodesics[Index].PosH  = vec4(Ray.GeodesicPos, Ray.GeodesicH);
+        Geodesics[Index].VelL2 = vec4(Ray.GeodesicVel, Ray.GeodesicL2);
+        Geodesics[Index].Accel = vec4(Ray.GeodesicAccel, 0.0);
+    }
+}
+
+MarchState LoadRay(uint Index)
+{
+    MarchState Ray;
+    WavefrontRay Stored = Rays[Index];
+    uint Flags = RayFlags[Index];
+    Ray.FragUv     = WavefrontFragCoord(WavefrontPixel(Index)) / iResolution.xy;
+    Ray.RayPos     = Stored.PosStep.xyz;
+    Ray.StepLength = Stored.PosStep.w;
+    Ray.RayDir     = Stored.DirLastR.xyz;
+    Ray.LastR      = Stored.DirLastR.w;
+    Ray.Color      = Stored.Color;
+    Ray.Count      = int(Flags & kRayCountMask);
+    Ray.DiskCalls  = 0;   // 波前路径不做步数统计
+    Ray.Opaque     = (Flags & kRayOpaque) != 0u;
+    Ray.Escaped    = (Flags & kRayEscaped) != 0u;
+    Ray.EscapeDir  = Ray.RayDir;
+    if (geodesicIntegrator == 1)
+    {
+        WavefrontGeodesic Geodesic = Geodesics[Index];
+        Ray.GeodesicPos   = Geodesic.PosH.xyz;
+        Ray.GeodesicH     = Geodesic.PosH.w;
+        Ray.GeodesicVel   = Geodesic.VelL2.xyz;
+        Ray.GeodesicL2    = Geodesic.VelL2.w;
+        Ray.GeodesicAccel = Geodesic.Accel.xyz;
+    }
+    else
+    {
+        Ray.GeodesicPos   = vec3(0.0);
+        Ray.GeodesicH     = 0.0;
+        Ray.GeodesicVel   = vec3(0.0);
+        Ray.GeodesicL2    = 0.0;
+        Ray.GeodesicAccel = vec3(0.0);
+    }
+    Ray.Distance      = 0.0;
+    Ray.NormalizedPos = vec3(0.0);
+    Ray.SlabGap       = 0.0;
+    return Ray;
+}
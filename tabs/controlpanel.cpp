@@ -1,4 +1,5 @@
 #include "controlpanel.h"
+#include "../render/blackholerenderer.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -47,6 +48,20 @@ ControlPanel::ControlPanel(QWidget* parent) : QFrame(parent) {
     
     layout->addWidget(bgGroup);
     
+    // 黑洞自旋：非零时查 Kerr 转移表，表在后台生成，生成完之前按 Schwarzschild 显示
+    QGroupBox* spinGroup = new QGroupBox("Black Hole Spin");
+    QHBoxLayout* spinLayout = new QHBoxLayout(spinGroup);
+    spinLayout->setContentsMargins(10, 15, 10, 15);
+    spinLayout->addWidget(new QLabel("a / M"));
+    spinBox = new QDoubleSpinBox();
+    spinBox->setObjectName("spinBox");
+    spinBox->setRange(-0.99, 0.99);
+    spinBox->setSingleStep(0.05);
+    spinBox->setDecimals(3);
+    spinBox->setValue(0.0);
+    spinLayout->addWidget(spinBox);
+    layout->addWidget(spinGroup);
+    
     // 添加间距
     layout->addSpacing(20);
     
@@ -82,6 +97,42 @@ ControlPanel::ControlPanel(QWidget* parent) : QFrame(parent) {
     verticalBlurRadio->setChecked(true);  // 默认选中
     debugLayout->addWidget(verticalBlurRadio);
     
+    // 录制帧序列到 capture/ 目录 (默认关闭)
+    recordFramesCheck = new QCheckBox("Record Frames");
+    recordFramesCheck->setObjectName("recordFramesCheck");
+    recordFramesCheck->setChecked(false);
+    debugLayout->addWidget(recordFramesCheck);
+    
+    // circle 通道的调试视图，顺序与 DebugView 相同
+    QHBoxLayout* viewLayout = new QHBoxLayout();
+    viewLayout->addWidget(new QLabel("View"));
+    debugViewCombo = new QComboBox();
+    debugViewCombo->setObjectName("debugViewCombo");
+    debugViewCombo->addItems({"Render", "Escape Direction", "Termination", "Step Heat Map"});
+    viewLayout->addWidget(debugViewCombo);
+    debugLayout->addLayout(viewLayout);
+    
+    // 每条光线的步数上限
+    QHBoxLayout* maxStepsLayout = new QHBoxLayout();
+    maxStepsLayout->addWidget(new QLabel("Max Steps"));
+    maxStepsBox = new QSpinBox();
+    maxStepsBox->setObjectName("maxStepsBox");
+    maxStepsBox->setRange(BlackHoleRenderer::kMinGeodesicSteps, BlackHoleRenderer::kMaxGeodesicStepsLimit);
+    maxStepsBox->setSingleStep(100);
+    maxStepsBox->setValue(1000);
+    maxStepsLayout->addWidget(maxStepsBox);
+    debugLayout->addLayout(maxStepsLayout);
+    
+    // 步数统计 (默认关闭)，读回的结果显示在下面
+    stepStatisticsCheck = new QCheckBox("Step Statistics");
+    stepStatisticsCheck->setObjectName("stepStatisticsCheck");
+    stepStatisticsCheck->setChecked(false);
+    debugLayout->addWidget(stepStatisticsCheck);
+    stepStatisticsLabel = new QLabel();
+    stepStatisticsLabel->setObjectName("stepStatisticsLabel");
+    stepStatisticsLabel->setWordWrap(true);
+    debugLayout->addWidget(stepStatisticsLabel);
+    
     layout->addWidget(debugGroup);
     
     // 添加间距
@@ -138,6 +189,30 @@ ControlPanel::ControlPanel(QWidget* parent) : QFrame(parent) {
         }
         emit showRenderResultChanged(checked);
     });
+    
+    // 录制信号
+    connect(recordFramesCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        emit recordFramesChanged(checked);
+    });
+    
+    // 自旋信号
+    connect(spinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double spin) {
+        emit spinChanged(spin);
+    });
+    
+    // 调试视图、步数上限和步数统计信号
+    connect(debugViewCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int view) {
+        emit debugViewChanged(view);
+    });
+    connect(maxStepsBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int steps) {
+        emit maxStepsChanged(steps);
+    });
+    connect(stepStatisticsCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        if (!checked) {
+            stepStatisticsLabel->clear();
+        }
+        emit stepStatisticsChanged(checked);
+    });
 }
 
 QPushButton* ControlPanel::createBgButton(const QString& text, int type) {
@@ -175,4 +250,10 @@ void ControlPanel::setBackgroundType(int type) {
 
 void ControlPanel::setAspectRatio(const QString& ratio) {
     ratioLabel->setText(ratio);
-}
\ No newline at end of file
+}
+
+void ControlPanel::setStepStatisticsText(const QString& text) {
+    if (stepStatisticsCheck->isChecked()) {
+        stepStatisticsLabel->setText(text);
+    }
+}
@@ -6,12 +6,16 @@
 #include <QLabel>
 #include <QRadioButton>
 #include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+#include <QComboBox>
 
 class ControlPanel : public QFrame {
     Q_OBJECT
 public:
     explicit ControlPanel(QWidget* parent = nullptr);
     void setAspectRatio(const QString& ratio);
+    void setStepStatisticsText(const QString& text);
 
 signals:
     void backgroundTypeChanged(int type);
@@ -19,6 +23,11 @@ signals:
     void horizontalBlurChanged(bool enabled);  // 改为bool类型信号
     void verticalBlurChanged(bool enabled);    // 改为bool类型信号
     void showRenderResultChanged(bool show);   // 新增渲染结果信号
+    void recordFramesChanged(bool enabled);
+    void spinChanged(double spin);
+    void debugViewChanged(int view);          // DebugView 的值
+    void stepStatisticsChanged(bool enabled);
+    void maxStepsChanged(int steps);
 
 public:
     QPushButton* createBgButton(const QString& text, int type);
@@ -34,6 +43,12 @@ public:
     QCheckBox* horizontalBlurRadio; 
     QCheckBox* verticalBlurRadio;
     QCheckBox* showRenderResultCheck; // 新增渲染结果复选框
+    QCheckBox* recordFramesCheck;
+    QComboBox* debugViewCombo;
+    QCheckBox* stepStatisticsCheck;
+    QSpinBox* maxStepsBox;
+    QLabel* stepStatisticsLabel;
+    QDoubleSpinBox* spinBox;
 };
 
 #endif // CONTROLPANEL_H
\ No newline at end of file